@@ -61,7 +61,12 @@ public sealed class HLLib
         HL_PROC_DEFRAGMENT_PROGRESS_EX,
         HL_PROC_SEEK_EX,
         HL_PROC_TELL_EX,
-        HL_PROC_SIZE_EX
+        HL_PROC_SIZE_EX,
+        HL_SKIP_UNCHANGED_FILES,
+        HL_READ_AHEAD,
+        HL_EXTRACT_THREAD_COUNT,
+        HL_ARCHIVE_HANDLE_LIMIT,
+        HL_STREAM_CACHE_SIZE
     }
 
     public enum HLFileMode : uint
@@ -121,7 +126,12 @@ public sealed class HLLib
         HL_STREAM_MAPPING,
         HL_STREAM_MEMORY,
         HL_STREAM_PROC,
-        HL_STREAM_NULL
+        HL_STREAM_NULL,
+        HL_STREAM_READ_AHEAD,
+        HL_STREAM_INFLATE,
+        HL_STREAM_LZMA,
+        HL_STREAM_CONCATENATED,
+        HL_STREAM_LZSS
     }
 
     public enum HLMappingType : uint
@@ -255,6 +265,13 @@ public sealed class HLLib
         HL_VALIDATES_CANCELED,
         HL_VALIDATES_ERROR
     }
+
+    public enum HLSkipMode : uint
+    {
+        HL_SKIP_NONE = 0,
+        HL_SKIP_SIZE,
+        HL_SKIP_CHECKSUM
+    }
     #endregion
 
     #region Structures
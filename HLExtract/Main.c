@@ -51,6 +51,8 @@
 #ifdef _WIN32
 #	define WIN32_LEAN_AND_MEAN
 #	include <windows.h>
+#	include <fcntl.h>
+#	include <io.h>
 #else
 #	include <linux/limits.h>
 #	define MAX_PATH PATH_MAX
@@ -74,6 +76,7 @@ hlVoid ProgressUpdate(hlULongLong uiBytesDone, hlULongLong uiBytesTotal);
 hlVoid ExtractItemStartCallback(HLDirectoryItem *pItem);
 hlVoid FileProgressCallback(HLDirectoryItem *pFile, hlUInt uiBytesExtracted, hlUInt uiBytesTotal, hlBool *pCancel);
 hlVoid ExtractItemEndCallback(HLDirectoryItem *pItem, hlBool bSuccess);
+hlUInt TarWriteCallback(const hlVoid *lpData, hlUInt uiBytes, hlVoid *pUserData);
 hlVoid DefragmentProgressCallback(HLDirectoryItem *pFile, hlUInt uiFilesDefragmented, hlUInt uiFilesTotal, hlULongLong uiBytesDefragmented, hlULongLong uiBytesTotal, hlBool *pCancel);
 HLValidation Validate(HLDirectoryItem *pItem);
 hlVoid PrintAttribute(hlChar *lpPrefix, HLAttribute *pAttribute, hlChar *lpPostfix);
@@ -98,6 +101,8 @@ int main(hlInt argc, hlChar* argv[])
 	hlChar *lpPackage = 0;
 	hlUInt uiExtractItems = 0;
 	hlChar *lpExtractItems[MAX_ITEMS];
+	hlChar *lpTarFile = 0;
+	FILE *pTarFile = 0;
 	hlUInt uiValidateItems = 0;
 	hlChar *lpValidateItems[MAX_ITEMS];
 	hlChar *lpList = 0;
@@ -117,6 +122,7 @@ int main(hlInt argc, hlChar* argv[])
 	hlBool bVolatileAccess = hlFalse;
 	hlBool bOverwriteFiles = hlTrue;
 	hlBool bForceDefragment = hlFalse;
+	HLSkipMode eSkipUnchangedFiles = HL_SKIP_NONE;
 
 	// Package stuff.
 	HLPackageType ePackageType = HL_PACKAGE_NONE;
@@ -182,6 +188,18 @@ int main(hlInt argc, hlChar* argv[])
 					return 2;
 				}
 			}
+			else if(stricmp(argv[i], "-a") == 0 || stricmp(argv[i], "--tar") == 0)
+			{
+				if(i + 1 < uiArgumentCount)
+				{
+					lpTarFile = argv[++i];
+				}
+				else
+				{
+					PrintUsage();
+					return 2;
+				}
+			}
 			else if(stricmp(argv[i], "-t") == 0 || stricmp(argv[i], "--validate") == 0)
 			{
 				if(i + 1 < uiArgumentCount)
@@ -291,6 +309,14 @@ int main(hlInt argc, hlChar* argv[])
 				bDefragment = hlTrue;
 				bForceDefragment = hlTrue;
 			}
+			else if(stricmp(argv[i], "-u") == 0 || stricmp(argv[i], "--update") == 0)
+			{
+				eSkipUnchangedFiles = HL_SKIP_SIZE;
+			}
+			else if(stricmp(argv[i], "-k") == 0 || stricmp(argv[i], "--update-checksum") == 0)
+			{
+				eSkipUnchangedFiles = HL_SKIP_CHECKSUM;
+			}
 			else
 			{
 				PrintUsage();
@@ -319,10 +345,17 @@ int main(hlInt argc, hlChar* argv[])
 		}
 	}
 
+	// Writing the tar stream to stdout, keep it clean.
+	if(lpTarFile != 0 && strcmp(lpTarFile, "-") == 0)
+	{
+		bSilent = hlTrue;
+	}
+
 	hlInitialize();
 
 	hlSetBoolean(HL_OVERWRITE_FILES, bOverwriteFiles);
 	hlSetBoolean(HL_FORCE_DEFRAGMENT, bForceDefragment);
+	hlSetUnsignedInteger(HL_SKIP_UNCHANGED_FILES, eSkipUnchangedFiles);
 	hlSetVoid(HL_PROC_EXTRACT_ITEM_START, ExtractItemStartCallback);
 	hlSetVoid(HL_PROC_EXTRACT_ITEM_END, ExtractItemEndCallback);
 	hlSetVoid(HL_PROC_EXTRACT_FILE_PROGRESS, FileProgressCallback);
@@ -402,6 +435,32 @@ int main(hlInt argc, hlChar* argv[])
 	if(!bSilent)
 		Print(FOREGROUND_GREEN | FOREGROUND_INTENSITY, "%s opened.\n", lpPackage);
 
+	// Open the tar file to extract to.
+	if(lpTarFile != 0 && uiExtractItems != 0)
+	{
+		if(strcmp(lpTarFile, "-") == 0)
+		{
+#ifdef _WIN32
+			// Don't let text mode turn \n into \r\n in the tar stream.
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			pTarFile = stdout;
+		}
+		else
+		{
+			pTarFile = fopen(lpTarFile, "wb");
+		}
+
+		if(pTarFile == 0)
+		{
+			Print(FOREGROUND_RED | FOREGROUND_INTENSITY, "Error creating %s.\n", lpTarFile);
+
+			hlShutdown();
+
+			return 1;
+		}
+	}
+
 	// Extract the requested items.
 	for(i = 0; i < uiExtractItems; i++)
 	{
@@ -421,8 +480,15 @@ int main(hlInt argc, hlChar* argv[])
 		}
 
 		// Extract the item.
-		// Item is extracted to cDestination\Item->GetName().
-		hlItemExtract(pItem, lpDestination);
+		// Item is extracted to cDestination\Item->GetName() or appended to the tar file.
+		if(pTarFile != 0)
+		{
+			hlItemExtractTarProc(pItem, TarWriteCallback, pTarFile, hlFalse);
+		}
+		else
+		{
+			hlItemExtract(pItem, lpDestination);
+		}
 
 		if(!bSilent)
 		{
@@ -431,6 +497,21 @@ int main(hlInt argc, hlChar* argv[])
 		}
 	}
 
+	if(pTarFile != 0)
+	{
+		hlItemExtractTarProc(0, TarWriteCallback, pTarFile, hlTrue);
+
+		if(pTarFile != stdout)
+		{
+			fclose(pTarFile);
+		}
+		else
+		{
+			fflush(pTarFile);
+		}
+		pTarFile = 0;
+	}
+
 	// Validate the requested items.
 	for(i = 0; i < uiValidateItems; i++)
 	{
@@ -604,6 +685,7 @@ hlVoid PrintUsage()
 	printf(" -d <path>           (Destination extraction directory.)\n");
 	printf(" -e <itempath>       (Item in package to extract.)\n");
 	printf(" -t <itempath>       (Item in package to validate.)\n");
+	printf(" -a <filepath>       (Extract items to a tar file, - for stdout.)\n");
 	printf(" -l[d][f] [filepath] (List the contents of the package.)\n");
 	printf(" -f                  (Defragment package.)\n");
 	printf(" -c                  (Console mode.)\n");
@@ -614,6 +696,8 @@ hlVoid PrintUsage()
 	printf(" -v                  (Allow volatile access.)\n");
 	printf(" -o                  (Don't overwrite files.)\n");
 	printf(" -r                  (Force defragmenting on all files.)\n");
+	printf(" -u                  (Skip files whose size is unchanged.)\n");
+	printf(" -k                  (Skip files whose checksum is unchanged.)\n");
 	printf(" -n <path>           (NCF file's root path.)\n");
 	printf("\n");
 	printf("Example HLExtract usage:\n");
@@ -712,6 +796,11 @@ hlVoid ProgressUpdate(hlULongLong uiBytesDone, hlULongLong uiBytesTotal)
 	}
 }
 
+hlUInt TarWriteCallback(const hlVoid *lpData, hlUInt uiBytes, hlVoid *pUserData)
+{
+	return (hlUInt)fwrite(lpData, 1, uiBytes, (FILE *)pUserData);
+}
+
 hlVoid ExtractItemStartCallback(HLDirectoryItem *pItem)
 {
 	if(!bSilent)
@@ -11,6 +11,7 @@
 
 #include "HLLib.h"
 #include "BSPFile.h"
+#include "Bitmap.h"
 #include "Streams.h"
 
 using namespace HLLib;
@@ -22,7 +23,7 @@ using namespace HLLib;
 const char *CBSPFile::lpAttributeNames[] = { "Version" };
 const char *CBSPFile::lpItemAttributeNames[] = { "Width", "Height", "Palette Entries" };
 
-CBSPFile::CBSPFile() : CPackage(), pHeaderView(0), pTextureView(0), pHeader(0), pTextureHeader(0)
+CBSPFile::CBSPFile() : CPackage(), pHeaderView(0), pTextureView(0), pHeader(0), pTextureHeader(0), pStreamCache(0)
 {
 
 }
@@ -73,11 +74,19 @@ hlBool CBSPFile::MapDataStructures()
 	}
 	this->pTextureHeader = static_cast<const BSPTextureHeader *>(this->pTextureView->GetView());
 
+	if(this->GetContext().uiStreamCacheSize != 0)
+	{
+		this->pStreamCache = new CBufferCache(this->GetContext().uiStreamCacheSize);
+	}
+
 	return hlTrue;
 }
 
 hlVoid CBSPFile::UnmapDataStructures()
 {
+	delete this->pStreamCache;
+	this->pStreamCache = 0;
+
 	this->pTextureHeader = 0;
 	this->pMapping->Unmap(this->pTextureView);
 
@@ -222,7 +231,7 @@ hlBool CBSPFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize
 			return hlFalse;
 		}
 
-		uiSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
+		uiSize = GetBitmapSize(uiWidth, uiHeight, uiPaletteSize);
 	}
 	else
 	{
@@ -261,75 +270,113 @@ hlBool CBSPFile::GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &
 	return hlTrue;
 }
 
-hlBool CBSPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
+//
+// BorrowImage()
+// Points Image at the palette and the indices of each mipmap of a texture
+// where they lie in the package, without copying them.  Textures stay mapped
+// as long as the package is open; the image must still be passed to
+// ReleaseImage() when done.
+//
+hlBool CBSPFile::BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image)
 {
-	if(pFile->GetID() < this->pTextureHeader->uiTextureCount)
+	memset(&Image, 0, sizeof(HLBorrowedImage));
+
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
 	{
-		hlUInt uiWidth, uiHeight, uiPaletteSize;
-		const hlByte *lpPalette, *lpPixels;
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
 
-		if(!this->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels))
-		{
-			return hlFalse;
-		}
+	if(pFile->GetID() >= this->pTextureHeader->uiTextureCount)
+	{
+		LastError.SetErrorMessage("File is not a texture.");
+		return hlFalse;
+	}
+
+	hlUInt uiWidth, uiHeight, uiPaletteSize;
+	const hlByte *lpPalette, *lpPixels;
 
-		hlUInt uiBufferSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
-		hlByte *lpBuffer = new hlByte[uiBufferSize];
+	if(!this->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels))
+	{
+		return hlFalse;
+	}
+
+	// Callers read straight from the mapping, make sure everything they can reach lies in the lump.
+	const hlByte *lpLump = (const hlByte *)this->pTextureHeader;
+	hlULongLong uiLength = this->pHeader->lpLumps[HL_BSP_LUMP_TEXTUREDATA].uiLength;
+
+	if(static_cast<hlULongLong>(lpPalette - lpLump) + static_cast<hlULongLong>(uiPaletteSize) * 3 > uiLength)
+	{
+		LastError.SetErrorMessage("Error reading texture: texture data exceeds lump.");
+		return hlFalse;
+	}
 
-		//
-		// Allocate data.
-		//
+	hlULongLong uiTextureOffset = this->pTextureHeader->lpOffsets[pFile->GetID()];
+	const BSPTexture *pTexture = (const BSPTexture *)(lpLump + uiTextureOffset);
 
-		BITMAPFILEHEADER *pFileHeader = (BITMAPFILEHEADER *)lpBuffer;
-		BITMAPINFOHEADER *pInfoHeader = (BITMAPINFOHEADER *)((hlByte *)pFileHeader + sizeof(BITMAPFILEHEADER));
-		hlByte *lpPaletteData = (hlByte *)pInfoHeader + sizeof(BITMAPINFOHEADER);
-		hlByte *lpPixelData = lpPaletteData + uiPaletteSize * 4;
+	hlUInt uiMipmapCount = 0;
+	while(uiMipmapCount < HL_BSP_MIPMAP_COUNT && pTexture->lpOffsets[uiMipmapCount] != 0)
+	{
+		hlULongLong uiOffset = uiTextureOffset + pTexture->lpOffsets[uiMipmapCount];
+		if(uiOffset + static_cast<hlULongLong>(uiWidth >> uiMipmapCount) * static_cast<hlULongLong>(uiHeight >> uiMipmapCount) > uiLength)
+		{
+			memset(&Image, 0, sizeof(HLBorrowedImage));
 
-		memset(pFileHeader, 0, sizeof(BITMAPFILEHEADER));
-		memset(pInfoHeader, 0, sizeof(BITMAPINFOHEADER));
+			LastError.SetErrorMessage("Error reading texture: texture data exceeds lump.");
+			return hlFalse;
+		}
 
-		//
-		// Fill in headers.
-		//
+		Image.lpMipmaps[uiMipmapCount] = lpLump + uiOffset;
+		uiMipmapCount++;
+	}
 
-		pFileHeader->bfType = ('M' << 8) | 'B';
-		pFileHeader->bfSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
-		pFileHeader->bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4;
+	Image.uiWidth = uiWidth;
+	Image.uiHeight = uiHeight;
+	Image.uiMipmapCount = uiMipmapCount;
+	Image.uiPaletteSize = uiPaletteSize;
+	Image.lpPalette = lpPalette;
 
-		pInfoHeader->biSize = sizeof(BITMAPINFOHEADER);
-		pInfoHeader->biWidth = uiWidth;
-		pInfoHeader->biHeight = uiHeight;
-		pInfoHeader->biPlanes = 1;
-		pInfoHeader->biBitCount = 8;
-		pInfoHeader->biSizeImage = 0;
-		pInfoHeader->biClrUsed = uiPaletteSize;
-		pInfoHeader->biClrImportant = uiPaletteSize;
+	this->SetImageHandle(Image, 0, hlFalse);
 
-		//
-		// Fill in Palette data.
-		//
+	return hlTrue;
+}
 
-		for(hlUInt i = 0; i < uiPaletteSize; i++)
-		{
-			lpPaletteData[i * 4 + 0] = lpPalette[i * 3 + 2];
-			lpPaletteData[i * 4 + 1] = lpPalette[i * 3 + 1];
-			lpPaletteData[i * 4 + 2] = lpPalette[i * 3 + 0];
-			lpPaletteData[i * 4 + 3] = 0;
-		}
+//
+// ReleaseImage()
+// Releases an image returned by BorrowImage().  Images borrowed from another
+// package are left alone.
+//
+hlVoid CBSPFile::ReleaseImage(HLBorrowedImage &Image)
+{
+	ReleaseBorrowedImage(Image, HL_PACKAGE_BSP, this);
+}
 
-		//
-		// Fill in Index data.
-		//
+hlBool CBSPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
+{
+	if(pFile->GetID() < this->pTextureHeader->uiTextureCount)
+	{
+		hlUInt uiBufferSize;
+		const hlByte *lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Acquire(pFile->GetID(), uiBufferSize) : 0;
 
-		for(hlUInt i = 0; i < uiWidth; i++)
+		if(lpBuffer == 0)
 		{
-			for(hlUInt j = 0; j < uiHeight; j++)
+			hlUInt uiWidth, uiHeight, uiPaletteSize;
+			const hlByte *lpPalette, *lpPixels;
+
+			if(!this->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels))
 			{
-				lpPixelData[i + (uiHeight - 1 - j) * uiWidth] = lpPixels[i + j * uiWidth];
+				return hlFalse;
 			}
+
+			uiBufferSize = GetBitmapSize(uiWidth, uiHeight, uiPaletteSize);
+			hlByte *lpBitmap = new hlByte[uiBufferSize];
+
+			WriteBitmap(lpBitmap, uiWidth, uiHeight, lpPalette, uiPaletteSize, lpPixels);
+
+			lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Add(pFile->GetID(), lpBitmap, uiBufferSize) : lpBitmap;
 		}
 
-		pStream = new Streams::CMemoryStream(lpBuffer, uiBufferSize);
+		pStream = new Streams::CMemoryStream(static_cast<const hlVoid *>(lpBuffer), uiBufferSize);
 	}
 	else
 	{
@@ -343,7 +390,11 @@ hlVoid CBSPFile::ReleaseStreamInternal(Streams::IStream &Stream) const
 {
 	if(Stream.GetType() == HL_STREAM_MEMORY)
 	{
-		delete [](hlByte *)static_cast<Streams::CMemoryStream &>(Stream).GetBuffer();
+		const hlByte *lpBuffer = static_cast<const hlByte *>(static_cast<Streams::CMemoryStream &>(Stream).GetBuffer());
+		if(this->pStreamCache == 0 || !this->pStreamCache->Release(lpBuffer))
+		{
+			delete []lpBuffer;
+		}
 	}
 }
 
@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "Package.h"
+#include "BufferCache.h"
 
 #define HL_BSP_LUMP_COUNT 15
 
@@ -62,6 +63,8 @@ namespace HLLib
 		const BSPHeader *pHeader;
 		const BSPTextureHeader *pTextureHeader;
 
+		CBufferCache *pStreamCache;
+
 	public:
 		CBSPFile();
 		virtual ~CBSPFile();
@@ -70,6 +73,9 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		hlBool BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image);
+		hlVoid ReleaseImage(HLBorrowedImage &Image);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
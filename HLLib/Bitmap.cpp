@@ -0,0 +1,120 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "Bitmap.h"
+
+//
+// ExpandPalette()
+// Converts uiCount 8 bit palette indices to 24 bit RGB pixels.  The palette
+// is first widened to 4 bytes per color so each pixel is one load and one
+// 4 byte store; the store's extra byte is overwritten by the next pixel.
+// Indices past the palette give black.
+//
+hlVoid HLLib::ExpandPalette(const hlByte *lpPalette, hlUInt uiPaletteSize, const hlByte *lpIndices, hlUInt uiCount, hlByte *lpPixels)
+{
+	if(uiCount == 0)
+	{
+		return;
+	}
+
+	if(uiPaletteSize > 256)
+	{
+		uiPaletteSize = 256;
+	}
+
+	hlByte lpTable[256][4];
+	for(hlUInt i = 0; i < uiPaletteSize; i++)
+	{
+		lpTable[i][0] = lpPalette[i * 3 + 0];
+		lpTable[i][1] = lpPalette[i * 3 + 1];
+		lpTable[i][2] = lpPalette[i * 3 + 2];
+		lpTable[i][3] = 0;
+	}
+	memset(lpTable + uiPaletteSize, 0, (256 - uiPaletteSize) * 4);
+
+	const hlByte *lpEnd = lpIndices + uiCount - 1;
+	while(lpIndices < lpEnd)
+	{
+		memcpy(lpPixels, lpTable[*lpIndices++], 4);
+		lpPixels += 3;
+	}
+
+	// The last pixel mustn't write past the end.
+	memcpy(lpPixels, lpTable[*lpIndices], 3);
+}
+
+//
+// GetBitmapSize()
+// Returns the size of an 8 bit bitmap file.
+//
+hlUInt HLLib::GetBitmapSize(hlUInt uiWidth, hlUInt uiHeight, hlUInt uiPaletteSize)
+{
+	return sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
+}
+
+//
+// WriteBitmap()
+// Writes an 8 bit bitmap file of top down indices to lpBuffer, which must be
+// GetBitmapSize() bytes.  Bitmaps are stored bottom up, so the rows are
+// copied in reverse order.
+//
+hlVoid HLLib::WriteBitmap(hlByte *lpBuffer, hlUInt uiWidth, hlUInt uiHeight, const hlByte *lpPalette, hlUInt uiPaletteSize, const hlByte *lpIndices)
+{
+	//
+	// Allocate data.
+	//
+
+	BITMAPFILEHEADER *pFileHeader = (BITMAPFILEHEADER *)lpBuffer;
+	BITMAPINFOHEADER *pInfoHeader = (BITMAPINFOHEADER *)((hlByte *)pFileHeader + sizeof(BITMAPFILEHEADER));
+	hlByte *lpPaletteData = (hlByte *)pInfoHeader + sizeof(BITMAPINFOHEADER);
+	hlByte *lpPixelData = lpPaletteData + uiPaletteSize * 4;
+
+	memset(pFileHeader, 0, sizeof(BITMAPFILEHEADER));
+	memset(pInfoHeader, 0, sizeof(BITMAPINFOHEADER));
+
+	//
+	// Fill in headers.
+	//
+
+	pFileHeader->bfType = ('M' << 8) | 'B';
+	pFileHeader->bfSize = GetBitmapSize(uiWidth, uiHeight, uiPaletteSize);
+	pFileHeader->bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4;
+
+	pInfoHeader->biSize = sizeof(BITMAPINFOHEADER);
+	pInfoHeader->biWidth = uiWidth;
+	pInfoHeader->biHeight = uiHeight;
+	pInfoHeader->biPlanes = 1;
+	pInfoHeader->biBitCount = 8;
+	pInfoHeader->biSizeImage = 0;
+	pInfoHeader->biClrUsed = uiPaletteSize;
+	pInfoHeader->biClrImportant = uiPaletteSize;
+
+	//
+	// Fill in Palette data.
+	//
+
+	for(hlUInt i = 0; i < uiPaletteSize; i++)
+	{
+		lpPaletteData[i * 4 + 0] = lpPalette[i * 3 + 2];
+		lpPaletteData[i * 4 + 1] = lpPalette[i * 3 + 1];
+		lpPaletteData[i * 4 + 2] = lpPalette[i * 3 + 0];
+		lpPaletteData[i * 4 + 3] = 0;
+	}
+
+	//
+	// Fill in Index data.
+	//
+
+	for(hlUInt i = 0; i < uiHeight; i++)
+	{
+		memcpy(lpPixelData + (uiHeight - 1 - i) * uiWidth, lpIndices + i * uiWidth, uiWidth);
+	}
+}
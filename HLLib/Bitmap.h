@@ -0,0 +1,25 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include "stdafx.h"
+
+namespace HLLib
+{
+	hlVoid ExpandPalette(const hlByte *lpPalette, hlUInt uiPaletteSize, const hlByte *lpIndices, hlUInt uiCount, hlByte *lpPixels);
+
+	hlUInt GetBitmapSize(hlUInt uiWidth, hlUInt uiHeight, hlUInt uiPaletteSize);
+	hlVoid WriteBitmap(hlByte *lpBuffer, hlUInt uiWidth, hlUInt uiHeight, const hlByte *lpPalette, hlUInt uiPaletteSize, const hlByte *lpIndices);
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "BufferCache.h"
+
+using namespace HLLib;
+
+CBufferCache::CBufferCache(hlULongLong uiCapacity) : uiCapacity(uiCapacity), uiSize(0)
+{
+
+}
+
+CBufferCache::~CBufferCache()
+{
+	for(CBufferList::iterator i = this->Buffers.begin(); i != this->Buffers.end(); ++i)
+	{
+		delete [](*i).lpData;
+	}
+}
+
+//
+// Acquire()
+// Returns the buffer cached for file uiID, or 0 if there is none.  The
+// buffer is kept until it is released.
+//
+const hlByte *CBufferCache::Acquire(hlUInt uiID, hlUInt &uiBufferSize)
+{
+	Threading::CLock Lock(this->Mutex);
+
+	return this->Find(uiID, uiBufferSize);
+}
+
+//
+// Add()
+// Caches lpBuffer, allocated with new[], as file uiID's and returns the
+// buffer to use, acquired.  If another thread cached the file first its
+// buffer is returned and lpBuffer deleted.  Buffers larger than the capacity
+// aren't cached and stay the caller's, see Release().
+//
+const hlByte *CBufferCache::Add(hlUInt uiID, hlByte *lpBuffer, hlUInt uiBufferSize)
+{
+	Threading::CLock Lock(this->Mutex);
+
+	hlUInt uiCachedBufferSize;
+	const hlByte *lpCachedBuffer = this->Find(uiID, uiCachedBufferSize);
+	if(lpCachedBuffer != 0)
+	{
+		delete []lpBuffer;
+		return lpCachedBuffer;
+	}
+
+	if(static_cast<hlULongLong>(uiBufferSize) > this->uiCapacity)
+	{
+		return lpBuffer;
+	}
+
+	Buffer NewBuffer;
+	NewBuffer.uiID = uiID;
+	NewBuffer.lpData = lpBuffer;
+	NewBuffer.uiSize = uiBufferSize;
+	NewBuffer.uiReferences = 1;
+
+	this->Buffers.push_front(NewBuffer);
+	this->IDs[uiID] = this->Buffers.begin();
+	this->Data[lpBuffer] = this->Buffers.begin();
+	this->uiSize += static_cast<hlULongLong>(uiBufferSize);
+
+	this->Trim();
+
+	return lpBuffer;
+}
+
+//
+// Release()
+// Releases a buffer returned by Acquire() or Add().  Returns false if the
+// buffer isn't cached, in which case the caller deletes it.
+//
+hlBool CBufferCache::Release(const hlByte *lpBuffer)
+{
+	Threading::CLock Lock(this->Mutex);
+
+	CDataMap::iterator i = this->Data.find(lpBuffer);
+	if(i == this->Data.end())
+	{
+		return hlFalse;
+	}
+
+	(*i->second).uiReferences--;
+
+	this->Trim();
+
+	return hlTrue;
+}
+
+//
+// Find()
+// Acquires file uiID's buffer and moves it to the front.  The caller holds
+// the lock.
+//
+const hlByte *CBufferCache::Find(hlUInt uiID, hlUInt &uiBufferSize)
+{
+	CIDMap::iterator i = this->IDs.find(uiID);
+	if(i == this->IDs.end())
+	{
+		return 0;
+	}
+
+	// Splicing keeps the iterators in the maps valid.
+	this->Buffers.splice(this->Buffers.begin(), this->Buffers, i->second);
+
+	Buffer &Found = this->Buffers.front();
+
+	Found.uiReferences++;
+	uiBufferSize = Found.uiSize;
+
+	return Found.lpData;
+}
+
+//
+// Trim()
+// Deletes unused buffers, least recently used first, until the cache fits
+// in its capacity.
+//
+hlVoid CBufferCache::Trim()
+{
+	CBufferList::iterator i = this->Buffers.end();
+	while(this->uiSize > this->uiCapacity && i != this->Buffers.begin())
+	{
+		--i;
+
+		if((*i).uiReferences == 0)
+		{
+			this->uiSize -= static_cast<hlULongLong>((*i).uiSize);
+
+			this->IDs.erase((*i).uiID);
+			this->Data.erase((*i).lpData);
+
+			delete [](*i).lpData;
+			i = this->Buffers.erase(i);
+		}
+	}
+}
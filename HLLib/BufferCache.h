@@ -0,0 +1,70 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef BUFFERCACHE_H
+#define BUFFERCACHE_H
+
+#include "stdafx.h"
+#include "Thread.h"
+
+#include <list>
+#include <map>
+
+namespace HLLib
+{
+	//
+	// CBufferCache
+	// Keeps the buffers a package builds for its files' streams, keyed by file
+	// ID, so streams created for the same file share one buffer.  Buffers are
+	// counted by the streams using them; unused ones are kept, least recently
+	// used first out, as long as all buffers fit in the capacity.  Cached
+	// buffers must not be changed.
+	//
+	class CBufferCache
+	{
+	private:
+		struct Buffer
+		{
+			hlUInt uiID;
+			hlByte *lpData;
+			hlUInt uiSize;
+			hlUInt uiReferences;
+		};
+
+		// Most recently used first, indexed by file ID and by buffer.
+		typedef std::list<Buffer> CBufferList;
+		typedef std::map<hlUInt, CBufferList::iterator> CIDMap;
+		typedef std::map<const hlByte *, CBufferList::iterator> CDataMap;
+
+	private:
+		hlULongLong uiCapacity;
+		hlULongLong uiSize;
+
+		CBufferList Buffers;
+		CIDMap IDs;
+		CDataMap Data;
+		Threading::CMutex Mutex;
+
+	public:
+		CBufferCache(hlULongLong uiCapacity);
+		~CBufferCache();
+
+		const hlByte *Acquire(hlUInt uiID, hlUInt &uiBufferSize);
+		const hlByte *Add(hlUInt uiID, hlByte *lpBuffer, hlUInt uiBufferSize);
+		hlBool Release(const hlByte *lpBuffer);
+
+	private:
+		const hlByte *Find(hlUInt uiID, hlUInt &uiBufferSize);
+		hlVoid Trim();
+	};
+}
+
+#endif
@@ -183,26 +183,211 @@ const hlULong lpCRCTable[256] =
     0x2d02ef8dUL
 };
 
+//
+// CRCTables
+// Slicing-by-8 tables: lpTable[k][n] is the CRC of byte n followed by k zero
+// bytes, which lets CRC32() fold eight bytes per step instead of one.  Built
+// from lpCRCTable when the library is loaded.
+//
+struct CRCTables
+{
+	hlUInt lpTable[8][256];
+
+	CRCTables()
+	{
+		for(hlUInt i = 0; i < 256; i++)
+		{
+			this->lpTable[0][i] = static_cast<hlUInt>(lpCRCTable[i]);
+		}
+
+		for(hlUInt i = 0; i < 256; i++)
+		{
+			for(hlUInt j = 1; j < 8; j++)
+			{
+				this->lpTable[j][i] = (this->lpTable[j - 1][i] >> 8) ^ this->lpTable[0][this->lpTable[j - 1][i] & 0xff];
+			}
+		}
+	}
+};
+
+static const CRCTables SlicingTables;
+
 #define DOCRC1 uiCRC = lpCRCTable[((hlInt)uiCRC ^ (*lpBuffer++)) & 0xff] ^ (uiCRC >> 8)
-#define DOCRC8 DOCRC1; DOCRC1; DOCRC1; DOCRC1; DOCRC1; DOCRC1; DOCRC1; DOCRC1
 
 hlULong HLLib::CRC32(const hlByte *lpBuffer, hlUInt uiBufferSize, hlULong uiCRC)
 {
-    uiCRC = uiCRC ^ 0xffffffffUL;
+	uiCRC = uiCRC ^ 0xffffffffUL;
 
-    while(uiBufferSize >= 8)
+	// Align to four bytes for the word loads below.
+	while(uiBufferSize && (reinterpret_cast<hlUInt64>(lpBuffer) & 3) != 0)
 	{
-        DOCRC8;
-        uiBufferSize -= 8;
-    }
+		DOCRC1;
+		uiBufferSize--;
+	}
 
-    if(uiBufferSize)
+	const hlUInt (*lpTable)[256] = SlicingTables.lpTable;
+
+	hlUInt uiCRC32 = static_cast<hlUInt>(uiCRC);
+	while(uiBufferSize >= 8)
 	{
-		do
+		hlUInt uiLow = *reinterpret_cast<const hlUInt *>(lpBuffer) ^ uiCRC32;
+		hlUInt uiHigh = *reinterpret_cast<const hlUInt *>(lpBuffer + 4);
+
+		uiCRC32 = lpTable[7][uiLow & 0xff] ^ lpTable[6][(uiLow >> 8) & 0xff] ^ lpTable[5][(uiLow >> 16) & 0xff] ^ lpTable[4][uiLow >> 24]
+			^ lpTable[3][uiHigh & 0xff] ^ lpTable[2][(uiHigh >> 8) & 0xff] ^ lpTable[1][(uiHigh >> 16) & 0xff] ^ lpTable[0][uiHigh >> 24];
+
+		lpBuffer += 8;
+		uiBufferSize -= 8;
+	}
+	uiCRC = static_cast<hlULong>(uiCRC32);
+
+	while(uiBufferSize)
+	{
+		DOCRC1;
+		uiBufferSize--;
+	}
+
+	return uiCRC ^ 0xffffffffUL;
+}
+
+//
+// MD5 (RFC 1321).
+//
+
+static const hlUInt lpMD5Shifts[64] =
+{
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static const hlUInt lpMD5Constants[64] =
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static hlVoid MD5Transform(hlUInt lpState[4], const hlByte *lpBlock)
+{
+	hlUInt lpWords[16];
+	for(hlUInt i = 0; i < 16; i++)
+	{
+		lpWords[i] = static_cast<hlUInt>(lpBlock[i * 4]) | (static_cast<hlUInt>(lpBlock[i * 4 + 1]) << 8) | (static_cast<hlUInt>(lpBlock[i * 4 + 2]) << 16) | (static_cast<hlUInt>(lpBlock[i * 4 + 3]) << 24);
+	}
+
+	hlUInt a = lpState[0], b = lpState[1], c = lpState[2], d = lpState[3];
+
+	for(hlUInt i = 0; i < 64; i++)
+	{
+		hlUInt f, g;
+		if(i < 16)
+		{
+			f = (b & c) | (~b & d);
+			g = i;
+		}
+		else if(i < 32)
 		{
-			DOCRC1;
-		} while(--uiBufferSize);
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) & 15;
+		}
+		else if(i < 48)
+		{
+			f = b ^ c ^ d;
+			g = (3 * i + 5) & 15;
+		}
+		else
+		{
+			f = c ^ (b | ~d);
+			g = (7 * i) & 15;
+		}
+
+		hlUInt uiTemp = d;
+		d = c;
+		c = b;
+		f += a + lpMD5Constants[i] + lpWords[g];
+		b += (f << lpMD5Shifts[i]) | (f >> (32 - lpMD5Shifts[i]));
+		a = uiTemp;
 	}
 
-    return uiCRC ^ 0xffffffffUL;
+	lpState[0] += a;
+	lpState[1] += b;
+	lpState[2] += c;
+	lpState[3] += d;
+}
+
+hlVoid HLLib::MD5Initialize(MD5Context &Context)
+{
+	Context.lpState[0] = 0x67452301;
+	Context.lpState[1] = 0xefcdab89;
+	Context.lpState[2] = 0x98badcfe;
+	Context.lpState[3] = 0x10325476;
+	Context.uiLength = 0;
+}
+
+hlVoid HLLib::MD5Update(MD5Context &Context, const hlByte *lpBuffer, hlUInt uiBufferSize)
+{
+	hlUInt uiBuffered = static_cast<hlUInt>(Context.uiLength & 63);
+	Context.uiLength += uiBufferSize;
+
+	if(uiBuffered != 0)
+	{
+		hlUInt uiCopy = 64 - uiBuffered;
+		if(uiCopy > uiBufferSize)
+		{
+			uiCopy = uiBufferSize;
+		}
+
+		memcpy(Context.lpBuffer + uiBuffered, lpBuffer, uiCopy);
+		lpBuffer += uiCopy;
+		uiBufferSize -= uiCopy;
+
+		if(uiBuffered + uiCopy < 64)
+		{
+			return;
+		}
+
+		MD5Transform(Context.lpState, Context.lpBuffer);
+	}
+
+	while(uiBufferSize >= 64)
+	{
+		MD5Transform(Context.lpState, lpBuffer);
+		lpBuffer += 64;
+		uiBufferSize -= 64;
+	}
+
+	if(uiBufferSize != 0)
+	{
+		memcpy(Context.lpBuffer, lpBuffer, uiBufferSize);
+	}
+}
+
+hlVoid HLLib::MD5Finalize(MD5Context &Context, hlByte lpDigest[16])
+{
+	hlULongLong uiBits = Context.uiLength << 3;
+
+	hlByte lpPadding[72];
+	memset(lpPadding, 0, sizeof(lpPadding));
+	lpPadding[0] = 0x80;
+
+	hlUInt uiBuffered = static_cast<hlUInt>(Context.uiLength & 63);
+	hlUInt uiPadding = uiBuffered < 56 ? 56 - uiBuffered : 120 - uiBuffered;
+	for(hlUInt i = 0; i < 8; i++)
+	{
+		lpPadding[uiPadding + i] = static_cast<hlByte>(uiBits >> (i * 8));
+	}
+
+	MD5Update(Context, lpPadding, uiPadding + 8);
+
+	for(hlUInt i = 0; i < 16; i++)
+	{
+		lpDigest[i] = static_cast<hlByte>(Context.lpState[i / 4] >> ((i % 4) * 8));
+	}
 }
@@ -19,6 +19,17 @@ namespace HLLib
 {
 	hlULong Adler32(const hlByte *lpBuffer, hlUInt uiBufferSize, hlULong uiAdler32 = 0);
 	hlULong CRC32(const hlByte *lpBuffer, hlUInt uiBufferSize, hlULong uiCRC = 0);
+
+	struct MD5Context
+	{
+		hlUInt lpState[4];
+		hlULongLong uiLength;
+		hlByte lpBuffer[64];
+	};
+
+	hlVoid MD5Initialize(MD5Context &Context);
+	hlVoid MD5Update(MD5Context &Context, const hlByte *lpBuffer, hlUInt uiBufferSize);
+	hlVoid MD5Finalize(MD5Context &Context, hlByte lpDigest[16]);
 }
 
 #endif
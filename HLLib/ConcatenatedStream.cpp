@@ -0,0 +1,215 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "ConcatenatedStream.h"
+
+using namespace HLLib;
+using namespace HLLib::Streams;
+
+CConcatenatedStream::CConcatenatedStream(IStream *pFirst, IStream *pSecond) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), pFirst(pFirst), pSecond(pSecond), uiFirstLength(0), uiPointer(0), uiLength(0)
+{
+
+}
+
+CConcatenatedStream::~CConcatenatedStream()
+{
+	this->Close();
+
+	delete this->pFirst;
+	delete this->pSecond;
+}
+
+HLStreamType CConcatenatedStream::GetType() const
+{
+	return HL_STREAM_CONCATENATED;
+}
+
+const hlChar *CConcatenatedStream::GetFileName() const
+{
+	return "";
+}
+
+hlBool CConcatenatedStream::GetOpened() const
+{
+	return this->bOpened;
+}
+
+hlUInt CConcatenatedStream::GetMode() const
+{
+	return this->uiMode;
+}
+
+hlBool CConcatenatedStream::Open(hlUInt uiMode)
+{
+	this->Close();
+
+	if((uiMode & HL_MODE_READ) == 0 || (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessageFormated("Invalid open mode (%#.8x).", uiMode);
+		return hlFalse;
+	}
+
+	if(!this->pFirst->Open(uiMode))
+	{
+		return hlFalse;
+	}
+
+	if(!this->pSecond->Open(uiMode))
+	{
+		this->pFirst->Close();
+		return hlFalse;
+	}
+
+	this->uiFirstLength = this->pFirst->GetStreamSize();
+
+	this->uiPointer = 0;
+	this->uiLength = this->uiFirstLength + this->pSecond->GetStreamSize();
+
+	this->bOpened = hlTrue;
+	this->uiMode = uiMode;
+
+	return hlTrue;
+}
+
+hlVoid CConcatenatedStream::Close()
+{
+	if(this->bOpened)
+	{
+		this->pFirst->Close();
+		this->pSecond->Close();
+	}
+
+	this->bOpened = hlFalse;
+	this->uiMode = HL_MODE_INVALID;
+
+	this->uiFirstLength = 0;
+
+	this->uiPointer = 0;
+	this->uiLength = 0;
+}
+
+hlULongLong CConcatenatedStream::GetStreamSize() const
+{
+	return this->uiLength;
+}
+
+hlULongLong CConcatenatedStream::GetStreamPointer() const
+{
+	return this->uiPointer;
+}
+
+hlULongLong CConcatenatedStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	switch(eSeekMode)
+	{
+		case HL_SEEK_BEGINNING:
+			this->uiPointer = 0;
+			break;
+		case HL_SEEK_CURRENT:
+
+			break;
+		case HL_SEEK_END:
+			this->uiPointer = this->uiLength;
+			break;
+	}
+
+	hlLongLong iPointer = static_cast<hlLongLong>(this->uiPointer) + iOffset;
+
+	if(iPointer < 0)
+	{
+		iPointer = 0;
+	}
+	else if(iPointer > static_cast<hlLongLong>(this->uiLength))
+	{
+		iPointer = static_cast<hlLongLong>(this->uiLength);
+	}
+
+	this->uiPointer = static_cast<hlULongLong>(iPointer);
+
+	return this->uiPointer;
+}
+
+hlBool CConcatenatedStream::Read(hlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+hlUInt CConcatenatedStream::Read(hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	hlUInt uiTotalBytes = 0;
+	while(uiTotalBytes < uiBytes && this->uiPointer < this->uiLength)
+	{
+		// Pick the part the pointer is in; the parts only move when seeked.
+		IStream *pPart;
+		hlULongLong uiPartPointer, uiPartBytes;
+		if(this->uiPointer < this->uiFirstLength)
+		{
+			pPart = this->pFirst;
+			uiPartPointer = this->uiPointer;
+			uiPartBytes = this->uiFirstLength - uiPartPointer;
+		}
+		else
+		{
+			pPart = this->pSecond;
+			uiPartPointer = this->uiPointer - this->uiFirstLength;
+			uiPartBytes = this->uiLength - this->uiPointer;
+		}
+
+		if(pPart->GetStreamPointer() != uiPartPointer && pPart->Seek(static_cast<hlLongLong>(uiPartPointer), HL_SEEK_BEGINNING) != uiPartPointer)
+		{
+			break;
+		}
+
+		hlUInt uiReadBytes = uiBytes - uiTotalBytes;
+		if(static_cast<hlULongLong>(uiReadBytes) > uiPartBytes)
+		{
+			uiReadBytes = static_cast<hlUInt>(uiPartBytes);
+		}
+
+		uiReadBytes = pPart->Read(static_cast<hlByte *>(lpData) + uiTotalBytes, uiReadBytes);
+		if(uiReadBytes == 0)
+		{
+			break;
+		}
+
+		this->uiPointer += uiReadBytes;
+		uiTotalBytes += uiReadBytes;
+	}
+
+	return uiTotalBytes;
+}
+
+hlBool CConcatenatedStream::Write(hlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+hlUInt CConcatenatedStream::Write(const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	LastError.SetErrorMessage("Stream not in write mode.");
+	return 0;
+}
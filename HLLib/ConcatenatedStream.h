@@ -0,0 +1,66 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef CONCATENATEDSTREAM_H
+#define CONCATENATEDSTREAM_H
+
+#include "stdafx.h"
+#include "Stream.h"
+
+namespace HLLib
+{
+	namespace Streams
+	{
+		// Presents two streams back to back as one read only stream.  The
+		// parts are owned by the concatenated stream and deleted with it.
+		class HLLIB_API CConcatenatedStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			IStream *pFirst;
+			IStream *pSecond;
+
+			hlULongLong uiFirstLength;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+		public:
+			CConcatenatedStream(IStream *pFirst, IStream *pSecond);
+			~CConcatenatedStream();
+
+			virtual HLStreamType GetType() const;
+
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+		};
+	}
+}
+
+#endif
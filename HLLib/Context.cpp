@@ -0,0 +1,162 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "Context.h"
+#include "Package.h"
+
+#ifdef _MSC_VER
+#	define HL_THREAD_LOCAL __declspec(thread)
+#else
+#	define HL_THREAD_LOCAL __thread
+#endif
+
+using namespace HLLib;
+
+namespace HLLib
+{
+	static CContext DefaultContext;
+	static HL_THREAD_LOCAL CContext *pCurrentContext = 0;
+}
+
+CContext::CContext() : pOpenProc(0), pCloseProc(0), pReadProc(0), pWriteProc(0), pSeekProc(0), pSeekExProc(0), pTellProc(0), pTellExProc(0), pSizeProc(0), pSizeExProc(0), pExtractItemStartProc(0), pExtractItemEndProc(0), pExtractFileProgressProc(0), pValidateFileProgressProc(0), pDefragmentProgressProc(0), pDefragmentProgressExProc(0), pPackage(0), pPackageVector(new CPackageVector()), bOverwriteFiles(hlTrue), bReadEncrypted(hlTrue), bForceDefragment(hlFalse), bReadAhead(hlTrue), eSkipUnchangedFiles(HL_SKIP_NONE), uiExtractThreadCount(0), uiArchiveHandleLimit(HL_DEFAULT_ARCHIVE_HANDLE_LIMIT), uiStreamCacheSize(HL_DEFAULT_STREAM_CACHE_SIZE)
+{
+
+}
+
+CContext::~CContext()
+{
+	this->DeletePackages();
+
+	delete this->pPackageVector;
+}
+
+//
+// CopyOptions()
+// Copies every option of Context, but none of its callbacks, packages or
+// error.  Worker threads use it to read and write the way the context that
+// started them would.
+//
+hlVoid CContext::CopyOptions(const CContext &Context)
+{
+	this->bOverwriteFiles = Context.bOverwriteFiles;
+	this->bReadEncrypted = Context.bReadEncrypted;
+	this->bForceDefragment = Context.bForceDefragment;
+	this->bReadAhead = Context.bReadAhead;
+	this->eSkipUnchangedFiles = Context.eSkipUnchangedFiles;
+	this->uiExtractThreadCount = Context.uiExtractThreadCount;
+	this->uiArchiveHandleLimit = Context.uiArchiveHandleLimit;
+	this->uiStreamCacheSize = Context.uiStreamCacheSize;
+}
+
+CPackage *CContext::GetPackage(hlUInt uiPackage) const
+{
+	if(uiPackage >= this->pPackageVector->size())
+	{
+		return 0;
+	}
+
+	return (*this->pPackageVector)[uiPackage];
+}
+
+hlUInt CContext::GetPackageID(const CPackage *pPackage) const
+{
+	if(pPackage != 0)
+	{
+		for(hlUInt i = 0; i < static_cast<hlUInt>(this->pPackageVector->size()); i++)
+		{
+			if((*this->pPackageVector)[i] == pPackage)
+			{
+				return i;
+			}
+		}
+	}
+
+	return HL_ID_INVALID;
+}
+
+//
+// AddPackage()
+// Takes ownership of pPackage and returns its ID, reusing the first free slot.
+//
+hlUInt CContext::AddPackage(CPackage *pPackage)
+{
+	for(hlUInt i = 0; i < static_cast<hlUInt>(this->pPackageVector->size()); i++)
+	{
+		if((*this->pPackageVector)[i] == 0)
+		{
+			(*this->pPackageVector)[i] = pPackage;
+			return i;
+		}
+	}
+
+	this->pPackageVector->push_back(pPackage);
+
+	return static_cast<hlUInt>(this->pPackageVector->size()) - 1;
+}
+
+hlVoid CContext::DeletePackage(hlUInt uiPackage)
+{
+	CPackage *pPackage = this->GetPackage(uiPackage);
+
+	if(pPackage == 0)
+	{
+		return;
+	}
+
+	if(pPackage == this->pPackage)
+	{
+		this->pPackage = 0;
+	}
+
+	delete pPackage;
+	(*this->pPackageVector)[uiPackage] = 0;
+}
+
+hlVoid CContext::DeletePackages()
+{
+	this->pPackage = 0;
+
+	for(hlUInt i = 0; i < static_cast<hlUInt>(this->pPackageVector->size()); i++)
+	{
+		delete (*this->pPackageVector)[i];
+	}
+
+	this->pPackageVector->clear();
+}
+
+CContextScope::CContextScope(CContext &Context) : pPrevious(pCurrentContext)
+{
+	pCurrentContext = &Context;
+}
+
+CContextScope::~CContextScope()
+{
+	pCurrentContext = this->pPrevious;
+}
+
+CContext &HLLib::GetDefaultContext()
+{
+	return DefaultContext;
+}
+
+//
+// GetContext()
+// Returns the calling thread's current context, the default context (used by
+// the legacy API) if none is set.  The default context is shared by every
+// thread, so legacy callers can bind a package on one thread and use it on
+// another; threads working in their own contexts must use the hlContext*
+// calls for anything that can fail, or they race on its last error.
+//
+CContext &HLLib::GetContext()
+{
+	return pCurrentContext != 0 ? *pCurrentContext : DefaultContext;
+}
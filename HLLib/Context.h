@@ -0,0 +1,107 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "stdafx.h"
+#include "Error.h"
+
+namespace HLLib
+{
+	class CPackage;
+
+	typedef std::vector<CPackage *> CPackageVector;
+
+	//
+	// CContext
+	// Everything the C API used to keep in process globals: options, callbacks,
+	// packages and the last error.  A context may be used by one thread at a time;
+	// independent contexts may be used concurrently.
+	//
+	class CContext
+	{
+	public:
+		CError Error;
+
+		POpenProc pOpenProc;
+		PCloseProc pCloseProc;
+		PReadProc pReadProc;
+		PWriteProc pWriteProc;
+		PSeekProc pSeekProc;
+		PSeekExProc pSeekExProc;
+		PTellProc pTellProc;
+		PTellExProc pTellExProc;
+		PSizeProc pSizeProc;
+		PSizeExProc pSizeExProc;
+
+		PExtractItemStartProc pExtractItemStartProc;
+		PExtractItemEndProc pExtractItemEndProc;
+		PExtractFileProgressProc pExtractFileProgressProc;
+		PValidateFileProgressProc pValidateFileProgressProc;
+		PDefragmentProgressProc pDefragmentProgressProc;
+		PDefragmentProgressExProc pDefragmentProgressExProc;
+
+		CPackage *pPackage;
+		CPackageVector *pPackageVector;
+
+		// Options, keep CopyOptions() up to date.
+		hlBool bOverwriteFiles;
+		hlBool bReadEncrypted;
+		hlBool bForceDefragment;
+		hlBool bReadAhead;
+		HLSkipMode eSkipUnchangedFiles;
+		hlUInt uiExtractThreadCount;
+		hlUInt uiArchiveHandleLimit;
+		hlUInt uiStreamCacheSize;
+
+	public:
+		CContext();
+		~CContext();
+
+		hlVoid CopyOptions(const CContext &Context);
+
+		CPackage *GetPackage(hlUInt uiPackage) const;
+		hlUInt GetPackageID(const CPackage *pPackage) const;
+
+		hlUInt AddPackage(CPackage *pPackage);
+		hlVoid DeletePackage(hlUInt uiPackage);
+		hlVoid DeletePackages();
+
+	private:
+		CContext(const CContext &);
+		CContext &operator=(const CContext &);
+	};
+
+	//
+	// CContextScope
+	// Makes a context the calling thread's current context for the lifetime of
+	// the scope.
+	//
+	class CContextScope
+	{
+	private:
+		CContext *pPrevious;
+
+	public:
+		CContextScope(CContext &Context);
+		~CContextScope();
+
+	private:
+		CContextScope(const CContextScope &);
+		CContextScope &operator=(const CContextScope &);
+	};
+
+	CContext &GetDefaultContext();
+	CContext &GetContext();
+}
+
+#endif
@@ -81,6 +81,30 @@ hlBool CDirectoryFile::GetSizeOnDisk(hlUInt &uiSize) const
 	return this->GetPackage()->GetFileSizeOnDisk(this, uiSize);
 }
 
+hlULongLong CDirectoryFile::GetSizeEx() const
+{
+	hlULongLong uiSize = 0;
+	this->GetPackage()->GetFileSizeEx(this, uiSize);
+	return uiSize;
+}
+
+hlBool CDirectoryFile::GetSizeEx(hlULongLong &uiSize) const
+{
+	return this->GetPackage()->GetFileSizeEx(this, uiSize);
+}
+
+hlULongLong CDirectoryFile::GetSizeOnDiskEx() const
+{
+	hlULongLong uiSize = 0;
+	this->GetPackage()->GetFileSizeOnDiskEx(this, uiSize);
+	return uiSize;
+}
+
+hlBool CDirectoryFile::GetSizeOnDiskEx(hlULongLong &uiSize) const
+{
+	return this->GetPackage()->GetFileSizeOnDiskEx(this, uiSize);
+}
+
 hlBool CDirectoryFile::CreateStream(Streams::IStream *&pStream) const
 {
 	return this->GetPackage()->CreateStream(this, pStream);
@@ -91,6 +115,86 @@ hlVoid CDirectoryFile::ReleaseStream(Streams::IStream *pStream) const
 	return this->GetPackage()->ReleaseStream(pStream);
 }
 
+//
+// GetUnchanged()
+// Returns true if the file at lpFileName matches this file.  HL_SKIP_SIZE only
+// compares sizes, HL_SKIP_CHECKSUM also checks the existing file's contents
+// against the package checksums (or the package data if it has none).
+//
+hlBool CDirectoryFile::GetUnchanged(const hlChar *lpFileName, HLSkipMode eSkipMode) const
+{
+	if(eSkipMode == HL_SKIP_NONE)
+	{
+		return hlFalse;
+	}
+
+	hlULongLong uiFileSize = 0;
+	if(!GetFileSize(lpFileName, uiFileSize) || uiFileSize != this->GetSizeEx())
+	{
+		return hlFalse;
+	}
+
+	if(eSkipMode == HL_SKIP_SIZE)
+	{
+		return hlTrue;
+	}
+
+	hlBool bUnchanged = hlFalse;
+
+	Streams::CFileStream Existing = Streams::CFileStream(lpFileName);
+
+	if(Existing.Open(HL_MODE_READ))
+	{
+		HLValidation eValidation = HL_VALIDATES_ERROR;
+		if(this->GetPackage()->GetFileValidation(this, Existing, eValidation))
+		{
+			if(eValidation == HL_VALIDATES_ASSUMED_OK)
+			{
+				// No checksum, compare against the package data.
+				Streams::IStream *pInput = 0;
+
+				if(this->GetPackage()->CreateStream(this, pInput))
+				{
+					if(pInput->Open(HL_MODE_READ))
+					{
+						hlByte *lpBuffer = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE * 2];
+						hlByte *lpExisting = lpBuffer + HL_DEFAULT_COPY_BUFFER_SIZE;
+
+						Existing.Seek(0, HL_SEEK_BEGINNING);
+
+						bUnchanged = hlTrue;
+						while(bUnchanged)
+						{
+							hlUInt uiBytes = pInput->Read(lpBuffer, HL_DEFAULT_COPY_BUFFER_SIZE);
+
+							if(uiBytes == 0)
+							{
+								break;
+							}
+
+							bUnchanged = Existing.Read(lpExisting, uiBytes) == uiBytes && memcmp(lpBuffer, lpExisting, uiBytes) == 0;
+						}
+
+						delete []lpBuffer;
+
+						pInput->Close();
+					}
+
+					this->GetPackage()->ReleaseStream(pInput);
+				}
+			}
+			else
+			{
+				bUnchanged = eValidation == HL_VALIDATES_OK;
+			}
+		}
+
+		Existing.Close();
+	}
+
+	return bUnchanged;
+}
+
 hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 {
 	hlExtractItemStart(this);
@@ -115,8 +219,14 @@ hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 
 	FixupIllegalCharacters(lpFileName);
 
+	const CContext &Context = this->GetPackage()->GetContext();
+
 	hlBool bResult;
-	if(!bOverwriteFiles && GetFileExists(lpFileName))
+	if(!Context.bOverwriteFiles && GetFileExists(lpFileName))
+	{
+		bResult = hlTrue;
+	}
+	else if(Context.eSkipUnchangedFiles != HL_SKIP_NONE && this->GetUnchanged(lpFileName, Context.eSkipUnchangedFiles))
 	{
 		bResult = hlTrue;
 	}
@@ -130,11 +240,12 @@ hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 		{
 			if(pInput->Open(HL_MODE_READ))
 			{
-				Streams::CFileStream Output = Streams::CFileStream(lpFileName);
+				Streams::CReadAheadStream Input(*pInput, Context.bReadAhead);
+				Streams::CFileStream Output = Streams::CFileStream(lpFileName, Context.bOverwriteFiles);
 
-				if(Output.Open(HL_MODE_WRITE | HL_MODE_CREATE))
+				if(Input.Open(HL_MODE_READ) && Output.Open(HL_MODE_WRITE | HL_MODE_CREATE))
 				{
-					hlUInt uiTotalBytes = 0, uiFileBytes = this->GetSize();
+					hlULongLong uiTotalBytes = 0, uiFileBytes = this->GetSizeEx();
 					hlByte lpBuffer[HL_DEFAULT_COPY_BUFFER_SIZE];
 
 					hlBool bCancel = hlFalse;
@@ -145,13 +256,14 @@ hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 						if(bCancel)
 						{
 							LastError.SetErrorMessage("Canceled by user.");
+							break;
 						}
 
-						hlUInt uiBytes = pInput->Read(lpBuffer, sizeof(lpBuffer));
+						hlUInt uiBytes = Input.Read(lpBuffer, sizeof(lpBuffer));
 
 						if(uiBytes == 0)
 						{
-							bResult = uiTotalBytes == pInput->GetStreamSize();
+							bResult = uiTotalBytes == Input.GetStreamSize();
 							break;
 						}
 
@@ -160,7 +272,7 @@ hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 							break;
 						}
 
-						uiTotalBytes += uiBytes;
+						uiTotalBytes += static_cast<hlULongLong>(uiBytes);
 
 						hlExtractFileProgress(this, uiTotalBytes, uiFileBytes, &bCancel);
 					}
@@ -168,6 +280,8 @@ hlBool CDirectoryFile::Extract(const hlChar *lpPath) const
 					Output.Close();
 				}
 
+				Input.Close();
+
 				pInput->Close();
 			}
 
@@ -33,10 +33,16 @@ namespace HLLib
 		hlBool GetSize(hlUInt &uiSize) const;
 		hlUInt GetSizeOnDisk() const;
 		hlBool GetSizeOnDisk(hlUInt &uiSize) const;
+		hlULongLong GetSizeEx() const;
+		hlBool GetSizeEx(hlULongLong &uiSize) const;
+		hlULongLong GetSizeOnDiskEx() const;
+		hlBool GetSizeOnDiskEx(hlULongLong &uiSize) const;
 
 		hlBool CreateStream(Streams::IStream *&pStream) const;
 		hlVoid ReleaseStream(Streams::IStream *pStream) const;
 
+		hlBool GetUnchanged(const hlChar *lpFileName, HLSkipMode eSkipMode) const;
+
 		virtual hlBool Extract(const hlChar *lpPath) const;
 	};
 }
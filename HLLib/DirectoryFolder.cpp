@@ -12,6 +12,9 @@
 #include "DirectoryFile.h"
 #include "DirectoryFolder.h"
 #include "HLLib.h"
+#include "Context.h"
+#include "Package.h"
+#include "Thread.h"
 #include "Utility.h"
 
 #include <algorithm>
@@ -539,7 +542,7 @@ hlULongLong CDirectoryFolder::GetSizeEx(hlBool bRecurse) const
 			}
 			break;
 		case HL_ITEM_FILE:
-			uiSize += static_cast<hlULongLong>(static_cast<const CDirectoryFile *>(pItem)->GetSize());
+			uiSize += static_cast<const CDirectoryFile *>(pItem)->GetSizeEx();
 			break;
 		}
 	}
@@ -587,7 +590,7 @@ hlULongLong CDirectoryFolder::GetSizeOnDiskEx(hlBool bRecurse) const
 			}
 			break;
 		case HL_ITEM_FILE:
-			uiSize += static_cast<hlULongLong>(static_cast<const CDirectoryFile *>(pItem)->GetSizeOnDisk());
+			uiSize += static_cast<const CDirectoryFile *>(pItem)->GetSizeOnDiskEx();
 			break;
 		}
 	}
@@ -641,12 +644,41 @@ hlUInt CDirectoryFolder::GetFileCount(hlBool bRecurse) const
 	return uiCount;
 }
  
-hlBool CDirectoryFolder::Extract(const hlChar *lpPath) const
+//
+// Concurrent extraction.
+// Folders are created and their files queued up front, in the order a serial
+// extraction would visit them.  Worker threads then extract the queued files,
+// each under a private context (no callbacks, no shared last error) and with
+// its own stream, while the calling thread walks the queue in order, waits for
+// each file and raises the callbacks, so callers see the same sequence of
+// events as a serial extraction.
+//
+
+struct ExtractQueueItem
 {
-	hlExtractItemStart(this);
+	const CDirectoryItem *pItem;
+	hlChar *lpPath;
+	hlBool bResult;
+	CError *pError;
+	Threading::CSemaphore *pDone;
+};
+
+typedef std::vector<ExtractQueueItem> CExtractQueue;
+
+struct ExtractPool
+{
+	CExtractQueue *pQueue;
+	const CContext *pContext;
 
-	hlChar *lpName = new hlChar[strlen(this->GetName()) + 1];
-	strcpy(lpName, this->GetName());
+	Threading::CMutex Mutex;
+	hlUInt uiNext;
+	hlBool bCancel;
+};
+
+static hlChar *GetExtractFolderName(const CDirectoryFolder *pFolder, const hlChar *lpPath)
+{
+	hlChar *lpName = new hlChar[strlen(pFolder->GetName()) + 1];
+	strcpy(lpName, pFolder->GetName());
 	RemoveIllegalCharacters(lpName);
 
 	hlChar *lpFolderName;
@@ -665,6 +697,270 @@ hlBool CDirectoryFolder::Extract(const hlChar *lpPath) const
 
 	FixupIllegalCharacters(lpFolderName);
 
+	delete []lpName;
+
+	return lpFolderName;
+}
+
+//
+// QueueExtract()
+// Creates pFolder under lpPath and queues it and everything below it.  The
+// contents of folders that can't be created aren't queued.
+//
+static hlVoid QueueExtract(const CDirectoryFolder *pFolder, const hlChar *lpPath, CExtractQueue &Queue)
+{
+	ExtractQueueItem Folder;
+	Folder.pItem = pFolder;
+	Folder.lpPath = GetExtractFolderName(pFolder, lpPath);
+	Folder.bResult = hlTrue;
+	Folder.pError = 0;
+	Folder.pDone = 0;
+
+	if(!CreateFolder(Folder.lpPath))
+	{
+		LastError.SetSystemErrorMessage("CreateDirectory() failed.");
+
+		Folder.bResult = hlFalse;
+		Folder.pError = new CError(LastError);
+	}
+
+	Queue.push_back(Folder);
+
+	if(!Folder.bResult)
+	{
+		return;
+	}
+
+	for(hlUInt i = 0; i < pFolder->GetCount(); i++)
+	{
+		const CDirectoryItem *pItem = pFolder->GetItem(i);
+		if(pItem->GetType() == HL_ITEM_FOLDER)
+		{
+			QueueExtract(static_cast<const CDirectoryFolder *>(pItem), Folder.lpPath, Queue);
+		}
+		else
+		{
+			ExtractQueueItem File;
+			File.pItem = pItem;
+			File.lpPath = new hlChar[strlen(Folder.lpPath) + 1];
+			strcpy(File.lpPath, Folder.lpPath);
+			File.bResult = hlFalse;
+			File.pError = 0;
+			File.pDone = new Threading::CSemaphore(0);
+
+			Queue.push_back(File);
+		}
+	}
+}
+
+static hlVoid ExtractWorker(hlVoid *pUserData)
+{
+	ExtractPool &Pool = *static_cast<ExtractPool *>(pUserData);
+
+	CContext Context;
+	Context.CopyOptions(*Pool.pContext);
+
+	CContextScope ContextScope(Context);
+
+	while(hlTrue)
+	{
+		ExtractQueueItem *pFile = 0;
+		hlBool bCancel;
+		{
+			Threading::CLock Lock(Pool.Mutex);
+
+			CExtractQueue &Queue = *Pool.pQueue;
+			while(Pool.uiNext < Queue.size() && Queue[Pool.uiNext].pDone == 0)
+			{
+				Pool.uiNext++;
+			}
+
+			if(Pool.uiNext < Queue.size())
+			{
+				pFile = &Queue[Pool.uiNext++];
+			}
+
+			bCancel = Pool.bCancel;
+		}
+
+		if(pFile == 0)
+		{
+			break;
+		}
+
+		if(bCancel)
+		{
+			LastError.SetErrorMessage("Canceled by user.");
+		}
+		else
+		{
+			pFile->bResult = pFile->pItem->Extract(pFile->lpPath);
+		}
+
+		if(!pFile->bResult)
+		{
+			pFile->pError = new CError(LastError);
+		}
+
+		pFile->pDone->Post();
+	}
+}
+
+//
+// FinishExtract()
+// Raises the callbacks for the queued item at uiIndex (and everything below
+// it), waiting for files to be extracted.
+//
+static hlBool FinishExtract(ExtractPool &Pool, hlUInt &uiIndex)
+{
+	ExtractQueueItem &Item = (*Pool.pQueue)[uiIndex++];
+
+	hlExtractItemStart(Item.pItem);
+
+	hlBool bResult;
+	if(Item.pItem->GetType() == HL_ITEM_FOLDER)
+	{
+		bResult = Item.bResult;
+
+		if(bResult)
+		{
+			const CDirectoryFolder *pFolder = static_cast<const CDirectoryFolder *>(Item.pItem);
+			for(hlUInt i = 0; i < pFolder->GetCount(); i++)
+			{
+				bResult &= FinishExtract(Pool, uiIndex);
+			}
+		}
+		else
+		{
+			LastError = *Item.pError;
+		}
+	}
+	else
+	{
+		Item.pDone->Wait();
+
+		bResult = Item.bResult;
+
+		if(bResult)
+		{
+			hlULongLong uiFileBytes = static_cast<const CDirectoryFile *>(Item.pItem)->GetSizeEx();
+
+			hlBool bCancel = hlFalse;
+			hlExtractFileProgress(Item.pItem, 0, uiFileBytes, &bCancel);
+			if(!bCancel)
+			{
+				hlExtractFileProgress(Item.pItem, uiFileBytes, uiFileBytes, &bCancel);
+			}
+
+			if(bCancel)
+			{
+				// Fail the file like a serial extraction does, even though it was already written.
+				LastError.SetErrorMessage("Canceled by user.");
+				bResult = hlFalse;
+
+				Threading::CLock Lock(Pool.Mutex);
+				Pool.bCancel = hlTrue;
+			}
+		}
+		else
+		{
+			LastError = *Item.pError;
+		}
+	}
+
+	hlExtractItemEnd(Item.pItem, bResult);
+
+	return bResult;
+}
+
+//
+// GetExtractThreadCount()
+// Returns the number of threads to extract pFolder with, 1 for a serial
+// extraction.
+//
+static hlUInt GetExtractThreadCount(const CDirectoryFolder *pFolder)
+{
+	const CPackage *pPackage = pFolder->GetPackage();
+	if(pPackage == 0 || !pPackage->GetConcurrentExtraction())
+	{
+		return 1;
+	}
+
+	hlUInt uiThreadCount = pPackage->GetContext().uiExtractThreadCount;
+	if(uiThreadCount == 0)
+	{
+		uiThreadCount = Threading::CThread::GetProcessorCount();
+	}
+
+	hlUInt uiFileCount = pFolder->GetFileCount(hlTrue);
+	if(uiThreadCount > uiFileCount)
+	{
+		uiThreadCount = uiFileCount;
+	}
+
+	return uiThreadCount > 1 ? uiThreadCount : 1;
+}
+
+static hlBool ExtractConcurrent(const CDirectoryFolder *pFolder, const hlChar *lpPath, hlUInt uiThreadCount)
+{
+	CExtractQueue Queue;
+	QueueExtract(pFolder, lpPath, Queue);
+
+	ExtractPool Pool;
+	Pool.pQueue = &Queue;
+	Pool.pContext = &pFolder->GetPackage()->GetContext();
+	Pool.uiNext = 0;
+	Pool.bCancel = hlFalse;
+
+	Threading::CThread *lpThreads = new Threading::CThread[uiThreadCount];
+
+	hlUInt uiStarted = 0;
+	for(hlUInt i = 0; i < uiThreadCount; i++)
+	{
+		if(lpThreads[i].Start(ExtractWorker, &Pool))
+		{
+			uiStarted++;
+		}
+	}
+
+	if(uiStarted == 0)
+	{
+		// Couldn't start any workers, do the work here instead.
+		ExtractWorker(&Pool);
+	}
+
+	hlUInt uiIndex = 0;
+	hlBool bResult = FinishExtract(Pool, uiIndex);
+
+	for(hlUInt i = 0; i < uiThreadCount; i++)
+	{
+		lpThreads[i].Join();
+	}
+
+	delete []lpThreads;
+
+	for(CExtractQueue::iterator i = Queue.begin(); i != Queue.end(); ++i)
+	{
+		delete []i->lpPath;
+		delete i->pError;
+		delete i->pDone;
+	}
+
+	return bResult;
+}
+
+hlBool CDirectoryFolder::Extract(const hlChar *lpPath) const
+{
+	hlUInt uiThreadCount = GetExtractThreadCount(this);
+	if(uiThreadCount > 1)
+	{
+		return ExtractConcurrent(this, lpPath, uiThreadCount);
+	}
+
+	hlExtractItemStart(this);
+
+	hlChar *lpFolderName = GetExtractFolderName(this, lpPath);
+
 	hlBool bResult;
 	if(!CreateFolder(lpFolderName))
 	{
@@ -683,7 +979,6 @@ hlBool CDirectoryFolder::Extract(const hlChar *lpPath) const
 	}
 
 	delete []lpFolderName;
-	delete []lpName;
 
 	hlExtractItemEnd(this, bResult);
 
@@ -0,0 +1,240 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "DirectoryTreeBuilder.h"
+
+using namespace HLLib;
+
+#define HL_TREE_BUILDER_INITIAL_BUCKETS 256
+
+static inline hlBool IsPathSeparator(hlChar cChar)
+{
+	return cChar == '/' || cChar == '\\';
+}
+
+CDirectoryTreeBuilder::CDirectoryTreeBuilder(CDirectoryFolder *pRoot) : pRoot(pRoot), Buckets(HL_TREE_BUILDER_INITIAL_BUCKETS, HL_ID_INVALID), lpLastPath(0), uiLastPathSize(0), uiLastPathLength(0), lpName(0), uiNameSize(0)
+{
+	// Index the folders the root already has; like GetItem(), the first of
+	// several folders with the same name wins.
+	for(hlUInt i = 0; i < pRoot->GetCount(); i++)
+	{
+		CDirectoryItem *pItem = pRoot->GetItem(i);
+		if(pItem->GetType() == HL_ITEM_FOLDER)
+		{
+			hlUInt uiLength = static_cast<hlUInt>(strlen(pItem->GetName()));
+			hlUInt uiHash = Hash(pRoot, pItem->GetName(), uiLength);
+			if(this->FindSubFolder(pRoot, pItem->GetName(), uiLength, uiHash) == 0)
+			{
+				this->AddFolderNode(static_cast<CDirectoryFolder *>(pItem), uiHash);
+			}
+		}
+	}
+}
+
+CDirectoryTreeBuilder::~CDirectoryTreeBuilder()
+{
+	delete []this->lpLastPath;
+	delete []this->lpName;
+}
+
+//
+// GetFolder()
+// Returns the folder lpPath, creating it and its parents as needed.  Like
+// strtok(), empty path components are skipped.
+//
+CDirectoryFolder *CDirectoryTreeBuilder::GetFolder(const hlChar *lpPath)
+{
+	return this->GetFolder(lpPath, static_cast<hlUInt>(strlen(lpPath)));
+}
+
+//
+// AddFile()
+// Adds a file at lpPath, the last path component being the file name.
+//
+CDirectoryFile *CDirectoryTreeBuilder::AddFile(const hlChar *lpPath, hlUInt uiID, hlVoid *lpData)
+{
+	hlUInt uiLength = static_cast<hlUInt>(strlen(lpPath));
+	while(uiLength > 0 && IsPathSeparator(lpPath[uiLength - 1]))
+	{
+		uiLength--;
+	}
+
+	hlUInt uiNameStart = uiLength;
+	while(uiNameStart > 0 && !IsPathSeparator(lpPath[uiNameStart - 1]))
+	{
+		uiNameStart--;
+	}
+
+	CDirectoryFolder *pFolder = this->GetFolder(lpPath, uiNameStart);
+
+	return pFolder->AddFile(this->GetName(lpPath + uiNameStart, uiLength - uiNameStart), uiID, lpData);
+}
+
+CDirectoryFolder *CDirectoryTreeBuilder::GetFolder(const hlChar *lpPath, hlUInt uiLength)
+{
+	// Reuse the folders of the previous path up to where the paths differ.
+	hlUInt uiCommon = 0;
+	while(uiCommon < uiLength && uiCommon < this->uiLastPathLength && lpPath[uiCommon] == this->lpLastPath[uiCommon])
+	{
+		uiCommon++;
+	}
+
+	CDirectoryFolder *pFolder = this->pRoot;
+	hlUInt uiOffset = 0;
+	hlUInt uiComponents = 0;
+	while(uiComponents < static_cast<hlUInt>(this->LastPathComponents.size()))
+	{
+		const PathComponent &Component = this->LastPathComponents[uiComponents];
+		if(Component.uiEnd > uiCommon || (Component.uiEnd < uiLength && !IsPathSeparator(lpPath[Component.uiEnd])))
+		{
+			break;
+		}
+
+		pFolder = Component.pFolder;
+		uiOffset = Component.uiEnd;
+		uiComponents++;
+	}
+	this->LastPathComponents.resize(uiComponents);
+
+	// Resolve the rest.
+	while(uiOffset < uiLength)
+	{
+		while(uiOffset < uiLength && IsPathSeparator(lpPath[uiOffset]))
+		{
+			uiOffset++;
+		}
+
+		hlUInt uiStart = uiOffset;
+		while(uiOffset < uiLength && !IsPathSeparator(lpPath[uiOffset]))
+		{
+			uiOffset++;
+		}
+
+		if(uiOffset == uiStart)
+		{
+			break;
+		}
+
+		pFolder = this->GetSubFolder(pFolder, lpPath + uiStart, uiOffset - uiStart);
+
+		PathComponent Component;
+		Component.uiEnd = uiOffset;
+		Component.pFolder = pFolder;
+		this->LastPathComponents.push_back(Component);
+	}
+
+	if(uiLength > this->uiLastPathSize)
+	{
+		delete []this->lpLastPath;
+		this->uiLastPathSize = uiLength * 2;
+		this->lpLastPath = new hlChar[this->uiLastPathSize];
+	}
+	memcpy(this->lpLastPath, lpPath, uiLength);
+	this->uiLastPathLength = uiLength;
+
+	return pFolder;
+}
+
+CDirectoryFolder *CDirectoryTreeBuilder::GetSubFolder(CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength)
+{
+	hlUInt uiHash = Hash(pParent, lpName, uiLength);
+
+	CDirectoryFolder *pFolder = this->FindSubFolder(pParent, lpName, uiLength, uiHash);
+	if(pFolder == 0)
+	{
+		pFolder = pParent->AddFolder(this->GetName(lpName, uiLength));
+		this->AddFolderNode(pFolder, uiHash);
+	}
+
+	return pFolder;
+}
+
+CDirectoryFolder *CDirectoryTreeBuilder::FindSubFolder(const CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength, hlUInt uiHash) const
+{
+	hlUInt uiNode = this->Buckets[uiHash & static_cast<hlUInt>(this->Buckets.size() - 1)];
+	while(uiNode != HL_ID_INVALID)
+	{
+		const FolderNode &Node = this->FolderNodes[uiNode];
+		if(Node.uiHash == uiHash && Node.pFolder->GetParent() == pParent)
+		{
+			const hlChar *lpFolderName = Node.pFolder->GetName();
+			if(_strnicmp(lpFolderName, lpName, uiLength) == 0 && lpFolderName[uiLength] == '\0')
+			{
+				return Node.pFolder;
+			}
+		}
+
+		uiNode = Node.uiNext;
+	}
+
+	return 0;
+}
+
+hlVoid CDirectoryTreeBuilder::AddFolderNode(CDirectoryFolder *pFolder, hlUInt uiHash)
+{
+	FolderNode Node;
+	Node.pFolder = pFolder;
+	Node.uiHash = uiHash;
+	Node.uiNext = HL_ID_INVALID;
+	this->FolderNodes.push_back(Node);
+
+	if(this->FolderNodes.size() > this->Buckets.size())
+	{
+		// Double the buckets and relink every node.
+		this->Buckets.assign(this->Buckets.size() * 2, HL_ID_INVALID);
+		for(hlUInt i = 0; i < static_cast<hlUInt>(this->FolderNodes.size()); i++)
+		{
+			hlUInt &uiBucket = this->Buckets[this->FolderNodes[i].uiHash & static_cast<hlUInt>(this->Buckets.size() - 1)];
+			this->FolderNodes[i].uiNext = uiBucket;
+			uiBucket = i;
+		}
+	}
+	else
+	{
+		hlUInt &uiBucket = this->Buckets[uiHash & static_cast<hlUInt>(this->Buckets.size() - 1)];
+		this->FolderNodes.back().uiNext = uiBucket;
+		uiBucket = static_cast<hlUInt>(this->FolderNodes.size() - 1);
+	}
+}
+
+const hlChar *CDirectoryTreeBuilder::GetName(const hlChar *lpName, hlUInt uiLength)
+{
+	if(uiLength + 1 > this->uiNameSize)
+	{
+		delete []this->lpName;
+		this->uiNameSize = (uiLength + 1) * 2;
+		this->lpName = new hlChar[this->uiNameSize];
+	}
+
+	memcpy(this->lpName, lpName, uiLength);
+	this->lpName[uiLength] = '\0';
+
+	return this->lpName;
+}
+
+//
+// Hash()
+// FNV-1a of the parent and the lower case name, matching stricmp().
+//
+hlUInt CDirectoryTreeBuilder::Hash(const CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength)
+{
+	hlUInt64 uiParent = reinterpret_cast<hlUInt64>(pParent);
+
+	hlUInt uiHash = 2166136261U;
+	uiHash = (uiHash ^ static_cast<hlUInt>(uiParent)) * 16777619U;
+	uiHash = (uiHash ^ static_cast<hlUInt>(uiParent >> 32)) * 16777619U;
+	for(hlUInt i = 0; i < uiLength; i++)
+	{
+		uiHash = (uiHash ^ static_cast<hlUInt>(tolower(static_cast<hlByte>(lpName[i])))) * 16777619U;
+	}
+
+	return uiHash;
+}
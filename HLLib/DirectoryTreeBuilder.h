@@ -0,0 +1,86 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef DIRECTORYTREEBUILDER_H
+#define DIRECTORYTREEBUILDER_H
+
+#include "stdafx.h"
+#include "DirectoryFolder.h"
+
+#include <vector>
+
+namespace HLLib
+{
+	//
+	// CDirectoryTreeBuilder
+	// Adds files by path to a package's root folder.  Folders are found through
+	// a hash of (parent, case folded name) instead of CDirectoryFolder::GetItem()
+	// and the folders of the previous path are reused, so building a tree takes
+	// time linear in the number of entries.  Folders added while building must
+	// be added through the builder.
+	//
+	class CDirectoryTreeBuilder
+	{
+	private:
+		struct FolderNode
+		{
+			CDirectoryFolder *pFolder;
+			hlUInt uiHash;
+			hlUInt uiNext;
+		};
+
+		struct PathComponent
+		{
+			hlUInt uiEnd;
+			CDirectoryFolder *pFolder;
+		};
+
+		typedef std::vector<FolderNode> CFolderNodeVector;
+		typedef std::vector<hlUInt> CBucketVector;
+		typedef std::vector<PathComponent> CPathComponentVector;
+
+	private:
+		CDirectoryFolder *pRoot;
+
+		CFolderNodeVector FolderNodes;
+		CBucketVector Buckets;
+
+		hlChar *lpLastPath;
+		hlUInt uiLastPathSize;
+		hlUInt uiLastPathLength;
+		CPathComponentVector LastPathComponents;
+
+		hlChar *lpName;
+		hlUInt uiNameSize;
+
+	public:
+		CDirectoryTreeBuilder(CDirectoryFolder *pRoot);
+		~CDirectoryTreeBuilder();
+
+		CDirectoryFolder *GetFolder(const hlChar *lpPath);
+		CDirectoryFile *AddFile(const hlChar *lpPath, hlUInt uiID = HL_ID_INVALID, hlVoid *lpData = 0);
+
+	private:
+		CDirectoryFolder *GetFolder(const hlChar *lpPath, hlUInt uiLength);
+		CDirectoryFolder *GetSubFolder(CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength);
+		CDirectoryFolder *FindSubFolder(const CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength, hlUInt uiHash) const;
+		hlVoid AddFolderNode(CDirectoryFolder *pFolder, hlUInt uiHash);
+
+		const hlChar *GetName(const hlChar *lpName, hlUInt uiLength);
+
+		static hlUInt Hash(const CDirectoryFolder *pParent, const hlChar *lpName, hlUInt uiLength);
+
+		CDirectoryTreeBuilder(const CDirectoryTreeBuilder &);
+		CDirectoryTreeBuilder &operator=(const CDirectoryTreeBuilder &);
+	};
+}
+
+#endif
@@ -72,7 +72,7 @@ hlBool CFileMapping::OpenInternal(hlUInt uiMode)
 #ifdef _WIN32
 	DWORD dwDesiredAccess = ((uiMode & HL_MODE_READ) ? GENERIC_READ : 0) | ((uiMode & HL_MODE_WRITE) ? GENERIC_WRITE : 0);
 	DWORD dwShareMode = (uiMode & HL_MODE_VOLATILE) ? FILE_SHARE_READ | FILE_SHARE_WRITE : ((uiMode & HL_MODE_READ) && !(uiMode & HL_MODE_WRITE) ? FILE_SHARE_READ : 0);
-	DWORD dwCreationDisposition = (uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE) ? (bOverwriteFiles ? CREATE_ALWAYS : CREATE_NEW) : ((uiMode & HL_MODE_READ) || (uiMode & HL_MODE_WRITE) ? OPEN_EXISTING : 0);
+	DWORD dwCreationDisposition = (uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE) ? (GetContext().bOverwriteFiles ? CREATE_ALWAYS : CREATE_NEW) : ((uiMode & HL_MODE_READ) || (uiMode & HL_MODE_WRITE) ? OPEN_EXISTING : 0);
 
 	if(dwDesiredAccess == 0 || dwCreationDisposition == 0)
 	{
@@ -149,7 +149,7 @@ hlBool CFileMapping::OpenInternal(hlUInt uiMode)
 
 	if((uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE))
 	{
-		iMode |= bOverwriteFiles ? O_CREAT | O_TRUNC : O_CREAT | O_EXCL;
+		iMode |= GetContext().bOverwriteFiles ? O_CREAT | O_TRUNC : O_CREAT | O_EXCL;
 	}
 
 	if((uiMode & (HL_MODE_READ | HL_MODE_WRITE)) == 0)
@@ -344,3 +344,26 @@ hlVoid CFileMapping::UnmapInternal(CView &View)
 #endif
 	}
 }
+
+hlVoid CFileMapping::PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const
+{
+	assert(this->GetOpened());
+
+#ifndef _WIN32
+	// madvise() and posix_fadvise() want page aligned offsets.
+	hlULongLong uiGrainOffset = uiOffset % static_cast<hlULongLong>(this->uiAllocationGranularity);
+	uiOffset -= uiGrainOffset;
+	uiLength += uiGrainOffset;
+
+	if(this->lpView != 0)
+	{
+		madvise(static_cast<hlByte *>(this->lpView) + uiOffset, static_cast<size_t>(uiLength), MADV_WILLNEED);
+	}
+	else
+	{
+#	ifdef POSIX_FADV_WILLNEED
+		posix_fadvise(this->iFile, static_cast<off_t>(uiOffset), static_cast<off_t>(uiLength), POSIX_FADV_WILLNEED);
+#	endif
+	}
+#endif
+}
@@ -55,6 +55,8 @@ namespace HLLib
 
 			virtual hlBool MapInternal(CView *&pView, hlULongLong uiOffset, hlULongLong uiLength);
 			virtual hlVoid UnmapInternal(CView &View);
+
+			virtual hlVoid PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const;
 		};
 	}
 }
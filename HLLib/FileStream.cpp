@@ -16,9 +16,24 @@ using namespace HLLib;
 using namespace HLLib::Streams;
 
 #ifdef _WIN32
-CFileStream::CFileStream(const hlChar *lpFileName) : hFile(0), uiMode(HL_MODE_INVALID)
+CFileStream::CFileStream(const hlChar *lpFileName) : hFile(0), uiMode(HL_MODE_INVALID), bOverwriteFiles(GetContext().bOverwriteFiles)
 #else
-CFileStream::CFileStream(const hlChar *lpFileName) : iFile(-1), uiMode(HL_MODE_INVALID)
+CFileStream::CFileStream(const hlChar *lpFileName) : iFile(-1), uiMode(HL_MODE_INVALID), bOverwriteFiles(GetContext().bOverwriteFiles)
+#endif
+{
+	this->lpFileName = new hlChar[strlen(lpFileName) + 1];
+	strcpy(this->lpFileName, lpFileName);
+}
+
+//
+// CFileStream()
+// bOverwriteFiles replaces the current context's option when the file is
+// opened with HL_MODE_CREATE.
+//
+#ifdef _WIN32
+CFileStream::CFileStream(const hlChar *lpFileName, hlBool bOverwriteFiles) : hFile(0), uiMode(HL_MODE_INVALID), bOverwriteFiles(bOverwriteFiles)
+#else
+CFileStream::CFileStream(const hlChar *lpFileName, hlBool bOverwriteFiles) : iFile(-1), uiMode(HL_MODE_INVALID), bOverwriteFiles(bOverwriteFiles)
 #endif
 {
 	this->lpFileName = new hlChar[strlen(lpFileName) + 1];
@@ -63,7 +78,7 @@ hlBool CFileStream::Open(hlUInt uiMode)
 #ifdef _WIN32
 	DWORD dwDesiredAccess = ((uiMode & HL_MODE_READ) ? GENERIC_READ : 0) | ((uiMode & HL_MODE_WRITE) ? GENERIC_WRITE : 0);
 	DWORD dwShareMode = (uiMode & HL_MODE_VOLATILE) ? FILE_SHARE_READ | FILE_SHARE_WRITE : ((uiMode & HL_MODE_READ) && !(uiMode & HL_MODE_WRITE) ? FILE_SHARE_READ : 0);
-	DWORD dwCreationDisposition = (uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE) ? (bOverwriteFiles ? CREATE_ALWAYS : CREATE_NEW) : ((uiMode & HL_MODE_READ) || (uiMode & HL_MODE_WRITE) ? OPEN_EXISTING : 0);
+	DWORD dwCreationDisposition = (uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE) ? (this->bOverwriteFiles ? CREATE_ALWAYS : CREATE_NEW) : ((uiMode & HL_MODE_READ) || (uiMode & HL_MODE_WRITE) ? OPEN_EXISTING : 0);
 
 	if(dwDesiredAccess == 0 || dwCreationDisposition == 0)
 	{
@@ -99,7 +114,7 @@ hlBool CFileStream::Open(hlUInt uiMode)
 
 	if((uiMode & HL_MODE_WRITE) && (uiMode & HL_MODE_CREATE))
 	{
-		iMode |= bOverwriteFiles ? O_CREAT | O_TRUNC : O_CREAT | O_EXCL;
+		iMode |= this->bOverwriteFiles ? O_CREAT | O_TRUNC : O_CREAT | O_EXCL;
 	}
 
 	if((uiMode & (HL_MODE_READ | HL_MODE_WRITE)) == 0)
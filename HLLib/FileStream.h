@@ -28,11 +28,13 @@ namespace HLLib
 			hlInt iFile;
 #endif
 			hlUInt uiMode;
+			hlBool bOverwriteFiles;
 
 			hlChar *lpFileName;
 
 		public:
 			CFileStream(const hlChar *lpFileName);
+			CFileStream(const hlChar *lpFileName, hlBool bOverwriteFiles);
 			~CFileStream();
 
 			virtual HLStreamType GetType() const;
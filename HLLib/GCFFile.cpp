@@ -362,7 +362,7 @@ hlBool CGCFFile::DefragmentInternal()
 
 		// If there are no data blocks to defragment, and we don't want to sort the data blocks
 		// lexicographically, then we're done.
-		if((uiBlocksFragmented == 0 && !bForceDefragment) || uiBlocksUsed == 0)
+		if((uiBlocksFragmented == 0 && !this->GetContext().bForceDefragment) || uiBlocksUsed == 0)
 		{
 			hlDefragmentProgress(0, uiFilesTotal, uiFilesTotal, uiBytesTotal, uiBytesTotal, &bCancel);
 
@@ -901,46 +901,17 @@ hlBool CGCFFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 	{
 		if(pStream->Open(HL_MODE_READ))
 		{
-			eValidation = HL_VALIDATES_OK;
+			Streams::CReadAheadStream Input(*pStream, this->GetContext().bReadAhead);
 
-			hlULongLong uiTotalBytes = 0, uiFileBytes = pStream->GetStreamSize();
-			hlUInt uiBufferSize;
-			hlByte lpBuffer[HL_GCF_CHECKSUM_LENGTH];
-
-			const GCFChecksumMapEntry *pChecksumMapEntry = this->lpChecksumMapEntries + this->lpDirectoryEntries[pFile->GetID()].uiChecksumIndex;
-
-			hlBool bCancel = hlFalse;
-			hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
-
-			hlUInt i = 0;
-			while((uiBufferSize = pStream->Read(lpBuffer, HL_GCF_CHECKSUM_LENGTH)) != 0)
+			if(Input.Open(HL_MODE_READ))
 			{
-				if(bCancel)
-				{
-					// User canceled.
-					eValidation = HL_VALIDATES_CANCELED;
-					break;
-				}
-
-				if(i >= pChecksumMapEntry->uiChecksumCount)
-				{
-					// Something bad happened.
-					eValidation = HL_VALIDATES_ERROR;
-					break;
-				}
-
-				hlULong uiChecksum = Adler32(lpBuffer, uiBufferSize) ^ CRC32(lpBuffer, uiBufferSize);
-				if(uiChecksum != this->lpChecksumEntries[pChecksumMapEntry->uiFirstChecksumIndex + i].uiChecksum)
-				{
-					eValidation = HL_VALIDATES_CORRUPT;
-					break;
-				}
-
-				uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+				this->ValidateStreamInternal(pFile, Input, eValidation);
 
-				hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
-
-				i++;
+				Input.Close();
+			}
+			else
+			{
+				eValidation = HL_VALIDATES_ERROR;
 			}
 
 			pStream->Close();
@@ -961,6 +932,67 @@ hlBool CGCFFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 	return hlTrue;
 }
 
+hlBool CGCFFile::ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	if((this->lpDirectoryEntries[pFile->GetID()].uiDirectoryFlags & HL_GCF_FLAG_ENCRYPTED) != 0)
+	{
+		// Checksums are of the encrypted data, assume it's ok.
+		eValidation = HL_VALIDATES_ASSUMED_OK;
+		return hlTrue;
+	}
+
+	// File has no checksum.
+	if(this->lpDirectoryEntries[pFile->GetID()].uiChecksumIndex == 0xffffffff)
+	{
+		eValidation = HL_VALIDATES_ASSUMED_OK;
+		return hlTrue;
+	}
+
+	eValidation = HL_VALIDATES_OK;
+
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Stream.GetStreamSize();
+	hlUInt uiBufferSize;
+	hlByte lpBuffer[HL_GCF_CHECKSUM_LENGTH];
+
+	const GCFChecksumMapEntry *pChecksumMapEntry = this->lpChecksumMapEntries + this->lpDirectoryEntries[pFile->GetID()].uiChecksumIndex;
+
+	hlBool bCancel = hlFalse;
+	hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+
+	hlUInt i = 0;
+	while((uiBufferSize = Stream.Read(lpBuffer, HL_GCF_CHECKSUM_LENGTH)) != 0)
+	{
+		if(bCancel)
+		{
+			// User canceled.
+			eValidation = HL_VALIDATES_CANCELED;
+			break;
+		}
+
+		if(i >= pChecksumMapEntry->uiChecksumCount)
+		{
+			// Something bad happened.
+			eValidation = HL_VALIDATES_ERROR;
+			break;
+		}
+
+		hlULong uiChecksum = Adler32(lpBuffer, uiBufferSize) ^ CRC32(lpBuffer, uiBufferSize);
+		if(uiChecksum != this->lpChecksumEntries[pChecksumMapEntry->uiFirstChecksumIndex + i].uiChecksum)
+		{
+			eValidation = HL_VALIDATES_CORRUPT;
+			break;
+		}
+
+		uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+
+		hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+
+		i++;
+	}
+
+	return hlTrue;
+}
+
 hlBool CGCFFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
 	uiSize = this->lpDirectoryEntries[pFile->GetID()].uiItemSize;
@@ -987,7 +1019,7 @@ hlBool CGCFFile::GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &
 
 hlBool CGCFFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
 {
-	if(!bReadEncrypted && this->lpDirectoryEntries[pFile->GetID()].uiDirectoryFlags & HL_GCF_FLAG_ENCRYPTED)
+	if(!this->GetContext().bReadEncrypted && this->lpDirectoryEntries[pFile->GetID()].uiDirectoryFlags & HL_GCF_FLAG_ENCRYPTED)
 	{
 		LastError.SetErrorMessage("File is encrypted.");
 		return hlFalse;
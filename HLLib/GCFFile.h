@@ -262,6 +262,7 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
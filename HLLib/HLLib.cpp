@@ -16,74 +16,58 @@ using namespace HLLib;
 namespace HLLib
 {
 	hlBool bInitialized = hlFalse;
-	CError LastError = CError();
-
-	POpenProc pOpenProc = 0;
-	PCloseProc pCloseProc = 0;
-	PReadProc pReadProc = 0;
-	PWriteProc pWriteProc = 0;
-	PSeekProc pSeekProc = 0;
-	PSeekExProc pSeekExProc = 0;
-	PTellProc pTellProc = 0;
-	PTellExProc pTellExProc = 0;
-	PSizeProc pSizeProc = 0;
-	PSizeExProc pSizeExProc = 0;
-
-	PExtractItemStartProc pExtractItemStartProc = 0;
-	PExtractItemEndProc pExtractItemEndProc = 0;
-	PExtractFileProgressProc pExtractFileProgressProc = 0;
-	PValidateFileProgressProc pValidateFileProgressProc = 0;
-	PDefragmentProgressProc pDefragmentProgressProc = 0;
-	PDefragmentProgressExProc pDefragmentProgressExProc = 0;
-
-	CPackage *pPackage = 0;
-	CPackageVector *pPackageVector = 0;
-
-	hlBool bOverwriteFiles = hlTrue;
-	hlBool bReadEncrypted = hlTrue;
-	hlBool bForceDefragment = hlFalse;
 
 	hlVoid hlExtractItemStart(const HLDirectoryItem *pItem)
 	{
-		if(pExtractItemStartProc != 0)
+		const CContext &Context = GetContext();
+
+		if(Context.pExtractItemStartProc != 0)
 		{
-			pExtractItemStartProc(pItem);
+			Context.pExtractItemStartProc(pItem);
 		}
 	}
 
 	hlVoid hlExtractItemEnd(const HLDirectoryItem *pItem, hlBool bSuccess)
 	{
-		if(pExtractItemEndProc != 0)
+		const CContext &Context = GetContext();
+
+		if(Context.pExtractItemEndProc != 0)
 		{
-			pExtractItemEndProc(pItem, bSuccess);
+			Context.pExtractItemEndProc(pItem, bSuccess);
 		}
 	}
 
 	hlVoid hlExtractFileProgress(const HLDirectoryItem *pFile, hlULongLong uiBytesExtracted, hlULongLong uiBytesTotal, hlBool *pCancel)
 	{
-		if(pExtractFileProgressProc)
+		const CContext &Context = GetContext();
+
+		if(Context.pExtractFileProgressProc)
 		{
-			pExtractFileProgressProc(pFile, static_cast<hlUInt>(uiBytesExtracted), static_cast<hlUInt>(uiBytesTotal), pCancel);
+			Context.pExtractFileProgressProc(pFile, static_cast<hlUInt>(uiBytesExtracted), static_cast<hlUInt>(uiBytesTotal), pCancel);
 		}
 	}
 
 	hlVoid hlValidateFileProgress(const HLDirectoryItem *pFile, hlULongLong uiBytesValidated, hlULongLong uiBytesTotal, hlBool *pCancel)
 	{
-		if(pValidateFileProgressProc)
+		const CContext &Context = GetContext();
+
+		if(Context.pValidateFileProgressProc)
 		{
-			pValidateFileProgressProc(pFile, static_cast<hlUInt>(uiBytesValidated), static_cast<hlUInt>(uiBytesTotal), pCancel);
+			Context.pValidateFileProgressProc(pFile, static_cast<hlUInt>(uiBytesValidated), static_cast<hlUInt>(uiBytesTotal), pCancel);
 		}
 	}
 
 	hlVoid hlDefragmentProgress(const HLDirectoryItem *pFile, hlUInt uiFilesDefragmented, hlUInt uiFilesTotal, hlULongLong uiBytesDefragmented, hlULongLong uiBytesTotal, hlBool *pCancel)
 	{
-		if(pDefragmentProgressProc)
+		const CContext &Context = GetContext();
+
+		if(Context.pDefragmentProgressProc)
 		{
-			pDefragmentProgressProc(pFile, uiFilesDefragmented, uiFilesTotal, static_cast<hlUInt>(uiBytesDefragmented), static_cast<hlUInt>(uiBytesTotal), pCancel);
+			Context.pDefragmentProgressProc(pFile, uiFilesDefragmented, uiFilesTotal, static_cast<hlUInt>(uiBytesDefragmented), static_cast<hlUInt>(uiBytesTotal), pCancel);
 		}
-		if(pDefragmentProgressExProc)
+		if(Context.pDefragmentProgressExProc)
 		{
-			pDefragmentProgressExProc(pFile, uiFilesDefragmented, uiFilesTotal, uiBytesDefragmented, uiBytesTotal, pCancel);
+			Context.pDefragmentProgressExProc(pFile, uiFilesDefragmented, uiFilesTotal, uiBytesDefragmented, uiBytesTotal, pCancel);
 		}
 	}
 }
@@ -102,9 +86,6 @@ HLLIB_API hlVoid hlInitialize()
 	bInitialized = hlTrue;
 	LastError = CError();
 
-	pPackage = 0;
-	pPackageVector = new CPackageVector();
-
 	return;
 }
 
@@ -119,15 +100,7 @@ HLLIB_API hlVoid hlShutdown()
 
 	bInitialized = hlFalse;
 
-	pPackage = 0;
-
-	for(hlUInt i = 0; i < pPackageVector->size(); i++)
-	{
-		delete (*pPackageVector)[i];
-	}
-
-	delete pPackageVector;
-	pPackageVector = 0;
+	GetDefaultContext().DeletePackages();
 }
 
 HLLIB_API hlBool hlGetBoolean(HLOption eOption)
@@ -139,39 +112,12 @@ HLLIB_API hlBool hlGetBoolean(HLOption eOption)
 
 HLLIB_API hlBool hlGetBooleanValidate(HLOption eOption, hlBool *pValue)
 {
-	switch(eOption)
-	{
-	case HL_OVERWRITE_FILES:
-		*pValue = bOverwriteFiles;
-		return hlTrue;
-	case HL_READ_ENCRYPTED:
-		*pValue = bReadEncrypted;
-		return hlTrue;
-	case HL_FORCE_DEFRAGMENT:
-		*pValue = bForceDefragment;
-		return hlTrue;
-	case HL_PACKAGE_BOUND:
-		*pValue = pPackage != 0;
-		return hlTrue;
-	}
-
-	return hlFalse;
+	return hlContextGetBooleanValidate(&GetContext(), eOption, pValue);
 }
 
 HLLIB_API hlVoid hlSetBoolean(HLOption eOption, hlBool bValue)
 {
-	switch(eOption)
-	{
-	case HL_OVERWRITE_FILES:
-		bOverwriteFiles = bValue;
-		break;
-	case HL_READ_ENCRYPTED:
-		bReadEncrypted = bValue;
-		break;
-	case HL_FORCE_DEFRAGMENT:
-		bForceDefragment = bValue;
-		break;
-	}
+	hlContextSetBoolean(&GetContext(), eOption, bValue);
 }
 
 HLLIB_API hlInt hlGetInteger(HLOption eOption)
@@ -203,155 +149,327 @@ HLLIB_API hlUInt hlGetUnsignedInteger(HLOption eOption)
 
 HLLIB_API hlBool hlGetUnsignedIntegerValidate(HLOption eOption, hlUInt *pValue)
 {
+	return hlContextGetUnsignedIntegerValidate(&GetContext(), eOption, pValue);
+}
+
+HLLIB_API hlVoid hlSetUnsignedInteger(HLOption eOption, hlUInt iValue)
+{
+	hlContextSetUnsignedInteger(&GetContext(), eOption, iValue);
+}
+
+HLLIB_API hlLongLong hlGetLongLong(HLOption eOption)
+{
+	hlLongLong iValue = 0;
+	hlGetLongLongValidate(eOption, &iValue);
+	return iValue;
+}
+
+HLLIB_API hlBool hlGetLongLongValidate(HLOption eOption, hlLongLong *pValue)
+{
+	hlULongLong uiValue = (hlLongLong)*pValue;
+	hlBool bResult = hlGetUnsignedLongLongValidate(eOption, &uiValue);
+	*pValue = (hlLongLong)uiValue;
+	return bResult;
+}
+
+HLLIB_API hlVoid hlSetLongLong(HLOption eOption, hlLongLong iValue)
+{
+
+}
+
+HLLIB_API hlULongLong hlGetUnsignedLongLong(HLOption eOption)
+{
+	hlULongLong uiValue = 0;
+	hlGetUnsignedLongLongValidate(eOption, &uiValue);
+	return uiValue;
+}
+
+HLLIB_API hlBool hlGetUnsignedLongLongValidate(HLOption eOption, hlULongLong *pValue)
+{
+	return hlContextGetUnsignedLongLongValidate(&GetContext(), eOption, pValue);
+}
+
+HLLIB_API hlVoid hlSetUnsignedLongLong(HLOption eOption, hlULongLong iValue)
+{
+
+}
+
+HLLIB_API hlFloat hlGetFloat(HLOption eOption)
+{
+	hlFloat fValue = 0.0f;
+	hlGetFloatValidate(eOption, &fValue);
+	return fValue;
+}
+
+HLLIB_API hlBool hlGetFloatValidate(HLOption eOption, hlFloat *pValue)
+{
+	return hlFalse;
+}
+
+HLLIB_API hlVoid hlSetFloat(HLOption eOption, hlFloat fValue)
+{
+	
+}
+
+HLLIB_API const hlChar *hlGetString(HLOption eOption)
+{
+	const hlChar *lpValue = 0;
+	hlGetStringValidate(eOption, &lpValue);
+	return lpValue ? lpValue : "";
+}
+
+HLLIB_API hlBool hlGetStringValidate(HLOption eOption, const hlChar **pValue)
+{
+	return hlContextGetStringValidate(&GetContext(), eOption, pValue);
+}
+
+HLLIB_API hlVoid hlSetString(HLOption eOption, const hlChar *lpValue)
+{
+
+}
+
+HLLIB_API const hlVoid *hlGetVoid(HLOption eOption)
+{
+	const hlVoid *lpValue = 0;
+	hlGetVoidValidate(eOption, &lpValue);
+	return lpValue;
+}
+
+HLLIB_API hlBool hlGetVoidValidate(HLOption eOption, const hlVoid **pValue)
+{
+	return hlContextGetVoidValidate(&GetContext(), eOption, pValue);
+}
+
+HLLIB_API hlVoid hlSetVoid(HLOption eOption, const hlVoid *pValue)
+{
+	hlContextSetVoid(&GetContext(), eOption, pValue);
+}
+
+//
+// hlContextCreate()
+// Creates an independent context with default options and no packages.
+//
+HLLIB_API hlBool hlContextCreate(HLContext **pContext)
+{
+	*pContext = new CContext();
+
+	return hlTrue;
+}
+
+//
+// hlContextDelete()
+// Deletes a context and every package created in it.
+//
+HLLIB_API hlVoid hlContextDelete(HLContext *pContext)
+{
+	if(pContext == 0 || pContext == &GetDefaultContext())
+	{
+		return;
+	}
+
+	CContext *pDeleteContext = static_cast<CContext *>(pContext);
+
+	{
+		// Packages report errors to (and may read options from) their own context.
+		CContextScope Scope(*pDeleteContext);
+
+		pDeleteContext->DeletePackages();
+	}
+
+	delete pDeleteContext;
+}
+
+HLLIB_API const hlChar *hlContextGetString(HLContext *pContext, HLOption eOption)
+{
+	const hlChar *lpValue = 0;
+	hlContextGetStringValidate(pContext, eOption, &lpValue);
+	return lpValue ? lpValue : "";
+}
+
+HLLIB_API hlBool hlContextGetBooleanValidate(HLContext *pContext, HLOption eOption, hlBool *pValue)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+
+	switch(eOption)
+	{
+	case HL_OVERWRITE_FILES:
+		*pValue = Context.bOverwriteFiles;
+		return hlTrue;
+	case HL_READ_ENCRYPTED:
+		*pValue = Context.bReadEncrypted;
+		return hlTrue;
+	case HL_FORCE_DEFRAGMENT:
+		*pValue = Context.bForceDefragment;
+		return hlTrue;
+	case HL_READ_AHEAD:
+		*pValue = Context.bReadAhead;
+		return hlTrue;
+	case HL_PACKAGE_BOUND:
+		*pValue = Context.pPackage != 0;
+		return hlTrue;
+	}
+
+	return hlFalse;
+}
+
+HLLIB_API hlVoid hlContextSetBoolean(HLContext *pContext, HLOption eOption, hlBool bValue)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+
+	switch(eOption)
+	{
+	case HL_OVERWRITE_FILES:
+		Context.bOverwriteFiles = bValue;
+		break;
+	case HL_READ_ENCRYPTED:
+		Context.bReadEncrypted = bValue;
+		break;
+	case HL_FORCE_DEFRAGMENT:
+		Context.bForceDefragment = bValue;
+		break;
+	case HL_READ_AHEAD:
+		Context.bReadAhead = bValue;
+		break;
+	}
+}
+
+HLLIB_API hlBool hlContextGetUnsignedIntegerValidate(HLContext *pContext, HLOption eOption, hlUInt *pValue)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+
 	switch(eOption)
 	{
 	case HL_VERSION:
 		*pValue = HL_VERSION_NUMBER;
 		return hlTrue;
 	case HL_ERROR_SYSTEM:
-		*pValue = LastError.GetSystemError();
+		*pValue = Context.Error.GetSystemError();
 		return hlTrue;
 	case HL_PACKAGE_ID:
-		*pValue = HL_ID_INVALID;
-		if(pPackage != 0)
-		{
-			for(hlUInt i = 0; i < static_cast<hlUInt>(pPackageVector->size()); i++)
-			{
-				if((*pPackageVector)[i] == pPackage)
-				{
-					*pValue = i;
-					break;
-				}
-			}
-		}
+		*pValue = Context.GetPackageID(Context.pPackage);
 		return hlTrue;
 		break;
 	case HL_PACKAGE_SIZE:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = static_cast<hlUInt>(pPackage->GetMapping()->GetMappingSize());
+		*pValue = static_cast<hlUInt>(Context.pPackage->GetMapping()->GetMappingSize());
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_ALLOCATIONS:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = pPackage->GetMapping()->GetTotalAllocations();
+		*pValue = Context.pPackage->GetMapping()->GetTotalAllocations();
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_MEMORY_ALLOCATED:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = static_cast<hlUInt>(pPackage->GetMapping()->GetTotalMemoryAllocated());
+		*pValue = static_cast<hlUInt>(Context.pPackage->GetMapping()->GetTotalMemoryAllocated());
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_MEMORY_USED:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = static_cast<hlUInt>(pPackage->GetMapping()->GetTotalMemoryUsed());
+		*pValue = static_cast<hlUInt>(Context.pPackage->GetMapping()->GetTotalMemoryUsed());
 		return hlTrue;
 		break;
+	case HL_SKIP_UNCHANGED_FILES:
+		*pValue = static_cast<hlUInt>(Context.eSkipUnchangedFiles);
+		return hlTrue;
+	case HL_EXTRACT_THREAD_COUNT:
+		*pValue = Context.uiExtractThreadCount;
+		return hlTrue;
+	case HL_ARCHIVE_HANDLE_LIMIT:
+		*pValue = Context.uiArchiveHandleLimit;
+		return hlTrue;
+	case HL_STREAM_CACHE_SIZE:
+		*pValue = Context.uiStreamCacheSize;
+		return hlTrue;
 	default:
 		return hlFalse;
 	}
 }
 
-HLLIB_API hlVoid hlSetUnsignedInteger(HLOption eOption, hlUInt iValue)
-{
-
-}
-
-HLLIB_API hlLongLong hlGetLongLong(HLOption eOption)
-{
-	hlLongLong iValue = 0;
-	hlGetLongLongValidate(eOption, &iValue);
-	return iValue;
-}
-
-HLLIB_API hlBool hlGetLongLongValidate(HLOption eOption, hlLongLong *pValue)
-{
-	hlULongLong uiValue = (hlLongLong)*pValue;
-	hlBool bResult = hlGetUnsignedLongLongValidate(eOption, &uiValue);
-	*pValue = (hlLongLong)uiValue;
-	return bResult;
-}
-
-HLLIB_API hlVoid hlSetLongLong(HLOption eOption, hlLongLong iValue)
+HLLIB_API hlVoid hlContextSetUnsignedInteger(HLContext *pContext, HLOption eOption, hlUInt iValue)
 {
+	CContext &Context = *static_cast<CContext *>(pContext);
 
+	switch(eOption)
+	{
+	case HL_SKIP_UNCHANGED_FILES:
+		if(iValue <= HL_SKIP_CHECKSUM)
+		{
+			Context.eSkipUnchangedFiles = static_cast<HLSkipMode>(iValue);
+		}
+		break;
+	case HL_EXTRACT_THREAD_COUNT:
+		Context.uiExtractThreadCount = iValue;
+		break;
+	case HL_ARCHIVE_HANDLE_LIMIT:
+		Context.uiArchiveHandleLimit = iValue;
+		break;
+	case HL_STREAM_CACHE_SIZE:
+		Context.uiStreamCacheSize = iValue;
+		break;
+	}
 }
 
-HLLIB_API hlULongLong hlGetUnsignedLongLong(HLOption eOption)
+HLLIB_API hlBool hlContextGetUnsignedLongLongValidate(HLContext *pContext, HLOption eOption, hlULongLong *pValue)
 {
-	hlULongLong uiValue = 0;
-	hlGetUnsignedLongLongValidate(eOption, &uiValue);
-	return uiValue;
-}
+	CContext &Context = *static_cast<CContext *>(pContext);
 
-HLLIB_API hlBool hlGetUnsignedLongLongValidate(HLOption eOption, hlULongLong *pValue)
-{
 	switch(eOption)
 	{
 	case HL_PACKAGE_ID:
-		*pValue = HL_ID_INVALID;
-		if(pPackage != 0)
-		{
-			for(hlUInt i = 0; i < static_cast<hlUInt>(pPackageVector->size()); i++)
-			{
-				if((*pPackageVector)[i] == pPackage)
-				{
-					*pValue = static_cast<hlULongLong>(i);
-					break;
-				}
-			}
-		}
+		*pValue = static_cast<hlULongLong>(Context.GetPackageID(Context.pPackage));
 		return hlTrue;
 		break;
 	case HL_PACKAGE_SIZE:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = pPackage->GetMapping()->GetMappingSize();
+		*pValue = Context.pPackage->GetMapping()->GetMappingSize();
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_ALLOCATIONS:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = static_cast<hlULongLong>(pPackage->GetMapping()->GetTotalAllocations());
+		*pValue = static_cast<hlULongLong>(Context.pPackage->GetMapping()->GetTotalAllocations());
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_MEMORY_ALLOCATED:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = pPackage->GetMapping()->GetTotalMemoryAllocated();
+		*pValue = Context.pPackage->GetMapping()->GetTotalMemoryAllocated();
 		return hlTrue;
 		break;
 	case HL_PACKAGE_TOTAL_MEMORY_USED:
-		if(pPackage == 0 || !pPackage->GetOpened() || !pPackage->GetMapping())
+		if(Context.pPackage == 0 || !Context.pPackage->GetOpened() || !Context.pPackage->GetMapping())
 		{
 			return hlFalse;
 		}
 
-		*pValue = pPackage->GetMapping()->GetTotalMemoryUsed();
+		*pValue = Context.pPackage->GetMapping()->GetTotalMemoryUsed();
 		return hlTrue;
 		break;
 	default:
@@ -359,179 +477,144 @@ HLLIB_API hlBool hlGetUnsignedLongLongValidate(HLOption eOption, hlULongLong *pV
 	}
 }
 
-HLLIB_API hlVoid hlSetUnsignedLongLong(HLOption eOption, hlULongLong iValue)
+HLLIB_API hlBool hlContextGetStringValidate(HLContext *pContext, HLOption eOption, const hlChar **pValue)
 {
+	CContext &Context = *static_cast<CContext *>(pContext);
 
-}
-
-HLLIB_API hlFloat hlGetFloat(HLOption eOption)
-{
-	hlFloat fValue = 0.0f;
-	hlGetFloatValidate(eOption, &fValue);
-	return fValue;
-}
-
-HLLIB_API hlBool hlGetFloatValidate(HLOption eOption, hlFloat *pValue)
-{
-	return hlFalse;
-}
-
-HLLIB_API hlVoid hlSetFloat(HLOption eOption, hlFloat fValue)
-{
-	
-}
-
-HLLIB_API const hlChar *hlGetString(HLOption eOption)
-{
-	const hlChar *lpValue = 0;
-	hlGetStringValidate(eOption, &lpValue);
-	return lpValue ? lpValue : "";
-}
-
-HLLIB_API hlBool hlGetStringValidate(HLOption eOption, const hlChar **pValue)
-{
 	switch(eOption)
 	{
 	case HL_VERSION:
 		*pValue = HL_VERSION_STRING;
 		return hlTrue;
 	case HL_ERROR:
-		*pValue = LastError.GetErrorMessage();
+		*pValue = Context.Error.GetErrorMessage();
 		return hlTrue;
 	case HL_ERROR_SYSTEM:
-		*pValue = LastError.GetSystemErrorMessage();
+		*pValue = Context.Error.GetSystemErrorMessage();
 		return hlTrue;
 	case HL_ERROR_SHORT_FORMATED:
-		*pValue = LastError.GetShortFormattedErrorMessage();
+		*pValue = Context.Error.GetShortFormattedErrorMessage();
 		return hlTrue;
 	case HL_ERROR_LONG_FORMATED:
-		*pValue = LastError.GetLongFormattedErrorMessage();
+		*pValue = Context.Error.GetLongFormattedErrorMessage();
 		return hlTrue;
 	default:
 		return hlFalse;
 	}
 }
 
-HLLIB_API hlVoid hlSetString(HLOption eOption, const hlChar *lpValue)
-{
-
-}
-
-HLLIB_API const hlVoid *hlGetVoid(HLOption eOption)
+HLLIB_API hlBool hlContextGetVoidValidate(HLContext *pContext, HLOption eOption, const hlVoid **pValue)
 {
-	const hlVoid *lpValue = 0;
-	hlGetVoidValidate(eOption, &lpValue);
-	return lpValue;
-}
+	CContext &Context = *static_cast<CContext *>(pContext);
 
-HLLIB_API hlBool hlGetVoidValidate(HLOption eOption, const hlVoid **pValue)
-{
 	switch(eOption)
 	{
 	case HL_PROC_OPEN:
-		*pValue = (const hlVoid *)pOpenProc;
+		*pValue = (const hlVoid *)Context.pOpenProc;
 		return hlTrue;
 	case HL_PROC_CLOSE:
-		*pValue = (const hlVoid *)pCloseProc;
+		*pValue = (const hlVoid *)Context.pCloseProc;
 		return hlTrue;
 	case HL_PROC_READ:
-		*pValue = (const hlVoid *)pReadProc;
+		*pValue = (const hlVoid *)Context.pReadProc;
 		return hlTrue;
 	case HL_PROC_WRITE:
-		*pValue = (const hlVoid *)pWriteProc;
+		*pValue = (const hlVoid *)Context.pWriteProc;
 		return hlTrue;
 	case HL_PROC_SEEK:
-		*pValue = (const hlVoid *)pSeekProc;
+		*pValue = (const hlVoid *)Context.pSeekProc;
 		return hlTrue;
 	case HL_PROC_SEEK_EX:
-		*pValue = (const hlVoid *)pSeekExProc;
+		*pValue = (const hlVoid *)Context.pSeekExProc;
 		return hlTrue;
 	case HL_PROC_TELL:
-		*pValue = (const hlVoid *)pTellProc;
+		*pValue = (const hlVoid *)Context.pTellProc;
 		return hlTrue;
 	case HL_PROC_TELL_EX:
-		*pValue = (const hlVoid *)pTellExProc;
+		*pValue = (const hlVoid *)Context.pTellExProc;
 		return hlTrue;
 	case HL_PROC_SIZE:
-		*pValue = (const hlVoid *)pSizeProc;
+		*pValue = (const hlVoid *)Context.pSizeProc;
 		return hlTrue;
 	case HL_PROC_SIZE_EX:
-		*pValue = (const hlVoid *)pSizeExProc;
+		*pValue = (const hlVoid *)Context.pSizeExProc;
 		return hlTrue;
 	case HL_PROC_EXTRACT_ITEM_START:
-		*pValue = (const hlVoid *)pExtractItemStartProc;
+		*pValue = (const hlVoid *)Context.pExtractItemStartProc;
 		return hlTrue;
 	case HL_PROC_EXTRACT_ITEM_END:
-		*pValue = (const hlVoid *)pExtractItemEndProc;
+		*pValue = (const hlVoid *)Context.pExtractItemEndProc;
 		return hlTrue;
 	case HL_PROC_EXTRACT_FILE_PROGRESS:
-		*pValue = (const hlVoid *)pExtractFileProgressProc;
+		*pValue = (const hlVoid *)Context.pExtractFileProgressProc;
 		return hlTrue;
 	case HL_PROC_VALIDATE_FILE_PROGRESS:
-		*pValue = (const hlVoid *)pValidateFileProgressProc;
+		*pValue = (const hlVoid *)Context.pValidateFileProgressProc;
 		return hlTrue;
 	case HL_PROC_DEFRAGMENT_PROGRESS:
-		*pValue = (const hlVoid *)pDefragmentProgressProc;
+		*pValue = (const hlVoid *)Context.pDefragmentProgressProc;
 		return hlTrue;
 	case HL_PROC_DEFRAGMENT_PROGRESS_EX:
-		*pValue = (const hlVoid *)pDefragmentProgressExProc;
+		*pValue = (const hlVoid *)Context.pDefragmentProgressExProc;
 		return hlTrue;
 	default:
 		return hlFalse;
 	}
 }
 
-HLLIB_API hlVoid hlSetVoid(HLOption eOption, const hlVoid *pValue)
+HLLIB_API hlVoid hlContextSetVoid(HLContext *pContext, HLOption eOption, const hlVoid *pValue)
 {
+	CContext &Context = *static_cast<CContext *>(pContext);
+
 	switch(eOption)
 	{
 	case HL_PROC_OPEN:
-		pOpenProc = (POpenProc)pValue;
+		Context.pOpenProc = (POpenProc)pValue;
 		break;
 	case HL_PROC_CLOSE:
-		pCloseProc = (PCloseProc)pValue;
+		Context.pCloseProc = (PCloseProc)pValue;
 		break;
 	case HL_PROC_READ:
-		pReadProc = (PReadProc)pValue;
+		Context.pReadProc = (PReadProc)pValue;
 		break;
 	case HL_PROC_WRITE:
-		pWriteProc = (PWriteProc)pValue;
+		Context.pWriteProc = (PWriteProc)pValue;
 		break;
 	case HL_PROC_SEEK:
-		pSeekProc = (PSeekProc)pValue;
+		Context.pSeekProc = (PSeekProc)pValue;
 		break;
 	case HL_PROC_SEEK_EX:
-		pSeekExProc = (PSeekExProc)pValue;
+		Context.pSeekExProc = (PSeekExProc)pValue;
 		break;
 	case HL_PROC_TELL:
-		pTellProc = (PTellProc)pValue;
+		Context.pTellProc = (PTellProc)pValue;
 		break;
 	case HL_PROC_TELL_EX:
-		pTellExProc = (PTellExProc)pValue;
+		Context.pTellExProc = (PTellExProc)pValue;
 		break;
 	case HL_PROC_SIZE:
-		pSizeProc = (PSizeProc)pValue;
+		Context.pSizeProc = (PSizeProc)pValue;
 		break;
 	case HL_PROC_SIZE_EX:
-		pSizeExProc = (PSizeExProc)pValue;
+		Context.pSizeExProc = (PSizeExProc)pValue;
 		break;
 	case HL_PROC_EXTRACT_ITEM_START:
-		pExtractItemStartProc = (PExtractItemStartProc)pValue;
+		Context.pExtractItemStartProc = (PExtractItemStartProc)pValue;
 		break;
 	case HL_PROC_EXTRACT_ITEM_END:
-		pExtractItemEndProc = (PExtractItemEndProc)pValue;
+		Context.pExtractItemEndProc = (PExtractItemEndProc)pValue;
 		break;
 	case HL_PROC_EXTRACT_FILE_PROGRESS:
-		pExtractFileProgressProc = (PExtractFileProgressProc)pValue;
+		Context.pExtractFileProgressProc = (PExtractFileProgressProc)pValue;
 		break;
 	case HL_PROC_VALIDATE_FILE_PROGRESS:
-		pValidateFileProgressProc = (PValidateFileProgressProc)pValue;
+		Context.pValidateFileProgressProc = (PValidateFileProgressProc)pValue;
 		break;
 	case HL_PROC_DEFRAGMENT_PROGRESS:
-		pDefragmentProgressProc = (PDefragmentProgressProc)pValue;
+		Context.pDefragmentProgressProc = (PDefragmentProgressProc)pValue;
 		break;
 	case HL_PROC_DEFRAGMENT_PROGRESS_EX:
-		pDefragmentProgressExProc = (PDefragmentProgressExProc)pValue;
+		Context.pDefragmentProgressExProc = (PDefragmentProgressExProc)pValue;
 		break;
 	}
 }
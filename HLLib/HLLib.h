@@ -14,47 +14,23 @@
 
 #include "stdafx.h"
 #include "Error.h"
+#include "Context.h"
 #include "Package.h"
 
 namespace HLLib
 {
-	typedef std::vector<CPackage *> CPackageVector;
-
 	extern hlBool bInitialized;
-	extern CError LastError;
-
-	extern POpenProc pOpenProc;
-	extern PCloseProc pCloseProc;
-	extern PReadProc pReadProc;
-	extern PWriteProc pWriteProc;
-	extern PSeekProc pSeekProc;
-	extern PSeekExProc pSeekExProc;
-	extern PTellProc pTellProc;
-	extern PTellExProc pTellExProc;
-	extern PSizeProc pSizeProc;
-	extern PSizeExProc pSizeExProc;
-
-	extern PExtractItemStartProc pExtractItemStartProc;
-	extern PExtractItemEndProc pExtractItemEndProc;
-	extern PExtractFileProgressProc pExtractFileProgressProc;
-	extern PValidateFileProgressProc pValidateFileProgressProc;
-	extern PDefragmentProgressProc pDefragmentProgressProc;
-	extern PDefragmentProgressExProc pDefragmentProgressExProc;
 
 	hlVoid hlExtractItemStart(const HLDirectoryItem *pItem);
 	hlVoid hlExtractItemEnd(const HLDirectoryItem *pItem, hlBool bSuccess);
 	hlVoid hlExtractFileProgress(const HLDirectoryItem *pFile, hlULongLong uiBytesExtracted, hlULongLong uiBytesTotal, hlBool *pCancel);
 	hlVoid hlValidateFileProgress(const HLDirectoryItem *pFile, hlULongLong uiBytesValidated, hlULongLong uiBytesTotal, hlBool *pCancel);
 	hlVoid hlDefragmentProgress(const HLDirectoryItem *pFile, hlUInt uiFilesDefragmented, hlUInt uiFilesTotal, hlULongLong uiBytesDefragmented, hlULongLong uiBytesTotal, hlBool *pCancel);
-
-	extern CPackage *pPackage;
-	extern CPackageVector *pPackageVector;
-
-	extern hlBool bOverwriteFiles;
-	extern hlBool bReadEncrypted;
-	extern hlBool bForceDefragment;
 }
 
+// The last error lives in the current context, much like errno is per thread.
+#define LastError (HLLib::GetContext().Error)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -98,6 +74,27 @@ HLLIB_API const hlVoid *hlGetVoid(HLOption eOption);
 HLLIB_API hlBool hlGetVoidValidate(HLOption eOption, const hlVoid **pValue);
 HLLIB_API hlVoid hlSetVoid(HLOption eOption, const hlVoid *pValue);
 
+//
+// Contexts
+//
+
+HLLIB_API hlBool hlContextCreate(HLContext **pContext);
+HLLIB_API hlVoid hlContextDelete(HLContext *pContext);
+
+HLLIB_API hlBool hlContextGetBooleanValidate(HLContext *pContext, HLOption eOption, hlBool *pValue);
+HLLIB_API hlVoid hlContextSetBoolean(HLContext *pContext, HLOption eOption, hlBool bValue);
+
+HLLIB_API hlBool hlContextGetUnsignedIntegerValidate(HLContext *pContext, HLOption eOption, hlUInt *pValue);
+HLLIB_API hlVoid hlContextSetUnsignedInteger(HLContext *pContext, HLOption eOption, hlUInt iValue);
+
+HLLIB_API hlBool hlContextGetUnsignedLongLongValidate(HLContext *pContext, HLOption eOption, hlULongLong *pValue);
+
+HLLIB_API const hlChar *hlContextGetString(HLContext *pContext, HLOption eOption);
+HLLIB_API hlBool hlContextGetStringValidate(HLContext *pContext, HLOption eOption, const hlChar **pValue);
+
+HLLIB_API hlBool hlContextGetVoidValidate(HLContext *pContext, HLOption eOption, const hlVoid **pValue);
+HLLIB_API hlVoid hlContextSetVoid(HLContext *pContext, HLOption eOption, const hlVoid *pValue);
+
 //
 // Attributes
 //
@@ -0,0 +1,414 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "InflateStream.h"
+
+#ifdef USE_ZLIB
+
+#include <zlib.h>
+
+using namespace HLLib;
+using namespace HLLib::Streams;
+
+// Distance in uncompressed bytes between restart points.  Each point costs up to 32 KB.
+#define HL_INFLATE_RESTART_SPACING (1024 * 1024)
+#define HL_INFLATE_WINDOW_SIZE 32768
+#define HL_INFLATE_SKIP_BUFFER_SIZE 32768
+
+//
+// CInflateStream
+// Decompresses a raw Deflate stream straight out of a mapping, one view of compressed
+// data at a time, so memory use does not depend on the size of the entry.  Seeking
+// backwards restarts from the closest restart point recorded while reading forwards
+// rather than from the start of the data.
+//
+
+CInflateStream::CInflateStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, hlULongLong uiLength) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Mapping(Mapping), pView(0), uiMappingOffset(uiMappingOffset), uiMappingSize(uiMappingSize), uiPointer(0), uiLength(uiLength), pZStream(0), uiInput(0), bEnd(hlFalse), pRestartPoints(0)
+{
+
+}
+
+CInflateStream::~CInflateStream()
+{
+	this->Close();
+}
+
+HLStreamType CInflateStream::GetType() const
+{
+	return HL_STREAM_INFLATE;
+}
+
+const Mapping::CMapping &CInflateStream::GetMapping() const
+{
+	return this->Mapping;
+}
+
+const hlChar *CInflateStream::GetFileName() const
+{
+	return "";
+}
+
+hlBool CInflateStream::GetOpened() const
+{
+	return this->bOpened;
+}
+
+hlUInt CInflateStream::GetMode() const
+{
+	return this->uiMode;
+}
+
+hlBool CInflateStream::Open(hlUInt uiMode)
+{
+	this->Close();
+
+	if((uiMode & HL_MODE_READ) == 0 || (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessageFormated("Invalid open mode (%#.8x).", uiMode);
+		return hlFalse;
+	}
+
+	if((this->Mapping.GetMode() & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Mapping does not have read permissions.");
+		return hlFalse;
+	}
+
+	z_stream *pStream = new z_stream;
+	memset(pStream, 0, sizeof(z_stream));
+
+	// Negative window bits: raw Deflate data with no zlib header.
+	if(inflateInit2(pStream, -MAX_WBITS) != Z_OK)
+	{
+		LastError.SetErrorMessageFormated("Error initializing inflate: %s.", pStream->msg != 0 ? pStream->msg : "unknown error");
+		delete pStream;
+		return hlFalse;
+	}
+
+	this->pZStream = pStream;
+	this->pRestartPoints = new CRestartPointVector();
+
+	this->uiPointer = 0;
+	this->uiInput = 0;
+	this->bEnd = hlFalse;
+
+	this->bOpened = hlTrue;
+	this->uiMode = uiMode;
+
+	return hlTrue;
+}
+
+hlVoid CInflateStream::Close()
+{
+	this->bOpened = hlFalse;
+	this->uiMode = HL_MODE_INVALID;
+
+	if(this->pZStream != 0)
+	{
+		z_stream *pStream = static_cast<z_stream *>(this->pZStream);
+
+		inflateEnd(pStream);
+		delete pStream;
+		this->pZStream = 0;
+	}
+
+	this->Mapping.Unmap(this->pView);
+
+	if(this->pRestartPoints != 0)
+	{
+		this->ClearRestartPoints();
+
+		delete this->pRestartPoints;
+		this->pRestartPoints = 0;
+	}
+
+	this->uiPointer = 0;
+	this->uiInput = 0;
+	this->bEnd = hlFalse;
+}
+
+hlULongLong CInflateStream::GetStreamSize() const
+{
+	return this->bOpened ? this->uiLength : 0;
+}
+
+hlULongLong CInflateStream::GetStreamPointer() const
+{
+	return this->uiPointer;
+}
+
+hlULongLong CInflateStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	hlULongLong uiPointer = this->uiPointer;
+	switch(eSeekMode)
+	{
+		case HL_SEEK_BEGINNING:
+			uiPointer = 0;
+			break;
+		case HL_SEEK_CURRENT:
+
+			break;
+		case HL_SEEK_END:
+			uiPointer = this->uiLength;
+			break;
+	}
+
+	hlLongLong iPointer = static_cast<hlLongLong>(uiPointer) + iOffset;
+
+	if(iPointer < 0)
+	{
+		iPointer = 0;
+	}
+	else if(iPointer > static_cast<hlLongLong>(this->uiLength))
+	{
+		iPointer = static_cast<hlLongLong>(this->uiLength);
+	}
+
+	uiPointer = static_cast<hlULongLong>(iPointer);
+
+	this->Restart(uiPointer);
+
+	// Decompress and discard up to the requested position.
+	hlByte lpBuffer[HL_INFLATE_SKIP_BUFFER_SIZE];
+	while(this->uiPointer < uiPointer)
+	{
+		hlULongLong uiBytes = uiPointer - this->uiPointer;
+		if(uiBytes > sizeof(lpBuffer))
+		{
+			uiBytes = sizeof(lpBuffer);
+		}
+
+		if(this->Read(lpBuffer, static_cast<hlUInt>(uiBytes)) == 0)
+		{
+			break;
+		}
+	}
+
+	return this->uiPointer;
+}
+
+hlBool CInflateStream::Read(hlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+hlUInt CInflateStream::Read(hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	if((this->uiMode & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Stream not in read mode.");
+		return 0;
+	}
+
+	z_stream *pStream = static_cast<z_stream *>(this->pZStream);
+
+	if(static_cast<hlULongLong>(uiBytes) > this->uiLength - this->uiPointer)
+	{
+		uiBytes = static_cast<hlUInt>(this->uiLength - this->uiPointer);
+	}
+
+	hlUInt uiOffset = 0;
+	while(uiOffset < uiBytes && !this->bEnd)
+	{
+		if(pStream->avail_in == 0 && !this->MapInput())
+		{
+			break;
+		}
+
+		pStream->next_out = static_cast<Bytef *>(lpData) + uiOffset;
+		pStream->avail_out = uiBytes - uiOffset;
+
+		hlInt iResult = inflate(pStream, Z_BLOCK);
+
+		hlUInt uiInflated = (uiBytes - uiOffset) - pStream->avail_out;
+		uiOffset += uiInflated;
+		this->uiPointer += static_cast<hlULongLong>(uiInflated);
+
+		if(iResult == Z_STREAM_END)
+		{
+			this->bEnd = hlTrue;
+			break;
+		}
+		else if(iResult != Z_OK && iResult != Z_BUF_ERROR)
+		{
+			LastError.SetErrorMessageFormated("Error inflating data: %s.", pStream->msg != 0 ? pStream->msg : "unknown error");
+			break;
+		}
+
+		// Bit 7 of data_type is set when inflate() stopped at a block boundary, bit 6 if
+		// that block is the last one.
+		if((pStream->data_type & 128) != 0 && (pStream->data_type & 64) == 0)
+		{
+			hlULongLong uiLastOutput = this->pRestartPoints->empty() ? 0 : this->pRestartPoints->back().uiOutput;
+
+			if(this->uiPointer >= uiLastOutput + HL_INFLATE_RESTART_SPACING)
+			{
+				this->AddRestartPoint();
+			}
+		}
+	}
+
+	return uiOffset;
+}
+
+hlBool CInflateStream::Write(hlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+hlUInt CInflateStream::Write(const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	LastError.SetErrorMessage("Stream not in write mode.");
+	return 0;
+}
+
+//
+// MapInput()
+// Maps the next view of compressed data and hands it to zlib.
+//
+hlBool CInflateStream::MapInput()
+{
+	if(this->uiInput >= this->uiMappingSize)
+	{
+		LastError.SetErrorMessage("Error inflating data: unexpected end of compressed data.");
+		return hlFalse;
+	}
+
+	hlULongLong uiLength = this->uiMappingSize - this->uiInput;
+	if(uiLength > HL_DEFAULT_VIEW_SIZE)
+	{
+		uiLength = HL_DEFAULT_VIEW_SIZE;
+	}
+
+	if(!this->Mapping.Map(this->pView, this->uiMappingOffset + this->uiInput, uiLength))
+	{
+		return hlFalse;
+	}
+
+	z_stream *pStream = static_cast<z_stream *>(this->pZStream);
+
+	pStream->next_in = static_cast<Bytef *>(const_cast<hlVoid *>(this->pView->GetView()));
+	pStream->avail_in = static_cast<uInt>(uiLength);
+
+	this->uiInput += uiLength;
+
+	return hlTrue;
+}
+
+//
+// Restart()
+// Moves the inflater to the closest restart point at or before uiPointer, unless the
+// current position is already closer.  The caller inflates forward from there.
+//
+hlVoid CInflateStream::Restart(hlULongLong uiPointer)
+{
+	const InflateRestartPoint *pPoint = 0;
+	for(CRestartPointVector::const_reverse_iterator i = this->pRestartPoints->rbegin(); i != this->pRestartPoints->rend(); ++i)
+	{
+		if(i->uiOutput <= uiPointer)
+		{
+			pPoint = &*i;
+			break;
+		}
+	}
+
+	hlULongLong uiOutput = pPoint != 0 ? pPoint->uiOutput : 0;
+
+	if(uiPointer >= this->uiPointer && uiOutput <= this->uiPointer)
+	{
+		return;
+	}
+
+	z_stream *pStream = static_cast<z_stream *>(this->pZStream);
+
+	inflateReset(pStream);
+	pStream->next_in = 0;
+	pStream->avail_in = 0;
+
+	this->bEnd = hlFalse;
+	this->uiPointer = 0;
+	this->uiInput = 0;
+
+	if(pPoint != 0)
+	{
+		if(pPoint->uiBits != 0)
+		{
+			// The block started part way through a byte, feed its remaining bits back in.
+			Mapping::CView *pByteView = 0;
+			if(!this->Mapping.Map(pByteView, this->uiMappingOffset + pPoint->uiInput - 1, 1))
+			{
+				// Fall back to inflating from the beginning.
+				return;
+			}
+
+			hlByte uiByte = *static_cast<const hlByte *>(pByteView->GetView());
+
+			this->Mapping.Unmap(pByteView);
+
+			inflatePrime(pStream, static_cast<int>(pPoint->uiBits), uiByte >> (8 - pPoint->uiBits));
+		}
+
+		inflateSetDictionary(pStream, pPoint->lpWindow, pPoint->uiWindowSize);
+
+		this->uiPointer = pPoint->uiOutput;
+		this->uiInput = pPoint->uiInput;
+	}
+}
+
+hlVoid CInflateStream::AddRestartPoint()
+{
+	z_stream *pStream = static_cast<z_stream *>(this->pZStream);
+
+	InflateRestartPoint Point;
+	Point.uiInput = this->uiInput - static_cast<hlULongLong>(pStream->avail_in);
+	Point.uiOutput = this->uiPointer;
+	Point.uiBits = static_cast<hlUInt>(pStream->data_type & 7);
+	Point.lpWindow = new hlByte[HL_INFLATE_WINDOW_SIZE];
+
+	uInt uiWindowSize = HL_INFLATE_WINDOW_SIZE;
+	if(inflateGetDictionary(pStream, Point.lpWindow, &uiWindowSize) != Z_OK)
+	{
+		delete []Point.lpWindow;
+		return;
+	}
+
+	Point.uiWindowSize = static_cast<hlUInt>(uiWindowSize);
+
+	this->pRestartPoints->push_back(Point);
+}
+
+hlVoid CInflateStream::ClearRestartPoints()
+{
+	for(CRestartPointVector::iterator i = this->pRestartPoints->begin(); i != this->pRestartPoints->end(); ++i)
+	{
+		delete []i->lpWindow;
+	}
+
+	this->pRestartPoints->clear();
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "InputPool.h"
+#include "Package.h"
+
+using namespace HLLib;
+
+//
+// CInputPool
+// The writing thread calls Wait() for each job in Jobs, in order, before it
+// writes the entry and Release() once it is done with the entry's data.  Each
+// worker may keep two finished jobs waiting to be written; the writing thread
+// runs a job itself rather than wait for a worker to get to it.  Failed jobs
+// keep a copy of the error in pError.
+//
+
+CInputPool::CInputPool(const CInputPoolJobVector &Jobs, PInputPoolProc pInputProc, const hlVoid *pUserData) : Jobs(Jobs), pInputProc(pInputProc), pUserData(pUserData), pContext(&GetContext()), pSlots(0), uiNext(0), bCancel(hlFalse), lpThreads(0), uiThreadCount(0)
+{
+	this->uiThreadCount = GetContext().uiExtractThreadCount;
+	if(this->uiThreadCount == 0)
+	{
+		this->uiThreadCount = Threading::CThread::GetProcessorCount();
+	}
+	if(this->uiThreadCount > static_cast<hlUInt>(Jobs.size()))
+	{
+		this->uiThreadCount = static_cast<hlUInt>(Jobs.size());
+	}
+	if(this->uiThreadCount < 2)
+	{
+		// Not worth a pool, the writing thread reads everything.
+		this->uiThreadCount = 0;
+		return;
+	}
+
+	this->pSlots = new Threading::CSemaphore(this->uiThreadCount * 2);
+
+	this->lpThreads = new Threading::CThread[this->uiThreadCount];
+	for(hlUInt i = 0; i < this->uiThreadCount; i++)
+	{
+		this->lpThreads[i].Start(CInputPool::Worker, this);
+	}
+}
+
+//
+// ~CInputPool()
+// Stops the workers; jobs they haven't started are dropped.
+//
+CInputPool::~CInputPool()
+{
+	if(this->uiThreadCount == 0)
+	{
+		return;
+	}
+
+	{
+		Threading::CLock Lock(this->Mutex);
+
+		this->bCancel = hlTrue;
+	}
+
+	for(hlUInt i = 0; i < this->uiThreadCount; i++)
+	{
+		this->pSlots->Post();
+	}
+
+	for(hlUInt i = 0; i < this->uiThreadCount; i++)
+	{
+		this->lpThreads[i].Join();
+	}
+
+	delete []this->lpThreads;
+	delete this->pSlots;
+}
+
+//
+// Wait()
+// Returns once Job has been run, by a worker or on the calling thread.
+//
+hlVoid CInputPool::Wait(InputPoolJob &Job)
+{
+	if(Job.pDone == 0)
+	{
+		return;
+	}
+
+	hlBool bClaimed;
+	{
+		Threading::CLock Lock(this->Mutex);
+
+		bClaimed = Job.bClaimed;
+		Job.bClaimed = hlTrue;
+	}
+
+	if(!bClaimed)
+	{
+		this->Run(Job);
+	}
+	else
+	{
+		Job.pDone->Wait();
+	}
+}
+
+//
+// Release()
+// Frees the slot a worker's job was holding.
+//
+hlVoid CInputPool::Release(InputPoolJob &Job)
+{
+	if(Job.bWorker)
+	{
+		this->pSlots->Post();
+	}
+}
+
+hlVoid CInputPool::Run(InputPoolJob &Job)
+{
+	Job.bResult = this->pInputProc(Job, this->pUserData);
+	if(!Job.bResult)
+	{
+		Job.pError = new CError(LastError);
+	}
+}
+
+hlVoid CInputPool::Worker(hlVoid *pUserData)
+{
+	CInputPool &Pool = *static_cast<CInputPool *>(pUserData);
+
+	CContext Context;
+	Context.CopyOptions(*Pool.pContext);
+
+	CContextScope ContextScope(Context);
+
+	while(hlTrue)
+	{
+		Pool.pSlots->Wait();
+
+		InputPoolJob *pJob = 0;
+		{
+			Threading::CLock Lock(Pool.Mutex);
+
+			if(!Pool.bCancel)
+			{
+				while(Pool.uiNext < Pool.Jobs.size() && (Pool.Jobs[Pool.uiNext]->pDone == 0 || Pool.Jobs[Pool.uiNext]->bClaimed))
+				{
+					Pool.uiNext++;
+				}
+
+				if(Pool.uiNext < Pool.Jobs.size())
+				{
+					pJob = Pool.Jobs[Pool.uiNext++];
+					pJob->bClaimed = hlTrue;
+					pJob->bWorker = hlTrue;
+				}
+			}
+		}
+
+		if(pJob == 0)
+		{
+			// Pass the slot on so the other workers see there is nothing left.
+			Pool.pSlots->Post();
+			break;
+		}
+
+		Pool.Run(*pJob);
+
+		pJob->pDone->Post();
+	}
+}
+
+//
+// OpenInput()
+// Returns the opened stream to read an entry from, creating it if the entry
+// is a package file.
+//
+Streams::IStream *CInputPool::OpenInput(const CDirectoryItem *pItem, Streams::IStream *pInput)
+{
+	if(pInput != 0)
+	{
+		return pInput;
+	}
+
+	const CDirectoryFile *pFile = static_cast<const CDirectoryFile *>(pItem);
+
+	if(!pFile->GetPackage()->CreateStream(pFile, pInput))
+	{
+		return 0;
+	}
+
+	if(!pInput->Open(HL_MODE_READ))
+	{
+		pFile->GetPackage()->ReleaseStream(pInput);
+		return 0;
+	}
+
+	return pInput;
+}
+
+hlVoid CInputPool::CloseInput(const CDirectoryItem *pItem, Streams::IStream *pInput, Streams::IStream *pOpenedInput)
+{
+	if(pInput == 0 && pOpenedInput != 0)
+	{
+		pOpenedInput->Close();
+		pItem->GetPackage()->ReleaseStream(pOpenedInput);
+	}
+}
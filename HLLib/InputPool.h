@@ -0,0 +1,85 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef INPUTPOOL_H
+#define INPUTPOOL_H
+
+#include "stdafx.h"
+#include "DirectoryItems.h"
+#include "Stream.h"
+#include "Thread.h"
+
+namespace HLLib
+{
+	class CContext;
+	class CError;
+
+	//
+	// InputPoolJob
+	// The part of a writer's entry the input pool works on.  Only entries with a
+	// pDone semaphore are read ahead.
+	//
+	struct InputPoolJob
+	{
+		hlBool bClaimed;
+		hlBool bWorker;
+		hlBool bResult;
+		CError *pError;
+		Threading::CSemaphore *pDone;
+	};
+
+	typedef std::vector<InputPoolJob *> CInputPoolJobVector;
+
+	typedef hlBool (*PInputPoolProc)(InputPoolJob &Job, const hlVoid *pUserData);
+
+	//
+	// CInputPool
+	// Reads a writer's small entries into memory on a pool of worker threads, a
+	// bounded number ahead of the entry being written.
+	//
+	class CInputPool
+	{
+	private:
+		const CInputPoolJobVector &Jobs;
+		PInputPoolProc pInputProc;
+		const hlVoid *pUserData;
+		const CContext *pContext;
+
+		Threading::CMutex Mutex;
+		Threading::CSemaphore *pSlots;
+		hlUInt uiNext;
+		hlBool bCancel;
+
+		Threading::CThread *lpThreads;
+		hlUInt uiThreadCount;
+
+	public:
+		CInputPool(const CInputPoolJobVector &Jobs, PInputPoolProc pInputProc, const hlVoid *pUserData);
+		~CInputPool();
+
+		hlVoid Wait(InputPoolJob &Job);
+		hlVoid Release(InputPoolJob &Job);
+
+		static Streams::IStream *OpenInput(const CDirectoryItem *pItem, Streams::IStream *pInput);
+		static hlVoid CloseInput(const CDirectoryItem *pItem, Streams::IStream *pInput, Streams::IStream *pOpenedInput);
+
+	private:
+		hlVoid Run(InputPoolJob &Job);
+
+		static hlVoid Worker(hlVoid *pUserData);
+
+	private:
+		CInputPool(const CInputPool &);
+		CInputPool &operator=(const CInputPool &);
+	};
+}
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "LZMAStream.h"
+
+#ifdef USE_LZMA
+
+#include <lzma.h>
+
+using namespace HLLib;
+using namespace HLLib::Streams;
+
+#define HL_LZMA_SKIP_BUFFER_SIZE 32768
+
+static const hlChar *GetLZMAErrorMessage(lzma_ret eResult)
+{
+	switch(eResult)
+	{
+	case LZMA_MEM_ERROR:
+		return "out of memory";
+	case LZMA_OPTIONS_ERROR:
+		return "unsupported properties";
+	case LZMA_DATA_ERROR:
+		return "corrupt data";
+	case LZMA_BUF_ERROR:
+		return "unexpected end of compressed data";
+	default:
+		return "unknown error";
+	}
+}
+
+//
+// CLZMAStream
+// Decodes a raw LZMA stream (five property bytes followed by compressed data, no
+// end marker required) straight out of a mapping.  The decoded size is always
+// known up front, so the dictionary is never allocated larger than the data it
+// has to hold; small lumps with a large encoder dictionary stay cheap.  LZMA
+// can't be resumed part way through, so seeking backwards decodes again from the
+// start.
+//
+
+CLZMAStream::CLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, const hlByte *lpProperties, hlULongLong uiLength) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Mapping(Mapping), pView(0), uiMappingOffset(uiMappingOffset), uiMappingSize(uiMappingSize), uiPointer(0), uiLength(uiLength), pLZMAStream(0), uiInput(0), bEnd(hlFalse)
+{
+	memcpy(this->lpProperties, lpProperties, sizeof(this->lpProperties));
+}
+
+CLZMAStream::~CLZMAStream()
+{
+	this->Close();
+}
+
+HLStreamType CLZMAStream::GetType() const
+{
+	return HL_STREAM_LZMA;
+}
+
+const Mapping::CMapping &CLZMAStream::GetMapping() const
+{
+	return this->Mapping;
+}
+
+const hlChar *CLZMAStream::GetFileName() const
+{
+	return "";
+}
+
+hlBool CLZMAStream::GetOpened() const
+{
+	return this->bOpened;
+}
+
+hlUInt CLZMAStream::GetMode() const
+{
+	return this->uiMode;
+}
+
+hlBool CLZMAStream::Open(hlUInt uiMode)
+{
+	this->Close();
+
+	if((uiMode & HL_MODE_READ) == 0 || (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessageFormated("Invalid open mode (%#.8x).", uiMode);
+		return hlFalse;
+	}
+
+	if((this->Mapping.GetMode() & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Mapping does not have read permissions.");
+		return hlFalse;
+	}
+
+	if(!this->CreateDecoder())
+	{
+		return hlFalse;
+	}
+
+	this->bOpened = hlTrue;
+	this->uiMode = uiMode;
+
+	return hlTrue;
+}
+
+hlVoid CLZMAStream::Close()
+{
+	this->bOpened = hlFalse;
+	this->uiMode = HL_MODE_INVALID;
+
+	this->DestroyDecoder();
+
+	this->Mapping.Unmap(this->pView);
+}
+
+hlULongLong CLZMAStream::GetStreamSize() const
+{
+	return this->bOpened ? this->uiLength : 0;
+}
+
+hlULongLong CLZMAStream::GetStreamPointer() const
+{
+	return this->uiPointer;
+}
+
+hlULongLong CLZMAStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	hlULongLong uiPointer = this->uiPointer;
+	switch(eSeekMode)
+	{
+		case HL_SEEK_BEGINNING:
+			uiPointer = 0;
+			break;
+		case HL_SEEK_CURRENT:
+
+			break;
+		case HL_SEEK_END:
+			uiPointer = this->uiLength;
+			break;
+	}
+
+	hlLongLong iPointer = static_cast<hlLongLong>(uiPointer) + iOffset;
+
+	if(iPointer < 0)
+	{
+		iPointer = 0;
+	}
+	else if(iPointer > static_cast<hlLongLong>(this->uiLength))
+	{
+		iPointer = static_cast<hlLongLong>(this->uiLength);
+	}
+
+	uiPointer = static_cast<hlULongLong>(iPointer);
+
+	if(uiPointer < this->uiPointer)
+	{
+		this->DestroyDecoder();
+
+		if(!this->CreateDecoder())
+		{
+			return this->uiPointer;
+		}
+	}
+
+	// Decode and discard up to the requested position.
+	hlByte lpBuffer[HL_LZMA_SKIP_BUFFER_SIZE];
+	while(this->uiPointer < uiPointer)
+	{
+		hlULongLong uiBytes = uiPointer - this->uiPointer;
+		if(uiBytes > sizeof(lpBuffer))
+		{
+			uiBytes = sizeof(lpBuffer);
+		}
+
+		if(this->Read(lpBuffer, static_cast<hlUInt>(uiBytes)) == 0)
+		{
+			break;
+		}
+	}
+
+	return this->uiPointer;
+}
+
+hlBool CLZMAStream::Read(hlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+hlUInt CLZMAStream::Read(hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	if((this->uiMode & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Stream not in read mode.");
+		return 0;
+	}
+
+	lzma_stream *pStream = static_cast<lzma_stream *>(this->pLZMAStream);
+
+	if(pStream == 0)
+	{
+		return 0;
+	}
+
+	if(static_cast<hlULongLong>(uiBytes) > this->uiLength - this->uiPointer)
+	{
+		uiBytes = static_cast<hlUInt>(this->uiLength - this->uiPointer);
+	}
+
+	hlUInt uiOffset = 0;
+	while(uiOffset < uiBytes && !this->bEnd)
+	{
+		if(pStream->avail_in == 0 && !this->MapInput())
+		{
+			break;
+		}
+
+		pStream->next_out = static_cast<uint8_t *>(lpData) + uiOffset;
+		pStream->avail_out = uiBytes - uiOffset;
+
+		lzma_ret eResult = lzma_code(pStream, LZMA_RUN);
+
+		hlUInt uiDecoded = (uiBytes - uiOffset) - static_cast<hlUInt>(pStream->avail_out);
+		uiOffset += uiDecoded;
+		this->uiPointer += static_cast<hlULongLong>(uiDecoded);
+
+		if(eResult == LZMA_STREAM_END)
+		{
+			this->bEnd = hlTrue;
+			break;
+		}
+		else if(eResult != LZMA_OK)
+		{
+			LastError.SetErrorMessageFormated("Error decompressing LZMA data: %s.", GetLZMAErrorMessage(eResult));
+			break;
+		}
+	}
+
+	return uiOffset;
+}
+
+hlBool CLZMAStream::Write(hlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+hlUInt CLZMAStream::Write(const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	LastError.SetErrorMessage("Stream not in write mode.");
+	return 0;
+}
+
+//
+// MapInput()
+// Maps the next view of compressed data and hands it to the decoder.
+//
+hlBool CLZMAStream::MapInput()
+{
+	if(this->uiInput >= this->uiMappingSize)
+	{
+		LastError.SetErrorMessageFormated("Error decompressing LZMA data: %s.", GetLZMAErrorMessage(LZMA_BUF_ERROR));
+		return hlFalse;
+	}
+
+	hlULongLong uiLength = this->uiMappingSize - this->uiInput;
+	if(uiLength > HL_DEFAULT_VIEW_SIZE)
+	{
+		uiLength = HL_DEFAULT_VIEW_SIZE;
+	}
+
+	if(!this->Mapping.Map(this->pView, this->uiMappingOffset + this->uiInput, uiLength))
+	{
+		return hlFalse;
+	}
+
+	lzma_stream *pStream = static_cast<lzma_stream *>(this->pLZMAStream);
+
+	pStream->next_in = static_cast<const uint8_t *>(this->pView->GetView());
+	pStream->avail_in = static_cast<size_t>(uiLength);
+
+	this->uiInput += uiLength;
+
+	return hlTrue;
+}
+
+//
+// CreateDecoder()
+// Sets up a decoder positioned at the start of the data.
+//
+hlBool CLZMAStream::CreateDecoder()
+{
+	lzma_filter Filters[2];
+	Filters[0].id = LZMA_FILTER_LZMA1;
+	Filters[0].options = 0;
+	Filters[1].id = LZMA_VLI_UNKNOWN;
+	Filters[1].options = 0;
+
+	lzma_ret eResult = lzma_properties_decode(&Filters[0], 0, this->lpProperties, sizeof(this->lpProperties));
+	if(eResult != LZMA_OK)
+	{
+		LastError.SetErrorMessageFormated("Error initializing LZMA decoder: %s.", GetLZMAErrorMessage(eResult));
+		return hlFalse;
+	}
+
+	// The decoder never needs to look back further than the data it produces.
+	lzma_options_lzma *pOptions = static_cast<lzma_options_lzma *>(Filters[0].options);
+	if(static_cast<hlULongLong>(pOptions->dict_size) > this->uiLength)
+	{
+		pOptions->dict_size = this->uiLength > LZMA_DICT_SIZE_MIN ? static_cast<uint32_t>(this->uiLength) : LZMA_DICT_SIZE_MIN;
+	}
+
+	lzma_stream *pStream = new lzma_stream;
+	memset(pStream, 0, sizeof(lzma_stream));
+
+	eResult = lzma_raw_decoder(pStream, Filters);
+
+	free(Filters[0].options);
+
+	if(eResult != LZMA_OK)
+	{
+		LastError.SetErrorMessageFormated("Error initializing LZMA decoder: %s.", GetLZMAErrorMessage(eResult));
+		delete pStream;
+		return hlFalse;
+	}
+
+	this->pLZMAStream = pStream;
+
+	this->uiPointer = 0;
+	this->uiInput = 0;
+	this->bEnd = hlFalse;
+
+	return hlTrue;
+}
+
+hlVoid CLZMAStream::DestroyDecoder()
+{
+	if(this->pLZMAStream != 0)
+	{
+		lzma_stream *pStream = static_cast<lzma_stream *>(this->pLZMAStream);
+
+		lzma_end(pStream);
+		delete pStream;
+		this->pLZMAStream = 0;
+	}
+
+	this->uiPointer = 0;
+	this->uiInput = 0;
+	this->bEnd = hlFalse;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef LZMASTREAM_H
+#define LZMASTREAM_H
+
+#include "stdafx.h"
+#include "Stream.h"
+#include "Mapping.h"
+
+#define HL_LZMA_PROPERTIES_SIZE 5
+
+namespace HLLib
+{
+	namespace Streams
+	{
+		class HLLIB_API CLZMAStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			Mapping::CMapping &Mapping;
+			Mapping::CView *pView;
+
+			hlULongLong uiMappingOffset;
+			hlULongLong uiMappingSize;
+
+			hlByte lpProperties[HL_LZMA_PROPERTIES_SIZE];
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			hlVoid *pLZMAStream;
+			hlULongLong uiInput;
+			hlBool bEnd;
+
+		public:
+			CLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, const hlByte *lpProperties, hlULongLong uiLength);
+			~CLZMAStream();
+
+			virtual HLStreamType GetType() const;
+
+			const Mapping::CMapping &GetMapping() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+		private:
+			hlBool MapInput();
+
+			hlBool CreateDecoder();
+			hlVoid DestroyDecoder();
+		};
+	}
+}
+
+#endif
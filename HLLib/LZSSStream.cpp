@@ -0,0 +1,363 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "LZSSStream.h"
+
+using namespace HLLib;
+using namespace HLLib::Streams;
+
+// Matches are coded as a 12 bit window position and a 4 bit length; anything
+// shorter than HL_LZSS_THRESHOLD + 1 bytes is stored as a literal instead.
+#define HL_LZSS_MATCH_SIZE 18
+#define HL_LZSS_THRESHOLD 2
+#define HL_LZSS_SKIP_BUFFER_SIZE 32768
+
+//
+// CLZSSStream
+// Decodes LZSS data in the layout of Okumura's reference coder, the one the Quake
+// and Half-Life tools borrowed: a flag byte, read least significant bit first,
+// tells whether each of the next eight items is a literal byte or a two byte
+// match into a 4 KB window that starts out filled with spaces.  Compressed data
+// is read straight out of the mapping one view at a time and only the window is
+// kept, so memory use does not depend on the size of the data.  Seeking backwards
+// decodes again from the start.
+//
+
+CLZSSStream::CLZSSStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, hlULongLong uiLength) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Mapping(Mapping), pView(0), uiMappingOffset(uiMappingOffset), uiMappingSize(uiMappingSize), uiPointer(0), uiLength(uiLength), lpInput(0), uiInputSize(0), uiInput(0), uiWindowPosition(0), uiFlags(0), uiMatchPosition(0), uiMatchLength(0)
+{
+
+}
+
+CLZSSStream::~CLZSSStream()
+{
+	this->Close();
+}
+
+HLStreamType CLZSSStream::GetType() const
+{
+	return HL_STREAM_LZSS;
+}
+
+const Mapping::CMapping &CLZSSStream::GetMapping() const
+{
+	return this->Mapping;
+}
+
+const hlChar *CLZSSStream::GetFileName() const
+{
+	return "";
+}
+
+hlBool CLZSSStream::GetOpened() const
+{
+	return this->bOpened;
+}
+
+hlUInt CLZSSStream::GetMode() const
+{
+	return this->uiMode;
+}
+
+hlBool CLZSSStream::Open(hlUInt uiMode)
+{
+	this->Close();
+
+	if((uiMode & HL_MODE_READ) == 0 || (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessageFormated("Invalid open mode (%#.8x).", uiMode);
+		return hlFalse;
+	}
+
+	if((this->Mapping.GetMode() & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Mapping does not have read permissions.");
+		return hlFalse;
+	}
+
+	this->Reset();
+
+	this->bOpened = hlTrue;
+	this->uiMode = uiMode;
+
+	return hlTrue;
+}
+
+hlVoid CLZSSStream::Close()
+{
+	this->bOpened = hlFalse;
+	this->uiMode = HL_MODE_INVALID;
+
+	this->Mapping.Unmap(this->pView);
+
+	this->uiPointer = 0;
+	this->lpInput = 0;
+	this->uiInputSize = 0;
+	this->uiInput = 0;
+}
+
+hlULongLong CLZSSStream::GetStreamSize() const
+{
+	return this->bOpened ? this->uiLength : 0;
+}
+
+hlULongLong CLZSSStream::GetStreamPointer() const
+{
+	return this->uiPointer;
+}
+
+hlULongLong CLZSSStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	hlULongLong uiPointer = this->uiPointer;
+	switch(eSeekMode)
+	{
+		case HL_SEEK_BEGINNING:
+			uiPointer = 0;
+			break;
+		case HL_SEEK_CURRENT:
+
+			break;
+		case HL_SEEK_END:
+			uiPointer = this->uiLength;
+			break;
+	}
+
+	hlLongLong iPointer = static_cast<hlLongLong>(uiPointer) + iOffset;
+
+	if(iPointer < 0)
+	{
+		iPointer = 0;
+	}
+	else if(iPointer > static_cast<hlLongLong>(this->uiLength))
+	{
+		iPointer = static_cast<hlLongLong>(this->uiLength);
+	}
+
+	uiPointer = static_cast<hlULongLong>(iPointer);
+
+	if(uiPointer < this->uiPointer)
+	{
+		this->Reset();
+	}
+
+	// Decode and discard up to the requested position.
+	hlByte lpBuffer[HL_LZSS_SKIP_BUFFER_SIZE];
+	while(this->uiPointer < uiPointer)
+	{
+		hlULongLong uiBytes = uiPointer - this->uiPointer;
+		if(uiBytes > sizeof(lpBuffer))
+		{
+			uiBytes = sizeof(lpBuffer);
+		}
+
+		if(this->Read(lpBuffer, static_cast<hlUInt>(uiBytes)) == 0)
+		{
+			break;
+		}
+	}
+
+	return this->uiPointer;
+}
+
+hlBool CLZSSStream::Read(hlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+hlUInt CLZSSStream::Read(hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	if((this->uiMode & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Stream not in read mode.");
+		return 0;
+	}
+
+	if(static_cast<hlULongLong>(uiBytes) > this->uiLength - this->uiPointer)
+	{
+		uiBytes = static_cast<hlUInt>(this->uiLength - this->uiPointer);
+	}
+
+	hlByte *lpOutput = static_cast<hlByte *>(lpData);
+
+	hlUInt uiOffset = 0;
+	while(uiOffset < uiBytes)
+	{
+		// Finish the match left over from the last read first.
+		if(this->uiMatchLength != 0)
+		{
+			hlUInt uiCount = uiBytes - uiOffset;
+			if(uiCount > this->uiMatchLength)
+			{
+				uiCount = this->uiMatchLength;
+			}
+
+			for(hlUInt i = 0; i < uiCount; i++)
+			{
+				hlByte uiByte = this->lpWindow[this->uiMatchPosition];
+				this->uiMatchPosition = (this->uiMatchPosition + 1) & (HL_LZSS_WINDOW_SIZE - 1);
+
+				lpOutput[uiOffset++] = uiByte;
+				this->lpWindow[this->uiWindowPosition] = uiByte;
+				this->uiWindowPosition = (this->uiWindowPosition + 1) & (HL_LZSS_WINDOW_SIZE - 1);
+			}
+
+			this->uiMatchLength -= uiCount;
+			continue;
+		}
+
+		// The high byte counts down the items left in the current flag byte.
+		this->uiFlags >>= 1;
+		if((this->uiFlags & 0x100) == 0)
+		{
+			hlByte uiFlags;
+			if(!this->ReadInput(uiFlags))
+			{
+				break;
+			}
+
+			this->uiFlags = 0xff00 | uiFlags;
+		}
+
+		if(this->uiFlags & 1)
+		{
+			hlByte uiByte;
+			if(!this->ReadInput(uiByte))
+			{
+				break;
+			}
+
+			lpOutput[uiOffset++] = uiByte;
+			this->lpWindow[this->uiWindowPosition] = uiByte;
+			this->uiWindowPosition = (this->uiWindowPosition + 1) & (HL_LZSS_WINDOW_SIZE - 1);
+		}
+		else
+		{
+			hlByte uiLow, uiHigh;
+			if(!this->ReadInput(uiLow) || !this->ReadInput(uiHigh))
+			{
+				break;
+			}
+
+			this->uiMatchPosition = static_cast<hlUInt>(uiLow) | ((static_cast<hlUInt>(uiHigh) & 0xf0) << 4);
+			this->uiMatchLength = (static_cast<hlUInt>(uiHigh) & 0x0f) + HL_LZSS_THRESHOLD + 1;
+		}
+	}
+
+	this->uiPointer += static_cast<hlULongLong>(uiOffset);
+
+	return uiOffset;
+}
+
+hlBool CLZSSStream::Write(hlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+hlUInt CLZSSStream::Write(const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	LastError.SetErrorMessage("Stream not in write mode.");
+	return 0;
+}
+
+//
+// GetMaximumLength()
+// Returns the most uiMappingSize bytes of compressed data can decode to: a flag
+// byte followed by eight matches of the longest length, over and over.
+//
+hlULongLong CLZSSStream::GetMaximumLength(hlULongLong uiMappingSize)
+{
+	return (uiMappingSize / (1 + 8 * 2) + 1) * 8 * HL_LZSS_MATCH_SIZE;
+}
+
+//
+// ReadInput()
+// Returns the next byte of compressed data, mapping a new view when the current
+// one runs out.
+//
+hlBool CLZSSStream::ReadInput(hlByte &uiByte)
+{
+	if(this->uiInputSize == 0 && !this->MapInput())
+	{
+		return hlFalse;
+	}
+
+	uiByte = *this->lpInput++;
+	this->uiInputSize--;
+
+	return hlTrue;
+}
+
+//
+// MapInput()
+// Maps the next view of compressed data.
+//
+hlBool CLZSSStream::MapInput()
+{
+	if(this->uiInput >= this->uiMappingSize)
+	{
+		LastError.SetErrorMessage("Error decompressing LZSS data: unexpected end of compressed data.");
+		return hlFalse;
+	}
+
+	hlULongLong uiLength = this->uiMappingSize - this->uiInput;
+	if(uiLength > HL_DEFAULT_VIEW_SIZE)
+	{
+		uiLength = HL_DEFAULT_VIEW_SIZE;
+	}
+
+	if(!this->Mapping.Map(this->pView, this->uiMappingOffset + this->uiInput, uiLength))
+	{
+		return hlFalse;
+	}
+
+	this->lpInput = static_cast<const hlByte *>(this->pView->GetView());
+	this->uiInputSize = static_cast<hlUInt>(uiLength);
+
+	this->uiInput += uiLength;
+
+	return hlTrue;
+}
+
+//
+// Reset()
+// Positions the decoder at the start of the data.
+//
+hlVoid CLZSSStream::Reset()
+{
+	this->Mapping.Unmap(this->pView);
+
+	this->uiPointer = 0;
+	this->lpInput = 0;
+	this->uiInputSize = 0;
+	this->uiInput = 0;
+
+	memset(this->lpWindow, ' ', HL_LZSS_WINDOW_SIZE - HL_LZSS_MATCH_SIZE);
+	memset(this->lpWindow + HL_LZSS_WINDOW_SIZE - HL_LZSS_MATCH_SIZE, 0, HL_LZSS_MATCH_SIZE);
+	this->uiWindowPosition = HL_LZSS_WINDOW_SIZE - HL_LZSS_MATCH_SIZE;
+	this->uiFlags = 0;
+	this->uiMatchPosition = 0;
+	this->uiMatchLength = 0;
+}
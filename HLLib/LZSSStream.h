@@ -0,0 +1,87 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef LZSSSTREAM_H
+#define LZSSSTREAM_H
+
+#include "stdafx.h"
+#include "Stream.h"
+#include "Mapping.h"
+
+#define HL_LZSS_WINDOW_SIZE 4096
+
+namespace HLLib
+{
+	namespace Streams
+	{
+		class HLLIB_API CLZSSStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			Mapping::CMapping &Mapping;
+			Mapping::CView *pView;
+
+			hlULongLong uiMappingOffset;
+			hlULongLong uiMappingSize;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			const hlByte *lpInput;
+			hlUInt uiInputSize;
+			hlULongLong uiInput;
+
+			hlByte lpWindow[HL_LZSS_WINDOW_SIZE];
+			hlUInt uiWindowPosition;
+			hlUInt uiFlags;
+			hlUInt uiMatchPosition;
+			hlUInt uiMatchLength;
+
+		public:
+			CLZSSStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, hlULongLong uiLength);
+			~CLZSSStream();
+
+			virtual HLStreamType GetType() const;
+
+			const Mapping::CMapping &GetMapping() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+			static hlULongLong GetMaximumLength(hlULongLong uiMappingSize);
+
+		private:
+			hlBool ReadInput(hlByte &uiByte);
+			hlBool MapInput();
+
+			hlVoid Reset();
+		};
+	}
+}
+
+#endif
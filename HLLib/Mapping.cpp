@@ -15,7 +15,7 @@
 using namespace HLLib;
 using namespace HLLib::Mapping;
 
-CView::CView(CMapping *pMapping, hlVoid *lpView, hlULongLong uiAllocationOffset, hlULongLong uiAllocationLength, hlULongLong uiOffset, hlULongLong uiLength) : pMapping(pMapping), lpView(lpView), uiAllocationOffset(uiAllocationOffset), uiAllocationLength(uiAllocationLength), uiOffset(uiOffset), uiLength(uiLength == 0 ? uiAllocationLength - uiOffset : uiLength)
+CView::CView(CMapping *pMapping, hlVoid *lpView, hlULongLong uiAllocationOffset, hlULongLong uiAllocationLength, hlULongLong uiOffset, hlULongLong uiLength) : pMapping(pMapping), lpView(lpView), uiAllocationOffset(uiAllocationOffset), uiAllocationLength(uiAllocationLength), uiOffset(uiOffset), uiLength(uiLength == 0 ? uiAllocationLength - uiOffset : uiLength), pPrevious(0), pNext(0)
 {
 	assert(this->uiOffset + this->uiLength <= this->uiAllocationLength);
 }
@@ -60,7 +60,7 @@ const hlVoid *CView::GetAllocationView() const
 	return this->lpView;
 }
 
-CMapping::CMapping() : pViews(0)
+CMapping::CMapping() : pViews(0), uiTotalAllocations(0), uiTotalMemoryAllocated(0), uiTotalMemoryUsed(0)
 {
 
 }
@@ -77,42 +77,23 @@ const hlChar *CMapping::GetFileName() const
 
 hlUInt CMapping::GetTotalAllocations() const
 {
-	if(this->pViews == 0)
-	{
-		return 0;
-	}
+	Threading::CLock Lock(this->ViewsMutex);
 
-	return (hlUInt)this->pViews->size();
+	return this->uiTotalAllocations;
 }
 
 hlULongLong CMapping::GetTotalMemoryAllocated() const
 {
-	if(this->pViews == 0)
-	{
-		return 0;
-	}
+	Threading::CLock Lock(this->ViewsMutex);
 
-	hlULongLong uiTotal = 0;
-	for(CViewList::iterator i = this->pViews->begin(); i != this->pViews->end(); ++i)
-	{
-		uiTotal += (*i)->GetAllocationLength();
-	}
-	return uiTotal;
+	return this->uiTotalMemoryAllocated;
 }
 
 hlULongLong CMapping::GetTotalMemoryUsed() const
 {
-	if(this->pViews == 0)
-	{
-		return 0;
-	}
+	Threading::CLock Lock(this->ViewsMutex);
 
-	hlULongLong uiTotal = 0;
-	for(CViewList::iterator i = this->pViews->begin(); i != this->pViews->end(); ++i)
-	{
-		uiTotal += (*i)->GetLength();
-	}
-	return uiTotal;
+	return this->uiTotalMemoryUsed;
 }
 
 hlBool CMapping::Open(hlUInt uiMode)
@@ -121,7 +102,6 @@ hlBool CMapping::Open(hlUInt uiMode)
 
 	if(this->OpenInternal(uiMode))
 	{
-		this->pViews = new CViewList();
 		return hlTrue;
 	}
 	else
@@ -133,16 +113,20 @@ hlBool CMapping::Open(hlUInt uiMode)
 
 hlVoid CMapping::Close()
 {
-	if(this->pViews != 0)
+	while(this->pViews != 0)
 	{
-		for(CViewList::iterator i = this->pViews->begin(); i != this->pViews->end(); ++i)
-		{
-			this->UnmapInternal(**i);
-		}
-		delete this->pViews;
-		this->pViews = 0;
+		CView *pView = this->pViews;
+
+		this->UnlinkView(*pView);
+		this->UnmapInternal(*pView);
+
+		// Whoever still holds the view can no longer use it, but may still pass it to
+		// Unmap() which will then free it.
+		pView->pMapping = 0;
 	}
 
+	assert(this->uiTotalAllocations == 0);
+
 	this->CloseInternal();
 }
 
@@ -154,7 +138,7 @@ hlBool CMapping::Map(CView *&pView, hlULongLong uiOffset, hlULongLong uiLength)
 		return hlFalse;
 	}
 
-	if(pView != 0)
+	if(pView != 0 && pView->GetMapping() != 0)
 	{
 		if(pView->GetMapping() != this)
 		{
@@ -164,15 +148,33 @@ hlBool CMapping::Map(CView *&pView, hlULongLong uiOffset, hlULongLong uiLength)
 
 		if(uiOffset >= pView->GetAllocationOffset() && uiOffset + uiLength <= pView->GetAllocationOffset() + pView->GetAllocationLength())
 		{
+			Threading::CLock Lock(this->ViewsMutex);
+
+			this->uiTotalMemoryUsed -= pView->uiLength;
+
 			pView->uiOffset = uiOffset - pView->GetAllocationOffset();
 			pView->uiLength = uiLength;
+
+			this->uiTotalMemoryUsed += pView->uiLength;
 			return hlTrue;
 		}
 	}
 
 	if(this->Unmap(pView) && this->MapInternal(pView, uiOffset, uiLength))
 	{
-		this->pViews->push_back(pView);
+		Threading::CLock Lock(this->ViewsMutex);
+
+		pView->pPrevious = 0;
+		pView->pNext = this->pViews;
+		if(this->pViews != 0)
+		{
+			this->pViews->pPrevious = pView;
+		}
+		this->pViews = pView;
+
+		this->uiTotalAllocations++;
+		this->uiTotalMemoryAllocated += pView->uiAllocationLength;
+		this->uiTotalMemoryUsed += pView->uiLength;
 		return hlTrue;
 	}
 
@@ -186,27 +188,61 @@ hlBool CMapping::Unmap(CView *&pView)
 		return hlTrue;
 	}
 
+	if(pView->GetMapping() == 0)
+	{
+		// The view outlived the Close() of its mapping and is already unmapped.
+		delete pView;
+		pView = 0;
+
+		return hlTrue;
+	}
+
 	if(this->GetOpened() && pView->GetMapping() == this)
 	{
-		for(CViewList::iterator i = this->pViews->begin(); i != this->pViews->end(); ++i)
-		{
-			if(*i == pView)
-			{
-				this->UnmapInternal(*pView);
-				delete pView;
-				pView = 0;
-
-				this->pViews->erase(i);
-				return hlTrue;
-				break;
-			}
-		}
+		this->UnlinkView(*pView);
+
+		this->UnmapInternal(*pView);
+		delete pView;
+		pView = 0;
+
+		return hlTrue;
 	}
 
 	LastError.SetErrorMessage("View does not belong to mapping.");
 	return hlFalse;
 }
 
+//
+// UnlinkView()
+// Removes a view from the view list and the running totals.  Only the bookkeeping
+// is serialized, the platform unmap runs outside the lock.
+//
+hlVoid CMapping::UnlinkView(CView &View)
+{
+	Threading::CLock Lock(this->ViewsMutex);
+
+	if(View.pPrevious != 0)
+	{
+		View.pPrevious->pNext = View.pNext;
+	}
+	else
+	{
+		this->pViews = View.pNext;
+	}
+
+	if(View.pNext != 0)
+	{
+		View.pNext->pPrevious = View.pPrevious;
+	}
+
+	View.pPrevious = 0;
+	View.pNext = 0;
+
+	this->uiTotalAllocations--;
+	this->uiTotalMemoryAllocated -= View.uiAllocationLength;
+	this->uiTotalMemoryUsed -= View.uiLength;
+}
+
 hlVoid CMapping::UnmapInternal(CView &View)
 {
 
@@ -248,3 +284,35 @@ hlBool CMapping::CommitInternal(CView &View, hlULongLong uiOffset, hlULongLong u
 {
 	return hlTrue;
 }
+
+//
+// Prefetch()
+// Hints that the given range will be read soon.  This is advisory only and
+// never fails; mappings that can't make use of it ignore it.
+//
+hlVoid CMapping::Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const
+{
+	if(!this->GetOpened() || uiLength == 0)
+	{
+		return;
+	}
+
+	hlULongLong uiMappingSize = this->GetMappingSize();
+
+	if(uiOffset >= uiMappingSize)
+	{
+		return;
+	}
+
+	if(uiLength > uiMappingSize - uiOffset)
+	{
+		uiLength = uiMappingSize - uiOffset;
+	}
+
+	this->PrefetchInternal(uiOffset, uiLength);
+}
+
+hlVoid CMapping::PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const
+{
+
+}
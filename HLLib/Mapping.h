@@ -13,6 +13,7 @@
 #define MAPPING_H
 
 #include "stdafx.h"
+#include "Thread.h"
 
 namespace HLLib
 {
@@ -33,6 +34,9 @@ namespace HLLib
 			hlULongLong uiAllocationOffset;
 			hlULongLong uiAllocationLength;
 
+			CView *pPrevious;
+			CView *pNext;
+
 		public:
 			CView(CMapping *pMapping, hlVoid *lpView, hlULongLong uiAllocationOffset, hlULongLong uiAllocationLength, hlULongLong uiOffset = 0, hlULongLong uiLength = 0);
 			~CView();
@@ -47,12 +51,15 @@ namespace HLLib
 			hlULongLong GetAllocationLength() const;
 		};
 
-		typedef std::list<CView *> CViewList;
-
 		class HLLIB_API CMapping
 		{
 		private:
-			CViewList *pViews;
+			CView *pViews;
+			mutable Threading::CMutex ViewsMutex;
+
+			hlUInt uiTotalAllocations;
+			hlULongLong uiTotalMemoryAllocated;
+			hlULongLong uiTotalMemoryUsed;
 
 		public:
 			CMapping();
@@ -80,6 +87,8 @@ namespace HLLib
 			hlBool Commit(CView &View);
 			hlBool Commit(CView &View, hlULongLong uiOffset, hlULongLong uiLength);
 
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const;
+
 		private:
 			virtual hlBool OpenInternal(hlUInt uiMode) = 0;
 			virtual hlVoid CloseInternal() = 0;
@@ -88,6 +97,10 @@ namespace HLLib
 			virtual hlVoid UnmapInternal(CView &View);
 
 			virtual hlBool CommitInternal(CView &View, hlULongLong uiOffset, hlULongLong uiLength);
+
+			virtual hlVoid PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const;
+
+			hlVoid UnlinkView(CView &View);
 		};
 	}
 }
@@ -332,6 +332,25 @@ hlUInt CMappingStream::Write(const hlVoid *lpData, hlUInt uiBytes)
 	}
 }
 
+//
+// Prefetch()
+// Hints to the mapping that the given range of the stream will be read soon.
+//
+hlVoid CMappingStream::Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const
+{
+	if(!this->bOpened || uiOffset >= this->uiMappingSize)
+	{
+		return;
+	}
+
+	if(uiLength > this->uiMappingSize - uiOffset)
+	{
+		uiLength = this->uiMappingSize - uiOffset;
+	}
+
+	this->Mapping.Prefetch(this->uiMappingOffset + uiOffset, uiLength);
+}
+
 hlBool CMappingStream::Map(hlULongLong uiPointer)
 {
 	uiPointer = (uiPointer / this->uiViewSize) * this->uiViewSize;
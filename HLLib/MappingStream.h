@@ -62,6 +62,8 @@ namespace HLLib
 			virtual hlBool Write(hlChar cChar);
 			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
 
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const;
+
 		private:
 			hlBool Map(hlULongLong uiPointer);
 		};
@@ -15,7 +15,12 @@
 using namespace HLLib;
 using namespace HLLib::Streams;
 
-CMemoryStream::CMemoryStream(hlVoid *lpData, hlULongLong uiBufferSize) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), lpData(lpData), uiBufferSize(uiBufferSize), uiPointer(0), uiLength(0)
+CMemoryStream::CMemoryStream(hlVoid *lpData, hlULongLong uiBufferSize) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), lpData(lpData), uiBufferSize(uiBufferSize), bReadOnly(hlFalse), uiPointer(0), uiLength(0)
+{
+
+}
+
+CMemoryStream::CMemoryStream(const hlVoid *lpData, hlULongLong uiBufferSize) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), lpData(const_cast<hlVoid *>(lpData)), uiBufferSize(uiBufferSize), bReadOnly(hlTrue), uiPointer(0), uiLength(0)
 {
 
 }
@@ -69,6 +74,12 @@ hlBool CMemoryStream::Open(hlUInt uiMode)
 		return hlFalse;
 	}
 
+	if(this->bReadOnly && (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessage("Memory stream is read only.");
+		return hlFalse;
+	}
+
 	this->uiPointer = 0;
 	this->uiLength = (uiMode & HL_MODE_READ) ? this->uiBufferSize : 0;
 
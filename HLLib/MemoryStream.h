@@ -27,12 +27,14 @@ namespace HLLib
 
 			hlVoid *lpData;
 			hlULongLong uiBufferSize;
+			hlBool bReadOnly;
 
 			hlULongLong uiPointer;
 			hlULongLong uiLength;
 
 		public:
 			CMemoryStream(hlVoid *lpData, hlULongLong uiBufferSize);
+			CMemoryStream(const hlVoid *lpData, hlULongLong uiBufferSize);
 			~CMemoryStream();
 
 			virtual HLStreamType GetType() const;
@@ -11,6 +11,7 @@
 
 #include "HLLib.h"
 #include "PAKFile.h"
+#include "DirectoryTreeBuilder.h"
 #include "Streams.h"
 
 using namespace HLLib;
@@ -81,6 +82,7 @@ hlVoid CPAKFile::UnmapDataStructures()
 CDirectoryFolder *CPAKFile::CreateRoot()
 {
 	CDirectoryFolder *pRoot = new CDirectoryFolder(this);
+	CDirectoryTreeBuilder Builder(pRoot);
 
 	hlUInt uiItemCount = this->pHeader->uiDirectoryLength / sizeof(PAKDirectoryItem);
 
@@ -90,44 +92,7 @@ CDirectoryFolder *CPAKFile::CreateRoot()
 		hlChar lpFileName[56];
 		strcpy(lpFileName, this->lpDirectoryItems[i].lpItemName);
 
-		// Check if we have just a file, or if the file has directories we need to create.
-		if(strchr(lpFileName, '/') == 0 && strchr(lpFileName, '\\') == 0)
-		{
-			pRoot->AddFile(lpFileName, i);
-		}
-		else
-		{
-			// Tokenize the file path and create the directories.
-			CDirectoryFolder *pInsertFolder = pRoot;
-
-			hlChar lpTemp[56] = "";
-			hlChar *lpToken = strtok(lpFileName, "/\\");
-			while(lpToken != 0)
-			{
-				strcpy(lpTemp, lpToken);
-
-				lpToken = strtok(0, "/\\");
-
-				if(lpToken != 0)
-				{
-					// Check if the directory exists.
-					CDirectoryItem *pItem = pInsertFolder->GetItem(lpTemp);
-					if(pItem == 0 || pItem->GetType() == HL_ITEM_FILE)
-					{
-						// It doesn't, create it.
-						pInsertFolder = pInsertFolder->AddFolder(lpTemp);
-					}
-					else
-					{
-						// It does, use it.
-						pInsertFolder = static_cast<CDirectoryFolder *>(pItem);
-					}
-				}
-			}
-
-			// The file name is the last token, add it.
-			pInsertFolder->AddFile(lpTemp, i);
-		}
+		Builder.AddFile(lpFileName, i);
 	}
 
 	return pRoot;
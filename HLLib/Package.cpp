@@ -16,7 +16,29 @@
 
 using namespace HLLib;
 
-CPackage::CPackage() : bDeleteStream(hlFalse), bDeleteMapping(hlFalse), pStream(0), pMapping(0), pRoot(0), pStreams(0)
+#define HL_IMAGE_HANDLE_SIGNATURE 0x474d4948
+
+//
+// ImageHandle
+// What HLBorrowedImage.pHandle points to: the package that lent the image,
+// the view the image lies in, if any, and whether that view's mapping and
+// buffer are the image's own.
+//
+struct CPackage::ImageHandle
+{
+	hlUInt uiSignature;
+	HLPackageType ePackageType;
+	const CPackage *pPackage;
+	Mapping::CView *pView;
+	hlBool bOwnsBuffer;
+};
+
+//
+// CPackage()
+// The package belongs to the calling thread's current context, its options
+// apply to the package whichever context it is later used from.
+//
+CPackage::CPackage() : bDeleteStream(hlFalse), bDeleteMapping(hlFalse), pStream(0), pMapping(0), pRoot(0), pStreams(0), pContext(&HLLib::GetContext())
 {
 
 }
@@ -89,8 +111,6 @@ hlBool CPackage::Open(Streams::IStream *pStream, hlUInt uiMode, hlBool bDeleteSt
 		return hlFalse;
 	}
 
-	this->pStreams = new CStreamList();
-
 	return hlTrue;
 }
 
@@ -114,26 +134,20 @@ hlBool CPackage::Open(Mapping::CMapping *pMapping, hlUInt uiMode, hlBool bDelete
 		return hlFalse;
 	}
 
-	this->pStreams = new CStreamList();
-
 	return hlTrue;
 }
 
 hlVoid CPackage::Close()
 {
-	if(this->pStreams != 0)
+	while(this->pStreams != 0)
 	{
-		for(CStreamList::iterator i = this->pStreams->begin(); i != this->pStreams->end(); ++i)
-		{
-			Streams::IStream *pStream = *i;
+		Streams::IStream *pStream = this->pStreams;
 
-			pStream->Close();
-			this->ReleaseStreamInternal(*pStream);
-			delete pStream;
-		}
+		this->pStreams = pStream->pNext;
 
-		delete this->pStreams;
-		this->pStreams = 0;
+		pStream->Close();
+		this->ReleaseStreamInternal(*pStream);
+		delete pStream;
 	}
 
 	if(this->pMapping != 0)
@@ -363,6 +377,56 @@ hlBool CPackage::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 	return hlTrue;
 }
 
+// Validates an opened stream (i.e. a previously extracted copy of pFile) against the checksums
+// stored in the package.  HL_VALIDATES_ASSUMED_OK is returned if the package has none.
+hlBool CPackage::GetFileValidation(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	eValidation = HL_VALIDATES_ASSUMED_OK;
+
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
+	{
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
+
+	if(!Stream.GetOpened())
+	{
+		LastError.SetErrorMessage("Stream not opened.");
+		return hlFalse;
+	}
+
+	hlULongLong uiSize = 0;
+	if(!this->GetFileSizeExInternal(pFile, uiSize))
+	{
+		return hlFalse;
+	}
+
+	if(Stream.GetStreamSize() != uiSize)
+	{
+		eValidation = HL_VALIDATES_CORRUPT;
+		return hlTrue;
+	}
+
+	Streams::CReadAheadStream Input(Stream, this->GetContext().bReadAhead);
+
+	if(!Input.Open(HL_MODE_READ))
+	{
+		return hlFalse;
+	}
+
+	hlBool bResult = this->ValidateStreamInternal(pFile, Input, eValidation);
+
+	Input.Close();
+
+	return bResult;
+}
+
+hlBool CPackage::ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	eValidation = HL_VALIDATES_ASSUMED_OK;
+	return hlTrue;
+}
+
 hlBool CPackage::GetFileSize(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
 	uiSize = 0;
@@ -389,6 +453,171 @@ hlBool CPackage::GetFileSizeOnDisk(const CDirectoryFile *pFile, hlUInt &uiSize)
 	return this->GetFileSizeOnDiskInternal(pFile, uiSize);
 }
 
+hlBool CPackage::GetFileSizeEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	uiSize = 0;
+
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
+	{
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
+
+	return this->GetFileSizeExInternal(pFile, uiSize);
+}
+
+hlBool CPackage::GetFileSizeOnDiskEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	uiSize = 0;
+
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
+	{
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
+
+	return this->GetFileSizeOnDiskExInternal(pFile, uiSize);
+}
+
+//
+// GetFileSizeExInternal()
+// Only formats that can hold files of 4 GB or more need to override these.
+//
+hlBool CPackage::GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	hlUInt uiSize32 = 0;
+	if(!this->GetFileSizeInternal(pFile, uiSize32))
+	{
+		return hlFalse;
+	}
+
+	uiSize = static_cast<hlULongLong>(uiSize32);
+	return hlTrue;
+}
+
+hlBool CPackage::GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	hlUInt uiSize32 = 0;
+	if(!this->GetFileSizeOnDiskInternal(pFile, uiSize32))
+	{
+		return hlFalse;
+	}
+
+	uiSize = static_cast<hlULongLong>(uiSize32);
+	return hlTrue;
+}
+
+//
+// GetConcurrentExtraction()
+// Returns true if folder extraction may decode several files at once, each on
+// its own thread and with its own stream.
+//
+hlBool CPackage::GetConcurrentExtraction() const
+{
+	return this->GetOpened() && this->GetConcurrentExtractionInternal();
+}
+
+hlBool CPackage::GetConcurrentExtractionInternal() const
+{
+	return hlFalse;
+}
+
+//
+// SetStreamData()
+// Stores a value of the package's choosing on a stream it creates, for
+// ReleaseStreamInternal() to get back without looking the stream up.
+//
+hlVoid CPackage::SetStreamData(Streams::IStream &Stream, hlUInt uiData)
+{
+	Stream.uiPackageData = uiData;
+}
+
+hlUInt CPackage::GetStreamData(const Streams::IStream &Stream)
+{
+	return Stream.uiPackageData;
+}
+
+//
+// SetImageHandle()
+// Gives an image lent by the package a handle, which takes over pView.
+//
+hlVoid CPackage::SetImageHandle(HLBorrowedImage &Image, Mapping::CView *pView, hlBool bOwnsBuffer) const
+{
+	ImageHandle *pHandle = new ImageHandle;
+
+	pHandle->uiSignature = HL_IMAGE_HANDLE_SIGNATURE;
+	pHandle->ePackageType = this->GetType();
+	pHandle->pPackage = this;
+	pHandle->pView = pView;
+	pHandle->bOwnsBuffer = bOwnsBuffer;
+
+	Image.pHandle = pHandle;
+}
+
+//
+// ReleaseBorrowedImage()
+// Releases an image lent by a package of type ePackageType, and by pPackage
+// if it isn't 0, going by the image's handle alone.  Fails on images whose
+// handle doesn't match.  An image that owns its buffer can be released after
+// the package is closed.
+//
+hlBool CPackage::ReleaseBorrowedImage(HLBorrowedImage &Image, HLPackageType ePackageType, const CPackage *pPackage)
+{
+	ImageHandle *pHandle = static_cast<ImageHandle *>(Image.pHandle);
+
+	if(pHandle == 0 || pHandle->uiSignature != HL_IMAGE_HANDLE_SIGNATURE || pHandle->ePackageType != ePackageType || (pPackage != 0 && pHandle->pPackage != pPackage))
+	{
+		LastError.SetErrorMessage("Image was not borrowed from this package.");
+		return hlFalse;
+	}
+
+	Mapping::CView *pView = pHandle->pView;
+	if(pView != 0)
+	{
+		Mapping::CMapping *pMapping = pView->GetMapping();
+
+		if(pMapping == 0)
+		{
+			// The package's mapping was closed, which unmapped the view.
+			delete pView;
+		}
+		else
+		{
+			pMapping->Unmap(pView);
+
+			if(pHandle->bOwnsBuffer)
+			{
+				hlByte *lpBuffer = (hlByte *)static_cast<Mapping::CMemoryMapping *>(pMapping)->GetBuffer();
+
+				delete pMapping;
+				delete []lpBuffer;
+			}
+		}
+	}
+
+	pHandle->uiSignature = 0;
+	delete pHandle;
+
+	memset(&Image, 0, sizeof(HLBorrowedImage));
+
+	return hlTrue;
+}
+
+//
+// GetContext()
+// Returns the context the package was created in, which holds its options.
+// Errors still go to the caller's current context.
+//
+CContext &CPackage::GetContext() const
+{
+	return *this->pContext;
+}
+
+//
+// CreateStream()
+// Safe to call from several threads at once on an opened package, as is
+// ReleaseStream(); each stream must only be used by the thread that holds it.
+//
 hlBool CPackage::CreateStream(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
 {
 	pStream = 0;
@@ -404,7 +633,17 @@ hlBool CPackage::CreateStream(const CDirectoryFile *pFile, Streams::IStream *&pS
 		return hlFalse;
 	}
 
-	this->pStreams->push_back(pStream);
+	Threading::CLock Lock(this->StreamsMutex);
+
+	pStream->pPackage = this;
+	pStream->pPrevious = 0;
+	pStream->pNext = this->pStreams;
+	if(this->pStreams != 0)
+	{
+		this->pStreams->pPrevious = pStream;
+	}
+	this->pStreams = pStream;
+
 	return hlTrue;
 }
 
@@ -415,18 +654,32 @@ hlVoid CPackage::ReleaseStream(Streams::IStream *pStream) const
 		return;
 	}
 
-	for(CStreamList::iterator i = this->pStreams->begin(); i != this->pStreams->end(); ++i)
+	if(pStream == 0 || pStream->pPackage != this)
 	{
-		if(*i == pStream)
+		return;
+	}
+
+	{
+		Threading::CLock Lock(this->StreamsMutex);
+
+		if(pStream->pPrevious != 0)
+		{
+			pStream->pPrevious->pNext = pStream->pNext;
+		}
+		else
 		{
-			pStream->Close();
-			this->ReleaseStreamInternal(*pStream);
-			delete pStream;
+			this->pStreams = pStream->pNext;
+		}
 
-			this->pStreams->erase(i);
-			break;
+		if(pStream->pNext != 0)
+		{
+			pStream->pNext->pPrevious = pStream->pPrevious;
 		}
 	}
+
+	pStream->Close();
+	this->ReleaseStreamInternal(*pStream);
+	delete pStream;
 }
 
 hlVoid CPackage::ReleaseStreamInternal(Streams::IStream &Stream) const
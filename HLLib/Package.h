@@ -19,7 +19,7 @@
 
 namespace HLLib
 {
-	typedef std::list<Streams::IStream *> CStreamList;
+	class CContext;
 
 	class HLLIB_API CPackage
 	{
@@ -34,7 +34,12 @@ namespace HLLib
 		CDirectoryFolder *pRoot;
 
 	private:
-		mutable CStreamList *pStreams;
+		mutable Streams::IStream *pStreams;
+		mutable Threading::CMutex StreamsMutex;
+
+		CContext *pContext;
+
+		struct ImageHandle;
 
 	public:
 		CPackage();
@@ -69,12 +74,21 @@ namespace HLLib
 
 		hlBool GetFileExtractable(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		hlBool GetFileValidation(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		hlBool GetFileValidation(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		hlBool GetFileSize(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		hlBool GetFileSizeOnDisk(const CDirectoryFile *pFile, hlUInt &uiSize) const;
+		hlBool GetFileSizeEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		hlBool GetFileSizeOnDiskEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		hlBool GetConcurrentExtraction() const;
+
+		CContext &GetContext() const;
 
 		hlBool CreateStream(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
 		hlVoid ReleaseStream(Streams::IStream *pStream) const;
 
+		static hlBool ReleaseBorrowedImage(HLBorrowedImage &Image, HLPackageType ePackageType, const CPackage *pPackage = 0);
+
 	protected:
 		virtual hlBool MapDataStructures() = 0;
 		virtual hlVoid UnmapDataStructures() = 0;
@@ -94,12 +108,22 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const = 0;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const = 0;
+		virtual hlBool GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		virtual hlBool GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		virtual hlBool GetConcurrentExtractionInternal() const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const = 0;
 		virtual hlVoid ReleaseStreamInternal(Streams::IStream &Stream) const;
 
+		static hlVoid SetStreamData(Streams::IStream &Stream, hlUInt uiData);
+		static hlUInt GetStreamData(const Streams::IStream &Stream);
+
+		hlVoid SetImageHandle(HLBorrowedImage &Image, Mapping::CView *pView, hlBool bOwnsBuffer) const;
+
 	private:
 		hlBool Open(Streams::IStream *pStream, hlUInt uiMode, hlBool bDeleteStream);
 		hlBool Open(Mapping::CMapping *pMapping, hlUInt uiMode, hlBool bDeleteMapping);
@@ -15,7 +15,7 @@
 using namespace HLLib;
 using namespace HLLib::Streams;
 
-CProcStream::CProcStream(hlVoid *pUserData) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), pUserData(pUserData)
+CProcStream::CProcStream(hlVoid *pUserData) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Context(GetContext()), pUserData(pUserData)
 {
 
 }
@@ -49,13 +49,13 @@ hlBool CProcStream::Open(hlUInt uiMode)
 {
 	this->Close();
 
-	if(pOpenProc == 0)
+	if(this->Context.pOpenProc == 0)
 	{
 		LastError.SetErrorMessage("pOpenProc not set.");
 		return hlFalse;
 	}
 
-	if(!pOpenProc(uiMode, this->pUserData))
+	if(!this->Context.pOpenProc(uiMode, this->pUserData))
 	{
 		LastError.SetErrorMessage("pOpenProc() failed.");
 		return hlFalse;
@@ -71,9 +71,9 @@ hlVoid CProcStream::Close()
 {
 	if(this->bOpened)
 	{
-		if(pCloseProc != 0)
+		if(this->Context.pCloseProc != 0)
 		{
-			pCloseProc(this->pUserData);
+			this->Context.pCloseProc(this->pUserData);
 		}
 		this->bOpened = hlFalse;
 		this->uiMode = HL_MODE_INVALID;
@@ -87,13 +87,13 @@ hlULongLong CProcStream::GetStreamSize() const
 		return 0;
 	}
 
-	if(pSizeExProc != 0)
+	if(this->Context.pSizeExProc != 0)
 	{
-		return pSizeExProc(this->pUserData);
+		return this->Context.pSizeExProc(this->pUserData);
 	}
-	else if(pSizeProc != 0)
+	else if(this->Context.pSizeProc != 0)
 	{
-		return static_cast<hlULongLong>(pSizeProc(this->pUserData));
+		return static_cast<hlULongLong>(this->Context.pSizeProc(this->pUserData));
 	}
 
 	LastError.SetErrorMessage("pSizeProc not set.");
@@ -107,13 +107,13 @@ hlULongLong CProcStream::GetStreamPointer() const
 		return 0;
 	}
 
-	if(pTellExProc != 0)
+	if(this->Context.pTellExProc != 0)
 	{
-		return pTellExProc(this->pUserData);
+		return this->Context.pTellExProc(this->pUserData);
 	}
-	else if(pTellProc != 0)
+	else if(this->Context.pTellProc != 0)
 	{
-		return static_cast<hlULongLong>(pTellProc(this->pUserData));
+		return static_cast<hlULongLong>(this->Context.pTellProc(this->pUserData));
 	}
 
 	LastError.SetErrorMessage("pTellProc not set.");
@@ -127,13 +127,13 @@ hlULongLong CProcStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
 		return 0;
 	}
 
-	if(pSeekExProc != 0)
+	if(this->Context.pSeekExProc != 0)
 	{
-		return pSeekExProc(iOffset, eSeekMode, this->pUserData);
+		return this->Context.pSeekExProc(iOffset, eSeekMode, this->pUserData);
 	}
-	else if(pSeekProc != 0)
+	else if(this->Context.pSeekProc != 0)
 	{
-		return static_cast<hlULongLong>(pSeekExProc(iOffset, eSeekMode, this->pUserData));
+		return static_cast<hlULongLong>(this->Context.pSeekProc(iOffset, eSeekMode, this->pUserData));
 	}
 
 	LastError.SetErrorMessage("pSeekProc not set.");
@@ -153,13 +153,13 @@ hlBool CProcStream::Read(hlChar &cChar)
 		return hlFalse;
 	}
 
-	if(pReadProc == 0)
+	if(this->Context.pReadProc == 0)
 	{
 		LastError.SetErrorMessage("pReadProc not set.");
 		return hlFalse;
 	}
 
-	hlUInt uiBytesRead = pReadProc(&cChar, 1, this->pUserData);
+	hlUInt uiBytesRead = this->Context.pReadProc(&cChar, 1, this->pUserData);
 
 	if(uiBytesRead == 0)
 	{
@@ -182,13 +182,13 @@ hlUInt CProcStream::Read(hlVoid *lpData, hlUInt uiBytes)
 		return 0;
 	}
 
-	if(pReadProc == 0)
+	if(this->Context.pReadProc == 0)
 	{
 		LastError.SetErrorMessage("pReadProc not set.");
 		return 0;
 	}
 
-	hlUInt uiBytesRead = pReadProc(lpData, uiBytes, this->pUserData);
+	hlUInt uiBytesRead = this->Context.pReadProc(lpData, uiBytes, this->pUserData);
 
 	if(uiBytesRead == 0)
 	{
@@ -211,13 +211,13 @@ hlBool CProcStream::Write(hlChar cChar)
 		return hlFalse;
 	}
 
-	if(pWriteProc == 0)
+	if(this->Context.pWriteProc == 0)
 	{
 		LastError.SetErrorMessage("pWriteProc not set.");
 		return hlFalse;
 	}
 
-	hlUInt uiBytesWritten = pWriteProc(&cChar, 1, this->pUserData);
+	hlUInt uiBytesWritten = this->Context.pWriteProc(&cChar, 1, this->pUserData);
 
 	if(uiBytesWritten == 0)
 	{
@@ -240,13 +240,13 @@ hlUInt CProcStream::Write(const hlVoid *lpData, hlUInt uiBytes)
 		return 0;
 	}
 
-	if(pWriteProc == 0)
+	if(this->Context.pWriteProc == 0)
 	{
 		LastError.SetErrorMessage("pWriteProc not set.");
 		return 0;
 	}
 
-	hlUInt uiBytesWritten = pWriteProc(lpData, uiBytes, this->pUserData);
+	hlUInt uiBytesWritten = this->Context.pWriteProc(lpData, uiBytes, this->pUserData);
 
 	if(uiBytesWritten == 0)
 	{
@@ -17,6 +17,8 @@
 
 namespace HLLib
 {
+	class CContext;
+
 	namespace Streams
 	{
 		class HLLIB_API CProcStream : public IStream
@@ -25,6 +27,7 @@ namespace HLLib
 			hlBool bOpened;
 			hlUInt uiMode;
 
+			const CContext &Context;
 			hlVoid *pUserData;
 
 		public:
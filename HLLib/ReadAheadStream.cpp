@@ -0,0 +1,400 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "ReadAheadStream.h"
+#include "MappingStream.h"
+
+using namespace HLLib;
+using namespace HLLib::Streams;
+
+// Below this many bytes it isn't worth starting a thread.
+#define HL_READ_AHEAD_MINIMUM_SIZE (HL_DEFAULT_COPY_BUFFER_SIZE * 2)
+
+//
+// CReadAheadStream
+// Wraps an opened stream and reads it on a background thread into a small ring of
+// buffers so that reading the package overlaps with whatever the caller does with
+// the data (writing it out, checksumming it, etc.).  The wrapped stream must not be
+// used by anyone else while this stream is open.  Without bReadAhead, the current
+// context's read ahead option decides whether a reader thread is used.
+//
+
+CReadAheadStream::CReadAheadStream(IStream &Stream) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Stream(Stream), uiPointer(0), uiLength(0), bReadAhead(GetContext().bReadAhead), bThreaded(hlFalse), bEnd(hlFalse), bStop(hlFalse), pError(0), pFree(0), pFilled(0), lpBuffer(0), uiReadBuffer(0), uiReadOffset(0), bReadBuffer(hlFalse)
+{
+	memset(this->Buffers, 0, sizeof(this->Buffers));
+}
+
+CReadAheadStream::CReadAheadStream(IStream &Stream, hlBool bReadAhead) : bOpened(hlFalse), uiMode(HL_MODE_INVALID), Stream(Stream), uiPointer(0), uiLength(0), bReadAhead(bReadAhead), bThreaded(hlFalse), bEnd(hlFalse), bStop(hlFalse), pError(0), pFree(0), pFilled(0), lpBuffer(0), uiReadBuffer(0), uiReadOffset(0), bReadBuffer(hlFalse)
+{
+	memset(this->Buffers, 0, sizeof(this->Buffers));
+}
+
+CReadAheadStream::~CReadAheadStream()
+{
+	this->Close();
+}
+
+HLStreamType CReadAheadStream::GetType() const
+{
+	return HL_STREAM_READ_AHEAD;
+}
+
+const IStream &CReadAheadStream::GetStream() const
+{
+	return this->Stream;
+}
+
+const hlChar *CReadAheadStream::GetFileName() const
+{
+	return this->Stream.GetFileName();
+}
+
+hlBool CReadAheadStream::GetOpened() const
+{
+	return this->bOpened;
+}
+
+hlUInt CReadAheadStream::GetMode() const
+{
+	return this->uiMode;
+}
+
+hlBool CReadAheadStream::Open(hlUInt uiMode)
+{
+	this->Close();
+
+	if((uiMode & HL_MODE_READ) == 0 || (uiMode & HL_MODE_WRITE) != 0)
+	{
+		LastError.SetErrorMessageFormated("Invalid open mode (%#.8x).", uiMode);
+		return hlFalse;
+	}
+
+	if(!this->Stream.GetOpened() || (this->Stream.GetMode() & HL_MODE_READ) == 0)
+	{
+		LastError.SetErrorMessage("Stream not in read mode.");
+		return hlFalse;
+	}
+
+	this->uiPointer = this->Stream.GetStreamPointer();
+	this->uiLength = this->Stream.GetStreamSize();
+
+	this->bOpened = hlTrue;
+	this->uiMode = uiMode;
+
+	// Memory backed streams gain nothing from a reader thread.
+	switch(this->Stream.GetType())
+	{
+	case HL_STREAM_MEMORY:
+	case HL_STREAM_NULL:
+		break;
+	default:
+		if(this->bReadAhead && this->uiLength > this->uiPointer && this->uiLength - this->uiPointer >= HL_READ_AHEAD_MINIMUM_SIZE)
+		{
+			this->lpBuffer = new hlByte[HL_READ_AHEAD_BUFFER_COUNT * HL_DEFAULT_COPY_BUFFER_SIZE];
+			for(hlUInt i = 0; i < HL_READ_AHEAD_BUFFER_COUNT; i++)
+			{
+				this->Buffers[i].lpData = this->lpBuffer + i * HL_DEFAULT_COPY_BUFFER_SIZE;
+				this->Buffers[i].uiSize = 0;
+			}
+
+			this->Start();
+		}
+		break;
+	}
+
+	return hlTrue;
+}
+
+hlVoid CReadAheadStream::Close()
+{
+	this->Stop();
+
+	delete []this->lpBuffer;
+	this->lpBuffer = 0;
+	memset(this->Buffers, 0, sizeof(this->Buffers));
+
+	this->bOpened = hlFalse;
+	this->uiMode = HL_MODE_INVALID;
+	this->uiPointer = 0;
+	this->uiLength = 0;
+}
+
+hlULongLong CReadAheadStream::GetStreamSize() const
+{
+	return this->uiLength;
+}
+
+hlULongLong CReadAheadStream::GetStreamPointer() const
+{
+	return this->uiPointer;
+}
+
+hlULongLong CReadAheadStream::Seek(hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	hlULongLong uiPointer = this->uiPointer;
+	switch(eSeekMode)
+	{
+		case HL_SEEK_BEGINNING:
+			uiPointer = 0;
+			break;
+		case HL_SEEK_CURRENT:
+
+			break;
+		case HL_SEEK_END:
+			uiPointer = this->uiLength;
+			break;
+	}
+
+	hlLongLong iPointer = static_cast<hlLongLong>(uiPointer) + iOffset;
+
+	if(iPointer < 0)
+	{
+		iPointer = 0;
+	}
+	else if(iPointer > static_cast<hlLongLong>(this->uiLength))
+	{
+		iPointer = static_cast<hlLongLong>(this->uiLength);
+	}
+
+	if(static_cast<hlULongLong>(iPointer) != this->uiPointer)
+	{
+		// Whatever was read ahead is now useless, restart the reader at the new position.
+		hlBool bRestart = this->bThreaded;
+
+		this->Stop();
+
+		this->uiPointer = this->Stream.Seek(iPointer, HL_SEEK_BEGINNING);
+
+		if(bRestart)
+		{
+			this->Start();
+		}
+	}
+
+	return this->uiPointer;
+}
+
+hlBool CReadAheadStream::Read(hlChar &cChar)
+{
+	return this->Read(&cChar, 1) == 1;
+}
+
+hlUInt CReadAheadStream::Read(hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	if(!this->bThreaded)
+	{
+		uiBytes = this->Stream.Read(lpData, uiBytes);
+		this->uiPointer += static_cast<hlULongLong>(uiBytes);
+
+		return uiBytes;
+	}
+
+	hlUInt uiOffset = 0;
+	while(uiOffset < uiBytes && !this->bEnd)
+	{
+		if(!this->bReadBuffer)
+		{
+			this->pFilled->Wait();
+			this->bReadBuffer = hlTrue;
+			this->uiReadOffset = 0;
+		}
+
+		ReadAheadBuffer &Buffer = this->Buffers[this->uiReadBuffer];
+
+		if(Buffer.uiSize == 0)
+		{
+			// The reader hit the end of the stream (or an error) and has exited.
+			if(this->pError != 0)
+			{
+				LastError = *this->pError;
+			}
+
+			this->bEnd = hlTrue;
+			break;
+		}
+
+		hlUInt uiCopy = Buffer.uiSize - this->uiReadOffset;
+		if(uiCopy > uiBytes - uiOffset)
+		{
+			uiCopy = uiBytes - uiOffset;
+		}
+
+		memcpy(static_cast<hlByte *>(lpData) + uiOffset, Buffer.lpData + this->uiReadOffset, uiCopy);
+
+		uiOffset += uiCopy;
+		this->uiReadOffset += uiCopy;
+
+		if(this->uiReadOffset == Buffer.uiSize)
+		{
+			this->bReadBuffer = hlFalse;
+			this->uiReadBuffer = (this->uiReadBuffer + 1) % HL_READ_AHEAD_BUFFER_COUNT;
+			this->pFree->Post();
+		}
+	}
+
+	this->uiPointer += static_cast<hlULongLong>(uiOffset);
+
+	return uiOffset;
+}
+
+hlBool CReadAheadStream::Write(hlChar cChar)
+{
+	return this->Write(&cChar, 1) == 1;
+}
+
+hlUInt CReadAheadStream::Write(const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(!this->bOpened)
+	{
+		return 0;
+	}
+
+	LastError.SetErrorMessage("Stream not in write mode.");
+	return 0;
+}
+
+//
+// Start()
+// Starts the reader thread at the current position.  If the thread can't be
+// created reads simply pass through to the wrapped stream.
+//
+hlBool CReadAheadStream::Start()
+{
+	assert(!this->bThreaded);
+
+	this->bEnd = hlFalse;
+	this->bStop = hlFalse;
+
+	this->pFree = new Threading::CSemaphore(HL_READ_AHEAD_BUFFER_COUNT);
+	this->pFilled = new Threading::CSemaphore(0);
+
+	this->uiReadBuffer = 0;
+	this->uiReadOffset = 0;
+	this->bReadBuffer = hlFalse;
+
+	this->Prefetch(this->uiPointer, HL_READ_AHEAD_BUFFER_COUNT * HL_DEFAULT_COPY_BUFFER_SIZE);
+
+	if(!this->Thread.Start(CReadAheadStream::ReadAheadProc, this))
+	{
+		delete this->pFree;
+		this->pFree = 0;
+		delete this->pFilled;
+		this->pFilled = 0;
+
+		return hlFalse;
+	}
+
+	this->bThreaded = hlTrue;
+
+	return hlTrue;
+}
+
+hlVoid CReadAheadStream::Stop()
+{
+	if(!this->bThreaded)
+	{
+		return;
+	}
+
+	this->bStop = hlTrue;
+	this->pFree->Post();
+
+	this->Thread.Join();
+
+	delete this->pFree;
+	this->pFree = 0;
+	delete this->pFilled;
+	this->pFilled = 0;
+
+	delete this->pError;
+	this->pError = 0;
+
+	this->bThreaded = hlFalse;
+}
+
+hlVoid CReadAheadStream::Prefetch(hlULongLong uiOffset, hlULongLong uiLength)
+{
+	if(this->Stream.GetType() == HL_STREAM_MAPPING)
+	{
+		static_cast<CMappingStream &>(this->Stream).Prefetch(uiOffset, uiLength);
+	}
+}
+
+hlVoid CReadAheadStream::ReadAhead()
+{
+	// The reader runs under a private context so it never writes the caller's
+	// error; a failed read is handed back through pError instead.
+	CContext Context;
+	CContextScope Scope(Context);
+
+	hlUInt uiWriteBuffer = 0;
+	hlULongLong uiPointer = this->uiPointer;
+
+	while(hlTrue)
+	{
+		this->pFree->Wait();
+
+		if(this->bStop)
+		{
+			break;
+		}
+
+		ReadAheadBuffer &Buffer = this->Buffers[uiWriteBuffer];
+
+		// Ask for the data a full ring ahead of us so it is resident by the time we get there.
+		this->Prefetch(uiPointer + HL_READ_AHEAD_BUFFER_COUNT * HL_DEFAULT_COPY_BUFFER_SIZE, HL_DEFAULT_COPY_BUFFER_SIZE);
+
+		Buffer.uiSize = 0;
+		while(Buffer.uiSize < HL_DEFAULT_COPY_BUFFER_SIZE && !this->bStop)
+		{
+			hlUInt uiBytes = this->Stream.Read(Buffer.lpData + Buffer.uiSize, HL_DEFAULT_COPY_BUFFER_SIZE - Buffer.uiSize);
+
+			if(uiBytes == 0)
+			{
+				break;
+			}
+
+			Buffer.uiSize += uiBytes;
+		}
+
+		uiPointer += static_cast<hlULongLong>(Buffer.uiSize);
+
+		if(Buffer.uiSize == 0 && uiPointer < this->uiLength && !this->bStop)
+		{
+			this->pError = new CError(LastError);
+		}
+
+		this->pFilled->Post();
+
+		if(Buffer.uiSize == 0)
+		{
+			break;
+		}
+
+		uiWriteBuffer = (uiWriteBuffer + 1) % HL_READ_AHEAD_BUFFER_COUNT;
+	}
+}
+
+hlVoid CReadAheadStream::ReadAheadProc(hlVoid *pUserData)
+{
+	static_cast<CReadAheadStream *>(pUserData)->ReadAhead();
+}
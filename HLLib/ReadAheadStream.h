@@ -0,0 +1,98 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef READAHEADSTREAM_H
+#define READAHEADSTREAM_H
+
+#include "stdafx.h"
+#include "Stream.h"
+#include "Thread.h"
+
+namespace HLLib
+{
+	class CError;
+
+	namespace Streams
+	{
+		class HLLIB_API CReadAheadStream : public IStream
+		{
+		private:
+			struct ReadAheadBuffer
+			{
+				hlByte *lpData;
+				hlUInt uiSize;
+			};
+
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			IStream &Stream;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			hlBool bReadAhead;
+			hlBool bThreaded;
+			hlBool bEnd;
+			volatile hlBool bStop;
+
+			CError *pError;
+			Threading::CThread Thread;
+			Threading::CSemaphore *pFree;
+			Threading::CSemaphore *pFilled;
+
+			hlByte *lpBuffer;
+			ReadAheadBuffer Buffers[HL_READ_AHEAD_BUFFER_COUNT];
+			hlUInt uiReadBuffer;
+			hlUInt uiReadOffset;
+			hlBool bReadBuffer;
+
+		public:
+			CReadAheadStream(IStream &Stream);
+			CReadAheadStream(IStream &Stream, hlBool bReadAhead);
+			~CReadAheadStream();
+
+			virtual HLStreamType GetType() const;
+
+			const IStream &GetStream() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+		private:
+			hlBool Start();
+			hlVoid Stop();
+
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength);
+
+			hlVoid ReadAhead();
+			static hlVoid ReadAheadProc(hlVoid *pUserData);
+		};
+	}
+}
+
+#endif
@@ -14,6 +14,11 @@
 using namespace HLLib;
 using namespace HLLib::Streams;
 
+IStream::IStream() : pPackage(0), pPrevious(0), pNext(0), uiPackageData(0)
+{
+
+}
+
 IStream::~IStream()
 {
 
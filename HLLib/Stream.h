@@ -16,11 +16,23 @@
 
 namespace HLLib
 {
+	class CPackage;
+
 	namespace Streams
 	{
 		class HLLIB_API IStream
 		{
+			friend class HLLib::CPackage;
+
+		private:
+			// Links in the open stream list of the package that created the stream.
+			const CPackage *pPackage;
+			IStream *pPrevious;
+			IStream *pNext;
+			hlUInt uiPackageData;	// Free for that package to use.
+
 		public:
+			IStream();
 			virtual ~IStream();
 
 			virtual HLStreamType GetType() const = 0;
@@ -78,6 +78,9 @@ hlBool CStreamMapping::MapInternal(CView *&pView, hlULongLong uiOffset, hlULongL
 {
 	assert(this->GetOpened());
 
+	// The stream has a single file pointer, so concurrent views take turns using it.
+	Threading::CLock Lock(this->StreamMutex);
+
 	if(uiOffset + uiLength > this->Stream.GetStreamSize())
 	{
 #ifdef _WIN32
@@ -120,6 +123,8 @@ hlBool CStreamMapping::CommitInternal(CView &View, hlULongLong uiOffset, hlULong
 
 	hlULongLong uiFileOffset = View.GetAllocationOffset() + View.GetOffset() + uiOffset;
 
+	Threading::CLock Lock(this->StreamMutex);
+
 	if(Stream.Seek(static_cast<hlLongLong>(uiFileOffset), HL_SEEK_BEGINNING) != uiFileOffset)
 	{
 		return hlFalse;
@@ -24,6 +24,7 @@ namespace HLLib
 		{
 		private:
 			Streams::IStream &Stream;
+			Threading::CMutex StreamMutex;
 
 		public:
 			CStreamMapping(Streams::IStream &Stream);
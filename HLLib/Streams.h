@@ -10,9 +10,14 @@
  */
 
 #include "Stream.h"
+#include "ConcatenatedStream.h"
 #include "FileStream.h"
 #include "GCFStream.h"
+#include "InflateStream.h"
+#include "LZMAStream.h"
+#include "LZSSStream.h"
 #include "MappingStream.h"
 #include "MemoryStream.h"
 #include "NullStream.h"
 #include "ProcStream.h"
+#include "ReadAheadStream.h"
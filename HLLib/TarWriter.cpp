@@ -0,0 +1,363 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "TarWriter.h"
+#include "Package.h"
+#include "ReadAheadStream.h"
+#include "Utility.h"
+
+#include <time.h>
+
+using namespace HLLib;
+
+// Largest size that fits in the 11 octal digits of a ustar size field.
+#define HL_TAR_MAX_OCTAL_SIZE 077777777777ULL
+
+CTarWriter::CTarWriter(Streams::IStream &Stream) : pStream(&Stream), pWriteProc(0), pUserData(0), uiBytesWritten(0), uiModificationTime(static_cast<hlULongLong>(time(0)))
+{
+
+}
+
+CTarWriter::CTarWriter(PWriteProc pWriteProc, hlVoid *pUserData) : pStream(0), pWriteProc(pWriteProc), pUserData(pUserData), uiBytesWritten(0), uiModificationTime(static_cast<hlULongLong>(time(0)))
+{
+
+}
+
+CTarWriter::~CTarWriter()
+{
+
+}
+
+hlULongLong CTarWriter::GetBytesWritten() const
+{
+	return this->uiBytesWritten;
+}
+
+//
+// Write()
+// Writes pItem and, if it is a folder, everything below it.  Entry paths start
+// with pItem's name, mirroring the layout CDirectoryItem::Extract() creates.
+//
+hlBool CTarWriter::Write(const CDirectoryItem *pItem)
+{
+	return this->Write(0, pItem);
+}
+
+hlBool CTarWriter::Write(const hlChar *lpPath, const CDirectoryItem *pItem)
+{
+	hlExtractItemStart(pItem);
+
+	hlChar *lpName = new hlChar[strlen(pItem->GetName()) + 1];
+	strcpy(lpName, pItem->GetName());
+	RemoveIllegalCharacters(lpName);
+
+	hlChar *lpItemPath;
+	if(lpPath == 0 || *lpPath == '\0')
+	{
+		lpItemPath = new hlChar[strlen(lpName) + 1];
+		strcpy(lpItemPath, lpName);
+	}
+	else
+	{
+		lpItemPath = new hlChar[strlen(lpPath) + 1 + strlen(lpName) + 1];
+		strcpy(lpItemPath, lpPath);
+		strcat(lpItemPath, "/");
+		strcat(lpItemPath, lpName);
+	}
+
+	hlBool bResult = hlFalse;
+	switch(pItem->GetType())
+	{
+		case HL_ITEM_FOLDER:
+		{
+			const CDirectoryFolder *pFolder = static_cast<const CDirectoryFolder *>(pItem);
+
+			bResult = this->WriteFolder(lpItemPath);
+			for(hlUInt i = 0; bResult && i < pFolder->GetCount(); i++)
+			{
+				// Unlike Extract(), stop on the first failure; the output can't be rewound.
+				bResult = this->Write(lpItemPath, pFolder->GetItem(i));
+			}
+			break;
+		}
+		case HL_ITEM_FILE:
+		{
+			bResult = this->WriteFile(lpItemPath, static_cast<const CDirectoryFile *>(pItem));
+			break;
+		}
+	}
+
+	delete []lpItemPath;
+	delete []lpName;
+
+	hlExtractItemEnd(pItem, bResult);
+
+	return bResult;
+}
+
+hlBool CTarWriter::WriteFolder(const hlChar *lpPath)
+{
+	hlChar *lpFolderPath = new hlChar[strlen(lpPath) + 2];
+	strcpy(lpFolderPath, lpPath);
+	strcat(lpFolderPath, "/");
+
+	hlBool bResult = this->WriteHeader(lpFolderPath, '5', 0);
+
+	delete []lpFolderPath;
+
+	return bResult;
+}
+
+hlBool CTarWriter::WriteFile(const hlChar *lpPath, const CDirectoryFile *pFile)
+{
+	hlBool bResult = hlFalse;
+
+	Streams::IStream *pInput = 0;
+
+	if(pFile->GetPackage()->CreateStream(pFile, pInput))
+	{
+		if(pInput->Open(HL_MODE_READ))
+		{
+			Streams::CReadAheadStream Input(*pInput);
+
+			if(Input.Open(HL_MODE_READ))
+			{
+				bResult = this->WriteFile(lpPath, Input, pFile);
+
+				Input.Close();
+			}
+
+			pInput->Close();
+		}
+
+		pFile->GetPackage()->ReleaseStream(pInput);
+	}
+
+	return bResult;
+}
+
+//
+// WriteFile()
+// Writes an entry for an opened stream.  If pFile is given it is used for
+// extraction progress callbacks.
+//
+hlBool CTarWriter::WriteFile(const hlChar *lpPath, Streams::IStream &Input, const CDirectoryFile *pFile)
+{
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Input.GetStreamSize() - Input.GetStreamPointer();
+
+	if(!this->WriteHeader(lpPath, '0', uiFileBytes))
+	{
+		return hlFalse;
+	}
+
+	hlBool bResult = hlTrue;
+	hlByte lpBuffer[HL_DEFAULT_COPY_BUFFER_SIZE];
+
+	hlBool bCancel = hlFalse;
+	if(pFile != 0)
+	{
+		hlExtractFileProgress(pFile, uiTotalBytes, uiFileBytes, &bCancel);
+	}
+
+	while(uiTotalBytes < uiFileBytes)
+	{
+		if(bCancel)
+		{
+			LastError.SetErrorMessage("Canceled by user.");
+			bResult = hlFalse;
+			break;
+		}
+
+		hlUInt uiBytes = sizeof(lpBuffer);
+		if(static_cast<hlULongLong>(uiBytes) > uiFileBytes - uiTotalBytes)
+		{
+			uiBytes = static_cast<hlUInt>(uiFileBytes - uiTotalBytes);
+		}
+
+		uiBytes = Input.Read(lpBuffer, uiBytes);
+
+		if(uiBytes == 0)
+		{
+			LastError.SetErrorMessage("Unexpected end of input stream.");
+			bResult = hlFalse;
+			break;
+		}
+
+		if(!this->WriteData(lpBuffer, uiBytes))
+		{
+			return hlFalse;
+		}
+
+		uiTotalBytes += static_cast<hlULongLong>(uiBytes);
+
+		if(pFile != 0)
+		{
+			hlExtractFileProgress(pFile, uiTotalBytes, uiFileBytes, &bCancel);
+		}
+	}
+
+	// The header promised uiFileBytes, keep the archive well formed even on failure.
+	if(!this->WritePadding(uiFileBytes - uiTotalBytes))
+	{
+		return hlFalse;
+	}
+
+	if(!this->WritePadding((HL_TAR_BLOCK_SIZE - uiFileBytes % HL_TAR_BLOCK_SIZE) % HL_TAR_BLOCK_SIZE))
+	{
+		return hlFalse;
+	}
+
+	return bResult;
+}
+
+//
+// Finish()
+// Writes the end of archive marker (two zero blocks).
+//
+hlBool CTarWriter::Finish()
+{
+	return this->WritePadding(HL_TAR_BLOCK_SIZE * 2);
+}
+
+hlBool CTarWriter::WriteHeader(const hlChar *lpPath, hlChar cTypeFlag, hlULongLong uiSize)
+{
+	TarHeader Header;
+	memset(&Header, 0, sizeof(Header));
+
+	hlUInt uiPathLength = (hlUInt)strlen(lpPath);
+
+	if(uiPathLength <= sizeof(Header.lpName))
+	{
+		memcpy(Header.lpName, lpPath, uiPathLength);
+	}
+	else
+	{
+		// Try to split the path into the prefix and name fields.
+		const hlChar *lpSplit = 0;
+		for(const hlChar *lpSlash = strchr(lpPath, '/'); lpSlash != 0 && static_cast<hlUInt>(lpSlash - lpPath) <= sizeof(Header.lpPrefix); lpSlash = strchr(lpSlash + 1, '/'))
+		{
+			if(uiPathLength - static_cast<hlUInt>(lpSlash - lpPath) - 1 <= sizeof(Header.lpName) && lpSlash[1] != '\0')
+			{
+				lpSplit = lpSlash;
+				break;
+			}
+		}
+
+		if(lpSplit != 0)
+		{
+			memcpy(Header.lpPrefix, lpPath, lpSplit - lpPath);
+			memcpy(Header.lpName, lpSplit + 1, uiPathLength - (lpSplit - lpPath) - 1);
+		}
+		else
+		{
+			// Too long for ustar, precede the entry with a GNU long name entry.
+			if(!this->WriteHeader("././@LongLink", 'L', static_cast<hlULongLong>(uiPathLength + 1)))
+			{
+				return hlFalse;
+			}
+
+			if(!this->WriteData(lpPath, uiPathLength) || !this->WritePadding(1 + (HL_TAR_BLOCK_SIZE - (uiPathLength + 1) % HL_TAR_BLOCK_SIZE) % HL_TAR_BLOCK_SIZE))
+			{
+				return hlFalse;
+			}
+
+			memcpy(Header.lpName, lpPath, sizeof(Header.lpName));
+		}
+	}
+
+	sprintf(Header.lpMode, "%07o", cTypeFlag == '5' ? 0755 : 0644);
+	sprintf(Header.lpUserID, "%07o", 0);
+	sprintf(Header.lpGroupID, "%07o", 0);
+
+	if(uiSize <= HL_TAR_MAX_OCTAL_SIZE)
+	{
+		sprintf(Header.lpSize, "%011llo", uiSize);
+	}
+	else
+	{
+		// GNU base-256 encoding.
+		Header.lpSize[0] = (hlChar)0x80;
+		for(hlUInt i = sizeof(Header.lpSize) - 1; i > 0; i--)
+		{
+			Header.lpSize[i] = (hlChar)(uiSize & 0xff);
+			uiSize >>= 8;
+		}
+	}
+
+	sprintf(Header.lpModificationTime, "%011llo", this->uiModificationTime & HL_TAR_MAX_OCTAL_SIZE);
+	Header.cTypeFlag = cTypeFlag;
+	memcpy(Header.lpMagic, "ustar", 6);
+	memcpy(Header.lpVersion, "00", 2);
+
+	// The checksum is computed with the checksum field set to spaces.
+	memset(Header.lpChecksum, ' ', sizeof(Header.lpChecksum));
+
+	hlUInt uiChecksum = 0;
+	for(hlUInt i = 0; i < sizeof(Header); i++)
+	{
+		uiChecksum += reinterpret_cast<const hlByte *>(&Header)[i];
+	}
+	sprintf(Header.lpChecksum, "%06o", uiChecksum);
+	Header.lpChecksum[7] = ' ';
+
+	return this->WriteData(&Header, sizeof(Header));
+}
+
+hlBool CTarWriter::WriteData(const hlVoid *lpData, hlUInt uiBytes)
+{
+	const hlByte *lpBytes = static_cast<const hlByte *>(lpData);
+
+	while(uiBytes > 0)
+	{
+		hlUInt uiBytesWritten;
+		if(this->pStream != 0)
+		{
+			uiBytesWritten = this->pStream->Write(lpBytes, uiBytes);
+		}
+		else
+		{
+			uiBytesWritten = this->pWriteProc(lpBytes, uiBytes, this->pUserData);
+		}
+
+		if(uiBytesWritten == 0)
+		{
+			LastError.SetErrorMessage("Error writing tar stream.");
+			return hlFalse;
+		}
+
+		lpBytes += uiBytesWritten;
+		uiBytes -= uiBytesWritten;
+		this->uiBytesWritten += static_cast<hlULongLong>(uiBytesWritten);
+	}
+
+	return hlTrue;
+}
+
+hlBool CTarWriter::WritePadding(hlULongLong uiSize)
+{
+	hlByte lpZeros[HL_TAR_BLOCK_SIZE];
+	memset(lpZeros, 0, sizeof(lpZeros));
+
+	while(uiSize > 0)
+	{
+		hlUInt uiBytes = uiSize > sizeof(lpZeros) ? sizeof(lpZeros) : static_cast<hlUInt>(uiSize);
+
+		if(!this->WriteData(lpZeros, uiBytes))
+		{
+			return hlFalse;
+		}
+
+		uiSize -= static_cast<hlULongLong>(uiBytes);
+	}
+
+	return hlTrue;
+}
@@ -0,0 +1,82 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef TARWRITER_H
+#define TARWRITER_H
+
+#include "stdafx.h"
+#include "DirectoryItems.h"
+#include "Stream.h"
+
+#define HL_TAR_BLOCK_SIZE 512
+
+namespace HLLib
+{
+	class HLLIB_API CTarWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct TarHeader
+		{
+			hlChar lpName[100];
+			hlChar lpMode[8];
+			hlChar lpUserID[8];
+			hlChar lpGroupID[8];
+			hlChar lpSize[12];
+			hlChar lpModificationTime[12];
+			hlChar lpChecksum[8];
+			hlChar cTypeFlag;
+			hlChar lpLinkName[100];
+			hlChar lpMagic[6];
+			hlChar lpVersion[2];
+			hlChar lpUserName[32];
+			hlChar lpGroupName[32];
+			hlChar lpDeviceMajor[8];
+			hlChar lpDeviceMinor[8];
+			hlChar lpPrefix[155];
+			hlChar lpPadding[12];
+		};
+
+		#pragma pack()
+
+	private:
+		Streams::IStream *pStream;
+		PWriteProc pWriteProc;
+		hlVoid *pUserData;
+
+		hlULongLong uiBytesWritten;
+		hlULongLong uiModificationTime;
+
+	public:
+		CTarWriter(Streams::IStream &Stream);
+		CTarWriter(PWriteProc pWriteProc, hlVoid *pUserData);
+		~CTarWriter();
+
+		hlULongLong GetBytesWritten() const;
+
+		hlBool Write(const CDirectoryItem *pItem);
+		hlBool WriteFolder(const hlChar *lpPath);
+		hlBool WriteFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool WriteFile(const hlChar *lpPath, Streams::IStream &Input, const CDirectoryFile *pFile = 0);
+
+		hlBool Finish();
+
+	private:
+		hlBool Write(const hlChar *lpPath, const CDirectoryItem *pItem);
+
+		hlBool WriteHeader(const hlChar *lpPath, hlChar cTypeFlag, hlULongLong uiSize);
+		hlBool WriteData(const hlVoid *lpData, hlUInt uiBytes);
+		hlBool WritePadding(hlULongLong uiSize);
+	};
+}
+
+#endif
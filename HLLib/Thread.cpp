@@ -0,0 +1,230 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "Thread.h"
+
+using namespace HLLib;
+using namespace HLLib::Threading;
+
+//
+// CMutex
+//
+
+CMutex::CMutex()
+{
+#ifdef _WIN32
+	InitializeCriticalSection(&this->CriticalSection);
+#else
+	pthread_mutex_init(&this->Mutex, 0);
+#endif
+}
+
+CMutex::~CMutex()
+{
+#ifdef _WIN32
+	DeleteCriticalSection(&this->CriticalSection);
+#else
+	pthread_mutex_destroy(&this->Mutex);
+#endif
+}
+
+hlVoid CMutex::Lock()
+{
+#ifdef _WIN32
+	EnterCriticalSection(&this->CriticalSection);
+#else
+	pthread_mutex_lock(&this->Mutex);
+#endif
+}
+
+hlVoid CMutex::Unlock()
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&this->CriticalSection);
+#else
+	pthread_mutex_unlock(&this->Mutex);
+#endif
+}
+
+//
+// CLock
+//
+
+CLock::CLock(CMutex &Mutex) : Mutex(Mutex)
+{
+	this->Mutex.Lock();
+}
+
+CLock::~CLock()
+{
+	this->Mutex.Unlock();
+}
+
+//
+// CSemaphore
+//
+
+CSemaphore::CSemaphore(hlUInt uiCount)
+{
+#ifdef _WIN32
+	this->hSemaphore = CreateSemaphore(NULL, (LONG)uiCount, 0x7fffffff, NULL);
+#else
+	pthread_mutex_init(&this->Mutex, 0);
+	pthread_cond_init(&this->Condition, 0);
+	this->uiCount = uiCount;
+#endif
+}
+
+CSemaphore::~CSemaphore()
+{
+#ifdef _WIN32
+	CloseHandle(this->hSemaphore);
+#else
+	pthread_cond_destroy(&this->Condition);
+	pthread_mutex_destroy(&this->Mutex);
+#endif
+}
+
+hlVoid CSemaphore::Wait()
+{
+#ifdef _WIN32
+	WaitForSingleObject(this->hSemaphore, INFINITE);
+#else
+	pthread_mutex_lock(&this->Mutex);
+	while(this->uiCount == 0)
+	{
+		pthread_cond_wait(&this->Condition, &this->Mutex);
+	}
+	this->uiCount--;
+	pthread_mutex_unlock(&this->Mutex);
+#endif
+}
+
+hlVoid CSemaphore::Post()
+{
+#ifdef _WIN32
+	ReleaseSemaphore(this->hSemaphore, 1, NULL);
+#else
+	pthread_mutex_lock(&this->Mutex);
+	this->uiCount++;
+	pthread_cond_signal(&this->Condition);
+	pthread_mutex_unlock(&this->Mutex);
+#endif
+}
+
+//
+// CThread
+//
+
+#ifdef _WIN32
+CThread::CThread() : hThread(0), pThreadProc(0), pUserData(0)
+#else
+CThread::CThread() : bStarted(hlFalse), pThreadProc(0), pUserData(0)
+#endif
+{
+
+}
+
+CThread::~CThread()
+{
+	this->Join();
+}
+
+hlBool CThread::GetStarted() const
+{
+#ifdef _WIN32
+	return this->hThread != 0;
+#else
+	return this->bStarted;
+#endif
+}
+
+hlBool CThread::Start(PThreadProc pThreadProc, hlVoid *pUserData)
+{
+	this->Join();
+
+	this->pThreadProc = pThreadProc;
+	this->pUserData = pUserData;
+
+#ifdef _WIN32
+	this->hThread = CreateThread(NULL, 0, CThread::ThreadProc, this, 0, NULL);
+
+	if(this->hThread == 0)
+	{
+		LastError.SetSystemErrorMessage("Error creating thread.");
+		return hlFalse;
+	}
+#else
+	hlInt iResult = pthread_create(&this->Thread, 0, CThread::ThreadProc, this);
+
+	if(iResult != 0)
+	{
+		errno = iResult;
+		LastError.SetSystemErrorMessage("Error creating thread.");
+		return hlFalse;
+	}
+
+	this->bStarted = hlTrue;
+#endif
+
+	return hlTrue;
+}
+
+hlVoid CThread::Join()
+{
+#ifdef _WIN32
+	if(this->hThread != 0)
+	{
+		WaitForSingleObject(this->hThread, INFINITE);
+		CloseHandle(this->hThread);
+		this->hThread = 0;
+	}
+#else
+	if(this->bStarted)
+	{
+		pthread_join(this->Thread, 0);
+		this->bStarted = hlFalse;
+	}
+#endif
+}
+
+hlUInt CThread::GetProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+
+	return SystemInfo.dwNumberOfProcessors > 0 ? (hlUInt)SystemInfo.dwNumberOfProcessors : 1;
+#else
+	long iProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return iProcessors > 0 ? (hlUInt)iProcessors : 1;
+#endif
+}
+
+#ifdef _WIN32
+DWORD WINAPI CThread::ThreadProc(LPVOID lpParameter)
+{
+	CThread *pThread = static_cast<CThread *>(lpParameter);
+	pThread->pThreadProc(pThread->pUserData);
+
+	return 0;
+}
+#else
+hlVoid *CThread::ThreadProc(hlVoid *lpParameter)
+{
+	CThread *pThread = static_cast<CThread *>(lpParameter);
+	pThread->pThreadProc(pThread->pUserData);
+
+	return 0;
+}
+#endif
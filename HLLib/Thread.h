@@ -0,0 +1,121 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "stdafx.h"
+
+#ifndef _WIN32
+#	include <pthread.h>
+#endif
+
+namespace HLLib
+{
+	namespace Threading
+	{
+		typedef hlVoid (*PThreadProc)(hlVoid *pUserData);
+
+		class HLLIB_API CMutex
+		{
+		private:
+#ifdef _WIN32
+			CRITICAL_SECTION CriticalSection;
+#else
+			pthread_mutex_t Mutex;
+#endif
+
+		public:
+			CMutex();
+			~CMutex();
+
+			hlVoid Lock();
+			hlVoid Unlock();
+
+		private:
+			CMutex(const CMutex &);
+			CMutex &operator=(const CMutex &);
+		};
+
+		class HLLIB_API CLock
+		{
+		private:
+			CMutex &Mutex;
+
+		public:
+			CLock(CMutex &Mutex);
+			~CLock();
+
+		private:
+			CLock(const CLock &);
+			CLock &operator=(const CLock &);
+		};
+
+		class HLLIB_API CSemaphore
+		{
+		private:
+#ifdef _WIN32
+			HANDLE hSemaphore;
+#else
+			pthread_mutex_t Mutex;
+			pthread_cond_t Condition;
+			hlUInt uiCount;
+#endif
+
+		public:
+			CSemaphore(hlUInt uiCount = 0);
+			~CSemaphore();
+
+			hlVoid Wait();
+			hlVoid Post();
+
+		private:
+			CSemaphore(const CSemaphore &);
+			CSemaphore &operator=(const CSemaphore &);
+		};
+
+		class HLLIB_API CThread
+		{
+		private:
+#ifdef _WIN32
+			HANDLE hThread;
+#else
+			pthread_t Thread;
+			hlBool bStarted;
+#endif
+			PThreadProc pThreadProc;
+			hlVoid *pUserData;
+
+		public:
+			CThread();
+			~CThread();
+
+			hlBool GetStarted() const;
+
+			hlBool Start(PThreadProc pThreadProc, hlVoid *pUserData);
+			hlVoid Join();
+
+			static hlUInt GetProcessorCount();
+
+		private:
+			CThread(const CThread &);
+			CThread &operator=(const CThread &);
+
+#ifdef _WIN32
+			static DWORD WINAPI ThreadProc(LPVOID lpParameter);
+#else
+			static hlVoid *ThreadProc(hlVoid *lpParameter);
+#endif
+		};
+	}
+}
+
+#endif
@@ -68,6 +68,16 @@ hlBool HLLib::GetFolderExists(const hlChar *lpPath)
 }
 
 hlBool HLLib::GetFileSize(const hlChar *lpPath, hlUInt &uiFileSize)
+{
+	hlULongLong uiFileSizeEx = 0;
+	hlBool bResult = GetFileSize(lpPath, uiFileSizeEx);
+
+	uiFileSize = (hlUInt)uiFileSizeEx;
+
+	return bResult;
+}
+
+hlBool HLLib::GetFileSize(const hlChar *lpPath, hlULongLong &uiFileSize)
 {
 	uiFileSize = 0;
 
@@ -81,7 +91,7 @@ hlBool HLLib::GetFileSize(const hlChar *lpPath, hlUInt &uiFileSize)
 
 		if((FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
 		{
-			uiFileSize = (hlUInt)FindData.nFileSizeLow;
+			uiFileSize = ((hlULongLong)FindData.nFileSizeHigh << 32) | (hlULongLong)FindData.nFileSizeLow;
 			return hlTrue;
 		}
 	}
@@ -90,7 +100,7 @@ hlBool HLLib::GetFileSize(const hlChar *lpPath, hlUInt &uiFileSize)
 
 	if(stat(lpPath, &Stat) >= 0 && S_ISREG(Stat.st_mode) != 0)
 	{
-		uiFileSize = (hlUInt)Stat.st_size;
+		uiFileSize = (hlULongLong)Stat.st_size;
 		return hlTrue;
 	}
 #endif
@@ -21,6 +21,7 @@ namespace HLLib
 	hlBool GetFolderExists(const hlChar *lpPath);
 
 	hlBool GetFileSize(const hlChar *lpPath, hlUInt &uiFileSize);
+	hlBool GetFileSize(const hlChar *lpPath, hlULongLong &uiFileSize);
 
 	hlBool CreateFolder(const hlChar *lpPath);
 
@@ -11,6 +11,8 @@
 
 #include "HLLib.h"
 #include "VBSPFile.h"
+#include "ZIPFile.h"
+#include "DirectoryTreeBuilder.h"
 #include "Streams.h"
 #include "Checksum.h"
 
@@ -19,16 +21,22 @@ using namespace HLLib;
 #define HL_VBSP_LUMP_ENTITIES		0
 #define HL_VBSP_LUMP_PAKFILE		40
 
+#define HL_VBSP_LZMA_ID			0x414d5a4c	// "LZMA"
+
 #define HL_VBSP_ZIP_LOCAL_FILE_HEADER_SIGNATURE					0x04034b50
 #define HL_VBSP_ZIP_FILE_HEADER_SIGNATURE						0x02014b50
 #define HL_VBSP_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE	0x06054b50
 
+#define HL_VBSP_ZIP_COMPRESSION_STORE							0
+#define HL_VBSP_ZIP_COMPRESSION_DEFLATE							8
+#define HL_VBSP_ZIP_COMPRESSION_LZMA							14
+
 #define HL_VBSP_ZIP_CHECKSUM_LENGTH								0x00008000
 
 const char *CVBSPFile::lpAttributeNames[] = { "Version", "Map Revision" };
 const char *CVBSPFile::lpItemAttributeNames[] = { "Version", "Four CC", "Zip Disk", "Zip Comment", "Create Version", "Extract Version", "Flags", "Compression Method", "CRC", "Disk", "Comment" };
 
-CVBSPFile::CVBSPFile() : CPackage(), pHeaderView(0), pFileHeaderView(0), pEndOfCentralDirectoryRecordView(0), pHeader(0), pEndOfCentralDirectoryRecord(0)
+CVBSPFile::CVBSPFile() : CPackage(), pHeaderView(0), pFileHeaderView(0), pEndOfCentralDirectoryRecordView(0), pHeader(0), pEndOfCentralDirectoryRecord(0), pStreamCache(0)
 {
 
 }
@@ -98,85 +106,42 @@ hlBool CVBSPFile::MapDataStructures()
 
 	if(sizeof(ZIPEndOfCentralDirectoryRecord) <= this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiLength)
 	{
-		hlUInt uiTest, uiOffset = this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset;
-		while(uiOffset < this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset + this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiLength - sizeof(uiTest))
-		{
-			Mapping::CView *pTestView = 0;
+		hlULongLong uiLumpOffset = static_cast<hlULongLong>(this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset);
+		hlULongLong uiLumpLength = static_cast<hlULongLong>(this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiLength);
 
-			if(!this->pMapping->Map(pTestView, uiOffset, sizeof(hlUInt)))
-			{
-				return hlFalse;
-			}
-
-			uiTest = *(hlUInt *)pTestView->GetView();
-
-			this->pMapping->Unmap(pTestView);
-
-			switch(uiTest)
-			{
-				case HL_VBSP_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE:
-				{
-					if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord)))
-					{
-						return hlFalse;
-					}
-
-					const ZIPEndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIPEndOfCentralDirectoryRecord *>(pTestView->GetView());
-
-					this->pMapping->Unmap(pTestView);
-
-					if(!this->pMapping->Map(this->pEndOfCentralDirectoryRecordView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord) + EndOfCentralDirRecord.uiCommentLength))
-					{
-						return hlFalse;
-					}
-
-					this->pEndOfCentralDirectoryRecord = static_cast<const ZIPEndOfCentralDirectoryRecord *>(this->pEndOfCentralDirectoryRecordView->GetView());
-
-					if(!this->pMapping->Map(this->pFileHeaderView, this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset + this->pEndOfCentralDirectoryRecord->uiStartOfCentralDirOffset, this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize))
-					{
-						return hlFalse;
-					}
+		hlULongLong uiOffset;
+		if(!CZIPFile::FindEndOfCentralDirectoryRecord(*this->pMapping, uiLumpOffset, uiLumpLength, uiOffset) && !CZIPFile::ScanEndOfCentralDirectoryRecord(*this->pMapping, uiLumpOffset, uiLumpLength, uiOffset))
+		{
+			return hlFalse;
+		}
 
-					return hlTrue;
-				}
-				case HL_VBSP_ZIP_FILE_HEADER_SIGNATURE:
-				{
-					if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPFileHeader)))
-					{
-						return hlFalse;
-					}
+		Mapping::CView *pTestView = 0;
 
-					const ZIPFileHeader FileHeader = *static_cast<const ZIPFileHeader *>(pTestView->GetView());
+		if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord)))
+		{
+			return hlFalse;
+		}
 
-					this->pMapping->Unmap(pTestView);
+		const ZIPEndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIPEndOfCentralDirectoryRecord *>(pTestView->GetView());
 
-					uiOffset += sizeof(ZIPFileHeader) + FileHeader.uiFileNameLength + FileHeader.uiExtraFieldLength + FileHeader.uiFileCommentLength;
-					break;
-				}
-				case HL_VBSP_ZIP_LOCAL_FILE_HEADER_SIGNATURE:
-				{
-					if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPLocalFileHeader)))
-					{
-						return hlFalse;
-					}
+		this->pMapping->Unmap(pTestView);
 
-					const ZIPLocalFileHeader LocalFileHeader = *static_cast<const ZIPLocalFileHeader *>(pTestView->GetView());
+		if(!this->pMapping->Map(this->pEndOfCentralDirectoryRecordView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord) + EndOfCentralDirRecord.uiCommentLength))
+		{
+			return hlFalse;
+		}
 
-					this->pMapping->Unmap(pTestView);
+		this->pEndOfCentralDirectoryRecord = static_cast<const ZIPEndOfCentralDirectoryRecord *>(this->pEndOfCentralDirectoryRecordView->GetView());
 
-					uiOffset += sizeof(ZIPLocalFileHeader) + LocalFileHeader.uiFileNameLength + LocalFileHeader.uiExtraFieldLength + LocalFileHeader.uiCompressedSize;
-					break;
-				}
-				default:
-				{
-					LastError.SetErrorMessageFormated("Invalid file: unknown ZIP section signature %#.8x.", uiTest);
-					return hlFalse;
-				}
-			}
+		if(!this->pMapping->Map(this->pFileHeaderView, this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset + this->pEndOfCentralDirectoryRecord->uiStartOfCentralDirOffset, this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize))
+		{
+			return hlFalse;
 		}
+	}
 
-		LastError.SetErrorMessage("Invalid file: unexpected end of file while scanning for end of ZIP central directory record.");
-		return hlFalse;
+	if(this->GetContext().uiStreamCacheSize != 0)
+	{
+		this->pStreamCache = new CBufferCache(this->GetContext().uiStreamCacheSize);
 	}
 
 	return hlTrue;
@@ -184,6 +149,9 @@ hlBool CVBSPFile::MapDataStructures()
 
 hlVoid CVBSPFile::UnmapDataStructures()
 {
+	delete this->pStreamCache;
+	this->pStreamCache = 0;
+
 	this->pMapping->Unmap(this->pFileHeaderView);
 
 	this->pEndOfCentralDirectoryRecord = 0;
@@ -250,6 +218,8 @@ CDirectoryFolder *CVBSPFile::CreateRoot()
 		}
 	}
 
+	CDirectoryTreeBuilder Builder(pRoot);
+
 	hlUInt uiTest, uiOffset = 0;
 	while(uiOffset < this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize - sizeof(uiTest))
 	{
@@ -265,44 +235,7 @@ CDirectoryFolder *CVBSPFile::CreateRoot()
 				memcpy(lpFileName, (hlByte *)pFileHeader + sizeof(ZIPFileHeader), pFileHeader->uiFileNameLength);
 				lpFileName[pFileHeader->uiFileNameLength] = '\0';
 
-				// Check if we have just a file, or if the file has directories we need to create.
-				if(strchr(lpFileName, '/') == 0 && strchr(lpFileName, '\\') == 0)
-				{
-					pRoot->AddFile(lpFileName, HL_ID_INVALID, pFileHeader);
-				}
-				else
-				{
-					// Tokenize the file path and create the directories.
-					CDirectoryFolder *pInsertFolder = pRoot;
-
-					hlChar lpTemp[256] = "";
-					hlChar *lpToken = strtok(lpFileName, "/\\");
-					while(lpToken != 0)
-					{
-						strcpy(lpTemp, lpToken);
-
-						lpToken = strtok(0, "/\\");
-
-						if(lpToken != 0)
-						{
-							// Check if the directory exists.
-							CDirectoryItem *pItem = pInsertFolder->GetItem(lpTemp);
-							if(pItem == 0 || pItem->GetType() == HL_ITEM_FILE)
-							{
-								// It doesn't, create it.
-								pInsertFolder = pInsertFolder->AddFolder(lpTemp);
-							}
-							else
-							{
-								// It does, use it.
-								pInsertFolder = static_cast<CDirectoryFolder *>(pItem);
-							}
-						}
-					}
-
-					// The file name is the last token, add it.
-					pInsertFolder->AddFile(lpTemp, HL_ID_INVALID, pFileHeader);
-				}
+				Builder.AddFile(lpFileName, HL_ID_INVALID, pFileHeader);
 
 				delete []lpFileName;
 
@@ -479,11 +412,17 @@ hlBool CVBSPFile::GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool
 	{
 		const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-		bExtractable = pDirectoryItem->uiCompressionMethod == 0 && pDirectoryItem->uiDiskNumberStart == this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk;
+		bExtractable = this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod) && pDirectoryItem->uiDiskNumberStart == this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk;
 	}
 	else
 	{
+#ifdef USE_LZMA
 		bExtractable = hlTrue;
+#else
+		hlUInt uiID = pFile->GetID() < HL_VBSP_LUMP_COUNT ? pFile->GetID() : pFile->GetID() - HL_VBSP_LUMP_COUNT;
+
+		bExtractable = !this->GetLumpCompressed(uiID);
+#endif
 	}
 
 	return hlTrue;
@@ -495,48 +434,44 @@ hlBool CVBSPFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValid
 	{
 		const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-		if(pDirectoryItem->uiCompressionMethod != 0 || pDirectoryItem->uiDiskNumberStart != this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk)
+		if(!this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod) || pDirectoryItem->uiDiskNumberStart != this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk)
 		{
 			eValidation = HL_VALIDATES_ASSUMED_OK;
 			return hlTrue;
 		}
 
-		hlULong uiChecksum = 0;
 		Streams::IStream *pStream = 0;
 		if(this->CreateStreamInternal(pFile, pStream))
 		{
 			if(pStream->Open(HL_MODE_READ))
 			{
-				hlULongLong uiTotalBytes = 0, uiFileBytes = pStream->GetStreamSize();
-				hlUInt uiBufferSize;
-				hlByte lpBuffer[HL_VBSP_ZIP_CHECKSUM_LENGTH];
-
-				hlBool bCancel = hlFalse;
-				hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+				Streams::CReadAheadStream Input(*pStream, this->GetContext().bReadAhead);
 
-				while((uiBufferSize = pStream->Read(lpBuffer, sizeof(lpBuffer))) != 0)
+				if(Input.Open(HL_MODE_READ))
 				{
-					if(bCancel)
-					{
-						eValidation = HL_VALIDATES_CANCELED;
-						break;
-					}
+					this->ValidateStreamInternal(pFile, Input, eValidation);
 
-					uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
-
-					uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
-
-					hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+					Input.Close();
+				}
+				else
+				{
+					eValidation = HL_VALIDATES_ERROR;
 				}
 
 				pStream->Close();
 			}
+			else
+			{
+				eValidation = HL_VALIDATES_ERROR;
+			}
 
 			this->ReleaseStreamInternal(*pStream);
 			delete pStream;
 		}
-
-		eValidation = (hlULong)pDirectoryItem->uiCRC32 == uiChecksum ? HL_VALIDATES_OK : HL_VALIDATES_CORRUPT;
+		else
+		{
+			eValidation = HL_VALIDATES_ERROR;
+		}
 	}
 	else
 	{
@@ -546,6 +481,45 @@ hlBool CVBSPFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValid
 	return hlTrue;
 }
 
+hlBool CVBSPFile::ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	if(pFile->GetData() == 0)
+	{
+		// Lumps have no checksum.
+		eValidation = HL_VALIDATES_ASSUMED_OK;
+		return hlTrue;
+	}
+
+	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
+
+	hlULong uiChecksum = 0;
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Stream.GetStreamSize();
+	hlUInt uiBufferSize;
+	hlByte lpBuffer[HL_VBSP_ZIP_CHECKSUM_LENGTH];
+
+	hlBool bCancel = hlFalse;
+	hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+
+	while((uiBufferSize = Stream.Read(lpBuffer, sizeof(lpBuffer))) != 0)
+	{
+		if(bCancel)
+		{
+			eValidation = HL_VALIDATES_CANCELED;
+			return hlTrue;
+		}
+
+		uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
+
+		uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+
+		hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+	}
+
+	eValidation = (hlULong)pDirectoryItem->uiCRC32 == uiChecksum ? HL_VALIDATES_OK : HL_VALIDATES_CORRUPT;
+
+	return hlTrue;
+}
+
 hlBool CVBSPFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
 	if(pFile->GetData())
@@ -556,11 +530,11 @@ hlBool CVBSPFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSiz
 	}
 	else if(pFile->GetID() < HL_VBSP_LUMP_COUNT)
 	{
-		uiSize = this->pHeader->lpLumps[pFile->GetID()].uiLength;
+		uiSize = this->GetLumpSize(pFile->GetID());
 	}
 	else
 	{
-		uiSize = sizeof(LMPHeader) + this->pHeader->lpLumps[pFile->GetID() - HL_VBSP_LUMP_COUNT].uiLength;
+		uiSize = sizeof(LMPHeader) + this->GetLumpSize(pFile->GetID() - HL_VBSP_LUMP_COUNT);
 	}
 
 	return hlTrue;
@@ -592,7 +566,7 @@ hlBool CVBSPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::ISt
 	{
 		const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-		if(pDirectoryItem->uiCompressionMethod != 0)
+		if(!this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod))
 		{
 			LastError.SetErrorMessageFormated("Compression format %#.2x not supported.", pDirectoryItem->uiCompressionMethod);
 			return hlFalse;
@@ -621,37 +595,70 @@ hlBool CVBSPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::ISt
 			return hlFalse;
 		}
 
-		pStream = new Streams::CMappingStream(*this->pMapping, this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset + pDirectoryItem->uiRelativeOffsetOfLocalHeader + sizeof(ZIPLocalFileHeader) + DirectoryEntry.uiFileNameLength + DirectoryEntry.uiExtraFieldLength, DirectoryEntry.uiUncompressedSize);
+		// Sizes come from the central directory, the local header's are zero when a data descriptor is used.
+		hlULongLong uiDataOffset = static_cast<hlULongLong>(this->pHeader->lpLumps[HL_VBSP_LUMP_PAKFILE].uiOffset) + pDirectoryItem->uiRelativeOffsetOfLocalHeader + sizeof(ZIPLocalFileHeader) + DirectoryEntry.uiFileNameLength + DirectoryEntry.uiExtraFieldLength;
+
+		switch(pDirectoryItem->uiCompressionMethod)
+		{
+		case HL_VBSP_ZIP_COMPRESSION_STORE:
+			pStream = new Streams::CMappingStream(*this->pMapping, uiDataOffset, pDirectoryItem->uiUncompressedSize);
+			break;
+#ifdef USE_ZLIB
+		case HL_VBSP_ZIP_COMPRESSION_DEFLATE:
+			pStream = new Streams::CInflateStream(*this->pMapping, uiDataOffset, pDirectoryItem->uiCompressedSize, pDirectoryItem->uiUncompressedSize);
+			break;
+#endif
+#ifdef USE_LZMA
+		case HL_VBSP_ZIP_COMPRESSION_LZMA:
+			return CZIPFile::CreateLZMAStream(*this->pMapping, uiDataOffset, pDirectoryItem->uiCompressedSize, pDirectoryItem->uiUncompressedSize, pStream);
+#endif
+		}
 	}
 	else if(pFile->GetID() < HL_VBSP_LUMP_COUNT)
 	{
-		pStream = new Streams::CMappingStream(*this->pMapping, this->pHeader->lpLumps[pFile->GetID()].uiOffset, this->pHeader->lpLumps[pFile->GetID()].uiLength);
+		return this->CreateLumpStream(pFile->GetID(), pStream);
 	}
 	else
 	{
-		hlUInt uiID = pFile->GetID() - HL_VBSP_LUMP_COUNT;
+		hlUInt uiBufferSize;
+		const hlByte *lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Acquire(pFile->GetID(), uiBufferSize) : 0;
 
-		Mapping::CView *pLumpView = 0;
-		if(!this->pMapping->Map(pLumpView, this->pHeader->lpLumps[uiID].uiOffset, this->pHeader->lpLumps[uiID].uiLength))
+		if(lpBuffer == 0)
 		{
-			return hlFalse;
-		}
+			hlUInt uiID = pFile->GetID() - HL_VBSP_LUMP_COUNT;
+
+			// .lmp files hold the lump uncompressed, decode straight into the buffer.
+			Streams::IStream *pLumpStream = 0;
+			if(!this->CreateLumpStream(uiID, pLumpStream))
+			{
+				return hlFalse;
+			}
 
-		hlUInt uiBufferSize = sizeof(LMPHeader) + this->pHeader->lpLumps[uiID].uiLength;
-		hlByte *lpBuffer = new hlByte[uiBufferSize];
+			hlUInt uiLumpSize = this->GetLumpSize(uiID);
+			uiBufferSize = sizeof(LMPHeader) + uiLumpSize;
+			hlByte *lpLMP = new hlByte[uiBufferSize];
 
-		LMPHeader *pLMPHeader = (LMPHeader *)lpBuffer;
-		pLMPHeader->iLumpOffset = sizeof(LMPHeader);
-		pLMPHeader->iLumpID = uiID;
-		pLMPHeader->iLumpVersion = this->pHeader->lpLumps[uiID].uiVersion;
-		pLMPHeader->iLumpLength = this->pHeader->lpLumps[uiID].uiLength;
-		pLMPHeader->iMapRevision = this->pHeader->iMapRevision;
+			LMPHeader *pLMPHeader = (LMPHeader *)lpLMP;
+			pLMPHeader->iLumpOffset = sizeof(LMPHeader);
+			pLMPHeader->iLumpID = uiID;
+			pLMPHeader->iLumpVersion = this->pHeader->lpLumps[uiID].uiVersion;
+			pLMPHeader->iLumpLength = uiLumpSize;
+			pLMPHeader->iMapRevision = this->pHeader->iMapRevision;
 
-		memcpy(lpBuffer + sizeof(LMPHeader), pLumpView->GetView(), this->pHeader->lpLumps[uiID].uiLength);
+			hlBool bResult = pLumpStream->Open(HL_MODE_READ) && pLumpStream->Read(lpLMP + sizeof(LMPHeader), uiLumpSize) == uiLumpSize;
 
-		pStream = new Streams::CMemoryStream(lpBuffer, uiBufferSize);
+			delete pLumpStream;
 
-		this->pMapping->Unmap(pLumpView);
+			if(!bResult)
+			{
+				delete []lpLMP;
+				return hlFalse;
+			}
+
+			lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Add(pFile->GetID(), lpLMP, uiBufferSize) : lpLMP;
+		}
+
+		pStream = new Streams::CMemoryStream(static_cast<const hlVoid *>(lpBuffer), uiBufferSize);
 	}
 
 	return hlTrue;
@@ -661,7 +668,11 @@ hlVoid CVBSPFile::ReleaseStreamInternal(Streams::IStream &Stream) const
 {
 	if(Stream.GetType() == HL_STREAM_MEMORY)
 	{
-		delete [](hlByte *)static_cast<Streams::CMemoryStream &>(Stream).GetBuffer();
+		const hlByte *lpBuffer = static_cast<const hlByte *>(static_cast<Streams::CMemoryStream &>(Stream).GetBuffer());
+		if(this->pStreamCache == 0 || !this->pStreamCache->Release(lpBuffer))
+		{
+			delete []lpBuffer;
+		}
 	}
 }
 
@@ -708,3 +719,82 @@ hlVoid CVBSPFile::GetFileName(hlChar *lpBuffer, hlUInt uiBufferSize)
 	strncpy(lpBuffer, lpStart, uiBufferSize);
 	lpBuffer[uiBufferSize - 1] = '\0';
 }
+
+hlBool CVBSPFile::GetCompressionSupported(hlUInt uiCompressionMethod) const
+{
+	switch(uiCompressionMethod)
+	{
+	case HL_VBSP_ZIP_COMPRESSION_STORE:
+#ifdef USE_ZLIB
+	case HL_VBSP_ZIP_COMPRESSION_DEFLATE:
+#endif
+#ifdef USE_LZMA
+	case HL_VBSP_ZIP_COMPRESSION_LZMA:
+#endif
+		return hlTrue;
+	default:
+		return hlFalse;
+	}
+}
+
+//
+// GetLumpCompressed()
+// Lumps are LZMA compressed when the four CC field holds their uncompressed size.
+//
+hlBool CVBSPFile::GetLumpCompressed(hlUInt uiID) const
+{
+	return *(const hlUInt *)this->pHeader->lpLumps[uiID].lpFourCC != 0;
+}
+
+hlUInt CVBSPFile::GetLumpSize(hlUInt uiID) const
+{
+	return this->GetLumpCompressed(uiID) ? *(const hlUInt *)this->pHeader->lpLumps[uiID].lpFourCC : this->pHeader->lpLumps[uiID].uiLength;
+}
+
+hlBool CVBSPFile::CreateLumpStream(hlUInt uiID, Streams::IStream *&pStream) const
+{
+	const VBSPLump &Lump = this->pHeader->lpLumps[uiID];
+
+	if(!this->GetLumpCompressed(uiID))
+	{
+		pStream = new Streams::CMappingStream(*this->pMapping, Lump.uiOffset, Lump.uiLength);
+		return hlTrue;
+	}
+
+#ifdef USE_LZMA
+	if(Lump.uiLength < sizeof(VBSPLZMAHeader))
+	{
+		LastError.SetErrorMessageFormated("Invalid LZMA header: lump %u is too small.", uiID);
+		return hlFalse;
+	}
+
+	Mapping::CView *pLZMAHeaderView = 0;
+
+	if(!this->pMapping->Map(pLZMAHeaderView, Lump.uiOffset, sizeof(VBSPLZMAHeader)))
+	{
+		return hlFalse;
+	}
+
+	const VBSPLZMAHeader LZMAHeader = *static_cast<const VBSPLZMAHeader *>(pLZMAHeaderView->GetView());
+
+	this->pMapping->Unmap(pLZMAHeaderView);
+
+	if(LZMAHeader.uiID != HL_VBSP_LZMA_ID)
+	{
+		LastError.SetErrorMessageFormated("Invalid LZMA header: lump %u signature does not match.", uiID);
+		return hlFalse;
+	}
+
+	if(LZMAHeader.uiLZMASize > Lump.uiLength - sizeof(VBSPLZMAHeader) || LZMAHeader.uiActualSize != this->GetLumpSize(uiID))
+	{
+		LastError.SetErrorMessageFormated("Invalid LZMA header: lump %u sizes do not match.", uiID);
+		return hlFalse;
+	}
+
+	pStream = new Streams::CLZMAStream(*this->pMapping, static_cast<hlULongLong>(Lump.uiOffset) + sizeof(VBSPLZMAHeader), LZMAHeader.uiLZMASize, LZMAHeader.lpProperties, LZMAHeader.uiActualSize);
+	return hlTrue;
+#else
+	LastError.SetErrorMessageFormated("Lump %u is LZMA compressed, LZMA not supported.", uiID);
+	return hlFalse;
+#endif
+}
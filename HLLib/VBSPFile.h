@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "Package.h"
+#include "BufferCache.h"
 
 #define HL_VBSP_LUMP_COUNT 64
 
@@ -40,6 +41,14 @@ namespace HLLib
 			hlInt		iMapRevision;					// The map's revision (iteration, version) number.
 		};
 
+		struct VBSPLZMAHeader
+		{
+			hlUInt		uiID;							// LZMA header signature ("LZMA").
+			hlUInt		uiActualSize;					// Uncompressed size.
+			hlUInt		uiLZMASize;						// Compressed size.
+			hlByte		lpProperties[5];				// LZMA properties.
+		};
+
 		struct ZIPEndOfCentralDirectoryRecord
 		{
 			hlUInt uiSignature; // 4 bytes (0x06054b50)
@@ -117,6 +126,8 @@ namespace HLLib
 		const VBSPHeader *pHeader;
 		const ZIPEndOfCentralDirectoryRecord *pEndOfCentralDirectoryRecord;
 
+		CBufferCache *pStreamCache;
+
 	public:
 		CVBSPFile();
 		virtual ~CVBSPFile();
@@ -141,6 +152,7 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
@@ -149,6 +161,12 @@ namespace HLLib
 
 	private:
 		hlVoid GetFileName(hlChar *lpBuffer, hlUInt uiBufferSize);
+
+		hlBool GetCompressionSupported(hlUInt uiCompressionMethod) const;
+
+		hlBool GetLumpCompressed(hlUInt uiID) const;
+		hlUInt GetLumpSize(hlUInt uiID) const;
+		hlBool CreateLumpStream(hlUInt uiID, Streams::IStream *&pStream) const;
 	};
 }
 
@@ -11,9 +11,12 @@
 
 #include "HLLib.h"
 #include "VPKFile.h"
+#include "Utility.h"
+#include "DirectoryTreeBuilder.h"
 #include "Mappings.h"
 #include "Streams.h"
 #include "Checksum.h"
+#include "Thread.h"
 
 using namespace HLLib;
 
@@ -21,11 +24,12 @@ using namespace HLLib;
 #define HL_VPK_NO_ARCHIVE 0x7fff
 
 #define HL_VPK_CHECKSUM_LENGTH 0x00008000
+#define HL_VPK_MD5_VIEW_SIZE 0x00100000
 
 const char *CVPKFile::lpAttributeNames[] = { "Archives", "Version" };
 const char *CVPKFile::lpItemAttributeNames[] = { "Preload Bytes", "Archive", "CRC" };
 
-CVPKFile::CVPKFile() : CPackage(), pView(0), uiArchiveCount(0), lpArchives(0), pHeader(0), pDirectoryItems(0)
+CVPKFile::CVPKFile() : CPackage(), pView(0), uiArchiveCount(0), lpArchives(0), lpArchivePrefix(0), lpArchiveExtension(0), uiArchiveHandleLimit(0), uiOpenArchiveCount(0), uiArchiveClock(0), pHeader(0), pExtendedHeader(0), lpArchiveMD5Entries(0), uiArchiveMD5EntryCount(0), pOtherMD5Section(0), uiDirectoryItemCount(0), lpDirectoryItems(0), uiDirectoryItemBucketCount(0), lpDirectoryItemBuckets(0)
 {
 
 }
@@ -70,36 +74,15 @@ hlBool CVPKFile::MapString(const hlChar *&lpViewData, const hlChar *lpViewDirect
 	return hlTrue;
 }
 
-hlBool CVPKFile::MapDataStructures()
+//
+// MapDirectoryItems()
+// Walks the extension, path and name tree of the directory.  If
+// lpDirectoryItems is 0 the items are only counted, otherwise they are
+// stored in it.
+//
+hlBool CVPKFile::MapDirectoryItems(const hlChar *lpViewData, const hlChar *lpViewDirectoryDataEnd, const hlChar *lpViewDataEnd, VPKDirectoryItem *lpDirectoryItems, hlUInt &uiDirectoryItemCount)
 {
-	if(!this->pMapping->Map(this->pView, 0, this->pMapping->GetMappingSize()))
-	{
-		return hlFalse;
-	}
-
-	this->pDirectoryItems = new CDirectoryItemList();
-
-	const hlChar *lpViewData = static_cast<const hlChar *>(this->pView->GetView());
-	const hlChar *lpViewDataEnd = static_cast<const hlChar *>(this->pView->GetView()) + this->pView->GetLength();
-	const hlChar *lpViewDirectoryDataEnd = lpViewDataEnd;
-
-	if(lpViewData + sizeof(VPKHeader) > lpViewDataEnd)
-	{
-		LastError.SetErrorMessage("Invalid file: The file map is not within mapping bounds.");
-		return hlFalse;
-	}
-	this->pHeader = reinterpret_cast<const VPKHeader *>(lpViewData);
-
-	if(this->pHeader->uiSignature != HL_VPK_SIGNATURE)
-	{
-		// The original version had no signature.
-		this->pHeader = 0;
-	}
-	else
-	{
-		lpViewData += sizeof(VPKHeader);
-		lpViewDirectoryDataEnd = lpViewData + this->pHeader->uiDirectoryLength;
-	}
+	uiDirectoryItemCount = 0;
 
 	while(lpViewData != lpViewDirectoryDataEnd)
 	{
@@ -176,61 +159,183 @@ hlBool CVPKFile::MapDataStructures()
 					}
 				}
 
-				this->pDirectoryItems->push_back(new VPKDirectoryItem(lpExtension, lpPath, lpName, pDirectoryEntry, lpPreloadData));
+				if(lpDirectoryItems != 0)
+				{
+					VPKDirectoryItem &DirectoryItem = lpDirectoryItems[uiDirectoryItemCount];
+					DirectoryItem.lpExtention = lpExtension;
+					DirectoryItem.lpPath = lpPath;
+					DirectoryItem.lpName = lpName;
+					DirectoryItem.pDirectoryEntry = pDirectoryEntry;
+					DirectoryItem.lpPreloadData = lpPreloadData;
+					DirectoryItem.pFile = 0;
+					DirectoryItem.uiHash = HashDirectoryItem(lpExtension, lpPath, lpName);
+					DirectoryItem.uiNext = HL_ID_INVALID;
+				}
+				uiDirectoryItemCount++;
 			}
 		}
 	}
 
-	const hlChar *lpFileName = this->pMapping->GetFileName();
-	if(this->uiArchiveCount > 0 && lpFileName != 0)
+	return hlTrue;
+}
+
+//
+// HashDirectoryItem()
+// Case insensitive FNV-1a hash of an item's extension, path and name.  The
+// root path is stored as " ", so it hashes the same as "".
+//
+hlUInt CVPKFile::HashDirectoryItem(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName)
+{
+	if(strcmp(lpPath, " ") == 0)
 	{
-		const hlChar *lpExtension = strrchr(lpFileName, '.');
-		if(lpExtension && lpExtension - lpFileName > 3 && _strnicmp(lpExtension - 3, "dir", 3) == 0)
+		lpPath = "";
+	}
+
+	const hlChar *lpStrings[] = { lpExtension, lpPath, lpName };
+
+	hlUInt uiHash = 2166136261U;
+	for(hlUInt i = 0; i < 3; i++)
+	{
+		for(const hlChar *lpChar = lpStrings[i]; *lpChar != '\0'; lpChar++)
 		{
-			hlChar *lpArchiveFileName = new hlChar[strlen(lpFileName) + 2 + 1];  // We need 5 digits to print a short, but we already have 3 for dir.
-			hlChar *lpArchiveNumber = lpArchiveFileName + (lpExtension - lpFileName) - 3;
-			strcpy(lpArchiveFileName, lpFileName);
+			uiHash = (uiHash ^ static_cast<hlByte>(tolower(static_cast<hlByte>(*lpChar)))) * 16777619U;
+		}
+		uiHash = (uiHash ^ '/') * 16777619U;
+	}
 
-			this->lpArchives = new VPKArchive[this->uiArchiveCount];
-			memset(this->lpArchives, 0, this->uiArchiveCount * sizeof(VPKArchive));
-			for(hlUInt i = 0; i < this->uiArchiveCount; i++)
+	return uiHash;
+}
+
+hlBool CVPKFile::MapDataStructures()
+{
+	if(!this->pMapping->Map(this->pView, 0, this->pMapping->GetMappingSize()))
+	{
+		return hlFalse;
+	}
+
+	const hlChar *lpViewData = static_cast<const hlChar *>(this->pView->GetView());
+	const hlChar *lpViewDataEnd = static_cast<const hlChar *>(this->pView->GetView()) + this->pView->GetLength();
+	const hlChar *lpViewDirectoryDataEnd = lpViewDataEnd;
+
+	if(lpViewData + sizeof(VPKHeader) > lpViewDataEnd)
+	{
+		LastError.SetErrorMessage("Invalid file: The file map is not within mapping bounds.");
+		return hlFalse;
+	}
+	this->pHeader = reinterpret_cast<const VPKHeader *>(lpViewData);
+
+	if(this->pHeader->uiSignature != HL_VPK_SIGNATURE)
+	{
+		// The original version had no signature.
+		this->pHeader = 0;
+	}
+	else
+	{
+		if(this->pHeader->uiVersion < 1 || this->pHeader->uiVersion > 2)
+		{
+			LastError.SetErrorMessageFormated("Invalid VPK version (v%u): you have a version of a VPK file that HLLib does not know how to read. Check for product updates.", this->pHeader->uiVersion);
+			return hlFalse;
+		}
+
+		lpViewData += sizeof(VPKHeader);
+
+		if(this->pHeader->uiVersion >= 2)
+		{
+			if(lpViewData + sizeof(VPKExtendedHeader) > lpViewDataEnd)
 			{
-				hlInt iPrinted = sprintf(lpArchiveNumber, "%03u", i);
-				if(iPrinted > 0)
-				{
-					strcat(lpArchiveNumber + iPrinted, lpExtension);
+				LastError.SetErrorMessage("Invalid file: The file map is not within mapping bounds.");
+				return hlFalse;
+			}
+			this->pExtendedHeader = reinterpret_cast<const VPKExtendedHeader *>(lpViewData);
 
-					if(this->pMapping->GetMode() & HL_MODE_NO_FILEMAPPING)
-					{
-						this->lpArchives[i].pStream = new Streams::CFileStream(lpArchiveFileName);
-						this->lpArchives[i].pMapping = new Mapping::CStreamMapping(*this->lpArchives[i].pStream);
+			lpViewData += sizeof(VPKExtendedHeader);
+		}
 
-						if(!this->lpArchives[i].pMapping->Open(this->pMapping->GetMode()))
-						{
-							delete this->lpArchives[i].pMapping;
-							this->lpArchives[i].pMapping = 0;
+		if(static_cast<hlULongLong>(lpViewDataEnd - lpViewData) < this->pHeader->uiDirectoryLength)
+		{
+			LastError.SetErrorMessage("Invalid file: The file map is not within mapping bounds.");
+			return hlFalse;
+		}
+		lpViewDirectoryDataEnd = lpViewData + this->pHeader->uiDirectoryLength;
 
-							delete this->lpArchives[i].pStream;
-							this->lpArchives[i].pStream = 0;
-						}
-					}
-					else
-					{
-						this->lpArchives[i].pMapping = new Mapping::CFileMapping(lpArchiveFileName);
+		if(this->pExtendedHeader != 0)
+		{
+			// The MD5 sections follow the data stored in the directory file.
+			if(static_cast<hlULongLong>(lpViewDataEnd - lpViewDirectoryDataEnd) < static_cast<hlULongLong>(this->pExtendedHeader->uiFileDataSectionSize) + static_cast<hlULongLong>(this->pExtendedHeader->uiArchiveMD5SectionSize) + static_cast<hlULongLong>(this->pExtendedHeader->uiOtherMD5SectionSize))
+			{
+				LastError.SetErrorMessage("Invalid file: The file map is not within mapping bounds.");
+				return hlFalse;
+			}
 
-						if(!this->lpArchives[i].pMapping->Open(this->pMapping->GetMode()))
-						{
-							delete this->lpArchives[i].pMapping;
-							this->lpArchives[i].pMapping = 0;
-						}
-					}
-				}
+			const hlChar *lpMD5Data = lpViewDirectoryDataEnd + this->pExtendedHeader->uiFileDataSectionSize;
+
+			this->lpArchiveMD5Entries = reinterpret_cast<const VPKArchiveMD5Entry *>(lpMD5Data);
+			this->uiArchiveMD5EntryCount = this->pExtendedHeader->uiArchiveMD5SectionSize / sizeof(VPKArchiveMD5Entry);
+			lpMD5Data += this->pExtendedHeader->uiArchiveMD5SectionSize;
+
+			if(this->pExtendedHeader->uiOtherMD5SectionSize >= sizeof(VPKOtherMD5Section))
+			{
+				this->pOtherMD5Section = reinterpret_cast<const VPKOtherMD5Section *>(lpMD5Data);
 			}
+		}
+	}
+
+	// Count the items first so they can be stored in one array.
+	if(!this->MapDirectoryItems(lpViewData, lpViewDirectoryDataEnd, lpViewDataEnd, 0, this->uiDirectoryItemCount))
+	{
+		return hlFalse;
+	}
+
+	this->lpDirectoryItems = new VPKDirectoryItem[this->uiDirectoryItemCount];
+	if(!this->MapDirectoryItems(lpViewData, lpViewDirectoryDataEnd, lpViewDataEnd, this->lpDirectoryItems, this->uiDirectoryItemCount))
+	{
+		return hlFalse;
+	}
 
-			delete []lpArchiveFileName;
+	// Hash the items by extension, path and name.
+	this->uiDirectoryItemBucketCount = 16;
+	while(this->uiDirectoryItemBucketCount < this->uiDirectoryItemCount)
+	{
+		this->uiDirectoryItemBucketCount <<= 1;
+	}
+
+	this->lpDirectoryItemBuckets = new hlUInt[this->uiDirectoryItemBucketCount];
+	for(hlUInt i = 0; i < this->uiDirectoryItemBucketCount; i++)
+	{
+		this->lpDirectoryItemBuckets[i] = HL_ID_INVALID;
+	}
+
+	for(hlUInt i = this->uiDirectoryItemCount; i-- > 0;)
+	{
+		VPKDirectoryItem &DirectoryItem = this->lpDirectoryItems[i];
+		hlUInt &uiBucket = this->lpDirectoryItemBuckets[DirectoryItem.uiHash & (this->uiDirectoryItemBucketCount - 1)];
+		DirectoryItem.uiNext = uiBucket;
+		uiBucket = i;
+	}
+
+	const hlChar *lpFileName = this->pMapping->GetFileName();
+	if(this->uiArchiveCount > 0 && lpFileName != 0)
+	{
+		const hlChar *lpExtension = strrchr(lpFileName, '.');
+		if(lpExtension && lpExtension - lpFileName > 3 && _strnicmp(lpExtension - 3, "dir", 3) == 0)
+		{
+			// The archives are opened as they are used, see AcquireArchive().
+			hlUInt uiPrefixLength = static_cast<hlUInt>(lpExtension - lpFileName) - 3;
+
+			this->lpArchivePrefix = new hlChar[uiPrefixLength + 1];
+			strncpy(this->lpArchivePrefix, lpFileName, uiPrefixLength);
+			this->lpArchivePrefix[uiPrefixLength] = '\0';
+
+			this->lpArchiveExtension = new hlChar[strlen(lpExtension) + 1];
+			strcpy(this->lpArchiveExtension, lpExtension);
+
+			this->lpArchives = new VPKArchive[this->uiArchiveCount];
+			memset(this->lpArchives, 0, this->uiArchiveCount * sizeof(VPKArchive));
 		}
 	}
 
+	this->uiArchiveHandleLimit = this->GetContext().uiArchiveHandleLimit;
+
 	return hlTrue;
 }
 
@@ -240,17 +345,7 @@ hlVoid CVPKFile::UnmapDataStructures()
 	{
 		for(hlUInt i = 0; i < this->uiArchiveCount; i++)
 		{
-			if(this->lpArchives[i].pMapping != 0)
-			{
-				this->lpArchives[i].pMapping->Close();
-				delete this->lpArchives[i].pMapping;
-			}
-
-			if(this->lpArchives[i].pStream != 0)
-			{
-				this->lpArchives[i].pStream->Close();
-				delete this->lpArchives[i].pStream;
-			}
+			this->CloseArchive(i);
 		}
 	}
 
@@ -258,16 +353,29 @@ hlVoid CVPKFile::UnmapDataStructures()
 	delete []this->lpArchives;
 	this->lpArchives = 0;
 
+	delete []this->lpArchivePrefix;
+	this->lpArchivePrefix = 0;
+
+	delete []this->lpArchiveExtension;
+	this->lpArchiveExtension = 0;
+
+	this->uiArchiveHandleLimit = 0;
+	this->uiOpenArchiveCount = 0;
+	this->uiArchiveClock = 0;
+
 	this->pHeader = 0;
-	if(this->pDirectoryItems != 0)
-	{
-		for(CDirectoryItemList::iterator i = this->pDirectoryItems->begin(); i != this->pDirectoryItems->end(); ++i)
-		{
-			delete *i;
-		}
-		delete this->pDirectoryItems;
-		this->pDirectoryItems = 0;
-	}
+	this->pExtendedHeader = 0;
+	this->lpArchiveMD5Entries = 0;
+	this->uiArchiveMD5EntryCount = 0;
+	this->pOtherMD5Section = 0;
+
+	this->uiDirectoryItemBucketCount = 0;
+	delete []this->lpDirectoryItemBuckets;
+	this->lpDirectoryItemBuckets = 0;
+
+	this->uiDirectoryItemCount = 0;
+	delete []this->lpDirectoryItems;
+	this->lpDirectoryItems = 0;
 
 	this->pMapping->Unmap(this->pView);
 }
@@ -275,51 +383,17 @@ hlVoid CVPKFile::UnmapDataStructures()
 CDirectoryFolder *CVPKFile::CreateRoot()
 {
 	CDirectoryFolder *pRoot = new CDirectoryFolder(this);
-
-	const hlChar *lpLastPath = 0;
-	CDirectoryFolder *pLastInsertFolder = 0;
+	CDirectoryTreeBuilder Builder(pRoot);
 
 	// Loop through each file in the VPK file.
-	for(CDirectoryItemList::const_iterator i = this->pDirectoryItems->begin(); i != this->pDirectoryItems->end(); ++i)
+	for(hlUInt i = 0; i < this->uiDirectoryItemCount; i++)
 	{
-		const VPKDirectoryItem *pDirectoryItem = *i;
+		VPKDirectoryItem *pDirectoryItem = this->lpDirectoryItems + i;
 
-		CDirectoryFolder *pInsertFolder;
-		if(pDirectoryItem->lpPath == lpLastPath)
+		CDirectoryFolder *pInsertFolder = pRoot;
+		if(*pDirectoryItem->lpPath != '\0' && strcmp(pDirectoryItem->lpPath, " ") != 0)
 		{
-			pInsertFolder = pLastInsertFolder;
-		}
-		else
-		{
-			pInsertFolder = pRoot;
-
-			if(*pDirectoryItem->lpPath != '\0' && strcmp(pDirectoryItem->lpPath, " ") != 0)
-			{
-				// Tokenize the file path and create the directories.
-				hlChar *lpPath = new hlChar[strlen(pDirectoryItem->lpPath) + 1];
-				strcpy(lpPath, pDirectoryItem->lpPath);
-				hlChar *lpToken = strtok(lpPath, "/\\");
-				while(lpToken != 0)
-				{
-					// Check if the directory exists.
-					CDirectoryItem *pItem = pInsertFolder->GetItem(lpToken);
-					if(pItem == 0 || pItem->GetType() == HL_ITEM_FILE)
-					{
-						// It doesn't, create it.
-						pInsertFolder = pInsertFolder->AddFolder(lpToken);
-					}
-					else
-					{
-						// It does, use it.
-						pInsertFolder = static_cast<CDirectoryFolder *>(pItem);
-					}
-					lpToken = strtok(0, "/\\");
-				}
-				delete []lpPath;
-			}
-
-			lpLastPath = pDirectoryItem->lpPath;
-			pLastInsertFolder = pInsertFolder;
+			pInsertFolder = Builder.GetFolder(pDirectoryItem->lpPath);
 		}
 
 		hlChar *lpFileName = new hlChar[strlen(pDirectoryItem->lpName) + 1 + strlen(pDirectoryItem->lpExtention) + 1];
@@ -327,7 +401,7 @@ CDirectoryFolder *CVPKFile::CreateRoot()
 		strcat(lpFileName, ".");
 		strcat(lpFileName, pDirectoryItem->lpExtention);
 
-		pInsertFolder->AddFile(lpFileName, -1, const_cast<VPKDirectoryItem *>(pDirectoryItem));
+		pDirectoryItem->pFile = pInsertFolder->AddFile(lpFileName, -1, pDirectoryItem);
 
 		delete []lpFileName;
 	}
@@ -423,9 +497,15 @@ hlBool CVPKFile::GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool
 	}
 	else if(pDirectoryItem->pDirectoryEntry->uiEntryLength != 0)
 	{
-		Mapping::CMapping *pMapping = this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping;
-
-		bExtractable = pMapping ? pDirectoryItem->pDirectoryEntry->uiEntryOffset + pDirectoryItem->pDirectoryEntry->uiEntryLength <= pMapping->GetMappingSize() : hlFalse;
+		hlULongLong uiArchiveSize;
+		if(this->GetArchiveSize(pDirectoryItem->pDirectoryEntry->uiArchiveIndex, uiArchiveSize))
+		{
+			bExtractable = static_cast<hlULongLong>(pDirectoryItem->pDirectoryEntry->uiEntryOffset) + static_cast<hlULongLong>(pDirectoryItem->pDirectoryEntry->uiEntryLength) <= uiArchiveSize;
+		}
+		else
+		{
+			bExtractable = hlFalse;
+		}
 	}
 	else
 	{
@@ -447,39 +527,17 @@ hlBool CVPKFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 			{
 				if(pStream->Open(HL_MODE_READ))
 				{
-					hlULong uiChecksum = 0;
-					eValidation = HL_VALIDATES_OK;
-
-					hlULongLong uiTotalBytes = 0, uiFileBytes = pStream->GetStreamSize();
-					hlUInt uiBufferSize;
-					hlByte lpBuffer[HL_VPK_CHECKSUM_LENGTH];
+					Streams::CReadAheadStream Input(*pStream, this->GetContext().bReadAhead);
 
-					hlBool bCancel = hlFalse;
-					hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
-
-					while((uiBufferSize = pStream->Read(lpBuffer, HL_VPK_CHECKSUM_LENGTH)) != 0)
+					if(Input.Open(HL_MODE_READ))
 					{
-						if(bCancel)
-						{
-							// User canceled.
-							eValidation = HL_VALIDATES_CANCELED;
-							break;
-						}
-
-						uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
+						this->ValidateStreamInternal(pFile, Input, eValidation);
 
-						uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
-
-						hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+						Input.Close();
 					}
-
-					if(!bCancel)
+					else
 					{
-						const VPKDirectoryItem *pDirectoryItem = static_cast<const VPKDirectoryItem *>(pFile->GetData());
-						if(pDirectoryItem->pDirectoryEntry->uiCRC != uiChecksum)
-						{
-							eValidation = HL_VALIDATES_CORRUPT;
-						}
+						eValidation = HL_VALIDATES_ERROR;
 					}
 
 					pStream->Close();
@@ -510,6 +568,43 @@ hlBool CVPKFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 	return hlTrue;
 }
 
+hlBool CVPKFile::ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	hlULong uiChecksum = 0;
+	eValidation = HL_VALIDATES_OK;
+
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Stream.GetStreamSize();
+	hlUInt uiBufferSize;
+	hlByte lpBuffer[HL_VPK_CHECKSUM_LENGTH];
+
+	hlBool bCancel = hlFalse;
+	hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+
+	while((uiBufferSize = Stream.Read(lpBuffer, HL_VPK_CHECKSUM_LENGTH)) != 0)
+	{
+		if(bCancel)
+		{
+			// User canceled.
+			eValidation = HL_VALIDATES_CANCELED;
+			return hlTrue;
+		}
+
+		uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
+
+		uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+
+		hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+	}
+
+	const VPKDirectoryItem *pDirectoryItem = static_cast<const VPKDirectoryItem *>(pFile->GetData());
+	if(pDirectoryItem->pDirectoryEntry->uiCRC != uiChecksum)
+	{
+		eValidation = HL_VALIDATES_CORRUPT;
+	}
+
+	return hlTrue;
+}
+
 hlBool CVPKFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
 	const VPKDirectoryItem *pDirectoryItem = static_cast<const VPKDirectoryItem *>(pFile->GetData());
@@ -538,14 +633,14 @@ hlBool CVPKFile::GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &
 	{
 		uiSize = pDirectoryItem->pDirectoryEntry->uiEntryLength;
 
-		Mapping::CMapping *pMapping = this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping;
-		if(pMapping == 0)
+		hlULongLong uiArchiveSize;
+		if(!this->GetArchiveSize(pDirectoryItem->pDirectoryEntry->uiArchiveIndex, uiArchiveSize))
 		{
 			uiSize = 0;
 		}
 		else
 		{
-			hlUInt uiMappingSize = static_cast<hlUInt>(pMapping->GetMappingSize());
+			hlUInt uiMappingSize = static_cast<hlUInt>(uiArchiveSize);
 			if(pDirectoryItem->pDirectoryEntry->uiEntryOffset >= uiMappingSize)
 			{
 				uiSize = 0;
@@ -583,34 +678,31 @@ hlBool CVPKFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStr
 				return hlFalse;
 			}
 		}
-		else if(this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping != 0)
+		else
 		{
-			if(pDirectoryItem->pDirectoryEntry->uiPreloadBytes != 0)
-			{
-				Mapping::CView *pView = 0;
-				if(!this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping->Map(pView, pDirectoryItem->pDirectoryEntry->uiEntryOffset, pDirectoryItem->pDirectoryEntry->uiEntryLength))
-				{
-					return hlFalse;
-				}
-
-				hlUInt uiBufferSize = pDirectoryItem->pDirectoryEntry->uiEntryLength + pDirectoryItem->pDirectoryEntry->uiPreloadBytes;
-				hlByte *lpBuffer = new hlByte[uiBufferSize];
+			hlUInt uiArchiveIndex = pDirectoryItem->pDirectoryEntry->uiArchiveIndex;
 
-				memcpy(lpBuffer, pDirectoryItem->lpPreloadData, pDirectoryItem->pDirectoryEntry->uiPreloadBytes);
-				memcpy(lpBuffer + pDirectoryItem->pDirectoryEntry->uiPreloadBytes, pView->GetView(), pDirectoryItem->pDirectoryEntry->uiEntryLength);
+			Mapping::CMapping *pArchiveMapping = this->AcquireArchive(uiArchiveIndex);
+			if(pArchiveMapping == 0)
+			{
+				return hlFalse;
+			}
 
-				this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping->Unmap(pView);
+			if(pDirectoryItem->pDirectoryEntry->uiPreloadBytes != 0)
+			{
+				// Read the preload bytes in place, followed by the archive data.
+				Streams::IStream *pPreloadStream = new Streams::CMemoryStream(const_cast<hlVoid *>(pDirectoryItem->lpPreloadData), pDirectoryItem->pDirectoryEntry->uiPreloadBytes);
+				Streams::IStream *pArchiveStream = new Streams::CMappingStream(*pArchiveMapping, pDirectoryItem->pDirectoryEntry->uiEntryOffset, pDirectoryItem->pDirectoryEntry->uiEntryLength);
 
-				pStream = new Streams::CMemoryStream(lpBuffer, uiBufferSize);
+				pStream = new Streams::CConcatenatedStream(pPreloadStream, pArchiveStream);
 			}
 			else
 			{
-				pStream = new Streams::CMappingStream(*this->lpArchives[pDirectoryItem->pDirectoryEntry->uiArchiveIndex].pMapping, pDirectoryItem->pDirectoryEntry->uiEntryOffset, pDirectoryItem->pDirectoryEntry->uiEntryLength);
+				pStream = new Streams::CMappingStream(*pArchiveMapping, pDirectoryItem->pDirectoryEntry->uiEntryOffset, pDirectoryItem->pDirectoryEntry->uiEntryLength);
 			}
-		}
-		else
-		{
-			return hlFalse;
+
+			// The archive stays open until the stream is released.
+			SetStreamData(*pStream, uiArchiveIndex + 1);
 		}
 	}
 	else if(pDirectoryItem->pDirectoryEntry->uiPreloadBytes != 0)
@@ -627,13 +719,487 @@ hlBool CVPKFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStr
 
 hlVoid CVPKFile::ReleaseStreamInternal(Streams::IStream &Stream) const
 {
-	if(Stream.GetType() == HL_STREAM_MEMORY)
+	// Streams into an archive hold the archive's index plus one.
+	hlUInt uiArchiveData = GetStreamData(Stream);
+	if(uiArchiveData != 0)
+	{
+		this->ReleaseArchive(uiArchiveData - 1);
+	}
+}
+
+//
+// Archive handles.
+// Archives are opened on first use and closed again, least recently used
+// first, once more than the handle limit are open.  Archives with open
+// streams or running validations and pinned archives are never closed; if
+// those alone exceed the limit it is exceeded.
+//
+
+hlBool CVPKFile::PinArchive(hlUInt uiArchiveIndex)
+{
+	if(!this->GetOpened())
+	{
+		LastError.SetErrorMessage("Package not opened.");
+		return hlFalse;
+	}
+
+	if(this->AcquireArchive(uiArchiveIndex) == 0)
+	{
+		return hlFalse;
+	}
+
+	{
+		Threading::CLock Lock(this->ArchiveMutex);
+		this->lpArchives[uiArchiveIndex].bPinned = hlTrue;
+	}
+
+	this->ReleaseArchive(uiArchiveIndex);
+
+	return hlTrue;
+}
+
+hlVoid CVPKFile::UnpinArchive(hlUInt uiArchiveIndex)
+{
+	if(!this->GetOpened() || this->lpArchives == 0 || uiArchiveIndex >= this->uiArchiveCount)
+	{
+		return;
+	}
+
+	Threading::CLock Lock(this->ArchiveMutex);
+
+	this->lpArchives[uiArchiveIndex].bPinned = hlFalse;
+
+	if(this->uiArchiveHandleLimit != 0)
+	{
+		this->CloseArchives(this->uiArchiveHandleLimit);
+	}
+}
+
+//
+// FindFile()
+// Looks a file up by the extension, path and name it is stored under,
+// without walking the directory tree.  The root path may be given as "" or
+// " ".  Returns 0 if no such file exists.
+//
+CDirectoryFile *CVPKFile::FindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName)
+{
+	if(!this->GetOpened() || this->GetRoot() == 0)
+	{
+		return 0;
+	}
+
+	hlBool bRootPath = *lpPath == '\0' || strcmp(lpPath, " ") == 0;
+	hlUInt uiHash = HashDirectoryItem(lpExtension, lpPath, lpName);
+
+	hlUInt i = this->lpDirectoryItemBuckets[uiHash & (this->uiDirectoryItemBucketCount - 1)];
+	while(i != HL_ID_INVALID)
+	{
+		const VPKDirectoryItem &DirectoryItem = this->lpDirectoryItems[i];
+		if(DirectoryItem.uiHash == uiHash && stricmp(DirectoryItem.lpExtention, lpExtension) == 0 && stricmp(DirectoryItem.lpName, lpName) == 0)
+		{
+			if(bRootPath ? (*DirectoryItem.lpPath == '\0' || strcmp(DirectoryItem.lpPath, " ") == 0) : stricmp(DirectoryItem.lpPath, lpPath) == 0)
+			{
+				return DirectoryItem.pFile;
+			}
+		}
+
+		i = DirectoryItem.uiNext;
+	}
+
+	return 0;
+}
+
+//
+// AcquireArchive()
+// Returns the mapping of archive uiArchiveIndex, opening it if need be.  The
+// archive stays open until the matching ReleaseArchive().
+//
+Mapping::CMapping *CVPKFile::AcquireArchive(hlUInt uiArchiveIndex) const
+{
+	if(this->lpArchives == 0 || uiArchiveIndex >= this->uiArchiveCount)
 	{
-		hlByte *lpBuffer = (hlByte *)static_cast<Streams::CMemoryStream &>(Stream).GetBuffer();
-		const hlByte *lpView = (const hlByte *)this->pView->GetView();
-		if(lpBuffer < lpView || lpBuffer >= lpView + this->pView->GetLength())
+		LastError.SetErrorMessageFormated("Archive %u does not exist.", uiArchiveIndex);
+		return 0;
+	}
+
+	Threading::CLock Lock(this->ArchiveMutex);
+
+	VPKArchive &Archive = this->lpArchives[uiArchiveIndex];
+	if(Archive.pMapping == 0)
+	{
+		if(Archive.bMissing)
+		{
+			LastError.SetErrorMessageFormated("Archive %u could not be opened.", uiArchiveIndex);
+			return 0;
+		}
+
+		if(this->uiArchiveHandleLimit != 0)
 		{
-			delete []lpBuffer;
+			this->CloseArchives(this->uiArchiveHandleLimit - 1);
 		}
+
+		if(!this->OpenArchive(uiArchiveIndex))
+		{
+			return 0;
+		}
+	}
+
+	Archive.uiReferences++;
+	Archive.uiLastUsed = ++this->uiArchiveClock;
+
+	return Archive.pMapping;
+}
+
+hlVoid CVPKFile::ReleaseArchive(hlUInt uiArchiveIndex) const
+{
+	Threading::CLock Lock(this->ArchiveMutex);
+
+	this->lpArchives[uiArchiveIndex].uiReferences--;
+
+	// Catch up if the limit had to be exceeded.
+	if(this->uiArchiveHandleLimit != 0)
+	{
+		this->CloseArchives(this->uiArchiveHandleLimit);
 	}
 }
+
+//
+// GetArchiveSize()
+// Returns the size of archive uiArchiveIndex, which is remembered once the
+// archive has been opened.
+//
+hlBool CVPKFile::GetArchiveSize(hlUInt uiArchiveIndex, hlULongLong &uiSize) const
+{
+	if(this->lpArchives == 0 || uiArchiveIndex >= this->uiArchiveCount)
+	{
+		return hlFalse;
+	}
+
+	{
+		Threading::CLock Lock(this->ArchiveMutex);
+
+		if(this->lpArchives[uiArchiveIndex].bSizeKnown)
+		{
+			uiSize = this->lpArchives[uiArchiveIndex].uiSize;
+			return hlTrue;
+		}
+	}
+
+	if(this->AcquireArchive(uiArchiveIndex) == 0)
+	{
+		return hlFalse;
+	}
+
+	{
+		Threading::CLock Lock(this->ArchiveMutex);
+
+		uiSize = this->lpArchives[uiArchiveIndex].uiSize;
+	}
+
+	this->ReleaseArchive(uiArchiveIndex);
+
+	return hlTrue;
+}
+
+//
+// OpenArchive()
+// Opens archive uiArchiveIndex.  ArchiveMutex must be held.
+//
+hlBool CVPKFile::OpenArchive(hlUInt uiArchiveIndex) const
+{
+	VPKArchive &Archive = this->lpArchives[uiArchiveIndex];
+
+	hlChar *lpArchiveFileName = new hlChar[strlen(this->lpArchivePrefix) + 5 + strlen(this->lpArchiveExtension) + 1];  // We need 5 digits to print a short.
+	sprintf(lpArchiveFileName, "%s%03u%s", this->lpArchivePrefix, uiArchiveIndex, this->lpArchiveExtension);
+
+	if(this->pMapping->GetMode() & HL_MODE_NO_FILEMAPPING)
+	{
+		Archive.pStream = new Streams::CFileStream(lpArchiveFileName);
+		Archive.pMapping = new Mapping::CStreamMapping(*Archive.pStream);
+	}
+	else
+	{
+		Archive.pMapping = new Mapping::CFileMapping(lpArchiveFileName);
+	}
+
+	if(!Archive.pMapping->Open(this->pMapping->GetMode()))
+	{
+		delete Archive.pMapping;
+		Archive.pMapping = 0;
+
+		delete Archive.pStream;
+		Archive.pStream = 0;
+
+		// Don't retry missing archives.  Anything else (out of handles, a
+		// sharing violation) may clear up, so the next use tries again.
+		if(!GetFileExists(lpArchiveFileName))
+		{
+			Archive.bMissing = hlTrue;
+		}
+
+		delete []lpArchiveFileName;
+		return hlFalse;
+	}
+
+	delete []lpArchiveFileName;
+
+	Archive.uiSize = Archive.pMapping->GetMappingSize();
+	Archive.bSizeKnown = hlTrue;
+
+	this->uiOpenArchiveCount++;
+
+	return hlTrue;
+}
+
+hlVoid CVPKFile::CloseArchive(hlUInt uiArchiveIndex) const
+{
+	VPKArchive &Archive = this->lpArchives[uiArchiveIndex];
+
+	if(Archive.pMapping != 0)
+	{
+		Archive.pMapping->Close();
+		delete Archive.pMapping;
+		Archive.pMapping = 0;
+
+		this->uiOpenArchiveCount--;
+	}
+
+	if(Archive.pStream != 0)
+	{
+		Archive.pStream->Close();
+		delete Archive.pStream;
+		Archive.pStream = 0;
+	}
+}
+
+//
+// CloseArchives()
+// Closes unused archives, least recently used first, until no more than
+// uiOpenCount are open.  ArchiveMutex must be held.
+//
+hlVoid CVPKFile::CloseArchives(hlUInt uiOpenCount) const
+{
+	while(this->uiOpenArchiveCount > uiOpenCount)
+	{
+		hlUInt uiArchiveIndex = this->uiArchiveCount;
+		for(hlUInt i = 0; i < this->uiArchiveCount; i++)
+		{
+			const VPKArchive &Archive = this->lpArchives[i];
+			if(Archive.pMapping != 0 && Archive.uiReferences == 0 && !Archive.bPinned)
+			{
+				if(uiArchiveIndex == this->uiArchiveCount || Archive.uiLastUsed < this->lpArchives[uiArchiveIndex].uiLastUsed)
+				{
+					uiArchiveIndex = i;
+				}
+			}
+		}
+
+		if(uiArchiveIndex == this->uiArchiveCount)
+		{
+			break;
+		}
+
+		this->CloseArchive(uiArchiveIndex);
+	}
+}
+
+//
+// Archive validation.
+// Version 2 directories hash their archives in chunks (usually a megabyte
+// each).  The chunks are spread over worker threads, each with a private
+// context, while the calling thread checks the hashes of the directory file
+// itself.
+//
+
+struct CVPKFile::VPKValidatePool
+{
+	const CVPKFile *pPackage;
+	HLValidation *lpResults;
+
+	Threading::CMutex Mutex;
+	hlUInt uiNext;
+};
+
+//
+// CombineValidation()
+// Returns the worse of two validation results.
+//
+static HLValidation CombineValidation(HLValidation eA, HLValidation eB)
+{
+	// Indexed by HLValidation; a corrupt chunk outranks one that couldn't be read.
+	static const hlUInt lpRanks[] = { 0, 1, 2, 4, 5, 3 };
+
+	return lpRanks[eB] > lpRanks[eA] ? eB : eA;
+}
+
+hlBool CVPKFile::ValidateArchives(HLValidation &eValidation) const
+{
+	if(!this->GetOpened())
+	{
+		LastError.SetErrorMessage("Package not opened.");
+		return hlFalse;
+	}
+
+	if(this->pExtendedHeader == 0)
+	{
+		// Only version 2 directories carry hashes.
+		eValidation = HL_VALIDATES_ASSUMED_OK;
+		return hlTrue;
+	}
+
+	eValidation = HL_VALIDATES_OK;
+
+	VPKValidatePool Pool;
+	Pool.pPackage = this;
+	Pool.lpResults = new HLValidation[this->uiArchiveMD5EntryCount];
+	Pool.uiNext = 0;
+
+	hlUInt uiThreadCount = this->GetContext().uiExtractThreadCount;
+	if(uiThreadCount == 0)
+	{
+		uiThreadCount = Threading::CThread::GetProcessorCount();
+	}
+	if(uiThreadCount > this->uiArchiveMD5EntryCount)
+	{
+		uiThreadCount = this->uiArchiveMD5EntryCount;
+	}
+
+	Threading::CThread *lpThreads = 0;
+	hlUInt uiStarted = 0;
+	if(uiThreadCount > 1)
+	{
+		lpThreads = new Threading::CThread[uiThreadCount];
+		for(hlUInt i = 0; i < uiThreadCount; i++)
+		{
+			if(lpThreads[i].Start(ValidateArchiveWorker, &Pool))
+			{
+				uiStarted++;
+			}
+		}
+	}
+
+	if(this->pOtherMD5Section != 0)
+	{
+		hlULongLong uiTreeOffset = sizeof(VPKHeader) + sizeof(VPKExtendedHeader);
+		hlULongLong uiArchiveMD5SectionOffset = uiTreeOffset + static_cast<hlULongLong>(this->pHeader->uiDirectoryLength) + static_cast<hlULongLong>(this->pExtendedHeader->uiFileDataSectionSize);
+
+		eValidation = CombineValidation(eValidation, this->ValidateMD5(*this->pMapping, uiTreeOffset, this->pHeader->uiDirectoryLength, this->pOtherMD5Section->lpTreeMD5));
+		eValidation = CombineValidation(eValidation, this->ValidateMD5(*this->pMapping, uiArchiveMD5SectionOffset, this->pExtendedHeader->uiArchiveMD5SectionSize, this->pOtherMD5Section->lpArchiveMD5SectionMD5));
+		// The whole file hash covers everything up to itself.
+		eValidation = CombineValidation(eValidation, this->ValidateMD5(*this->pMapping, 0, uiArchiveMD5SectionOffset + static_cast<hlULongLong>(this->pExtendedHeader->uiArchiveMD5SectionSize) + 32, this->pOtherMD5Section->lpWholeFileMD5));
+	}
+
+	if(uiStarted == 0)
+	{
+		// Couldn't start any workers, do the work here instead.
+		ValidateArchiveWorker(&Pool);
+	}
+
+	if(lpThreads != 0)
+	{
+		for(hlUInt i = 0; i < uiThreadCount; i++)
+		{
+			lpThreads[i].Join();
+		}
+
+		delete []lpThreads;
+	}
+
+	for(hlUInt i = 0; i < this->uiArchiveMD5EntryCount; i++)
+	{
+		eValidation = CombineValidation(eValidation, Pool.lpResults[i]);
+	}
+
+	delete []Pool.lpResults;
+
+	return hlTrue;
+}
+
+hlVoid CVPKFile::ValidateArchiveWorker(hlVoid *pUserData)
+{
+	VPKValidatePool &Pool = *static_cast<VPKValidatePool *>(pUserData);
+
+	CContext Context;
+	Context.CopyOptions(Pool.pPackage->GetContext());
+
+	CContextScope ContextScope(Context);
+
+	while(hlTrue)
+	{
+		hlUInt uiIndex;
+		{
+			Threading::CLock Lock(Pool.Mutex);
+
+			if(Pool.uiNext == Pool.pPackage->uiArchiveMD5EntryCount)
+			{
+				break;
+			}
+
+			uiIndex = Pool.uiNext++;
+		}
+
+		Pool.lpResults[uiIndex] = Pool.pPackage->ValidateArchiveMD5Entry(Pool.pPackage->lpArchiveMD5Entries[uiIndex]);
+	}
+}
+
+HLValidation CVPKFile::ValidateArchiveMD5Entry(const VPKArchiveMD5Entry &Entry) const
+{
+	if(Entry.uiArchiveIndex == HL_VPK_NO_ARCHIVE)
+	{
+		// A chunk of the data stored in the directory file.
+		if(static_cast<hlULongLong>(Entry.uiStartingOffset) + static_cast<hlULongLong>(Entry.uiCount) > this->pExtendedHeader->uiFileDataSectionSize)
+		{
+			return HL_VALIDATES_CORRUPT;
+		}
+
+		hlULongLong uiFileDataOffset = sizeof(VPKHeader) + sizeof(VPKExtendedHeader) + static_cast<hlULongLong>(this->pHeader->uiDirectoryLength);
+
+		return this->ValidateMD5(*this->pMapping, uiFileDataOffset + Entry.uiStartingOffset, Entry.uiCount, Entry.lpMD5);
+	}
+
+	Mapping::CMapping *pArchiveMapping = this->AcquireArchive(Entry.uiArchiveIndex);
+	if(pArchiveMapping == 0)
+	{
+		return HL_VALIDATES_INCOMPLETE;
+	}
+
+	HLValidation eValidation = this->ValidateMD5(*pArchiveMapping, Entry.uiStartingOffset, Entry.uiCount, Entry.lpMD5);
+
+	this->ReleaseArchive(Entry.uiArchiveIndex);
+
+	return eValidation;
+}
+
+HLValidation CVPKFile::ValidateMD5(Mapping::CMapping &Mapping, hlULongLong uiOffset, hlULongLong uiLength, const hlByte lpMD5[16]) const
+{
+	if(uiOffset + uiLength > Mapping.GetMappingSize())
+	{
+		return HL_VALIDATES_INCOMPLETE;
+	}
+
+	MD5Context Context;
+	MD5Initialize(Context);
+
+	while(uiLength > 0)
+	{
+		hlULongLong uiViewSize = uiLength > HL_VPK_MD5_VIEW_SIZE ? HL_VPK_MD5_VIEW_SIZE : uiLength;
+
+		Mapping::CView *pView = 0;
+		if(!Mapping.Map(pView, uiOffset, uiViewSize))
+		{
+			return HL_VALIDATES_ERROR;
+		}
+
+		MD5Update(Context, static_cast<const hlByte *>(pView->GetView()), static_cast<hlUInt>(uiViewSize));
+
+		Mapping.Unmap(pView);
+
+		uiOffset += uiViewSize;
+		uiLength -= uiViewSize;
+	}
+
+	hlByte lpDigest[16];
+	MD5Finalize(Context, lpDigest);
+
+	return memcmp(lpDigest, lpMD5, sizeof(lpDigest)) == 0 ? HL_VALIDATES_OK : HL_VALIDATES_CORRUPT;
+}
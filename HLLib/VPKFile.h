@@ -29,6 +29,14 @@ namespace HLLib
 			hlUInt uiDirectoryLength;
 		};
 
+		struct VPKExtendedHeader
+		{
+			hlUInt uiFileDataSectionSize;
+			hlUInt uiArchiveMD5SectionSize;
+			hlUInt uiOtherMD5SectionSize;	// Always 48.
+			hlUInt uiSignatureSectionSize;
+		};
+
 		struct VPKDirectoryEntry
 		{
 			hlUInt uiCRC;
@@ -39,28 +47,48 @@ namespace HLLib
 			hlUShort uiDummy0;			// Always 0xffff.
 		};
 
+		struct VPKArchiveMD5Entry
+		{
+			hlUInt uiArchiveIndex;
+			hlUInt uiStartingOffset;
+			hlUInt uiCount;
+			hlByte lpMD5[16];
+		};
+
+		struct VPKOtherMD5Section
+		{
+			hlByte lpTreeMD5[16];
+			hlByte lpArchiveMD5SectionMD5[16];
+			hlByte lpWholeFileMD5[16];
+		};
+
 		#pragma pack()
 
 		struct VPKArchive
 		{
 			Streams::IStream *pStream;
 			Mapping::CMapping *pMapping;
+			hlULongLong uiSize;
+			hlULongLong uiLastUsed;
+			hlUInt uiReferences;		// Open streams and validations.
+			hlBool bPinned;
+			hlBool bSizeKnown;
+			hlBool bMissing;
 		};
 
 		struct VPKDirectoryItem
 		{
-			VPKDirectoryItem(const hlChar *lpExtention, const hlChar *lpPath, const hlChar *lpName, const VPKDirectoryEntry *pDirectoryEntry, const hlVoid *lpPreloadData) : lpExtention(lpExtention), lpPath(lpPath), lpName(lpName), pDirectoryEntry(pDirectoryEntry), lpPreloadData(lpPreloadData)
-			{
-			}
-
 			const hlChar *lpExtention;
 			const hlChar *lpPath;
 			const hlChar *lpName;
 			const VPKDirectoryEntry *pDirectoryEntry;
 			const hlVoid *lpPreloadData;
+			CDirectoryFile *pFile;		// Set by CreateRoot().
+			hlUInt uiHash;
+			hlUInt uiNext;				// Next item in the same hash bucket.
 		};
 
-		typedef std::list<VPKDirectoryItem *> CDirectoryItemList;
+		struct VPKValidatePool;
 
 	private:
 		static const char *lpAttributeNames[];
@@ -70,9 +98,22 @@ namespace HLLib
 
 		hlUInt uiArchiveCount;
 		VPKArchive *lpArchives;
+		hlChar *lpArchivePrefix;
+		hlChar *lpArchiveExtension;
+		hlUInt uiArchiveHandleLimit;
+		mutable hlUInt uiOpenArchiveCount;
+		mutable hlULongLong uiArchiveClock;
+		mutable Threading::CMutex ArchiveMutex;
 
 		const VPKHeader *pHeader;
-		CDirectoryItemList *pDirectoryItems;
+		const VPKExtendedHeader *pExtendedHeader;
+		const VPKArchiveMD5Entry *lpArchiveMD5Entries;
+		hlUInt uiArchiveMD5EntryCount;
+		const VPKOtherMD5Section *pOtherMD5Section;
+		hlUInt uiDirectoryItemCount;
+		VPKDirectoryItem *lpDirectoryItems;
+		hlUInt uiDirectoryItemBucketCount;
+		hlUInt *lpDirectoryItemBuckets;
 
 	public:
 		CVPKFile();
@@ -82,6 +123,13 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		hlBool ValidateArchives(HLValidation &eValidation) const;
+
+		hlBool PinArchive(hlUInt uiArchiveIndex);
+		hlVoid UnpinArchive(hlUInt uiArchiveIndex);
+
+		CDirectoryFile *FindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -98,6 +146,7 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
@@ -106,6 +155,20 @@ namespace HLLib
 
 	private:
 		hlBool MapString(const hlChar *&lpViewData, const hlChar *lpViewDirectoryDataEnd, const hlChar *&lpString);
+		hlBool MapDirectoryItems(const hlChar *lpViewData, const hlChar *lpViewDirectoryDataEnd, const hlChar *lpViewDataEnd, VPKDirectoryItem *lpDirectoryItems, hlUInt &uiDirectoryItemCount);
+
+		static hlUInt HashDirectoryItem(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
+		Mapping::CMapping *AcquireArchive(hlUInt uiArchiveIndex) const;
+		hlVoid ReleaseArchive(hlUInt uiArchiveIndex) const;
+		hlBool GetArchiveSize(hlUInt uiArchiveIndex, hlULongLong &uiSize) const;
+		hlBool OpenArchive(hlUInt uiArchiveIndex) const;
+		hlVoid CloseArchive(hlUInt uiArchiveIndex) const;
+		hlVoid CloseArchives(hlUInt uiOpenCount) const;
+
+		static hlVoid ValidateArchiveWorker(hlVoid *pUserData);
+		HLValidation ValidateArchiveMD5Entry(const VPKArchiveMD5Entry &Entry) const;
+		HLValidation ValidateMD5(Mapping::CMapping &Mapping, hlULongLong uiOffset, hlULongLong uiLength, const hlByte lpMD5[16]) const;
 	};
 }
 
@@ -0,0 +1,1601 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "VPKWriter.h"
+#include "Context.h"
+#include "InputPool.h"
+#include "Package.h"
+#include "Streams.h"
+#include "Thread.h"
+#include "Utility.h"
+
+#include <algorithm>
+
+using namespace HLLib;
+
+#define HL_VPK_SIGNATURE 0x55aa1234
+#define HL_VPK_NO_ARCHIVE 0x7fff
+#define HL_VPK_MAX_PRELOAD_BYTES 0xffff
+
+// Archive data is covered by one MD5 per chunk of this size (version 2).
+#define HL_VPK_MD5_CHUNK_SIZE 0x00100000
+
+struct CVPKWriter::VPKWriterEntry : public InputPoolJob
+{
+	hlChar *lpStrings;
+	const hlChar *lpExtension;
+	const hlChar *lpPath;
+	const hlChar *lpName;
+	const CDirectoryItem *pItem;
+	Streams::IStream *pInput;
+	hlUInt uiSize;
+
+	// Updates: entries read from the existing directory, those whose data
+	// stays where it is in the archives and paths to remove.
+	hlBool bExisting;
+	hlBool bKept;
+	hlBool bRemoved;
+
+	VPKDirectoryEntry DirectoryEntry;
+	hlByte *lpPreloadData;
+
+	// Entries read in memory, possibly by a worker.
+	hlBool bBuffered;
+	hlByte *lpData;
+};
+
+static const hlChar *GetTreeString(const hlByte *&lpTree, const hlByte *lpTreeEnd)
+{
+	const hlByte *lpTerminator = static_cast<const hlByte *>(memchr(lpTree, '\0', static_cast<size_t>(lpTreeEnd - lpTree)));
+	if(lpTerminator == 0)
+	{
+		return 0;
+	}
+
+	const hlChar *lpString = reinterpret_cast<const hlChar *>(lpTree);
+	lpTree = lpTerminator + 1;
+
+	return lpString;
+}
+
+static hlVoid PutTreeData(hlByte *lpTree, hlUInt &uiLength, const hlVoid *lpData, hlUInt uiBytes)
+{
+	if(lpTree != 0)
+	{
+		memcpy(lpTree + uiLength, lpData, uiBytes);
+	}
+	uiLength += uiBytes;
+}
+
+//
+// CVPKWriter
+// Writes a VPK to lpFileName.  If it is named like a directory file
+// (pak01_dir.vpk) the file data goes to numbered archives beside it
+// (pak01_000.vpk, pak01_001.vpk, ...), otherwise it follows the tree in the
+// directory file.  Entries are queued with Add*() and written by Finish() in
+// extension, path and name order, the order of the tree.  Small entries are
+// read and checksummed on a pool of worker threads a bounded number ahead of
+// the entry being written; larger ones are streamed through the writing
+// thread.  The tree is written last, once every CRC is known.
+//
+// In update mode the entries are merged into the existing VPK instead: new
+// data is appended to the last archive, or to new ones, and only the
+// directory file is rewritten, so the unchanged entries keep their archive
+// and offset.  An optional compaction pass first copies the live data of
+// archives with space left by replaced and removed entries to new archives;
+// the old ones are only removed once the new directory is in place.
+//
+
+CVPKWriter::CVPKWriter(const hlChar *lpFileName) : lpFileName(0), uiVersion(2), uiArchiveSize(HL_VPK_WRITER_ARCHIVE_SIZE), uiPreloadSize(0), bUpdate(hlFalse), bCompact(hlFalse), pEntries(new CVPKWriterEntryVector()), bArchives(hlFalse), pDirectoryStream(0), pArchiveStream(0), uiArchiveIndex(0), uiArchiveOffset(0), bAppendArchive(hlFalse), pArchiveMD5Context(new MD5Context()), pArchiveMD5Entries(new CArchiveMD5EntryVector())
+{
+	this->lpFileName = new hlChar[strlen(lpFileName) + 1];
+	strcpy(this->lpFileName, lpFileName);
+
+	memset(&this->ArchiveMD5Entry, 0, sizeof(VPKArchiveMD5Entry));
+}
+
+CVPKWriter::~CVPKWriter()
+{
+	this->DeleteEntries();
+
+	delete this->pArchiveMD5Entries;
+	delete this->pArchiveMD5Context;
+	delete this->pEntries;
+
+	delete []this->lpFileName;
+}
+
+hlUInt CVPKWriter::GetVersion() const
+{
+	return this->uiVersion;
+}
+
+//
+// SetVersion()
+// Version 2 adds MD5s of the tree and of every megabyte of file data.
+//
+hlVoid CVPKWriter::SetVersion(hlUInt uiVersion)
+{
+	this->uiVersion = uiVersion < 2 ? 1 : 2;
+}
+
+hlULongLong CVPKWriter::GetArchiveSize() const
+{
+	return this->uiArchiveSize;
+}
+
+//
+// SetArchiveSize()
+// Sets the size at which a new archive is started; 0 fills one archive.  A
+// file larger than the size gets an archive of its own.
+//
+hlVoid CVPKWriter::SetArchiveSize(hlULongLong uiArchiveSize)
+{
+	this->uiArchiveSize = uiArchiveSize;
+}
+
+hlUInt CVPKWriter::GetPreloadSize() const
+{
+	return this->uiPreloadSize;
+}
+
+//
+// SetPreloadSize()
+// Files up to this size are stored whole in the directory as preload bytes,
+// so reading them doesn't touch the archives.  Only used when writing
+// archives.
+//
+hlVoid CVPKWriter::SetPreloadSize(hlUInt uiPreloadSize)
+{
+	this->uiPreloadSize = uiPreloadSize > HL_VPK_MAX_PRELOAD_BYTES ? HL_VPK_MAX_PRELOAD_BYTES : uiPreloadSize;
+}
+
+hlBool CVPKWriter::GetUpdate() const
+{
+	return this->bUpdate;
+}
+
+//
+// SetUpdate()
+// Merges the entries into the existing VPK at lpFileName rather than
+// replacing it.  Added files replace existing ones of the same path.  The
+// existing version is kept.
+//
+hlVoid CVPKWriter::SetUpdate(hlBool bUpdate)
+{
+	this->bUpdate = bUpdate;
+}
+
+hlBool CVPKWriter::GetCompact() const
+{
+	return this->bCompact;
+}
+
+//
+// SetCompact()
+// When updating, rewrites the archives left with data no entry refers to.
+// This moves the data after the first gap of each, so it costs a rewrite of
+// those archives.
+//
+hlVoid CVPKWriter::SetCompact(hlBool bCompact)
+{
+	this->bCompact = bCompact;
+}
+
+//
+// Add()
+// Queues pItem or, if it is a folder, everything below it.  Entry paths are
+// relative to pItem, so adding a package's root repacks it.
+//
+hlBool CVPKWriter::Add(const CDirectoryItem *pItem)
+{
+	if(pItem->GetType() == HL_ITEM_FOLDER)
+	{
+		const CDirectoryFolder *pFolder = static_cast<const CDirectoryFolder *>(pItem);
+
+		for(hlUInt i = 0; i < pFolder->GetCount(); i++)
+		{
+			if(!this->Add(0, pFolder->GetItem(i)))
+			{
+				return hlFalse;
+			}
+		}
+
+		return hlTrue;
+	}
+
+	return this->Add(0, pItem);
+}
+
+hlBool CVPKWriter::Add(const hlChar *lpPath, const CDirectoryItem *pItem)
+{
+	hlChar *lpItemPath;
+	if(lpPath == 0 || *lpPath == '\0')
+	{
+		lpItemPath = new hlChar[strlen(pItem->GetName()) + 1];
+		strcpy(lpItemPath, pItem->GetName());
+	}
+	else
+	{
+		lpItemPath = new hlChar[strlen(lpPath) + 1 + strlen(pItem->GetName()) + 1];
+		strcpy(lpItemPath, lpPath);
+		strcat(lpItemPath, "/");
+		strcat(lpItemPath, pItem->GetName());
+	}
+
+	hlBool bResult = hlTrue;
+	switch(pItem->GetType())
+	{
+		case HL_ITEM_FOLDER:
+		{
+			const CDirectoryFolder *pFolder = static_cast<const CDirectoryFolder *>(pItem);
+
+			for(hlUInt i = 0; bResult && i < pFolder->GetCount(); i++)
+			{
+				bResult = this->Add(lpItemPath, pFolder->GetItem(i));
+			}
+			break;
+		}
+		case HL_ITEM_FILE:
+		{
+			bResult = this->AddFile(lpItemPath, static_cast<const CDirectoryFile *>(pItem));
+			break;
+		}
+	}
+
+	delete []lpItemPath;
+
+	return bResult;
+}
+
+hlBool CVPKWriter::AddFile(const hlChar *lpPath, const CDirectoryFile *pFile)
+{
+	hlULongLong uiSize = 0;
+	if(!pFile->GetSizeEx(uiSize))
+	{
+		return hlFalse;
+	}
+
+	return this->AddEntry(lpPath, pFile, 0, uiSize);
+}
+
+//
+// AddFile()
+// Queues an opened stream, read from its current position to its end.  The
+// stream must stay open until Finish() returns.
+//
+hlBool CVPKWriter::AddFile(const hlChar *lpPath, Streams::IStream &Input)
+{
+	if(!Input.GetOpened())
+	{
+		LastError.SetErrorMessage("Stream not open.");
+		return hlFalse;
+	}
+
+	return this->AddEntry(lpPath, 0, &Input, Input.GetStreamSize() - Input.GetStreamPointer());
+}
+
+//
+// RemoveFile()
+// Removes lpPath from the VPK being updated.  Paths it doesn't have are
+// ignored.
+//
+hlBool CVPKWriter::RemoveFile(const hlChar *lpPath)
+{
+	this->NewEntry(lpPath)->bRemoved = hlTrue;
+
+	return hlTrue;
+}
+
+hlBool CVPKWriter::AddEntry(const hlChar *lpPath, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize)
+{
+	if(uiSize > 0xffffffff)
+	{
+		LastError.SetErrorMessageFormated("Error adding %s: the file is too large for a VPK.", lpPath);
+		return hlFalse;
+	}
+
+	VPKWriterEntry *pEntry = this->NewEntry(lpPath);
+
+	pEntry->pItem = pItem;
+	pEntry->pInput = pInput;
+	pEntry->uiSize = static_cast<hlUInt>(uiSize);
+	pEntry->bBuffered = uiSize <= HL_VPK_WRITER_BUFFER_SIZE;
+	pEntry->pDone = pEntry->bBuffered ? new Threading::CSemaphore(0) : 0;
+
+	return hlTrue;
+}
+
+//
+// NewEntry()
+// Splits lpPath into the extension, path and name the tree is keyed on.  Empty
+// components are stored as " ", as Valve's tools do.
+//
+CVPKWriter::VPKWriterEntry *CVPKWriter::NewEntry(const hlChar *lpPath)
+{
+	while(*lpPath == '/' || *lpPath == '\\')
+	{
+		lpPath++;
+	}
+
+	hlChar *lpStrings = new hlChar[strlen(lpPath) + 1];
+	strcpy(lpStrings, lpPath);
+	for(hlChar *lpSeparator = strchr(lpStrings, '\\'); lpSeparator != 0; lpSeparator = strchr(lpSeparator + 1, '\\'))
+	{
+		*lpSeparator = '/';
+	}
+
+	const hlChar *lpPathString = "";
+	hlChar *lpNameString = strrchr(lpStrings, '/');
+	if(lpNameString != 0)
+	{
+		*lpNameString++ = '\0';
+		lpPathString = lpStrings;
+	}
+	else
+	{
+		lpNameString = lpStrings;
+	}
+
+	const hlChar *lpExtensionString = "";
+	hlChar *lpDot = strrchr(lpNameString, '.');
+	if(lpDot != 0)
+	{
+		*lpDot = '\0';
+		lpExtensionString = lpDot + 1;
+	}
+
+	VPKWriterEntry *pEntry = this->NewEntry(*lpExtensionString != '\0' ? lpExtensionString : " ", *lpPathString != '\0' ? lpPathString : " ", *lpNameString != '\0' ? lpNameString : " ");
+
+	delete []lpStrings;
+
+	return pEntry;
+}
+
+CVPKWriter::VPKWriterEntry *CVPKWriter::NewEntry(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName)
+{
+	size_t uiExtensionLength = strlen(lpExtension) + 1;
+	size_t uiPathLength = strlen(lpPath) + 1;
+
+	hlChar *lpStrings = new hlChar[uiExtensionLength + uiPathLength + strlen(lpName) + 1];
+	strcpy(lpStrings, lpExtension);
+	strcpy(lpStrings + uiExtensionLength, lpPath);
+	strcpy(lpStrings + uiExtensionLength + uiPathLength, lpName);
+
+	VPKWriterEntry *pEntry = new VPKWriterEntry();
+
+	pEntry->lpStrings = lpStrings;
+	pEntry->lpExtension = lpStrings;
+	pEntry->lpPath = lpStrings + uiExtensionLength;
+	pEntry->lpName = lpStrings + uiExtensionLength + uiPathLength;
+	pEntry->pItem = 0;
+	pEntry->pInput = 0;
+	pEntry->uiSize = 0;
+	pEntry->bExisting = hlFalse;
+	pEntry->bKept = hlFalse;
+	pEntry->bRemoved = hlFalse;
+	memset(&pEntry->DirectoryEntry, 0, sizeof(VPKDirectoryEntry));
+	pEntry->DirectoryEntry.uiDummy0 = 0xffff;
+	pEntry->lpPreloadData = 0;
+	pEntry->bBuffered = hlFalse;
+	pEntry->bClaimed = hlFalse;
+	pEntry->bWorker = hlFalse;
+	pEntry->lpData = 0;
+	pEntry->bResult = hlFalse;
+	pEntry->pError = 0;
+	pEntry->pDone = 0;
+
+	this->pEntries->push_back(pEntry);
+
+	return pEntry;
+}
+
+hlVoid CVPKWriter::DeleteEntry(VPKWriterEntry *pEntry)
+{
+	delete []pEntry->lpStrings;
+	delete []pEntry->lpPreloadData;
+	delete []pEntry->lpData;
+	delete pEntry->pError;
+	delete pEntry->pDone;
+	delete pEntry;
+}
+
+hlVoid CVPKWriter::DeleteEntries()
+{
+	for(CVPKWriterEntryVector::iterator i = this->pEntries->begin(); i != this->pEntries->end(); ++i)
+	{
+		DeleteEntry(*i);
+	}
+
+	this->pEntries->clear();
+	this->pArchiveMD5Entries->clear();
+}
+
+hlBool CVPKWriter::CompareEntries(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond)
+{
+	hlInt iResult = strcmp(pFirst->lpExtension, pSecond->lpExtension);
+	if(iResult == 0)
+	{
+		iResult = strcmp(pFirst->lpPath, pSecond->lpPath);
+		if(iResult == 0)
+		{
+			iResult = strcmp(pFirst->lpName, pSecond->lpName);
+		}
+	}
+
+	return iResult < 0;
+}
+
+hlBool CVPKWriter::CompareEntryOffsets(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond)
+{
+	if(pFirst->DirectoryEntry.uiEntryOffset != pSecond->DirectoryEntry.uiEntryOffset)
+	{
+		return pFirst->DirectoryEntry.uiEntryOffset < pSecond->DirectoryEntry.uiEntryOffset;
+	}
+
+	return pFirst->DirectoryEntry.uiEntryLength < pSecond->DirectoryEntry.uiEntryLength;
+}
+
+//
+// GetTemporaryFileName()
+// Returns the name lpFileName is written under until it is complete.  The
+// caller deletes the name.
+//
+hlChar *CVPKWriter::GetTemporaryFileName(const hlChar *lpFileName)
+{
+	hlChar *lpTemporaryFileName = new hlChar[strlen(lpFileName) + 4 + 1];
+	strcpy(lpTemporaryFileName, lpFileName);
+	strcat(lpTemporaryFileName, ".tmp");
+
+	return lpTemporaryFileName;
+}
+
+//
+// CommitFile()
+// Moves lpTemporaryFileName over lpFileName.
+//
+hlBool CVPKWriter::CommitFile(const hlChar *lpTemporaryFileName, const hlChar *lpFileName)
+{
+#ifdef _WIN32
+	if(!MoveFileEx(lpTemporaryFileName, lpFileName, MOVEFILE_REPLACE_EXISTING))
+#else
+	if(rename(lpTemporaryFileName, lpFileName) != 0)
+#endif
+	{
+		LastError.SetSystemErrorMessageFormated("Error replacing %s.", lpFileName);
+		return hlFalse;
+	}
+
+	return hlTrue;
+}
+
+//
+// GetArchiveFileName()
+// Returns the name of archive uiArchiveIndex, or 0 if lpFileName isn't named
+// like a directory file.  The caller deletes the name.
+//
+hlChar *CVPKWriter::GetArchiveFileName(hlUInt uiArchiveIndex) const
+{
+	const hlChar *lpExtension = strrchr(this->lpFileName, '.');
+	if(lpExtension == 0 || lpExtension - this->lpFileName <= 3 || _strnicmp(lpExtension - 3, "dir", 3) != 0)
+	{
+		return 0;
+	}
+
+	hlUInt uiPrefixLength = static_cast<hlUInt>(lpExtension - this->lpFileName) - 3;
+
+	hlChar *lpArchiveFileName = new hlChar[uiPrefixLength + 5 + strlen(lpExtension) + 1];  // We need 5 digits to print a short.
+	strncpy(lpArchiveFileName, this->lpFileName, uiPrefixLength);
+	sprintf(lpArchiveFileName + uiPrefixLength, "%03u%s", uiArchiveIndex, lpExtension);
+
+	return lpArchiveFileName;
+}
+
+//
+// Finish()
+// Writes all queued entries followed by the tree.  Stops on the first
+// failure, leaving what was written so far.  When updating, the directory
+// is written to a temporary file that only replaces the existing one once
+// everything succeeded; nothing the existing one refers to is overwritten
+// before that, and archives it started are removed on failure.
+//
+hlBool CVPKWriter::Finish()
+{
+	CVPKWriterEntryVector &Entries = *this->pEntries;
+
+	hlChar *lpArchiveFileName = this->GetArchiveFileName(0);
+	this->bArchives = lpArchiveFileName != 0;
+	delete []lpArchiveFileName;
+
+	if(this->bUpdate && !this->ReadDirectory())
+	{
+		this->DeleteEntries();
+		return hlFalse;
+	}
+
+	// The archives in use before the update.
+	hlUInt uiArchiveCount = 0;
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+	{
+		const VPKWriterEntry &Entry = *Entries[i];
+
+		if(Entry.bKept && Entry.DirectoryEntry.uiArchiveIndex != HL_VPK_NO_ARCHIVE && Entry.DirectoryEntry.uiEntryLength != 0 && Entry.DirectoryEntry.uiArchiveIndex >= uiArchiveCount)
+		{
+			uiArchiveCount = Entry.DirectoryEntry.uiArchiveIndex + 1;
+		}
+	}
+
+	std::stable_sort(Entries.begin(), Entries.end(), CompareEntries);
+
+	if(!this->ResolveEntries())
+	{
+		this->DeleteEntries();
+		return hlFalse;
+	}
+
+	CInputPoolJobVector Jobs;
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+	{
+		VPKWriterEntry &Entry = *Entries[i];
+
+		if(Entry.bKept)
+		{
+			continue;
+		}
+
+		if(this->bArchives && Entry.uiSize <= this->uiPreloadSize)
+		{
+			Entry.DirectoryEntry.uiPreloadBytes = static_cast<hlUShort>(Entry.uiSize);
+		}
+
+		if(Entry.pDone != 0)
+		{
+			Jobs.push_back(&Entry);
+		}
+	}
+
+	hlChar *lpDirectoryFileName = this->bUpdate ? GetTemporaryFileName(this->lpFileName) : 0;
+
+	this->pDirectoryStream = new Streams::CFileStream(lpDirectoryFileName != 0 ? lpDirectoryFileName : this->lpFileName);
+	if(!this->pDirectoryStream->Open(HL_MODE_READ | HL_MODE_WRITE | HL_MODE_CREATE))
+	{
+		delete this->pDirectoryStream;
+		this->pDirectoryStream = 0;
+		delete []lpDirectoryFileName;
+		this->DeleteEntries();
+		return hlFalse;
+	}
+
+	// File data in the directory follows the tree, which is written last.
+	hlULongLong uiTreeOffset = sizeof(VPKHeader) + (this->uiVersion >= 2 ? sizeof(VPKExtendedHeader) : 0);
+	this->pDirectoryStream->Seek(static_cast<hlLongLong>(uiTreeOffset + this->GetTree(0)), HL_SEEK_BEGINNING);
+
+	this->pArchiveStream = this->bArchives ? 0 : this->pDirectoryStream;
+	this->uiArchiveIndex = this->bArchives ? 0 : HL_VPK_NO_ARCHIVE;
+	this->uiArchiveOffset = 0;
+	this->bAppendArchive = hlFalse;
+	this->ArchiveMD5Entry.uiCount = 0;
+
+	hlBool *lpCompacted = new hlBool[uiArchiveCount > 0 ? uiArchiveCount : 1];
+	memset(lpCompacted, 0, sizeof(hlBool) * uiArchiveCount);
+
+	hlBool bResult = hlTrue;
+	if(this->bUpdate && this->bArchives)
+	{
+		if(this->bCompact)
+		{
+			// Compacted data and new data go to new archives.
+			this->uiArchiveIndex = uiArchiveCount;
+			bResult = this->Compact(uiArchiveCount, lpCompacted);
+		}
+		else
+		{
+			this->BeginAppend(uiArchiveCount);
+		}
+	}
+
+	{
+		CInputPool Pool(Jobs, CVPKWriter::ReadProc, this);
+
+		for(hlUInt i = 0; bResult && i < static_cast<hlUInt>(Entries.size()); i++)
+		{
+			VPKWriterEntry &Entry = *Entries[i];
+
+			if(Entry.bKept)
+			{
+				continue;
+			}
+
+			// Entries moved out of an updated directory are already in memory and
+			// have nothing to wait for.
+			Pool.Wait(Entry);
+
+			bResult = this->WriteEntry(Entry);
+
+			delete []Entry.lpData;
+			Entry.lpData = 0;
+
+			Pool.Release(Entry);
+		}
+	}
+
+	this->EndArchiveMD5Entry();
+	this->CloseArchive();
+
+	if(bResult)
+	{
+		bResult = this->WriteTree();
+	}
+
+	this->pDirectoryStream->Close();
+	delete this->pDirectoryStream;
+	this->pDirectoryStream = 0;
+
+	// Put the new directory in place, in one step, and only then remove the
+	// archives it no longer refers to.  Until then the existing directory and
+	// its data are untouched.
+	if(lpDirectoryFileName != 0)
+	{
+		if(bResult)
+		{
+			bResult = CommitFile(lpDirectoryFileName, this->lpFileName);
+		}
+
+		if(bResult)
+		{
+			for(hlUInt i = 0; i < uiArchiveCount; i++)
+			{
+				if(lpCompacted[i])
+				{
+					lpArchiveFileName = this->GetArchiveFileName(i);
+					remove(lpArchiveFileName);
+					delete []lpArchiveFileName;
+				}
+			}
+		}
+		else
+		{
+			remove(lpDirectoryFileName);
+
+			for(hlUInt i = uiArchiveCount; this->bArchives && i <= this->uiArchiveIndex && i < HL_VPK_NO_ARCHIVE; i++)
+			{
+				lpArchiveFileName = this->GetArchiveFileName(i);
+				remove(lpArchiveFileName);
+				delete []lpArchiveFileName;
+			}
+		}
+	}
+
+	delete []lpCompacted;
+	delete []lpDirectoryFileName;
+
+	this->DeleteEntries();
+
+	return bResult;
+}
+
+//
+// ReadDirectory()
+// Queues the entries of the VPK being updated.  Entries with data in the
+// archives are kept as they are; those with data in the directory file are
+// read into memory, to be written again like added files.
+//
+hlBool CVPKWriter::ReadDirectory()
+{
+	Streams::CFileStream Stream(this->lpFileName);
+	if(!Stream.Open(HL_MODE_READ))
+	{
+		return hlFalse;
+	}
+
+	hlULongLong uiFileSize = Stream.GetStreamSize();
+	if(uiFileSize > 0xffffffff)
+	{
+		LastError.SetErrorMessageFormated("Error reading %s: the directory file is too large.", this->lpFileName);
+		return hlFalse;
+	}
+
+	hlUInt uiBufferSize = static_cast<hlUInt>(uiFileSize);
+	hlByte *lpBuffer = new hlByte[uiBufferSize > 0 ? uiBufferSize : 1];
+
+	hlUInt uiTotalBytes = 0;
+	while(uiTotalBytes < uiBufferSize)
+	{
+		hlUInt uiBytes = Stream.Read(lpBuffer + uiTotalBytes, uiBufferSize - uiTotalBytes);
+		if(uiBytes == 0)
+		{
+			break;
+		}
+		uiTotalBytes += uiBytes;
+	}
+
+	Stream.Close();
+
+	VPKHeader Header;
+	VPKExtendedHeader ExtendedHeader;
+	memset(&Header, 0, sizeof(VPKHeader));
+	memset(&ExtendedHeader, 0, sizeof(VPKExtendedHeader));
+
+	if(uiTotalBytes >= sizeof(VPKHeader))
+	{
+		memcpy(&Header, lpBuffer, sizeof(VPKHeader));
+	}
+
+	if(Header.uiSignature != HL_VPK_SIGNATURE || (Header.uiVersion != 1 && Header.uiVersion != 2))
+	{
+		LastError.SetErrorMessageFormated("Error reading %s: not a version 1 or 2 VPK.", this->lpFileName);
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	hlUInt uiHeaderSize = sizeof(VPKHeader) + (Header.uiVersion >= 2 ? sizeof(VPKExtendedHeader) : 0);
+	if(uiTotalBytes >= uiHeaderSize && Header.uiVersion >= 2)
+	{
+		memcpy(&ExtendedHeader, lpBuffer + sizeof(VPKHeader), sizeof(VPKExtendedHeader));
+	}
+
+	// Everything past the tree is file data for version 1.
+	hlUInt uiDataSize = 0;
+	if(uiTotalBytes >= uiHeaderSize && uiTotalBytes - uiHeaderSize >= Header.uiDirectoryLength)
+	{
+		uiDataSize = uiTotalBytes - uiHeaderSize - Header.uiDirectoryLength;
+	}
+	else
+	{
+		uiTotalBytes = 0;
+	}
+
+	if(Header.uiVersion >= 2 && ExtendedHeader.uiFileDataSectionSize <= uiDataSize && ExtendedHeader.uiArchiveMD5SectionSize <= uiDataSize - ExtendedHeader.uiFileDataSectionSize)
+	{
+		uiDataSize = ExtendedHeader.uiFileDataSectionSize;
+	}
+	else if(Header.uiVersion >= 2)
+	{
+		uiTotalBytes = 0;
+	}
+
+	if(uiTotalBytes == 0)
+	{
+		LastError.SetErrorMessageFormated("Error reading %s: the directory file is truncated.", this->lpFileName);
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	const hlByte *lpTree = lpBuffer + uiHeaderSize;
+	const hlByte *lpTreeEnd = lpTree + Header.uiDirectoryLength;
+	const hlByte *lpData = lpTreeEnd;
+
+	hlBool bResult = hlTrue;
+	while(bResult)
+	{
+		const hlChar *lpExtension = GetTreeString(lpTree, lpTreeEnd);
+		if(lpExtension == 0 || *lpExtension == '\0')
+		{
+			bResult = lpExtension != 0;
+			break;
+		}
+
+		while(bResult)
+		{
+			const hlChar *lpPath = GetTreeString(lpTree, lpTreeEnd);
+			if(lpPath == 0 || *lpPath == '\0')
+			{
+				bResult = lpPath != 0;
+				break;
+			}
+
+			while(bResult)
+			{
+				const hlChar *lpName = GetTreeString(lpTree, lpTreeEnd);
+				if(lpName == 0 || *lpName == '\0')
+				{
+					bResult = lpName != 0;
+					break;
+				}
+
+				VPKDirectoryEntry DirectoryEntry;
+				if(static_cast<hlUInt>(lpTreeEnd - lpTree) < sizeof(VPKDirectoryEntry))
+				{
+					bResult = hlFalse;
+					break;
+				}
+				memcpy(&DirectoryEntry, lpTree, sizeof(VPKDirectoryEntry));
+				lpTree += sizeof(VPKDirectoryEntry);
+
+				const hlByte *lpPreloadData = lpTree;
+				if(static_cast<hlUInt>(lpTreeEnd - lpTree) < DirectoryEntry.uiPreloadBytes)
+				{
+					bResult = hlFalse;
+					break;
+				}
+				lpTree += DirectoryEntry.uiPreloadBytes;
+
+				VPKWriterEntry *pEntry = this->NewEntry(lpExtension, lpPath, lpName);
+
+				pEntry->bExisting = hlTrue;
+				pEntry->uiSize = static_cast<hlUInt>(DirectoryEntry.uiPreloadBytes) + DirectoryEntry.uiEntryLength;
+
+				if(DirectoryEntry.uiArchiveIndex == HL_VPK_NO_ARCHIVE && DirectoryEntry.uiEntryLength != 0)
+				{
+					if(DirectoryEntry.uiEntryOffset > uiDataSize || DirectoryEntry.uiEntryLength > uiDataSize - DirectoryEntry.uiEntryOffset || pEntry->uiSize < DirectoryEntry.uiEntryLength)
+					{
+						bResult = hlFalse;
+						break;
+					}
+
+					pEntry->lpData = new hlByte[pEntry->uiSize];
+					memcpy(pEntry->lpData, lpPreloadData, DirectoryEntry.uiPreloadBytes);
+					memcpy(pEntry->lpData + DirectoryEntry.uiPreloadBytes, lpData + DirectoryEntry.uiEntryOffset, DirectoryEntry.uiEntryLength);
+
+					pEntry->DirectoryEntry.uiCRC = DirectoryEntry.uiCRC;
+					pEntry->bBuffered = hlTrue;
+					pEntry->bClaimed = hlTrue;
+					pEntry->bResult = hlTrue;
+				}
+				else
+				{
+					pEntry->DirectoryEntry = DirectoryEntry;
+					if(DirectoryEntry.uiPreloadBytes != 0)
+					{
+						pEntry->lpPreloadData = new hlByte[DirectoryEntry.uiPreloadBytes];
+						memcpy(pEntry->lpPreloadData, lpPreloadData, DirectoryEntry.uiPreloadBytes);
+					}
+					pEntry->bKept = hlTrue;
+				}
+			}
+		}
+	}
+
+	if(!bResult)
+	{
+		LastError.SetErrorMessageFormated("Error reading %s: the directory tree is corrupt.", this->lpFileName);
+	}
+	else
+	{
+		// The checksums of the directory's own file data are redone as it is
+		// written again.
+		const VPKArchiveMD5Entry *lpArchiveMD5Entries = reinterpret_cast<const VPKArchiveMD5Entry *>(lpData + ExtendedHeader.uiFileDataSectionSize);
+		for(hlUInt i = 0; i < ExtendedHeader.uiArchiveMD5SectionSize / sizeof(VPKArchiveMD5Entry); i++)
+		{
+			if(lpArchiveMD5Entries[i].uiArchiveIndex != HL_VPK_NO_ARCHIVE)
+			{
+				this->pArchiveMD5Entries->push_back(lpArchiveMD5Entries[i]);
+			}
+		}
+
+		this->uiVersion = Header.uiVersion;
+	}
+
+	delete []lpBuffer;
+
+	return bResult;
+}
+
+//
+// ResolveEntries()
+// Reduces each run of sorted entries with the same path to the one to write:
+// an added file, else the existing entry unless it is removed.  Fails on
+// paths added twice.
+//
+hlBool CVPKWriter::ResolveEntries()
+{
+	CVPKWriterEntryVector &Entries = *this->pEntries;
+
+	CVPKWriterEntryVector Resolved;
+	Resolved.reserve(Entries.size());
+
+	hlUInt uiDropped = 0;
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); )
+	{
+		VPKWriterEntry *pKeep = 0;
+		hlBool bRemoved = hlFalse;
+
+		hlUInt uiEnd = i + 1;
+		while(uiEnd < static_cast<hlUInt>(Entries.size()) && !CompareEntries(Entries[i], Entries[uiEnd]))
+		{
+			uiEnd++;
+		}
+
+		for(hlUInt j = i; j < uiEnd; j++)
+		{
+			VPKWriterEntry *pEntry = Entries[j];
+
+			if(pEntry->bRemoved)
+			{
+				bRemoved = hlTrue;
+			}
+			else if(!pEntry->bExisting)
+			{
+				if(pKeep != 0 && !pKeep->bExisting)
+				{
+					LastError.SetErrorMessageFormated("Duplicate entry %s/%s.%s.", pEntry->lpPath, pEntry->lpName, pEntry->lpExtension);
+					return hlFalse;
+				}
+				pKeep = pEntry;
+			}
+			else if(pKeep == 0)
+			{
+				pKeep = pEntry;
+			}
+		}
+
+		if(pKeep != 0 && pKeep->bExisting && bRemoved)
+		{
+			pKeep = 0;
+		}
+
+		if(pKeep != 0)
+		{
+			Resolved.push_back(pKeep);
+		}
+		uiDropped += uiEnd - i - (pKeep != 0 ? 1 : 0);
+
+		i = uiEnd;
+	}
+
+	if(uiDropped != 0)
+	{
+		for(hlUInt i = 0, j = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+		{
+			if(j < static_cast<hlUInt>(Resolved.size()) && Entries[i] == Resolved[j])
+			{
+				j++;
+			}
+			else
+			{
+				DeleteEntry(Entries[i]);
+			}
+		}
+
+		Entries.swap(Resolved);
+	}
+
+	return hlTrue;
+}
+
+//
+// BeginAppend()
+// Continues the last of uiArchiveCount archives if it has room, otherwise
+// starts a new one after it.
+//
+hlVoid CVPKWriter::BeginAppend(hlUInt uiArchiveCount)
+{
+	this->uiArchiveIndex = uiArchiveCount;
+
+	if(uiArchiveCount > 0)
+	{
+		hlChar *lpArchiveFileName = this->GetArchiveFileName(uiArchiveCount - 1);
+
+		hlULongLong uiSize = 0;
+		if(HLLib::GetFileSize(lpArchiveFileName, uiSize) && (this->uiArchiveSize == 0 || uiSize < this->uiArchiveSize) && uiSize < 0xffffffff)
+		{
+			this->uiArchiveIndex = uiArchiveCount - 1;
+			this->uiArchiveOffset = uiSize;
+			this->bAppendArchive = hlTrue;
+		}
+
+		delete []lpArchiveFileName;
+	}
+}
+
+//
+// Compact()
+// Copies the live data of each of the uiArchiveCount archives holding data
+// no entry refers to, in offset order, to the current archive and the ones
+// after it.  Entries sharing data keep sharing it.  Flags the archives
+// copied from in lpCompacted; they are left as they are.
+//
+hlBool CVPKWriter::Compact(hlUInt uiArchiveCount, hlBool *lpCompacted)
+{
+	CVPKWriterEntryVector &Entries = *this->pEntries;
+
+	hlByte *lpBuffer = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE];
+
+	hlBool bResult = hlTrue;
+	for(hlUInt i = 0; bResult && i < uiArchiveCount; i++)
+	{
+		CVPKWriterEntryVector Live;
+		for(hlUInt j = 0; j < static_cast<hlUInt>(Entries.size()); j++)
+		{
+			if(Entries[j]->bKept && Entries[j]->DirectoryEntry.uiArchiveIndex == i && Entries[j]->DirectoryEntry.uiEntryLength != 0)
+			{
+				Live.push_back(Entries[j]);
+			}
+		}
+
+		std::sort(Live.begin(), Live.end(), CompareEntryOffsets);
+
+		hlULongLong uiLiveSize = 0;
+		for(hlUInt j = 0; j < static_cast<hlUInt>(Live.size()); j++)
+		{
+			if(j == 0 || CompareEntryOffsets(Live[j - 1], Live[j]))
+			{
+				uiLiveSize += static_cast<hlULongLong>(Live[j]->DirectoryEntry.uiEntryLength);
+			}
+		}
+
+		hlChar *lpArchiveFileName = this->GetArchiveFileName(i);
+
+		hlULongLong uiSize = 0;
+		if(!HLLib::GetFileSize(lpArchiveFileName, uiSize) || uiSize <= uiLiveSize)
+		{
+			delete []lpArchiveFileName;
+			continue;
+		}
+
+		Streams::CFileStream Input(lpArchiveFileName);
+
+		delete []lpArchiveFileName;
+
+		if(!Input.Open(HL_MODE_READ))
+		{
+			bResult = hlFalse;
+			break;
+		}
+
+		lpCompacted[i] = hlTrue;
+
+		// The data's checksums are recomputed where it is copied to.
+		CArchiveMD5EntryVector &ArchiveMD5Entries = *this->pArchiveMD5Entries;
+		hlUInt uiArchiveMD5EntryCount = 0;
+		for(hlUInt j = 0; j < static_cast<hlUInt>(ArchiveMD5Entries.size()); j++)
+		{
+			if(ArchiveMD5Entries[j].uiArchiveIndex != i)
+			{
+				ArchiveMD5Entries[uiArchiveMD5EntryCount++] = ArchiveMD5Entries[j];
+			}
+		}
+		ArchiveMD5Entries.resize(uiArchiveMD5EntryCount);
+
+		hlUInt uiPreviousOffset = 0, uiPreviousLength = 0;
+		hlUShort uiPreviousNewIndex = 0;
+		hlUInt uiPreviousNewOffset = 0;
+		for(hlUInt j = 0; bResult && j < static_cast<hlUInt>(Live.size()); j++)
+		{
+			VPKDirectoryEntry &DirectoryEntry = Live[j]->DirectoryEntry;
+
+			if(j > 0 && DirectoryEntry.uiEntryOffset == uiPreviousOffset && DirectoryEntry.uiEntryLength == uiPreviousLength)
+			{
+				// Same data as the previous entry, which has already moved.
+				DirectoryEntry.uiArchiveIndex = uiPreviousNewIndex;
+				DirectoryEntry.uiEntryOffset = uiPreviousNewOffset;
+				continue;
+			}
+
+			uiPreviousOffset = DirectoryEntry.uiEntryOffset;
+			uiPreviousLength = DirectoryEntry.uiEntryLength;
+
+			if(Input.Seek(static_cast<hlLongLong>(DirectoryEntry.uiEntryOffset), HL_SEEK_BEGINNING) != DirectoryEntry.uiEntryOffset)
+			{
+				LastError.SetErrorMessage("Error reading VPK archive.");
+				bResult = hlFalse;
+				break;
+			}
+
+			if(!this->BeginArchiveData(DirectoryEntry, DirectoryEntry.uiEntryLength))
+			{
+				bResult = hlFalse;
+				break;
+			}
+
+			uiPreviousNewIndex = DirectoryEntry.uiArchiveIndex;
+			uiPreviousNewOffset = DirectoryEntry.uiEntryOffset;
+
+			hlUInt uiTotalBytes = 0;
+			while(bResult && uiTotalBytes < DirectoryEntry.uiEntryLength)
+			{
+				hlUInt uiBytes = HL_DEFAULT_COPY_BUFFER_SIZE;
+				if(uiBytes > DirectoryEntry.uiEntryLength - uiTotalBytes)
+				{
+					uiBytes = DirectoryEntry.uiEntryLength - uiTotalBytes;
+				}
+
+				uiBytes = Input.Read(lpBuffer, uiBytes);
+				if(uiBytes == 0)
+				{
+					LastError.SetErrorMessage("Unexpected end of VPK archive.");
+					bResult = hlFalse;
+					break;
+				}
+
+				bResult = this->WriteArchiveData(lpBuffer, uiBytes);
+				uiTotalBytes += uiBytes;
+			}
+		}
+
+		Input.Close();
+	}
+
+	delete []lpBuffer;
+
+	return bResult;
+}
+
+hlBool CVPKWriter::ReadProc(InputPoolJob &Job, const hlVoid *pUserData)
+{
+	return static_cast<const CVPKWriter *>(pUserData)->ReadEntry(static_cast<VPKWriterEntry &>(Job));
+}
+
+//
+// ReadEntry()
+// Reads a buffered entry into memory and checksums it.  Safe to call from
+// several threads for different entries.
+//
+hlBool CVPKWriter::ReadEntry(VPKWriterEntry &Entry) const
+{
+	Streams::IStream *pInput = CInputPool::OpenInput(Entry.pItem, Entry.pInput);
+	if(pInput == 0)
+	{
+		return hlFalse;
+	}
+
+	hlByte *lpBuffer = new hlByte[Entry.uiSize > 0 ? Entry.uiSize : 1];
+
+	hlUInt uiTotalBytes = 0;
+	while(uiTotalBytes < Entry.uiSize)
+	{
+		hlUInt uiBytes = pInput->Read(lpBuffer + uiTotalBytes, Entry.uiSize - uiTotalBytes);
+		if(uiBytes == 0)
+		{
+			break;
+		}
+		uiTotalBytes += uiBytes;
+	}
+
+	CInputPool::CloseInput(Entry.pItem, Entry.pInput, pInput);
+
+	if(uiTotalBytes != Entry.uiSize)
+	{
+		LastError.SetErrorMessage("Unexpected end of input stream.");
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	Entry.DirectoryEntry.uiCRC = static_cast<hlUInt>(CRC32(lpBuffer, Entry.uiSize));
+	Entry.lpData = lpBuffer;
+
+	return hlTrue;
+}
+
+//
+// WriteEntry()
+// Writes an entry's data to the current archive, or keeps it for the tree if
+// it is preloaded.  Buffered entries must already be read; other files are
+// checksummed here as they are written.
+//
+hlBool CVPKWriter::WriteEntry(VPKWriterEntry &Entry)
+{
+	if(Entry.pItem != 0)
+	{
+		hlExtractItemStart(Entry.pItem);
+	}
+
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Entry.uiSize;
+	hlBool bCancel = hlFalse;
+
+	hlBool bResult = hlFalse;
+	if(Entry.bBuffered)
+	{
+		if(!Entry.bResult)
+		{
+			LastError = *Entry.pError;
+		}
+		else
+		{
+			if(Entry.DirectoryEntry.uiPreloadBytes != 0 || (Entry.uiSize == 0 && this->bArchives))
+			{
+				// The data follows the entry in the tree.
+				Entry.DirectoryEntry.uiArchiveIndex = static_cast<hlUShort>(this->uiArchiveIndex);
+				Entry.lpPreloadData = Entry.lpData;
+				Entry.lpData = 0;
+				bResult = hlTrue;
+			}
+			else
+			{
+				bResult = this->BeginArchiveData(Entry.DirectoryEntry, Entry.uiSize) && this->WriteArchiveData(Entry.lpData, Entry.uiSize);
+			}
+
+			if(bResult && Entry.pItem != 0)
+			{
+				hlExtractFileProgress(Entry.pItem, 0, uiFileBytes, &bCancel);
+				hlExtractFileProgress(Entry.pItem, uiFileBytes, uiFileBytes, &bCancel);
+			}
+		}
+	}
+	else
+	{
+		Streams::IStream *pInput = CInputPool::OpenInput(Entry.pItem, Entry.pInput);
+
+		if(pInput != 0 && this->BeginArchiveData(Entry.DirectoryEntry, Entry.uiSize))
+		{
+			Streams::CReadAheadStream Input(*pInput);
+
+			if(Input.Open(HL_MODE_READ))
+			{
+				hlByte *lpBuffer = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE];
+
+				hlULong uiCRC = 0;
+
+				if(Entry.pItem != 0)
+				{
+					hlExtractFileProgress(Entry.pItem, uiTotalBytes, uiFileBytes, &bCancel);
+				}
+
+				bResult = hlTrue;
+				while(bResult && uiTotalBytes < uiFileBytes)
+				{
+					if(bCancel)
+					{
+						LastError.SetErrorMessage("Canceled by user.");
+						bResult = hlFalse;
+						break;
+					}
+
+					hlUInt uiBytes = HL_DEFAULT_COPY_BUFFER_SIZE;
+					if(static_cast<hlULongLong>(uiBytes) > uiFileBytes - uiTotalBytes)
+					{
+						uiBytes = static_cast<hlUInt>(uiFileBytes - uiTotalBytes);
+					}
+
+					uiBytes = Input.Read(lpBuffer, uiBytes);
+
+					if(uiBytes == 0)
+					{
+						LastError.SetErrorMessage("Unexpected end of input stream.");
+						bResult = hlFalse;
+						break;
+					}
+
+					// Checksum the data while it is still hot in the cache.
+					uiCRC = CRC32(lpBuffer, uiBytes, uiCRC);
+					uiTotalBytes += static_cast<hlULongLong>(uiBytes);
+
+					bResult = this->WriteArchiveData(lpBuffer, uiBytes);
+
+					if(Entry.pItem != 0)
+					{
+						hlExtractFileProgress(Entry.pItem, uiTotalBytes, uiFileBytes, &bCancel);
+					}
+				}
+
+				Entry.DirectoryEntry.uiCRC = static_cast<hlUInt>(uiCRC);
+
+				delete []lpBuffer;
+
+				Input.Close();
+			}
+		}
+
+		CInputPool::CloseInput(Entry.pItem, Entry.pInput, pInput);
+	}
+
+	if(bResult && bCancel)
+	{
+		LastError.SetErrorMessage("Canceled by user.");
+		bResult = hlFalse;
+	}
+
+	if(Entry.pItem != 0)
+	{
+		hlExtractItemEnd(Entry.pItem, bResult);
+	}
+
+	return bResult;
+}
+
+//
+// GetTree()
+// Writes the extension, path and name tree to lpTree, if not null, and
+// returns its length.  The entries must be sorted.
+//
+hlUInt CVPKWriter::GetTree(hlByte *lpTree) const
+{
+	const CVPKWriterEntryVector &Entries = *this->pEntries;
+
+	const hlByte lpTerminator[] = { 0 };
+
+	hlUInt uiLength = 0;
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+	{
+		const VPKWriterEntry &Entry = *Entries[i];
+
+		hlBool bNewExtension = i == 0 || strcmp(Entries[i - 1]->lpExtension, Entry.lpExtension) != 0;
+		hlBool bNewPath = bNewExtension || strcmp(Entries[i - 1]->lpPath, Entry.lpPath) != 0;
+
+		if(i > 0 && bNewPath)
+		{
+			// End the previous path's names and, if need be, its extension's paths.
+			PutTreeData(lpTree, uiLength, lpTerminator, 1);
+			if(bNewExtension)
+			{
+				PutTreeData(lpTree, uiLength, lpTerminator, 1);
+			}
+		}
+
+		if(bNewExtension)
+		{
+			PutTreeData(lpTree, uiLength, Entry.lpExtension, static_cast<hlUInt>(strlen(Entry.lpExtension)) + 1);
+		}
+		if(bNewPath)
+		{
+			PutTreeData(lpTree, uiLength, Entry.lpPath, static_cast<hlUInt>(strlen(Entry.lpPath)) + 1);
+		}
+		PutTreeData(lpTree, uiLength, Entry.lpName, static_cast<hlUInt>(strlen(Entry.lpName)) + 1);
+
+		PutTreeData(lpTree, uiLength, &Entry.DirectoryEntry, sizeof(VPKDirectoryEntry));
+		PutTreeData(lpTree, uiLength, Entry.lpPreloadData, Entry.DirectoryEntry.uiPreloadBytes);
+	}
+
+	if(!Entries.empty())
+	{
+		PutTreeData(lpTree, uiLength, lpTerminator, 1);
+		PutTreeData(lpTree, uiLength, lpTerminator, 1);
+	}
+	PutTreeData(lpTree, uiLength, lpTerminator, 1);
+
+	return uiLength;
+}
+
+//
+// WriteTree()
+// Writes the header and tree ahead of the file data in the directory and,
+// for version 2, the MD5 sections after it.
+//
+hlBool CVPKWriter::WriteTree()
+{
+	const CArchiveMD5EntryVector &ArchiveMD5Entries = *this->pArchiveMD5Entries;
+
+	hlUInt uiTreeLength = this->GetTree(0);
+	hlByte *lpTree = new hlByte[uiTreeLength];
+	this->GetTree(lpTree);
+
+	VPKHeader Header;
+	Header.uiSignature = HL_VPK_SIGNATURE;
+	Header.uiVersion = this->uiVersion;
+	Header.uiDirectoryLength = uiTreeLength;
+
+	VPKExtendedHeader ExtendedHeader;
+	ExtendedHeader.uiFileDataSectionSize = this->bArchives ? 0 : static_cast<hlUInt>(this->uiArchiveOffset);
+	ExtendedHeader.uiArchiveMD5SectionSize = static_cast<hlUInt>(ArchiveMD5Entries.size() * sizeof(VPKArchiveMD5Entry));
+	ExtendedHeader.uiOtherMD5SectionSize = sizeof(VPKOtherMD5Section);
+	ExtendedHeader.uiSignatureSectionSize = 0;
+
+	const hlByte *lpArchiveMD5Section = ArchiveMD5Entries.empty() ? 0 : reinterpret_cast<const hlByte *>(&ArchiveMD5Entries[0]);
+
+	hlBool bResult = this->pDirectoryStream->Seek(0, HL_SEEK_BEGINNING) == 0 && WriteData(*this->pDirectoryStream, &Header, sizeof(Header));
+	if(bResult && this->uiVersion >= 2)
+	{
+		bResult = WriteData(*this->pDirectoryStream, &ExtendedHeader, sizeof(ExtendedHeader));
+	}
+	if(bResult)
+	{
+		bResult = WriteData(*this->pDirectoryStream, lpTree, uiTreeLength);
+	}
+
+	if(bResult && this->uiVersion >= 2)
+	{
+		VPKOtherMD5Section OtherMD5Section;
+
+		MD5Context Context;
+		MD5Initialize(Context);
+		MD5Update(Context, lpTree, uiTreeLength);
+		MD5Finalize(Context, OtherMD5Section.lpTreeMD5);
+
+		MD5Initialize(Context);
+		MD5Update(Context, lpArchiveMD5Section, ExtendedHeader.uiArchiveMD5SectionSize);
+		MD5Finalize(Context, OtherMD5Section.lpArchiveMD5SectionMD5);
+
+		// The whole file MD5 covers everything before it, including the file
+		// data, which is read back.
+		MD5Initialize(Context);
+		MD5Update(Context, reinterpret_cast<const hlByte *>(&Header), sizeof(Header));
+		MD5Update(Context, reinterpret_cast<const hlByte *>(&ExtendedHeader), sizeof(ExtendedHeader));
+		MD5Update(Context, lpTree, uiTreeLength);
+
+		if(ExtendedHeader.uiFileDataSectionSize != 0)
+		{
+			hlByte *lpBuffer = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE];
+
+			hlUInt uiTotalBytes = 0;
+			while(bResult && uiTotalBytes < ExtendedHeader.uiFileDataSectionSize)
+			{
+				hlUInt uiBytes = HL_DEFAULT_COPY_BUFFER_SIZE;
+				if(uiBytes > ExtendedHeader.uiFileDataSectionSize - uiTotalBytes)
+				{
+					uiBytes = ExtendedHeader.uiFileDataSectionSize - uiTotalBytes;
+				}
+
+				uiBytes = this->pDirectoryStream->Read(lpBuffer, uiBytes);
+				if(uiBytes == 0)
+				{
+					LastError.SetErrorMessage("Error reading back VPK file data.");
+					bResult = hlFalse;
+					break;
+				}
+
+				MD5Update(Context, lpBuffer, uiBytes);
+				uiTotalBytes += uiBytes;
+			}
+
+			delete []lpBuffer;
+		}
+
+		MD5Update(Context, lpArchiveMD5Section, ExtendedHeader.uiArchiveMD5SectionSize);
+		MD5Update(Context, OtherMD5Section.lpTreeMD5, sizeof(OtherMD5Section.lpTreeMD5));
+		MD5Update(Context, OtherMD5Section.lpArchiveMD5SectionMD5, sizeof(OtherMD5Section.lpArchiveMD5SectionMD5));
+		MD5Finalize(Context, OtherMD5Section.lpWholeFileMD5);
+
+		if(bResult)
+		{
+			hlULongLong uiArchiveMD5SectionOffset = sizeof(Header) + sizeof(ExtendedHeader) + static_cast<hlULongLong>(uiTreeLength) + static_cast<hlULongLong>(ExtendedHeader.uiFileDataSectionSize);
+
+			bResult = this->pDirectoryStream->Seek(static_cast<hlLongLong>(uiArchiveMD5SectionOffset), HL_SEEK_BEGINNING) == uiArchiveMD5SectionOffset && WriteData(*this->pDirectoryStream, lpArchiveMD5Section, ExtendedHeader.uiArchiveMD5SectionSize) && WriteData(*this->pDirectoryStream, &OtherMD5Section, sizeof(OtherMD5Section));
+		}
+	}
+
+	delete []lpTree;
+
+	return bResult;
+}
+
+//
+// BeginArchiveData()
+// Points DirectoryEntry at where uiSize bytes of data will be written next,
+// starting a new archive if the current one would grow past the archive
+// size.
+//
+hlBool CVPKWriter::BeginArchiveData(VPKDirectoryEntry &DirectoryEntry, hlUInt uiSize)
+{
+	if(this->bArchives)
+	{
+		if(this->uiArchiveSize != 0 && this->uiArchiveOffset > 0 && this->uiArchiveOffset + static_cast<hlULongLong>(uiSize) > this->uiArchiveSize)
+		{
+			this->EndArchiveMD5Entry();
+			this->CloseArchive();
+
+			this->uiArchiveIndex++;
+			this->uiArchiveOffset = 0;
+			this->bAppendArchive = hlFalse;
+		}
+
+		if(this->pArchiveStream == 0)
+		{
+			if(this->uiArchiveIndex >= HL_VPK_NO_ARCHIVE)
+			{
+				LastError.SetErrorMessage("Too many VPK archives.");
+				return hlFalse;
+			}
+
+			hlChar *lpArchiveFileName = this->GetArchiveFileName(this->uiArchiveIndex);
+
+			this->pArchiveStream = new Streams::CFileStream(lpArchiveFileName);
+
+			delete []lpArchiveFileName;
+
+			// An archive being appended to is written after its existing data.
+			if(!this->pArchiveStream->Open(this->bAppendArchive ? HL_MODE_WRITE : HL_MODE_WRITE | HL_MODE_CREATE))
+			{
+				delete this->pArchiveStream;
+				this->pArchiveStream = 0;
+				return hlFalse;
+			}
+
+			if(this->bAppendArchive && this->pArchiveStream->Seek(0, HL_SEEK_END) != this->uiArchiveOffset)
+			{
+				LastError.SetErrorMessage("Error seeking to the end of VPK archive.");
+				this->CloseArchive();
+				return hlFalse;
+			}
+		}
+	}
+
+	if(this->uiArchiveOffset + static_cast<hlULongLong>(uiSize) > 0xffffffff)
+	{
+		LastError.SetErrorMessage("VPK file data exceeds 4 GB, use archives or a smaller archive size.");
+		return hlFalse;
+	}
+
+	DirectoryEntry.uiArchiveIndex = static_cast<hlUShort>(this->uiArchiveIndex);
+	DirectoryEntry.uiEntryOffset = static_cast<hlUInt>(this->uiArchiveOffset);
+	DirectoryEntry.uiEntryLength = uiSize;
+
+	return hlTrue;
+}
+
+//
+// WriteArchiveData()
+// Appends file data to the current archive, hashing each megabyte of it for
+// version 2.
+//
+hlBool CVPKWriter::WriteArchiveData(const hlVoid *lpData, hlUInt uiBytes)
+{
+	const hlByte *lpBytes = static_cast<const hlByte *>(lpData);
+
+	while(uiBytes > 0)
+	{
+		hlUInt uiChunkBytes = HL_VPK_MD5_CHUNK_SIZE - static_cast<hlUInt>(this->uiArchiveOffset % HL_VPK_MD5_CHUNK_SIZE);
+		if(uiChunkBytes > uiBytes)
+		{
+			uiChunkBytes = uiBytes;
+		}
+
+		if(!WriteData(*this->pArchiveStream, lpBytes, uiChunkBytes))
+		{
+			return hlFalse;
+		}
+
+		if(this->uiVersion >= 2)
+		{
+			if(this->ArchiveMD5Entry.uiCount == 0)
+			{
+				MD5Initialize(*this->pArchiveMD5Context);
+				this->ArchiveMD5Entry.uiArchiveIndex = this->uiArchiveIndex;
+				this->ArchiveMD5Entry.uiStartingOffset = static_cast<hlUInt>(this->uiArchiveOffset);
+			}
+
+			MD5Update(*this->pArchiveMD5Context, lpBytes, uiChunkBytes);
+			this->ArchiveMD5Entry.uiCount += uiChunkBytes;
+		}
+
+		lpBytes += uiChunkBytes;
+		uiBytes -= uiChunkBytes;
+		this->uiArchiveOffset += static_cast<hlULongLong>(uiChunkBytes);
+
+		if(this->uiArchiveOffset % HL_VPK_MD5_CHUNK_SIZE == 0)
+		{
+			this->EndArchiveMD5Entry();
+		}
+	}
+
+	return hlTrue;
+}
+
+hlVoid CVPKWriter::EndArchiveMD5Entry()
+{
+	if(this->ArchiveMD5Entry.uiCount != 0)
+	{
+		MD5Finalize(*this->pArchiveMD5Context, this->ArchiveMD5Entry.lpMD5);
+		this->pArchiveMD5Entries->push_back(this->ArchiveMD5Entry);
+
+		this->ArchiveMD5Entry.uiCount = 0;
+	}
+}
+
+hlVoid CVPKWriter::CloseArchive()
+{
+	if(this->pArchiveStream != 0 && this->pArchiveStream != this->pDirectoryStream)
+	{
+		this->pArchiveStream->Close();
+		delete this->pArchiveStream;
+	}
+	this->pArchiveStream = 0;
+}
+
+hlBool CVPKWriter::WriteData(Streams::IStream &Stream, const hlVoid *lpData, hlUInt uiBytes)
+{
+	const hlByte *lpBytes = static_cast<const hlByte *>(lpData);
+
+	while(uiBytes > 0)
+	{
+		hlUInt uiBytesWritten = Stream.Write(lpBytes, uiBytes);
+		if(uiBytesWritten == 0)
+		{
+			LastError.SetErrorMessage("Error writing VPK file.");
+			return hlFalse;
+		}
+
+		lpBytes += uiBytesWritten;
+		uiBytes -= uiBytesWritten;
+	}
+
+	return hlTrue;
+}
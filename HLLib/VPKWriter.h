@@ -0,0 +1,165 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef VPKWRITER_H
+#define VPKWRITER_H
+
+#include "stdafx.h"
+#include "DirectoryItems.h"
+#include "Checksum.h"
+#include "Stream.h"
+
+// Archives are started anew before they would grow past this size.
+#define HL_VPK_WRITER_ARCHIVE_SIZE 209715200
+
+// Entries up to this size are read and checksummed in memory by worker
+// threads; larger ones are streamed by the writing thread.
+#define HL_VPK_WRITER_BUFFER_SIZE 16777216
+
+namespace HLLib
+{
+	struct InputPoolJob;
+
+	class HLLIB_API CVPKWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct VPKHeader
+		{
+			hlUInt uiSignature;
+			hlUInt uiVersion;
+			hlUInt uiDirectoryLength;
+		};
+
+		struct VPKExtendedHeader
+		{
+			hlUInt uiFileDataSectionSize;
+			hlUInt uiArchiveMD5SectionSize;
+			hlUInt uiOtherMD5SectionSize;
+			hlUInt uiSignatureSectionSize;
+		};
+
+		struct VPKDirectoryEntry
+		{
+			hlUInt uiCRC;
+			hlUShort uiPreloadBytes;
+			hlUShort uiArchiveIndex;
+			hlUInt uiEntryOffset;
+			hlUInt uiEntryLength;
+			hlUShort uiDummy0;
+		};
+
+		struct VPKArchiveMD5Entry
+		{
+			hlUInt uiArchiveIndex;
+			hlUInt uiStartingOffset;
+			hlUInt uiCount;
+			hlByte lpMD5[16];
+		};
+
+		struct VPKOtherMD5Section
+		{
+			hlByte lpTreeMD5[16];
+			hlByte lpArchiveMD5SectionMD5[16];
+			hlByte lpWholeFileMD5[16];
+		};
+
+		#pragma pack()
+
+		struct VPKWriterEntry;
+
+		typedef std::vector<VPKWriterEntry *> CVPKWriterEntryVector;
+		typedef std::vector<VPKArchiveMD5Entry> CArchiveMD5EntryVector;
+
+	private:
+		hlChar *lpFileName;
+
+		hlUInt uiVersion;
+		hlULongLong uiArchiveSize;
+		hlUInt uiPreloadSize;
+		hlBool bUpdate;
+		hlBool bCompact;
+
+		CVPKWriterEntryVector *pEntries;
+
+		hlBool bArchives;
+		Streams::IStream *pDirectoryStream;
+		Streams::IStream *pArchiveStream;
+		hlUInt uiArchiveIndex;
+		hlULongLong uiArchiveOffset;
+		hlBool bAppendArchive;
+
+		MD5Context *pArchiveMD5Context;
+		VPKArchiveMD5Entry ArchiveMD5Entry;
+		CArchiveMD5EntryVector *pArchiveMD5Entries;
+
+	public:
+		CVPKWriter(const hlChar *lpFileName);
+		~CVPKWriter();
+
+		hlUInt GetVersion() const;
+		hlVoid SetVersion(hlUInt uiVersion);
+
+		hlULongLong GetArchiveSize() const;
+		hlVoid SetArchiveSize(hlULongLong uiArchiveSize);
+
+		hlUInt GetPreloadSize() const;
+		hlVoid SetPreloadSize(hlUInt uiPreloadSize);
+
+		hlBool GetUpdate() const;
+		hlVoid SetUpdate(hlBool bUpdate);
+
+		hlBool GetCompact() const;
+		hlVoid SetCompact(hlBool bCompact);
+
+		hlBool Add(const CDirectoryItem *pItem);
+		hlBool AddFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool AddFile(const hlChar *lpPath, Streams::IStream &Input);
+		hlBool RemoveFile(const hlChar *lpPath);
+
+		hlBool Finish();
+
+	private:
+		hlBool Add(const hlChar *lpPath, const CDirectoryItem *pItem);
+		hlBool AddEntry(const hlChar *lpPath, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize);
+		VPKWriterEntry *NewEntry(const hlChar *lpPath);
+		VPKWriterEntry *NewEntry(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+		static hlVoid DeleteEntry(VPKWriterEntry *pEntry);
+		hlVoid DeleteEntries();
+
+		hlBool ReadDirectory();
+		hlBool ResolveEntries();
+		hlVoid BeginAppend(hlUInt uiArchiveCount);
+		hlBool Compact(hlUInt uiArchiveCount, hlBool *lpCompacted);
+		static hlChar *GetTemporaryFileName(const hlChar *lpFileName);
+		static hlBool CommitFile(const hlChar *lpTemporaryFileName, const hlChar *lpFileName);
+
+		static hlBool CompareEntries(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond);
+		static hlBool CompareEntryOffsets(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond);
+		hlChar *GetArchiveFileName(hlUInt uiArchiveIndex) const;
+
+		static hlBool ReadProc(InputPoolJob &Job, const hlVoid *pUserData);
+		hlBool ReadEntry(VPKWriterEntry &Entry) const;
+		hlBool WriteEntry(VPKWriterEntry &Entry);
+		hlBool WriteTree();
+
+		hlUInt GetTree(hlByte *lpTree) const;
+
+		hlBool BeginArchiveData(VPKDirectoryEntry &DirectoryEntry, hlUInt uiSize);
+		hlBool WriteArchiveData(const hlVoid *lpData, hlUInt uiBytes);
+		hlVoid EndArchiveMD5Entry();
+		hlVoid CloseArchive();
+		static hlBool WriteData(Streams::IStream &Stream, const hlVoid *lpData, hlUInt uiBytes);
+	};
+}
+
+#endif
@@ -11,14 +11,21 @@
 
 #include "HLLib.h"
 #include "WADFile.h"
+#include "Bitmap.h"
+#include "Mappings.h"
 #include "Streams.h"
 
+#include <new>
+
 using namespace HLLib;
 
+#define HL_WAD_COMPRESSION_NONE		0
+#define HL_WAD_COMPRESSION_LZSS		1
+
 const char *CWADFile::lpAttributeNames[] = { "Version" };
 const char *CWADFile::lpItemAttributeNames[] = { "Width", "Height", "Palette Entries", "Mipmaps", "Compressed", "Type" };
 
-CWADFile::CWADFile() : CPackage(), pHeaderView(0), pLumpView(0), pHeader(0), lpLumps(0), lpLumpInfo(0)
+CWADFile::CWADFile() : CPackage(), pHeaderView(0), pLumpView(0), pHeader(0), lpLumps(0), lpLumpInfo(0), pStreamCache(0)
 {
 
 }
@@ -72,11 +79,19 @@ hlBool CWADFile::MapDataStructures()
 	this->lpLumpInfo = new WADLumpInfo[this->pHeader->uiLumpCount];
 	memset(this->lpLumpInfo, 0, sizeof(WADLumpInfo) * this->pHeader->uiLumpCount);
 
+	if(this->GetContext().uiStreamCacheSize != 0)
+	{
+		this->pStreamCache = new CBufferCache(this->GetContext().uiStreamCacheSize);
+	}
+
 	return hlTrue;
 }
 
 hlVoid CWADFile::UnmapDataStructures()
 {
+	delete this->pStreamCache;
+	this->pStreamCache = 0;
+
 	delete []this->lpLumpInfo;
 
 	this->lpLumps = 0;
@@ -212,7 +227,7 @@ hlBool CWADFile::GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool
 {
 	const WADLump *pLump = this->lpLumps + pFile->GetID();
 
-	bExtractable = (pLump->iType == 0x42 || pLump->iType == 0x43) && pLump->iCompression == 0;
+	bExtractable = (pLump->iType == 0x42 || pLump->iType == 0x43) && this->GetCompressionSupported(pLump->iCompression);
 
 	return hlTrue;
 }
@@ -225,7 +240,7 @@ hlBool CWADFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize
 		return hlFalse;
 	}
 
-	uiSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
+	uiSize = GetBitmapSize(uiWidth, uiHeight, uiPaletteSize);
 
 	return hlTrue;
 }
@@ -281,7 +296,7 @@ hlBool CWADFile::GetImageData(const CDirectoryFile *pFile, hlUInt &uiWidth, hlUI
 	memcpy(lpPaletteData, lpPalette, uiPaletteSize * 3);
 	memcpy(lpPixelData, lpPixels, uiWidth * uiHeight);
 
-	this->pMapping->Unmap(pView);
+	this->UnmapLump(pView);
 
 	return hlTrue;
 }
@@ -326,109 +341,241 @@ hlBool CWADFile::GetImageData(const CDirectoryFile *pFile, hlUInt &uiWidth, hlUI
 		return hlFalse;
 	}
 
-	for(hlUInt i = 0; i < uiWidth; i++)
+	ExpandPalette(lpPalette, uiPaletteSize, lpPixels, uiWidth * uiHeight, lpPixelData);
+
+	this->UnmapLump(pView);
+
+	return hlTrue;
+}
+
+//
+// GetImageMipmapsSize()
+// Returns the number of mipmaps of pFile and the size of all of them as RGB
+// pixels, for GetImageMipmaps().
+//
+hlBool CWADFile::GetImageMipmapsSize(const CDirectoryFile *pFile, hlUInt &uiImageCount, hlUInt &uiPixelDataSize)
+{
+	uiImageCount = uiPixelDataSize = 0;
+
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
 	{
-		for(hlUInt j = 0; j < uiHeight; j++)
-		{
-			hlUInt uiPixelIndex = i + j * uiWidth;
-			hlUInt uiPaletteIndex = (hlUInt)lpPixels[uiPixelIndex] * 3;
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
 
-			uiPixelIndex *= 3;
-			lpPixelData[uiPixelIndex + 0] = lpPalette[uiPaletteIndex + 0];
-			lpPixelData[uiPixelIndex + 1] = lpPalette[uiPaletteIndex + 1];
-			lpPixelData[uiPixelIndex + 2] = lpPalette[uiPaletteIndex + 2];
-		}
+	hlULongLong uiSize = 0;
+	if(!this->GetLumpImagesSize(*pFile, uiImageCount, uiSize))
+	{
+		return hlFalse;
 	}
 
-	this->pMapping->Unmap(pView);
+	if(uiSize > 0xffffffff)
+	{
+		LastError.SetErrorMessage("Image data exceeds 4 GB.");
+		return hlFalse;
+	}
+
+	uiPixelDataSize = static_cast<hlUInt>(uiSize);
 
 	return hlTrue;
 }
 
-hlBool CWADFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
+//
+// GetImageMipmaps()
+// Decodes every mipmap of pFile to RGB pixels in lpPixelData, mapping the
+// lump once.  lpImages gets the size and offset of each.
+//
+hlBool CWADFile::GetImageMipmaps(const CDirectoryFile *pFile, HLWADImage *lpImages, hlByte *lpPixelData)
 {
-	hlUInt uiWidth, uiHeight, uiPaletteSize;
-	const hlByte *lpPalette, *lpPixels;
-	Mapping::CView *pView = 0;
-
-	if(!const_cast<CWADFile *>(this)->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, pView))
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
 	{
+		LastError.SetErrorMessage("File does not belong to package.");
 		return hlFalse;
 	}
 
-	hlUInt uiBufferSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
-	hlByte *lpBuffer = new hlByte[uiBufferSize];
+	hlUInt uiOffset = 0;
+	return this->GetLumpImages(*pFile, lpImages, lpPixelData, uiOffset);
+}
 
-	//
-	// Allocate data.
-	//
+//
+// GetImagesSize()
+// Returns the number of mipmaps of all images in the package and the size of
+// all of them as RGB pixels, for GetImages().
+//
+hlBool CWADFile::GetImagesSize(hlUInt &uiImageCount, hlUInt &uiPixelDataSize)
+{
+	uiImageCount = uiPixelDataSize = 0;
 
-	BITMAPFILEHEADER *pFileHeader = (BITMAPFILEHEADER *)lpBuffer;
-	BITMAPINFOHEADER *pInfoHeader = (BITMAPINFOHEADER *)((hlByte *)pFileHeader + sizeof(BITMAPFILEHEADER));
-	hlByte *lpPaletteData = (hlByte *)pInfoHeader + sizeof(BITMAPINFOHEADER);
-	hlByte *lpPixelData = lpPaletteData + uiPaletteSize * 4;
+	if(!this->GetOpened())
+	{
+		LastError.SetErrorMessage("Package not opened.");
+		return hlFalse;
+	}
 
-	memset(pFileHeader, 0, sizeof(BITMAPFILEHEADER));
-	memset(pInfoHeader, 0, sizeof(BITMAPINFOHEADER));
+	const CDirectoryFolder *pRoot = this->GetRoot();
 
-	//
-	// Fill in headers.
-	//
+	hlULongLong uiSize = 0;
+	for(hlUInt i = 0; i < pRoot->GetCount(); i++)
+	{
+		const CDirectoryFile *pFile = static_cast<const CDirectoryFile *>(pRoot->GetItem(i));
 
-	pFileHeader->bfType = ('M' << 8) | 'B';
-	pFileHeader->bfSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4 + uiWidth * uiHeight;
-	pFileHeader->bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + uiPaletteSize * 4;
+		hlUInt uiFileImageCount = 0;
+		if(this->GetMipmapCount(*pFile) != 0 && !this->GetLumpImagesSize(*pFile, uiFileImageCount, uiSize))
+		{
+			uiImageCount = 0;
+			return hlFalse;
+		}
 
-	pInfoHeader->biSize = sizeof(BITMAPINFOHEADER);
-	pInfoHeader->biWidth = uiWidth;
-	pInfoHeader->biHeight = uiHeight;
-	pInfoHeader->biPlanes = 1;
-	pInfoHeader->biBitCount = 8;
-	pInfoHeader->biSizeImage = 0;
-	pInfoHeader->biClrUsed = uiPaletteSize;
-	pInfoHeader->biClrImportant = uiPaletteSize;
+		uiImageCount += uiFileImageCount;
+	}
 
-	//
-	// Fill in Palette data.
-	//
+	if(uiSize > 0xffffffff)
+	{
+		uiImageCount = 0;
+		LastError.SetErrorMessage("Image data exceeds 4 GB.");
+		return hlFalse;
+	}
+
+	uiPixelDataSize = static_cast<hlUInt>(uiSize);
 
-	for(hlUInt i = 0; i < uiPaletteSize; i++)
+	return hlTrue;
+}
+
+//
+// GetImages()
+// Decodes every mipmap of every image in the package to RGB pixels in
+// lpPixelData, one after the other.  Lumps that aren't images are skipped.
+//
+hlBool CWADFile::GetImages(HLWADImage *lpImages, hlByte *lpPixelData)
+{
+	if(!this->GetOpened())
 	{
-		lpPaletteData[i * 4 + 0] = lpPalette[i * 3 + 2];
-		lpPaletteData[i * 4 + 1] = lpPalette[i * 3 + 1];
-		lpPaletteData[i * 4 + 2] = lpPalette[i * 3 + 0];
-		lpPaletteData[i * 4 + 3] = 0;
+		LastError.SetErrorMessage("Package not opened.");
+		return hlFalse;
 	}
 
-	//
-	// Fill in Index data.
-	//
+	const CDirectoryFolder *pRoot = this->GetRoot();
 
-	for(hlUInt i = 0; i < uiWidth; i++)
+	hlUInt uiOffset = 0;
+	for(hlUInt i = 0; i < pRoot->GetCount(); i++)
 	{
-		for(hlUInt j = 0; j < uiHeight; j++)
+		const CDirectoryFile *pFile = static_cast<const CDirectoryFile *>(pRoot->GetItem(i));
+
+		hlUInt uiMipmapCount = this->GetMipmapCount(*pFile);
+		if(uiMipmapCount != 0)
 		{
-			lpPixelData[i + (uiHeight - 1 - j) * uiWidth] = lpPixels[i + j * uiWidth];
+			if(!this->GetLumpImages(*pFile, lpImages, lpPixelData, uiOffset))
+			{
+				return hlFalse;
+			}
+
+			lpImages += uiMipmapCount;
 		}
 	}
 
-	this->pMapping->Unmap(pView);
+	return hlTrue;
+}
+
+//
+// BorrowImage()
+// Points Image at the palette and the indices of each mipmap of an image
+// where they lie in the package, without copying them.  The lump stays mapped
+// until the image is passed to ReleaseImage(), which must happen before the
+// package is closed.
+//
+hlBool CWADFile::BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image)
+{
+	memset(&Image, 0, sizeof(HLBorrowedImage));
 
-	pStream = new Streams::CMemoryStream(lpBuffer, uiBufferSize);
+	if(!this->GetOpened() || pFile == 0 || pFile->GetPackage() != this)
+	{
+		LastError.SetErrorMessage("File does not belong to package.");
+		return hlFalse;
+	}
+
+	hlUInt uiWidth, uiHeight, uiPaletteSize;
+	const hlByte *lpPalette, *lpPixels;
+	Mapping::CView *pView = 0;
+
+	if(!this->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, pView))
+	{
+		return hlFalse;
+	}
+
+	// Callers read straight from the mapping, make sure everything they can reach lies in the lump.
+	if(!this->GetLumpMipmaps(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, *pView, Image.lpMipmaps))
+	{
+		this->UnmapLump(pView);
+		return hlFalse;
+	}
+
+	Image.uiWidth = uiWidth;
+	Image.uiHeight = uiHeight;
+	Image.uiMipmapCount = this->GetMipmapCount(*pFile);
+	Image.uiPaletteSize = uiPaletteSize;
+	Image.lpPalette = lpPalette;
+
+	// Compressed lumps are decompressed into a mapping of their own.
+	this->SetImageHandle(Image, pView, pView->GetMapping() != this->pMapping);
+
+	return hlTrue;
+}
+
+//
+// ReleaseImage()
+// Unmaps the lump of an image returned by BorrowImage().  Images borrowed
+// from another package are left alone.
+//
+hlVoid CWADFile::ReleaseImage(HLBorrowedImage &Image)
+{
+	ReleaseBorrowedImage(Image, HL_PACKAGE_WAD, this);
+}
+
+hlBool CWADFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const
+{
+	hlUInt uiBufferSize;
+	const hlByte *lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Acquire(pFile->GetID(), uiBufferSize) : 0;
+
+	if(lpBuffer == 0)
+	{
+		hlUInt uiWidth, uiHeight, uiPaletteSize;
+		const hlByte *lpPalette, *lpPixels;
+		Mapping::CView *pView = 0;
+
+		if(!const_cast<CWADFile *>(this)->GetLumpInfo(*pFile, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, pView))
+		{
+			return hlFalse;
+		}
+
+		uiBufferSize = GetBitmapSize(uiWidth, uiHeight, uiPaletteSize);
+		hlByte *lpBitmap = new hlByte[uiBufferSize];
+
+		WriteBitmap(lpBitmap, uiWidth, uiHeight, lpPalette, uiPaletteSize, lpPixels);
+
+		this->UnmapLump(pView);
+
+		lpBuffer = this->pStreamCache != 0 ? this->pStreamCache->Add(pFile->GetID(), lpBitmap, uiBufferSize) : lpBitmap;
+	}
+
+	pStream = new Streams::CMemoryStream(static_cast<const hlVoid *>(lpBuffer), uiBufferSize);
 
 	return hlTrue;
 }
 
 hlVoid CWADFile::ReleaseStreamInternal(Streams::IStream &Stream) const
 {
-	delete [](hlByte *)static_cast<Streams::CMemoryStream &>(Stream).GetBuffer();
+	const hlByte *lpBuffer = static_cast<const hlByte *>(static_cast<Streams::CMemoryStream &>(Stream).GetBuffer());
+	if(this->pStreamCache == 0 || !this->pStreamCache->Release(lpBuffer))
+	{
+		delete []lpBuffer;
+	}
 }
 
 hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, hlUInt uiMipmap) const
 {
 	const WADLump &Lump = this->lpLumps[File.GetID()];
 
-	if(Lump.iCompression)
+	if(!this->GetCompressionSupported(Lump.iCompression))
 	{
 		LastError.SetErrorMessageFormated("Error reading lump: compression format %#.2x not supported.", Lump.iCompression);
 		return hlFalse;
@@ -458,11 +605,28 @@ hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt
 
 	WADLumpInfo &Info = this->lpLumpInfo[File.GetID()];
 
-	if(Info.uiWidth && Info.uiHeight && Info.uiPaletteSize)
+	this->LumpInfoMutex.Lock();
+	WADLumpInfo CachedInfo = Info;
+	this->LumpInfoMutex.Unlock();
+
+	if(CachedInfo.uiWidth && CachedInfo.uiHeight && CachedInfo.uiPaletteSize)
 	{
-		uiWidth = Info.uiWidth;
-		uiHeight = Info.uiHeight;
-		uiPaletteSize = Info.uiPaletteSize;
+		uiWidth = CachedInfo.uiWidth;
+		uiHeight = CachedInfo.uiHeight;
+		uiPaletteSize = CachedInfo.uiPaletteSize;
+	}
+	else if(Lump.iCompression != HL_WAD_COMPRESSION_NONE)
+	{
+		if(!this->GetCompressedLumpInfo(Lump, uiWidth, uiHeight, uiPaletteSize))
+		{
+			return hlFalse;
+		}
+
+		Threading::CLock Lock(this->LumpInfoMutex);
+
+		Info.uiWidth = uiWidth;
+		Info.uiHeight = uiHeight;
+		Info.uiPaletteSize = uiPaletteSize;
 	}
 	else
 	{
@@ -530,7 +694,9 @@ hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt
 			uiPaletteSize = (hlUInt)(*(hlUInt16 *)lpData);
 		}
 
-		this->pMapping->Unmap(pView);
+		this->UnmapLump(pView);
+
+		Threading::CLock Lock(this->LumpInfoMutex);
 
 		Info.uiWidth = uiWidth;
 		Info.uiHeight = uiHeight;
@@ -556,13 +722,152 @@ hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt
 	return hlTrue;
 }
 
+//
+// GetMipmapCount()
+// Returns the number of mipmaps of a lump, 0 if it isn't a readable image.
+//
+hlUInt CWADFile::GetMipmapCount(const CDirectoryFile &File) const
+{
+	const WADLump &Lump = this->lpLumps[File.GetID()];
+
+	if(!this->GetCompressionSupported(Lump.iCompression))
+	{
+		return 0;
+	}
+
+	switch(Lump.iType)
+	{
+	case 0x42:
+		return 1;
+	case 0x43:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+//
+// GetLumpImagesSize()
+// Adds the number of mipmaps of a lump to uiImageCount and their size as RGB
+// pixels to uiPixelDataSize.
+//
+hlBool CWADFile::GetLumpImagesSize(const CDirectoryFile &File, hlUInt &uiImageCount, hlULongLong &uiPixelDataSize) const
+{
+	hlUInt uiWidth, uiHeight, uiPaletteSize;
+	if(!this->GetLumpInfo(File, uiWidth, uiHeight, uiPaletteSize))
+	{
+		return hlFalse;
+	}
+
+	hlUInt uiMipmapCount = this->GetMipmapCount(File);
+	for(hlUInt i = 0; i < uiMipmapCount; i++)
+	{
+		uiPixelDataSize += static_cast<hlULongLong>(uiWidth >> i) * static_cast<hlULongLong>(uiHeight >> i) * 3;
+	}
+
+	uiImageCount += uiMipmapCount;
+
+	return hlTrue;
+}
+
+//
+// GetLumpImages()
+// Decodes every mipmap of a lump to lpPixelData at uiOffset, advancing it,
+// and describes them in lpImages.
+//
+hlBool CWADFile::GetLumpImages(const CDirectoryFile &File, HLWADImage *lpImages, hlByte *lpPixelData, hlUInt &uiOffset) const
+{
+	hlUInt uiWidth, uiHeight, uiPaletteSize;
+	const hlByte *lpPalette, *lpPixels;
+	Mapping::CView *pView = 0;
+
+	if(!this->GetLumpInfo(File, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, pView))
+	{
+		return hlFalse;
+	}
+
+	const hlByte *lpMipmaps[4];
+	if(!this->GetLumpMipmaps(File, uiWidth, uiHeight, uiPaletteSize, lpPalette, lpPixels, *pView, lpMipmaps))
+	{
+		this->UnmapLump(pView);
+		return hlFalse;
+	}
+
+	hlUInt uiMipmapCount = this->GetMipmapCount(File);
+	for(hlUInt i = 0; i < uiMipmapCount; i++)
+	{
+		HLWADImage &Image = lpImages[i];
+
+		Image.pFile = &File;
+		Image.uiMipmap = i;
+		Image.uiWidth = uiWidth >> i;
+		Image.uiHeight = uiHeight >> i;
+		Image.uiOffset = uiOffset;
+
+		ExpandPalette(lpPalette, uiPaletteSize, lpMipmaps[i], Image.uiWidth * Image.uiHeight, lpPixelData + uiOffset);
+
+		uiOffset += Image.uiWidth * Image.uiHeight * 3;
+	}
+
+	this->UnmapLump(pView);
+
+	return hlTrue;
+}
+
+//
+// GetLumpMipmaps()
+// Points lpMipmaps at the indices of each mipmap of a lump mapped by
+// GetLumpInfo(), making sure they and the palette lie in the view.
+//
+hlBool CWADFile::GetLumpMipmaps(const CDirectoryFile &File, hlUInt uiWidth, hlUInt uiHeight, hlUInt uiPaletteSize, const hlByte *lpPalette, const hlByte *lpPixels, const Mapping::CView &View, const hlByte **lpMipmaps) const
+{
+	const hlByte *lpView = static_cast<const hlByte *>(View.GetView());
+	hlULongLong uiLength = View.GetLength();
+
+	const WADLump &Lump = this->lpLumps[File.GetID()];
+
+	// The name, width, height and mipmap offsets.
+	hlULongLong uiHeaderLength = Lump.iType == 0x43 ? 16 + 6 * sizeof(hlUInt) : 2 * sizeof(hlUInt);
+
+	if(uiLength < uiHeaderLength || static_cast<hlULongLong>(lpPalette - lpView) + static_cast<hlULongLong>(uiPaletteSize) * 3 > uiLength)
+	{
+		LastError.SetErrorMessage("Error reading lump: image data exceeds lump.");
+		return hlFalse;
+	}
+
+	hlUInt uiMipmapCount = this->GetMipmapCount(File);
+	for(hlUInt i = 0; i < uiMipmapCount; i++)
+	{
+		hlULongLong uiOffset;
+		if(Lump.iType == 0x43)
+		{
+			// Each mipmap starts at its own offset.
+			uiOffset = reinterpret_cast<const hlUInt *>(lpView + 16 + 2 * sizeof(hlUInt))[i];
+		}
+		else
+		{
+			uiOffset = static_cast<hlULongLong>(lpPixels - lpView);
+		}
+
+		if(uiOffset + static_cast<hlULongLong>(uiWidth >> i) * static_cast<hlULongLong>(uiHeight >> i) > uiLength)
+		{
+			LastError.SetErrorMessage("Error reading lump: image data exceeds lump.");
+			return hlFalse;
+		}
+
+		lpMipmaps[i] = lpView + uiOffset;
+	}
+
+	return hlTrue;
+}
+
 hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, const hlByte *&lpPalette, const hlByte *&lpPixels, Mapping::CView *&pView, hlUInt uiMipmap) const
 {
 	const WADLump &Lump = this->lpLumps[File.GetID()];
 
 	pView = 0;
 
-	if(Lump.iCompression)
+	if(!this->GetCompressionSupported(Lump.iCompression))
 	{
 		LastError.SetErrorMessageFormated("Error reading lump: compression format %#.2x not supported.", Lump.iCompression);
 		return hlFalse;
@@ -590,7 +895,14 @@ hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt
 		return hlFalse;
 	}
 
-	if(!this->pMapping->Map(pView, Lump.uiOffset, Lump.uiDiskLength))
+	if(Lump.iCompression != HL_WAD_COMPRESSION_NONE)
+	{
+		if(!this->MapCompressedLump(Lump, pView))
+		{
+			return hlFalse;
+		}
+	}
+	else if(!this->pMapping->Map(pView, Lump.uiOffset, Lump.uiDiskLength))
 	{
 		return hlFalse;
 	}
@@ -684,3 +996,144 @@ hlBool CWADFile::GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt
 
 	return hlTrue;
 }
+
+hlBool CWADFile::GetCompressionSupported(hlChar iCompression) const
+{
+	switch(iCompression)
+	{
+	case HL_WAD_COMPRESSION_NONE:
+	case HL_WAD_COMPRESSION_LZSS:
+		return hlTrue;
+	default:
+		return hlFalse;
+	}
+}
+
+//
+// GetCompressedLumpInfo()
+// Reads the dimensions and palette size of a compressed lump, decoding it as it
+// goes and discarding the pixels rather than decoding the whole lump up front.
+//
+hlBool CWADFile::GetCompressedLumpInfo(const WADLump &Lump, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize) const
+{
+	Streams::CLZSSStream Stream(*this->pMapping, Lump.uiOffset, Lump.uiDiskLength, Lump.uiLength);
+
+	if(!Stream.Open(HL_MODE_READ))
+	{
+		return hlFalse;
+	}
+
+	// Type 0x42 has no name, type 0x43 does.
+	if(Lump.iType == 0x43)
+	{
+		Stream.Seek(16, HL_SEEK_CURRENT);
+	}
+
+	hlUInt lpSize[2];
+	if(Stream.Read(lpSize, sizeof(lpSize)) != sizeof(lpSize))
+	{
+		LastError.SetErrorMessage("Error reading lump: unexpected end of lump data.");
+		return hlFalse;
+	}
+
+	uiWidth = lpSize[0];
+	uiHeight = lpSize[1];
+
+	// Scan past the pixel offsets and pixel data.
+	hlULongLong uiPixelSize = static_cast<hlULongLong>(uiWidth) * static_cast<hlULongLong>(uiHeight);
+	if(Lump.iType == 0x43)
+	{
+		Stream.Seek(16 + uiPixelSize + (uiPixelSize / 4) + (uiPixelSize / 16) + (uiPixelSize / 64), HL_SEEK_CURRENT);
+	}
+	else
+	{
+		Stream.Seek(uiPixelSize, HL_SEEK_CURRENT);
+	}
+
+	hlUInt16 uiPaletteCount;
+	if(Stream.Read(&uiPaletteCount, sizeof(uiPaletteCount)) != sizeof(uiPaletteCount))
+	{
+		LastError.SetErrorMessage("Error reading lump: unexpected end of lump data.");
+		return hlFalse;
+	}
+
+	uiPaletteSize = static_cast<hlUInt>(uiPaletteCount);
+
+	return hlTrue;
+}
+
+//
+// MapCompressedLump()
+// Decompresses a lump into memory and maps all of it, so it can be read like an
+// uncompressed lump.  The view is released with UnmapLump().
+//
+hlBool CWADFile::MapCompressedLump(const WADLump &Lump, Mapping::CView *&pView) const
+{
+	// The size comes from the directory, don't trust it further than the header
+	// the lump must have and what its compressed data can decode to.
+	hlUInt uiHeaderSize = Lump.iType == 0x43 ? 16 + 6 * sizeof(hlUInt) : 2 * sizeof(hlUInt);
+
+	if(Lump.uiLength < uiHeaderSize || static_cast<hlULongLong>(Lump.uiLength) > Streams::CLZSSStream::GetMaximumLength(Lump.uiDiskLength))
+	{
+		LastError.SetErrorMessageFormated("Error reading lump: invalid decompressed size %u for %u compressed bytes.", Lump.uiLength, Lump.uiDiskLength);
+		return hlFalse;
+	}
+
+	Streams::CLZSSStream Stream(*this->pMapping, Lump.uiOffset, Lump.uiDiskLength, Lump.uiLength);
+
+	if(!Stream.Open(HL_MODE_READ))
+	{
+		return hlFalse;
+	}
+
+	hlByte *lpBuffer = new (std::nothrow) hlByte[Lump.uiLength];
+
+	if(lpBuffer == 0)
+	{
+		LastError.SetErrorMessageFormated("Error reading lump: out of memory decompressing %u bytes.", Lump.uiLength);
+		return hlFalse;
+	}
+
+	if(Stream.Read(lpBuffer, Lump.uiLength) != Lump.uiLength)
+	{
+		LastError.SetErrorMessage("Error reading lump: compressed data is truncated.");
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	Mapping::CMemoryMapping *pLumpMapping = new Mapping::CMemoryMapping(lpBuffer, Lump.uiLength);
+
+	if(!pLumpMapping->Open(HL_MODE_READ) || !pLumpMapping->Map(pView, 0, Lump.uiLength))
+	{
+		delete pLumpMapping;
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	return hlTrue;
+}
+
+//
+// UnmapLump()
+// Releases a lump view returned by GetLumpInfo().  Compressed lumps were
+// decompressed into a mapping of their own, which goes with the view.
+//
+hlVoid CWADFile::UnmapLump(Mapping::CView *&pView) const
+{
+	if(pView == 0)
+	{
+		return;
+	}
+
+	Mapping::CMapping *pLumpMapping = pView->GetMapping();
+
+	pLumpMapping->Unmap(pView);
+
+	if(pLumpMapping != this->pMapping)
+	{
+		hlByte *lpBuffer = (hlByte *)static_cast<Mapping::CMemoryMapping *>(pLumpMapping)->GetBuffer();
+
+		delete pLumpMapping;
+		delete []lpBuffer;
+	}
+}
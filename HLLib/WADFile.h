@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "Package.h"
+#include "BufferCache.h"
 
 namespace HLLib
 {
@@ -60,6 +61,9 @@ namespace HLLib
 		const WADHeader *pHeader;
 		const WADLump *lpLumps;
 		WADLumpInfo *lpLumpInfo;
+		mutable Threading::CMutex LumpInfoMutex;
+
+		CBufferCache *pStreamCache;
 
 	public:
 		CWADFile();
@@ -75,6 +79,15 @@ namespace HLLib
 		hlBool GetImageSize(const CDirectoryFile *pFile, hlUInt &uiPixelDataSize);
 		hlBool GetImageData(const CDirectoryFile *pFile, hlUInt &uiWidth, hlUInt &uiHeight, hlByte *lpPixelData);
 
+		hlBool GetImageMipmapsSize(const CDirectoryFile *pFile, hlUInt &uiImageCount, hlUInt &uiPixelDataSize);
+		hlBool GetImageMipmaps(const CDirectoryFile *pFile, HLWADImage *lpImages, hlByte *lpPixelData);
+
+		hlBool GetImagesSize(hlUInt &uiImageCount, hlUInt &uiPixelDataSize);
+		hlBool GetImages(HLWADImage *lpImages, hlByte *lpPixelData);
+
+		hlBool BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image);
+		hlVoid ReleaseImage(HLBorrowedImage &Image);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -99,6 +112,16 @@ namespace HLLib
 	private:
 		hlBool GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, hlUInt uiMipmap = 0) const;
 		hlBool GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, const hlByte *&lpPalette, const hlByte *&lpPixels, Mapping::CView *&pView, hlUInt uiMipmap = 0) const;
+
+		hlUInt GetMipmapCount(const CDirectoryFile &File) const;
+		hlBool GetLumpImagesSize(const CDirectoryFile &File, hlUInt &uiImageCount, hlULongLong &uiPixelDataSize) const;
+		hlBool GetLumpImages(const CDirectoryFile &File, HLWADImage *lpImages, hlByte *lpPixelData, hlUInt &uiOffset) const;
+		hlBool GetLumpMipmaps(const CDirectoryFile &File, hlUInt uiWidth, hlUInt uiHeight, hlUInt uiPaletteSize, const hlByte *lpPalette, const hlByte *lpPixels, const Mapping::CView &View, const hlByte **lpMipmaps) const;
+
+		hlBool GetCompressionSupported(hlChar iCompression) const;
+		hlBool GetCompressedLumpInfo(const WADLump &Lump, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize) const;
+		hlBool MapCompressedLump(const WADLump &Lump, Mapping::CView *&pView) const;
+		hlVoid UnmapLump(Mapping::CView *&pView) const;
 	};
 }
 
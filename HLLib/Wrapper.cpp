@@ -15,6 +15,13 @@
 #include "Streams.h"
 #include "Packages.h"
 #include "Wrapper.h"
+#include "TarWriter.h"
+#include "VPKWriter.h"
+#include "ZIPWriter.h"
+
+#ifdef _WIN32
+#	include <io.h>
+#endif
 
 using namespace HLLib;
 using namespace HLLib::Streams;
@@ -46,20 +53,7 @@ HLLIB_API const hlVoid *hlItemGetData(const HLDirectoryItem *pItem)
 
 HLLIB_API hlUInt hlItemGetPackage(const HLDirectoryItem *pItem)
 {
-	if(bInitialized)
-	{
-		const CPackage *pPackage = static_cast<const CDirectoryItem *>(pItem)->GetPackage();
-
-		for(hlUInt i = 0; i < (hlUInt)pPackageVector->size(); i++)
-		{
-			if((*pPackageVector)[i] == pPackage)
-			{
-				return i;
-			}
-		}
-	}
-
-	return HL_ID_INVALID;
+	return GetContext().GetPackageID(static_cast<const CDirectoryItem *>(pItem)->GetPackage());
 }
 
 HLLIB_API HLDirectoryItem *hlItemGetParent(HLDirectoryItem *pItem)
@@ -93,12 +87,7 @@ HLLIB_API hlBool hlItemGetSizeEx(const HLDirectoryItem *pItem, hlULongLong *pSiz
 	}
 	else if(static_cast<const CDirectoryItem *>(pItem)->GetType() == HL_ITEM_FILE)
 	{
-		hlUInt uiSize;
-		if(static_cast<const CDirectoryFile *>(pItem)->GetSize(uiSize))
-		{
-			*pSize = static_cast<hlULongLong>(uiSize);
-			return hlTrue;
-		}
+		return static_cast<const CDirectoryFile *>(pItem)->GetSizeEx(*pSize);
 	}
 
 	return hlFalse;
@@ -130,12 +119,7 @@ HLLIB_API hlBool hlItemGetSizeOnDiskEx(const HLDirectoryItem *pItem, hlULongLong
 	}
 	else if(static_cast<const CDirectoryItem *>(pItem)->GetType() == HL_ITEM_FILE)
 	{
-		hlUInt uiSize;
-		if(static_cast<const CDirectoryFile *>(pItem)->GetSizeOnDisk(uiSize))
-		{
-			*pSize = static_cast<hlULongLong>(uiSize);
-			return hlTrue;
-		}
+		return static_cast<const CDirectoryFile *>(pItem)->GetSizeOnDiskEx(*pSize);
 	}
 
 	return hlFalse;
@@ -151,6 +135,93 @@ HLLIB_API hlBool hlItemExtract(HLDirectoryItem *pItem, const hlChar *lpPath)
 	return static_cast<CDirectoryItem *>(pItem)->Extract(lpPath);
 }
 
+static hlUInt hlWriteFileDescriptor(const hlVoid *lpData, hlUInt uiBytes, hlVoid *pUserData)
+{
+	hlInt iFile = *static_cast<hlInt *>(pUserData);
+
+#ifdef _WIN32
+	hlInt iBytesWritten = _write(iFile, lpData, uiBytes);
+#else
+	ssize_t iBytesWritten;
+	do
+	{
+		iBytesWritten = write(iFile, lpData, uiBytes);
+	} while(iBytesWritten < 0 && errno == EINTR);
+#endif
+
+	return iBytesWritten < 0 ? 0 : static_cast<hlUInt>(iBytesWritten);
+}
+
+//
+// hlItemExtractTar()
+// Writes pItem (if not null) to iFile as a tar stream.  Set bFinish on the last
+// call to write the end of archive marker.
+//
+HLLIB_API hlBool hlItemExtractTar(HLDirectoryItem *pItem, hlInt iFile, hlBool bFinish)
+{
+	return hlItemExtractTarProc(pItem, hlWriteFileDescriptor, &iFile, bFinish);
+}
+
+HLLIB_API hlBool hlItemExtractTarProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish)
+{
+	if(pWriteProc == 0)
+	{
+		LastError.SetErrorMessage("pWriteProc not set.");
+		return hlFalse;
+	}
+
+	CTarWriter Writer = CTarWriter(pWriteProc, pUserData);
+
+	if(pItem != 0 && !Writer.Write(static_cast<CDirectoryItem *>(pItem)))
+	{
+		return hlFalse;
+	}
+
+	return !bFinish || Writer.Finish();
+}
+
+//
+// hlItemExtractZIP()
+// Writes pItem to iFile as a complete zip archive.
+//
+HLLIB_API hlBool hlItemExtractZIP(HLDirectoryItem *pItem, hlInt iFile)
+{
+	return hlItemExtractZIPProc(pItem, hlWriteFileDescriptor, &iFile);
+}
+
+HLLIB_API hlBool hlItemExtractZIPProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData)
+{
+	if(pWriteProc == 0)
+	{
+		LastError.SetErrorMessage("pWriteProc not set.");
+		return hlFalse;
+	}
+
+	CZIPWriter Writer(pWriteProc, pUserData);
+
+	return Writer.Add(static_cast<CDirectoryItem *>(pItem)) && Writer.Finish();
+}
+
+//
+// hlItemExtractVPK()
+// Writes pItem, or everything below it if it is a folder, to lpFileName as a
+// VPK of version uiVersion.  File data goes to numbered archives if
+// lpFileName ends in _dir.vpk.
+//
+HLLIB_API hlBool hlItemExtractVPK(HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion)
+{
+	if(lpFileName == 0)
+	{
+		LastError.SetErrorMessage("lpFileName not set.");
+		return hlFalse;
+	}
+
+	CVPKWriter Writer(lpFileName);
+	Writer.SetVersion(uiVersion);
+
+	return Writer.Add(static_cast<CDirectoryItem *>(pItem)) && Writer.Finish();
+}
+
 //
 // Directory Folder
 //
@@ -442,13 +513,17 @@ HLLIB_API hlBool hlBindPackage(hlUInt uiPackage)
 		return hlFalse;
 	}
 
-	if(uiPackage >= pPackageVector->size() || (*pPackageVector)[uiPackage] == 0)
+	CContext &Context = GetContext();
+
+	CPackage *pPackage = Context.GetPackage(uiPackage);
+
+	if(pPackage == 0)
 	{
 		LastError.SetErrorMessage("Invalid package.");
 		return hlFalse;
 	}
 
-	pPackage = (*pPackageVector)[uiPackage];
+	Context.pPackage = pPackage;
 
 	return hlTrue;
 }
@@ -577,59 +652,7 @@ HLLIB_API hlBool hlCreatePackage(HLPackageType ePackageType, hlUInt *uiPackage)
 		return hlFalse;
 	}
 
-	CPackage* pNewPackage = 0;
-	switch(ePackageType)
-	{
-	case HL_PACKAGE_NONE:
-		LastError.SetErrorMessage("Unsupported package type.");
-		return hlFalse;
-		break;
-	case HL_PACKAGE_BSP:
-		pNewPackage = new CBSPFile();
-		break;
-	case HL_PACKAGE_GCF:
-		pNewPackage = new CGCFFile();
-		break;
-	case HL_PACKAGE_NCF:
-		pNewPackage = new CNCFFile();
-		break;
-	case HL_PACKAGE_PAK:
-		pNewPackage = new CPAKFile();
-		break;
-	case HL_PACKAGE_VBSP:
-		pNewPackage = new CVBSPFile();
-		break;
-	case HL_PACKAGE_VPK:
-		pNewPackage = new CVPKFile();
-		break;
-	case HL_PACKAGE_WAD:
-		pNewPackage = new CWADFile();
-		break;
-	case HL_PACKAGE_XZP:
-		pNewPackage = new CXZPFile();
-		break;
-	case HL_PACKAGE_ZIP:
-		pNewPackage = new CZIPFile();
-		break;
-	default:
-		LastError.SetErrorMessageFormated("Invalid package type %d.", ePackageType);
-		return hlFalse;
-	}
-
-	for(hlUInt i = 0; i < (hlUInt)pPackageVector->size(); i++)
-	{
-		if((*pPackageVector)[i] == 0)
-		{
-			(*pPackageVector)[i] = pNewPackage;
-			*uiPackage = i;
-			return hlTrue;
-		}
-	}
-
-	pPackageVector->push_back(pNewPackage);
-	*uiPackage = (hlUInt)pPackageVector->size() - 1;
-
-	return hlTrue;
+	return hlContextCreatePackage(&GetContext(), ePackageType, uiPackage);
 }
 
 HLLIB_API hlVoid hlDeletePackage(hlUInt uiPackage)
@@ -637,23 +660,13 @@ HLLIB_API hlVoid hlDeletePackage(hlUInt uiPackage)
 	if(!bInitialized)
 		return;
 
-	if(uiPackage >= pPackageVector->size())
-		return;
-
-	if((*pPackageVector)[uiPackage] == 0)
-		return;
-
-	if((*pPackageVector)[uiPackage] == pPackage)
-	{
-		pPackage = 0;
-	}
-
-	delete (*pPackageVector)[uiPackage];
-	(*pPackageVector)[uiPackage] = 0;
+	GetContext().DeletePackage(uiPackage);
 }
 
 HLLIB_API HLPackageType hlPackageGetType()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return HL_PACKAGE_NONE;
@@ -664,6 +677,8 @@ HLLIB_API HLPackageType hlPackageGetType()
 
 HLLIB_API const hlChar *hlPackageGetExtension()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return "";
@@ -674,6 +689,8 @@ HLLIB_API const hlChar *hlPackageGetExtension()
 
 HLLIB_API const hlChar *hlPackageGetDescription()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return "";
@@ -684,6 +701,8 @@ HLLIB_API const hlChar *hlPackageGetDescription()
 
 HLLIB_API hlBool hlPackageGetOpened()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -694,6 +713,8 @@ HLLIB_API hlBool hlPackageGetOpened()
 
 HLLIB_API hlBool hlPackageOpenFile(const hlChar *lpFileName, hlUInt uiMode)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -704,6 +725,8 @@ HLLIB_API hlBool hlPackageOpenFile(const hlChar *lpFileName, hlUInt uiMode)
 
 HLLIB_API hlBool hlPackageOpenMemory(hlVoid *lpData, hlUInt uiBufferSize, hlUInt uiMode)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -714,6 +737,8 @@ HLLIB_API hlBool hlPackageOpenMemory(hlVoid *lpData, hlUInt uiBufferSize, hlUInt
 
 HLLIB_API hlBool hlPackageOpenProc(hlVoid *pUserData, hlUInt uiMode)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -724,6 +749,8 @@ HLLIB_API hlBool hlPackageOpenProc(hlVoid *pUserData, hlUInt uiMode)
 
 HLLIB_API hlBool hlPackageOpenStream(HLStream *pStream, hlUInt uiMode)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -734,6 +761,8 @@ HLLIB_API hlBool hlPackageOpenStream(HLStream *pStream, hlUInt uiMode)
 
 HLLIB_API hlVoid hlPackageClose()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return;
@@ -744,6 +773,8 @@ HLLIB_API hlVoid hlPackageClose()
 
 HLLIB_API hlBool hlPackageDefragment()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return hlFalse;
@@ -754,6 +785,8 @@ HLLIB_API hlBool hlPackageDefragment()
 
 HLLIB_API HLDirectoryItem *hlPackageGetRoot()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return 0;
@@ -764,6 +797,8 @@ HLLIB_API HLDirectoryItem *hlPackageGetRoot()
 
 HLLIB_API hlUInt hlPackageGetAttributeCount()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return 0;
@@ -774,6 +809,8 @@ HLLIB_API hlUInt hlPackageGetAttributeCount()
 
 HLLIB_API const hlChar *hlPackageGetAttributeName(HLPackageAttribute eAttribute)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return 0;
@@ -784,6 +821,8 @@ HLLIB_API const hlChar *hlPackageGetAttributeName(HLPackageAttribute eAttribute)
 
 HLLIB_API hlBool hlPackageGetAttribute(HLPackageAttribute eAttribute, HLAttribute *pAttribute)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	pAttribute->eAttributeType = HL_ATTRIBUTE_INVALID;
 
 	if(pPackage == 0)
@@ -796,6 +835,8 @@ HLLIB_API hlBool hlPackageGetAttribute(HLPackageAttribute eAttribute, HLAttribut
 
 HLLIB_API hlUInt hlPackageGetItemAttributeCount()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return 0;
@@ -806,6 +847,8 @@ HLLIB_API hlUInt hlPackageGetItemAttributeCount()
 
 HLLIB_API const hlChar *hlPackageGetItemAttributeName(HLPackageAttribute eAttribute)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return 0;
@@ -816,6 +859,8 @@ HLLIB_API const hlChar *hlPackageGetItemAttributeName(HLPackageAttribute eAttrib
 
 HLLIB_API hlBool hlPackageGetItemAttribute(const HLDirectoryItem *pItem, HLPackageAttribute eAttribute, HLAttribute *pAttribute)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	pAttribute->eAttributeType = HL_ATTRIBUTE_INVALID;
 
 	if(pPackage == 0)
@@ -828,6 +873,8 @@ HLLIB_API hlBool hlPackageGetItemAttribute(const HLDirectoryItem *pItem, HLPacka
 
 HLLIB_API hlBool hlPackageGetExtractable(const HLDirectoryItem *pFile, hlBool *pExtractable)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	*pExtractable = hlFalse;
 
 	if(pPackage == 0)
@@ -845,6 +892,8 @@ HLLIB_API hlBool hlPackageGetExtractable(const HLDirectoryItem *pFile, hlBool *p
 
 HLLIB_API hlBool hlPackageGetFileSize(const HLDirectoryItem *pFile, hlUInt *pSize)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	*pSize = 0;
 
 	if(pPackage == 0)
@@ -862,6 +911,8 @@ HLLIB_API hlBool hlPackageGetFileSize(const HLDirectoryItem *pFile, hlUInt *pSiz
 
 HLLIB_API hlBool hlPackageGetFileSizeOnDisk(const HLDirectoryItem *pFile, hlUInt *pSize)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	*pSize = 0;
 
 	if(pPackage == 0)
@@ -879,6 +930,8 @@ HLLIB_API hlBool hlPackageGetFileSizeOnDisk(const HLDirectoryItem *pFile, hlUInt
 
 HLLIB_API hlBool hlPackageCreateStream(const HLDirectoryItem *pFile, HLStream **pStream)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	*pStream = 0;
 
 	if(pPackage == 0)
@@ -900,6 +953,8 @@ HLLIB_API hlBool hlPackageCreateStream(const HLDirectoryItem *pFile, HLStream **
 
 HLLIB_API hlVoid hlPackageReleaseStream(HLStream *pStream)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0)
 	{
 		return;
@@ -910,6 +965,8 @@ HLLIB_API hlVoid hlPackageReleaseStream(HLStream *pStream)
 
 HLLIB_API const hlChar *hlNCFFileGetRootPath()
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_NCF)
 	{
 		return 0;
@@ -920,6 +977,8 @@ HLLIB_API const hlChar *hlNCFFileGetRootPath()
 
 HLLIB_API hlVoid hlNCFFileSetRootPath(const hlChar *lpRootPath)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_NCF)
 	{
 		return;
@@ -928,8 +987,76 @@ HLLIB_API hlVoid hlNCFFileSetRootPath(const hlChar *lpRootPath)
 	static_cast<CNCFFile *>(pPackage)->SetRootPath(lpRootPath);
 }
 
+HLLIB_API HLValidation hlVPKFileValidateArchives()
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_VPK)
+	{
+		return HL_VALIDATES_ERROR;
+	}
+
+	HLValidation eValidation;
+	if(!static_cast<CVPKFile *>(pPackage)->ValidateArchives(eValidation))
+	{
+		return HL_VALIDATES_ERROR;
+	}
+
+	return eValidation;
+}
+
+HLLIB_API hlBool hlVPKFilePinArchive(hlUInt uiArchiveIndex)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_VPK)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CVPKFile *>(pPackage)->PinArchive(uiArchiveIndex);
+}
+
+HLLIB_API hlVoid hlVPKFileUnpinArchive(hlUInt uiArchiveIndex)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_VPK)
+	{
+		return;
+	}
+
+	static_cast<CVPKFile *>(pPackage)->UnpinArchive(uiArchiveIndex);
+}
+
+HLLIB_API HLDirectoryItem *hlVPKFileFindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_VPK)
+	{
+		return 0;
+	}
+
+	return static_cast<CVPKFile *>(pPackage)->FindFile(lpExtension, lpPath, lpName);
+}
+
+HLLIB_API HLDirectoryItem *hlXZPFileGetFileByCRC(hlUInt uiFileNameCRC)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_XZP)
+	{
+		return 0;
+	}
+
+	return static_cast<CXZPFile *>(pPackage)->GetFileByCRC(uiFileNameCRC);
+}
+
 HLLIB_API hlBool hlWADFileGetImageSizePaletted(const HLDirectoryItem *pFile, hlUInt *uiPaletteDataSize, hlUInt *uiPixelDataSize)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
 	{
 		return hlFalse;
@@ -940,6 +1067,8 @@ HLLIB_API hlBool hlWADFileGetImageSizePaletted(const HLDirectoryItem *pFile, hlU
 
 HLLIB_API hlBool hlWADFileGetImageDataPaletted(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPaletteData, hlByte **lpPixelData)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
 	{
 		return hlFalse;
@@ -950,6 +1079,8 @@ HLLIB_API hlBool hlWADFileGetImageDataPaletted(const HLDirectoryItem *pFile, hlU
 
 HLLIB_API hlBool hlWADFileGetImageSize(const HLDirectoryItem *pFile, hlUInt *uiPixelDataSize)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
 	{
 		return hlFalse;
@@ -960,6 +1091,8 @@ HLLIB_API hlBool hlWADFileGetImageSize(const HLDirectoryItem *pFile, hlUInt *uiP
 
 HLLIB_API hlBool hlWADFileGetImageData(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPixelData)
 {
+	CPackage *pPackage = GetContext().pPackage;
+
 	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
 	{
 		return hlFalse;
@@ -967,3 +1100,454 @@ HLLIB_API hlBool hlWADFileGetImageData(const HLDirectoryItem *pFile, hlUInt *uiW
 
 	return static_cast<CWADFile *>(pPackage)->GetImageData(static_cast<const CDirectoryFile *>(pFile), *uiWidth, *uiHeight, *lpPixelData);
 }
+
+HLLIB_API hlBool hlWADFileGetImageMipmapsSize(const HLDirectoryItem *pFile, hlUInt *uiImageCount, hlUInt *uiPixelDataSize)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CWADFile *>(pPackage)->GetImageMipmapsSize(static_cast<const CDirectoryFile *>(pFile), *uiImageCount, *uiPixelDataSize);
+}
+
+HLLIB_API hlBool hlWADFileGetImageMipmaps(const HLDirectoryItem *pFile, HLWADImage *lpImages, hlByte **lpPixelData)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CWADFile *>(pPackage)->GetImageMipmaps(static_cast<const CDirectoryFile *>(pFile), lpImages, *lpPixelData);
+}
+
+HLLIB_API hlBool hlWADFileGetImagesSize(hlUInt *uiImageCount, hlUInt *uiPixelDataSize)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CWADFile *>(pPackage)->GetImagesSize(*uiImageCount, *uiPixelDataSize);
+}
+
+HLLIB_API hlBool hlWADFileGetImages(HLWADImage *lpImages, hlByte **lpPixelData)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CWADFile *>(pPackage)->GetImages(lpImages, *lpPixelData);
+}
+
+HLLIB_API hlBool hlWADFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_WAD)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CWADFile *>(pPackage)->BorrowImage(static_cast<const CDirectoryFile *>(pFile), *pImage);
+}
+
+HLLIB_API hlVoid hlWADFileReleaseImage(HLBorrowedImage *pImage)
+{
+	// The image's handle knows its package, which needn't be bound.
+	CPackage::ReleaseBorrowedImage(*pImage, HL_PACKAGE_WAD);
+}
+
+HLLIB_API hlBool hlBSPFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage)
+{
+	CPackage *pPackage = GetContext().pPackage;
+
+	if(pPackage == 0 || pPackage->GetType() != HL_PACKAGE_BSP)
+	{
+		return hlFalse;
+	}
+
+	return static_cast<CBSPFile *>(pPackage)->BorrowImage(static_cast<const CDirectoryFile *>(pFile), *pImage);
+}
+
+HLLIB_API hlVoid hlBSPFileReleaseImage(HLBorrowedImage *pImage)
+{
+	// The image's handle knows its package, which needn't be bound.
+	CPackage::ReleaseBorrowedImage(*pImage, HL_PACKAGE_BSP);
+}
+
+HLLIB_API hlBool hlContextCreatePackage(HLContext *pContext, HLPackageType ePackageType, hlUInt *uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage* pNewPackage = 0;
+	switch(ePackageType)
+	{
+	case HL_PACKAGE_NONE:
+		LastError.SetErrorMessage("Unsupported package type.");
+		return hlFalse;
+		break;
+	case HL_PACKAGE_BSP:
+		pNewPackage = new CBSPFile();
+		break;
+	case HL_PACKAGE_GCF:
+		pNewPackage = new CGCFFile();
+		break;
+	case HL_PACKAGE_NCF:
+		pNewPackage = new CNCFFile();
+		break;
+	case HL_PACKAGE_PAK:
+		pNewPackage = new CPAKFile();
+		break;
+	case HL_PACKAGE_VBSP:
+		pNewPackage = new CVBSPFile();
+		break;
+	case HL_PACKAGE_VPK:
+		pNewPackage = new CVPKFile();
+		break;
+	case HL_PACKAGE_WAD:
+		pNewPackage = new CWADFile();
+		break;
+	case HL_PACKAGE_XZP:
+		pNewPackage = new CXZPFile();
+		break;
+	case HL_PACKAGE_ZIP:
+		pNewPackage = new CZIPFile();
+		break;
+	default:
+		LastError.SetErrorMessageFormated("Invalid package type %d.", ePackageType);
+		return hlFalse;
+	}
+
+	*uiPackage = Context.AddPackage(pNewPackage);
+
+	return hlTrue;
+}
+
+HLLIB_API hlVoid hlContextDeletePackage(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	Context.DeletePackage(uiPackage);
+}
+
+//
+// GetContextPackage()
+// Looks up one of Context's packages.  The caller makes Context current first.
+//
+static CPackage *GetContextPackage(CContext &Context, hlUInt uiPackage)
+{
+	CPackage *pPackage = Context.GetPackage(uiPackage);
+
+	if(pPackage == 0)
+	{
+		LastError.SetErrorMessage("Invalid package.");
+	}
+
+	return pPackage;
+}
+
+//
+// GetContextItem()
+// Checks that pItem belongs to one of pContext's packages.
+//
+static const CDirectoryItem *GetContextItem(CContext &Context, const HLDirectoryItem *pItem)
+{
+	const CDirectoryItem *pDirectoryItem = static_cast<const CDirectoryItem *>(pItem);
+
+	if(Context.GetPackageID(pDirectoryItem->GetPackage()) == HL_ID_INVALID)
+	{
+		LastError.SetErrorMessage("Item does not belong to context.");
+		return 0;
+	}
+
+	return pDirectoryItem;
+}
+
+HLLIB_API HLPackageType hlContextPackageGetType(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 ? pPackage->GetType() : HL_PACKAGE_NONE;
+}
+
+HLLIB_API hlBool hlContextPackageGetOpened(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->GetOpened();
+}
+
+HLLIB_API hlBool hlContextPackageOpenFile(HLContext *pContext, hlUInt uiPackage, const hlChar *lpFileName, hlUInt uiMode)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->Open(lpFileName, uiMode);
+}
+
+HLLIB_API hlBool hlContextPackageOpenMemory(HLContext *pContext, hlUInt uiPackage, hlVoid *lpData, hlUInt uiBufferSize, hlUInt uiMode)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->Open(lpData, uiBufferSize, uiMode);
+}
+
+HLLIB_API hlBool hlContextPackageOpenProc(HLContext *pContext, hlUInt uiPackage, hlVoid *pUserData, hlUInt uiMode)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->Open(pUserData, uiMode);
+}
+
+HLLIB_API hlBool hlContextPackageOpenStream(HLContext *pContext, hlUInt uiPackage, HLStream *pStream, hlUInt uiMode)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->Open(*static_cast<IStream *>(pStream), uiMode);
+}
+
+HLLIB_API hlVoid hlContextPackageClose(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	if(pPackage != 0)
+	{
+		pPackage->Close();
+	}
+}
+
+HLLIB_API hlBool hlContextPackageDefragment(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->Defragment();
+}
+
+HLLIB_API HLDirectoryItem *hlContextPackageGetRoot(HLContext *pContext, hlUInt uiPackage)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 ? pPackage->GetRoot() : 0;
+}
+
+HLLIB_API hlBool hlContextPackageGetAttribute(HLContext *pContext, hlUInt uiPackage, HLPackageAttribute eAttribute, HLAttribute *pAttribute)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	pAttribute->eAttributeType = HL_ATTRIBUTE_INVALID;
+
+	CPackage *pPackage = GetContextPackage(Context, uiPackage);
+
+	return pPackage != 0 && pPackage->GetAttribute(eAttribute, *pAttribute);
+}
+
+HLLIB_API hlBool hlContextPackageGetItemAttribute(HLContext *pContext, const HLDirectoryItem *pItem, HLPackageAttribute eAttribute, HLAttribute *pAttribute)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	pAttribute->eAttributeType = HL_ATTRIBUTE_INVALID;
+
+	const CDirectoryItem *pDirectoryItem = GetContextItem(Context, pItem);
+
+	return pDirectoryItem != 0 && pDirectoryItem->GetPackage()->GetItemAttribute(pDirectoryItem, eAttribute, *pAttribute);
+}
+
+HLLIB_API hlBool hlContextItemExtract(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpPath)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	const CDirectoryItem *pDirectoryItem = GetContextItem(Context, pItem);
+
+	return pDirectoryItem != 0 && pDirectoryItem->Extract(lpPath);
+}
+
+HLLIB_API hlBool hlContextItemExtractTarProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	if(pItem != 0 && GetContextItem(Context, pItem) == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlItemExtractTarProc(pItem, pWriteProc, pUserData, bFinish);
+}
+
+HLLIB_API hlBool hlContextItemExtractZIPProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	if(GetContextItem(Context, pItem) == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlItemExtractZIPProc(pItem, pWriteProc, pUserData);
+}
+
+HLLIB_API hlBool hlContextItemExtractVPK(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	if(GetContextItem(Context, pItem) == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlItemExtractVPK(pItem, lpFileName, uiVersion);
+}
+
+HLLIB_API HLValidation hlContextFileGetValidation(HLContext *pContext, const HLDirectoryItem *pItem)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	const CDirectoryItem *pDirectoryItem = GetContextItem(Context, pItem);
+
+	if(pDirectoryItem == 0)
+	{
+		return HL_VALIDATES_ERROR;
+	}
+
+	return hlFileGetValidation(pItem);
+}
+
+HLLIB_API hlBool hlContextFileCreateStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream **pStream)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	*pStream = 0;
+
+	const CDirectoryItem *pDirectoryItem = GetContextItem(Context, pItem);
+
+	if(pDirectoryItem == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlFileCreateStream(pItem, pStream);
+}
+
+HLLIB_API hlVoid hlContextFileReleaseStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream *pStream)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	hlFileReleaseStream(pItem, pStream);
+}
+
+HLLIB_API hlBool hlContextItemGetSizeEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	*pSize = 0;
+
+	if(GetContextItem(Context, pItem) == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlItemGetSizeEx(pItem, pSize);
+}
+
+HLLIB_API hlBool hlContextItemGetSizeOnDiskEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize)
+{
+	CContext &Context = *static_cast<CContext *>(pContext);
+	CContextScope Scope(Context);
+
+	*pSize = 0;
+
+	if(GetContextItem(Context, pItem) == 0)
+	{
+		return hlFalse;
+	}
+
+	return hlItemGetSizeOnDiskEx(pItem, pSize);
+}
+
+//
+// Context Stream
+// Streams don't know their package, so these only make pContext current for
+// the call.
+//
+
+HLLIB_API hlBool hlContextStreamOpen(HLContext *pContext, HLStream *pStream, hlUInt uiMode)
+{
+	CContextScope Scope(*static_cast<CContext *>(pContext));
+
+	return hlStreamOpen(pStream, uiMode);
+}
+
+HLLIB_API hlVoid hlContextStreamClose(HLContext *pContext, HLStream *pStream)
+{
+	CContextScope Scope(*static_cast<CContext *>(pContext));
+
+	hlStreamClose(pStream);
+}
+
+HLLIB_API hlULongLong hlContextStreamSeekEx(HLContext *pContext, HLStream *pStream, hlLongLong iOffset, HLSeekMode eSeekMode)
+{
+	CContextScope Scope(*static_cast<CContext *>(pContext));
+
+	return hlStreamSeekEx(pStream, iOffset, eSeekMode);
+}
+
+HLLIB_API hlUInt hlContextStreamRead(HLContext *pContext, HLStream *pStream, hlVoid *lpData, hlUInt uiBytes)
+{
+	CContextScope Scope(*static_cast<CContext *>(pContext));
+
+	return hlStreamRead(pStream, lpData, uiBytes);
+}
+
+HLLIB_API hlUInt hlContextStreamWrite(HLContext *pContext, HLStream *pStream, const hlVoid *lpData, hlUInt uiBytes)
+{
+	CContextScope Scope(*static_cast<CContext *>(pContext));
+
+	return hlStreamWrite(pStream, lpData, uiBytes);
+}
@@ -38,6 +38,11 @@ HLLIB_API hlBool hlItemGetSizeOnDiskEx(const HLDirectoryItem *pItem, hlULongLong
 
 HLLIB_API hlVoid hlItemGetPath(const HLDirectoryItem *pItem, hlChar *lpPath, hlUInt uiPathSize);
 HLLIB_API hlBool hlItemExtract(HLDirectoryItem *pItem, const hlChar *lpPath);
+HLLIB_API hlBool hlItemExtractTar(HLDirectoryItem *pItem, hlInt iFile, hlBool bFinish);
+HLLIB_API hlBool hlItemExtractTarProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish);
+HLLIB_API hlBool hlItemExtractZIP(HLDirectoryItem *pItem, hlInt iFile);
+HLLIB_API hlBool hlItemExtractZIPProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData);
+HLLIB_API hlBool hlItemExtractVPK(HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion);
 
 //
 // Directory Folder
@@ -144,10 +149,73 @@ HLLIB_API hlVoid hlPackageReleaseStream(HLStream *pStream);
 HLLIB_API const hlChar *hlNCFFileGetRootPath();
 HLLIB_API hlVoid hlNCFFileSetRootPath(const hlChar *lpRootPath);
 
+HLLIB_API HLValidation hlVPKFileValidateArchives();
+HLLIB_API hlBool hlVPKFilePinArchive(hlUInt uiArchiveIndex);
+HLLIB_API hlVoid hlVPKFileUnpinArchive(hlUInt uiArchiveIndex);
+HLLIB_API HLDirectoryItem *hlVPKFileFindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
+HLLIB_API HLDirectoryItem *hlXZPFileGetFileByCRC(hlUInt uiFileNameCRC);
+
 HLLIB_API hlBool hlWADFileGetImageSizePaletted(const HLDirectoryItem *pFile, hlUInt *uiPaletteDataSize, hlUInt *uiPixelDataSize);
 HLLIB_API hlBool hlWADFileGetImageDataPaletted(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPaletteData, hlByte **lpPixelData);
 HLLIB_API hlBool hlWADFileGetImageSize(const HLDirectoryItem *pFile, hlUInt *uiPixelDataSize);
 HLLIB_API hlBool hlWADFileGetImageData(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileGetImageMipmapsSize(const HLDirectoryItem *pFile, hlUInt *uiImageCount, hlUInt *uiPixelDataSize);
+HLLIB_API hlBool hlWADFileGetImageMipmaps(const HLDirectoryItem *pFile, HLWADImage *lpImages, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileGetImagesSize(hlUInt *uiImageCount, hlUInt *uiPixelDataSize);
+HLLIB_API hlBool hlWADFileGetImages(HLWADImage *lpImages, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage);
+HLLIB_API hlVoid hlWADFileReleaseImage(HLBorrowedImage *pImage);
+
+HLLIB_API hlBool hlBSPFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage);
+HLLIB_API hlVoid hlBSPFileReleaseImage(HLBorrowedImage *pImage);
+
+//
+// Context Package
+//
+
+HLLIB_API hlBool hlContextCreatePackage(HLContext *pContext, HLPackageType ePackageType, hlUInt *uiPackage);
+HLLIB_API hlVoid hlContextDeletePackage(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API HLPackageType hlContextPackageGetType(HLContext *pContext, hlUInt uiPackage);
+HLLIB_API hlBool hlContextPackageGetOpened(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageOpenFile(HLContext *pContext, hlUInt uiPackage, const hlChar *lpFileName, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenMemory(HLContext *pContext, hlUInt uiPackage, hlVoid *lpData, hlUInt uiBufferSize, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenProc(HLContext *pContext, hlUInt uiPackage, hlVoid *pUserData, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenStream(HLContext *pContext, hlUInt uiPackage, HLStream *pStream, hlUInt uiMode);
+HLLIB_API hlVoid hlContextPackageClose(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageDefragment(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API HLDirectoryItem *hlContextPackageGetRoot(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageGetAttribute(HLContext *pContext, hlUInt uiPackage, HLPackageAttribute eAttribute, HLAttribute *pAttribute);
+HLLIB_API hlBool hlContextPackageGetItemAttribute(HLContext *pContext, const HLDirectoryItem *pItem, HLPackageAttribute eAttribute, HLAttribute *pAttribute);
+
+HLLIB_API hlBool hlContextItemExtract(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpPath);
+HLLIB_API hlBool hlContextItemExtractTarProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish);
+HLLIB_API hlBool hlContextItemExtractZIPProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData);
+HLLIB_API hlBool hlContextItemExtractVPK(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion);
+
+HLLIB_API HLValidation hlContextFileGetValidation(HLContext *pContext, const HLDirectoryItem *pItem);
+HLLIB_API hlBool hlContextFileCreateStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream **pStream);
+HLLIB_API hlVoid hlContextFileReleaseStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream *pStream);
+
+HLLIB_API hlBool hlContextItemGetSizeEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize);
+HLLIB_API hlBool hlContextItemGetSizeOnDiskEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize);
+
+//
+// Context Stream
+//
+
+HLLIB_API hlBool hlContextStreamOpen(HLContext *pContext, HLStream *pStream, hlUInt uiMode);
+HLLIB_API hlVoid hlContextStreamClose(HLContext *pContext, HLStream *pStream);
+
+HLLIB_API hlULongLong hlContextStreamSeekEx(HLContext *pContext, HLStream *pStream, hlLongLong iOffset, HLSeekMode eSeekMode);
+
+HLLIB_API hlUInt hlContextStreamRead(HLContext *pContext, HLStream *pStream, hlVoid *lpData, hlUInt uiBytes);
+HLLIB_API hlUInt hlContextStreamWrite(HLContext *pContext, HLStream *pStream, const hlVoid *lpData, hlUInt uiBytes);
 
 #ifdef __cplusplus
 }
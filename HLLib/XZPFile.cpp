@@ -11,6 +11,7 @@
 
 #include "HLLib.h"
 #include "XZPFile.h"
+#include "DirectoryTreeBuilder.h"
 #include "Streams.h"
 
 using namespace HLLib;
@@ -18,9 +19,10 @@ using namespace HLLib;
 const char *CXZPFile::lpAttributeNames[] = { "Version", "Preload Bytes" };
 const char *CXZPFile::lpItemAttributeNames[] = { "Created", "Preload Bytes" };
 
-CXZPFile::CXZPFile() : CPackage(), pHeaderView(0), pDirectoryEntryView(0), pDirectoryItemView(0), pFooterView(0), pHeader(0), lpDirectoryEntries(0), lpPreloadDirectoryEntries(0), lpPreloadDirectoryMappings(0), lpDirectoryItems(0), pFooter(0)
+CXZPFile::CXZPFile() : CPackage(), pHeaderView(0), pDirectoryEntryView(0), pDirectoryItemView(0), pFooterView(0), pHeader(0), lpDirectoryEntries(0), lpPreloadDirectoryEntries(0), lpPreloadDirectoryMappings(0), lpDirectoryItems(0), pFooter(0), lpFiles(0)
 {
-
+	memset(&this->EntryIndex, 0, sizeof(XZPCRCIndex));
+	memset(&this->ItemIndex, 0, sizeof(XZPCRCIndex));
 }
 
 CXZPFile::~CXZPFile()
@@ -43,6 +45,23 @@ const hlChar *CXZPFile::GetDescription() const
 	return "XBox Package File";
 }
 
+//
+// GetFileByCRC()
+// Gets the file whose name has the CRC uiFileNameCRC, the way the XBox
+// addresses files.  Returns 0 if no such file exists.
+//
+CDirectoryFile *CXZPFile::GetFileByCRC(hlUInt uiFileNameCRC)
+{
+	if(!this->GetOpened() || this->GetRoot() == 0)
+	{
+		return 0;
+	}
+
+	hlUInt uiIndex = this->FindDirectoryEntry(uiFileNameCRC);
+
+	return uiIndex != HL_ID_INVALID ? this->lpFiles[uiIndex] : 0;
+}
+
 hlBool CXZPFile::MapDataStructures()
 {
 	if(sizeof(XZPHeader) > this->pMapping->GetMappingSize())
@@ -110,11 +129,23 @@ hlBool CXZPFile::MapDataStructures()
 		return hlFalse;
 	}
 
+	this->CreateCRCIndex(this->EntryIndex, this->lpDirectoryEntries, sizeof(XZPDirectoryEntry), this->pHeader->uiDirectoryEntryCount);
+	if(this->lpDirectoryItems != 0)
+	{
+		this->CreateCRCIndex(this->ItemIndex, this->lpDirectoryItems, sizeof(XZPDirectoryItem), this->pHeader->uiDirectoryItemCount);
+	}
+
 	return hlTrue;
 }
 
 hlVoid CXZPFile::UnmapDataStructures()
 {
+	delete []this->lpFiles;
+	this->lpFiles = 0;
+
+	this->DeleteCRCIndex(this->ItemIndex);
+	this->DeleteCRCIndex(this->EntryIndex);
+
 	this->pFooter = 0;
 	this->pMapping->Unmap(this->pFooterView);
 
@@ -133,6 +164,9 @@ hlVoid CXZPFile::UnmapDataStructures()
 CDirectoryFolder *CXZPFile::CreateRoot()
 {
 	CDirectoryFolder *pRoot = new CDirectoryFolder(this);
+	CDirectoryTreeBuilder Builder(pRoot);
+
+	this->lpFiles = new CDirectoryFile *[this->pHeader->uiDirectoryEntryCount];
 
 	if(this->pHeader->uiDirectoryItemCount != 0)
 	{
@@ -140,54 +174,18 @@ CDirectoryFolder *CXZPFile::CreateRoot()
 		for(hlUInt i = 0; i < this->pHeader->uiDirectoryEntryCount; i++)
 		{
 			// Find it's info (file name).
-			for(hlUInt j = 0; j < this->pHeader->uiDirectoryItemCount; j++)
+			hlUInt j = this->FindDirectoryItem(this->lpDirectoryEntries[i].uiFileNameCRC);
+			if(j != HL_ID_INVALID)
 			{
-				if(this->lpDirectoryEntries[i].uiFileNameCRC == this->lpDirectoryItems[j].uiFileNameCRC)
-				{
-					hlChar lpFileName[256];
-					strncpy(lpFileName, (hlChar *)this->lpDirectoryItems + this->lpDirectoryItems[j].uiNameOffset - this->pHeader->uiDirectoryItemOffset, sizeof(lpFileName));
-					lpFileName[sizeof(lpFileName) - 1] = '\0';
+				hlChar lpFileName[256];
+				strncpy(lpFileName, (hlChar *)this->lpDirectoryItems + this->lpDirectoryItems[j].uiNameOffset - this->pHeader->uiDirectoryItemOffset, sizeof(lpFileName));
+				lpFileName[sizeof(lpFileName) - 1] = '\0';
 
-					// Check if we have just a file, or if the file has directories we need to create.
-					if(strchr(lpFileName, '/') == 0 && strchr(lpFileName, '\\') == 0)
-					{
-						pRoot->AddFile(lpFileName, i);
-					}
-					else
-					{
-						// Tokenize the file path and create the directories.
-						CDirectoryFolder *pInsertFolder = pRoot;
-
-						hlChar lpTemp[256] = "";
-						hlChar *lpToken = strtok(lpFileName, "/\\");
-						while(lpToken != 0)
-						{
-							strcpy(lpTemp, lpToken);
-
-							lpToken = strtok(0, "/\\");
-
-							if(lpToken != 0)
-							{
-								// Check if the directory exists.
-								CDirectoryItem *pItem = pInsertFolder->GetItem(lpTemp);
-								if(pItem == 0 || pItem->GetType() == HL_ITEM_FILE)
-								{
-									// It doesn't, create it.
-									pInsertFolder = pInsertFolder->AddFolder(lpTemp);
-								}
-								else
-								{
-									// It does, use it.
-									pInsertFolder = static_cast<CDirectoryFolder *>(pItem);
-								}
-							}
-						}
-
-						// The file name is the last token, add it.
-						pInsertFolder->AddFile(lpTemp, i);
-					}
-					break;
-				}
+				this->lpFiles[i] = Builder.AddFile(lpFileName, i);
+			}
+			else
+			{
+				this->lpFiles[i] = 0;
 			}
 		}
 	}
@@ -205,7 +203,7 @@ CDirectoryFolder *CXZPFile::CreateRoot()
 
 			}
 
-			pRoot->AddFile(lpTemp, i);
+			this->lpFiles[i] = pRoot->AddFile(lpTemp, i);
 		}
 	}
 
@@ -269,19 +267,17 @@ hlBool CXZPFile::GetItemAttributeInternal(const CDirectoryItem *pItem, HLPackage
 			{
 				case HL_XZP_ITEM_CREATED:
 				{
-					for(hlUInt i = 0; i < this->pHeader->uiDirectoryItemCount; i++)
+					hlUInt uiIndex = this->FindDirectoryItem(pDirectoryEntry->uiFileNameCRC);
+					if(uiIndex != HL_ID_INVALID)
 					{
-						if(this->lpDirectoryItems[i].uiFileNameCRC == pDirectoryEntry->uiFileNameCRC)
-						{
-							time_t Time = (time_t)this->lpDirectoryItems[i].uiTimeCreated;
-							tm *pTime = localtime(&Time);
+						time_t Time = (time_t)this->lpDirectoryItems[uiIndex].uiTimeCreated;
+						tm *pTime = localtime(&Time);
 
-							hlChar lpTime[128];
-							strftime(lpTime, sizeof(lpTime), "%c", pTime);
+						hlChar lpTime[128];
+						strftime(lpTime, sizeof(lpTime), "%c", pTime);
 
-							hlAttributeSetString(&Attribute, this->lpItemAttributeNames[eAttribute], lpTime);
-							return hlTrue;
-						}
+						hlAttributeSetString(&Attribute, this->lpItemAttributeNames[eAttribute], lpTime);
+						return hlTrue;
 					}
 					break;
 				}
@@ -329,3 +325,69 @@ hlBool CXZPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStr
 
 	return hlTrue;
 }
+
+//
+// CreateCRCIndex()
+// Hashes the file name CRCs of uiCount records uiStride bytes apart, each
+// starting with its CRC.  Chains are ordered by index so lookups find the
+// first record with a given CRC, as the old linear searches did.
+//
+hlVoid CXZPFile::CreateCRCIndex(XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiCount)
+{
+	hlUInt uiBuckets = 16;
+	while(uiBuckets < uiCount)
+	{
+		uiBuckets <<= 1;
+	}
+
+	Index.uiMask = uiBuckets - 1;
+	Index.lpBuckets = new hlUInt[uiBuckets + uiCount];
+	Index.lpNext = Index.lpBuckets + uiBuckets;
+
+	for(hlUInt i = 0; i < uiBuckets; i++)
+	{
+		Index.lpBuckets[i] = HL_ID_INVALID;
+	}
+
+	for(hlUInt i = uiCount; i-- > 0;)
+	{
+		hlUInt uiFileNameCRC = *(const hlUInt *)((const hlByte *)lpFirst + i * uiStride);
+		hlUInt &uiBucket = Index.lpBuckets[(uiFileNameCRC ^ (uiFileNameCRC >> 16)) & Index.uiMask];
+		Index.lpNext[i] = uiBucket;
+		uiBucket = i;
+	}
+}
+
+hlVoid CXZPFile::DeleteCRCIndex(XZPCRCIndex &Index)
+{
+	delete []Index.lpBuckets;
+	Index.uiMask = 0;
+	Index.lpBuckets = 0;
+	Index.lpNext = 0;
+}
+
+hlUInt CXZPFile::FindCRC(const XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiFileNameCRC)
+{
+	if(Index.lpBuckets == 0)
+	{
+		return HL_ID_INVALID;
+	}
+
+	hlUInt i = Index.lpBuckets[(uiFileNameCRC ^ (uiFileNameCRC >> 16)) & Index.uiMask];
+	while(i != HL_ID_INVALID && *(const hlUInt *)((const hlByte *)lpFirst + i * uiStride) != uiFileNameCRC)
+	{
+		i = Index.lpNext[i];
+	}
+
+	return i;
+}
+
+hlUInt CXZPFile::FindDirectoryEntry(hlUInt uiFileNameCRC) const
+{
+	return this->FindCRC(this->EntryIndex, this->lpDirectoryEntries, sizeof(XZPDirectoryEntry), uiFileNameCRC);
+}
+
+hlUInt CXZPFile::FindDirectoryItem(hlUInt uiFileNameCRC) const
+{
+	return this->FindCRC(this->ItemIndex, this->lpDirectoryItems, sizeof(XZPDirectoryItem), uiFileNameCRC);
+}
@@ -62,6 +62,14 @@ namespace HLLib
 
 		#pragma pack()
 
+		// Chained hash of file name CRCs to directory entry or item indices.
+		struct XZPCRCIndex
+		{
+			hlUInt uiMask;
+			hlUInt *lpBuckets;
+			hlUInt *lpNext;
+		};
+
 	private:
 		static const char *lpAttributeNames[];
 		static const char *lpItemAttributeNames[];
@@ -78,6 +86,10 @@ namespace HLLib
 		const XZPDirectoryItem *lpDirectoryItems;
 		const XZPFooter *pFooter;
 
+		XZPCRCIndex EntryIndex;
+		XZPCRCIndex ItemIndex;
+		CDirectoryFile **lpFiles;
+
 	public:
 		CXZPFile();
 		virtual ~CXZPFile();
@@ -86,6 +98,8 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		CDirectoryFile *GetFileByCRC(hlUInt uiFileNameCRC);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -104,6 +118,14 @@ namespace HLLib
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
+
+	private:
+		static hlVoid CreateCRCIndex(XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiCount);
+		static hlVoid DeleteCRCIndex(XZPCRCIndex &Index);
+		static hlUInt FindCRC(const XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiFileNameCRC);
+
+		hlUInt FindDirectoryEntry(hlUInt uiFileNameCRC) const;
+		hlUInt FindDirectoryItem(hlUInt uiFileNameCRC) const;
 	};
 }
 
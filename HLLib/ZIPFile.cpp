@@ -11,6 +11,7 @@
 
 #include "HLLib.h"
 #include "ZIPFile.h"
+#include "DirectoryTreeBuilder.h"
 #include "Streams.h"
 #include "Checksum.h"
 
@@ -19,13 +20,21 @@ using namespace HLLib;
 #define HL_ZIP_LOCAL_FILE_HEADER_SIGNATURE					0x04034b50
 #define HL_ZIP_FILE_HEADER_SIGNATURE						0x02014b50
 #define HL_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE	0x06054b50
+#define HL_ZIP64_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE	0x06064b50
+#define HL_ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE	0x07064b50
+
+#define HL_ZIP64_EXTENDED_INFORMATION_ID					0x0001
+
+#define HL_ZIP_COMPRESSION_STORE							0
+#define HL_ZIP_COMPRESSION_DEFLATE							8
+#define HL_ZIP_COMPRESSION_LZMA								14
 
 #define HL_ZIP_CHECKSUM_LENGTH								0x00008000
 
 const char *CZIPFile::lpAttributeNames[] = { "Disk", "Comment" };
 const char *CZIPFile::lpItemAttributeNames[] = { "Create Version", "Extract Version", "Flags", "Compression Method", "CRC", "Disk", "Comment" };
 
-CZIPFile::CZIPFile() : CPackage(), pFileHeaderView(0), pEndOfCentralDirectoryRecordView(0), pEndOfCentralDirectoryRecord(0)
+CZIPFile::CZIPFile() : CPackage(), pFileHeaderView(0), pEndOfCentralDirectoryRecordView(0), pEndOfCentralDirectoryRecord(0), uiNumberOfThisDisk(0), uiCentralDirectoryOffset(0), uiCentralDirectorySize(0)
 {
 
 }
@@ -58,74 +67,201 @@ hlBool CZIPFile::MapDataStructures()
 		return hlFalse;
 	}
 
+	hlULongLong uiOffset;
+	if(!CZIPFile::FindEndOfCentralDirectoryRecord(*this->pMapping, 0, this->pMapping->GetMappingSize(), uiOffset) && !CZIPFile::ScanEndOfCentralDirectoryRecord(*this->pMapping, 0, this->pMapping->GetMappingSize(), uiOffset))
+	{
+		return hlFalse;
+	}
+
+	Mapping::CView *pTestView = 0;
+
+	if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord)))
+	{
+		return hlFalse;
+	}
+
+	const ZIPEndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIPEndOfCentralDirectoryRecord *>(pTestView->GetView());
+
+	this->pMapping->Unmap(pTestView);
+
+	if(!this->pMapping->Map(this->pEndOfCentralDirectoryRecordView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord) + EndOfCentralDirRecord.uiCommentLength))
+	{
+		return hlFalse;
+	}
+
+	this->pEndOfCentralDirectoryRecord = static_cast<const ZIPEndOfCentralDirectoryRecord *>(this->pEndOfCentralDirectoryRecordView->GetView());
+
+	this->uiNumberOfThisDisk = this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk;
+	this->uiCentralDirectoryOffset = this->pEndOfCentralDirectoryRecord->uiStartOfCentralDirOffset;
+	this->uiCentralDirectorySize = this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize;
+
+	if(!this->ReadZIP64EndOfCentralDirectoryRecord(uiOffset))
+	{
+		return hlFalse;
+	}
+
+	if(!this->pMapping->Map(this->pFileHeaderView, this->uiCentralDirectoryOffset, this->uiCentralDirectorySize))
+	{
+		return hlFalse;
+	}
+
+	return hlTrue;
+}
+
+//
+// FindEndOfCentralDirectoryRecord()
+// The end of central directory record is followed only by the archive comment, so
+// it must start within the last 64 KB + 22 bytes of the archive.  Map that window
+// once and scan it backwards.  The archive is the uiArchiveLength bytes at
+// uiArchiveOffset in Mapping (a VBSP pakfile lump is one); uiOffset is relative to
+// the start of Mapping.
+//
+hlBool CZIPFile::FindEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset)
+{
+	hlUInt uiWindowLength = sizeof(ZIPEndOfCentralDirectoryRecord) + 0xffff;
+	if(static_cast<hlULongLong>(uiWindowLength) > uiArchiveLength)
+	{
+		uiWindowLength = static_cast<hlUInt>(uiArchiveLength);
+	}
+	hlULongLong uiWindowOffset = uiArchiveLength - static_cast<hlULongLong>(uiWindowLength);
+
+	Mapping::CView *pWindowView = 0;
+
+	if(!Mapping.Map(pWindowView, uiArchiveOffset + uiWindowOffset, uiWindowLength))
+	{
+		return hlFalse;
+	}
+
+	const hlByte *lpWindow = static_cast<const hlByte *>(pWindowView->GetView());
+
+	hlBool bFound = hlFalse;
+	for(hlInt i = static_cast<hlInt>(uiWindowLength - sizeof(ZIPEndOfCentralDirectoryRecord)); i >= 0; i--)
+	{
+		const ZIPEndOfCentralDirectoryRecord *pRecord = reinterpret_cast<const ZIPEndOfCentralDirectoryRecord *>(lpWindow + i);
+
+		// Reject signatures that happen to appear inside the comment or the last file.
+		if(pRecord->uiSignature == HL_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE
+			&& static_cast<hlUInt>(i) + sizeof(ZIPEndOfCentralDirectoryRecord) + pRecord->uiCommentLength <= uiWindowLength
+			&& (pRecord->uiStartOfCentralDirOffset == 0xffffffff || pRecord->uiCentralDirectorySize == 0xffffffff
+				|| static_cast<hlULongLong>(pRecord->uiStartOfCentralDirOffset) + static_cast<hlULongLong>(pRecord->uiCentralDirectorySize) <= uiWindowOffset + static_cast<hlULongLong>(i)))
+		{
+			uiOffset = uiArchiveOffset + uiWindowOffset + static_cast<hlULongLong>(i);
+			bFound = hlTrue;
+			break;
+		}
+	}
+
+	Mapping.Unmap(pWindowView);
+
+	return bFound;
+}
+
+//
+// ScanEndOfCentralDirectoryRecord()
+// Recovery path for archives whose tail is damaged or padded: walk every header from
+// the start of the archive until the end of central directory record is reached.
+//
+hlBool CZIPFile::ScanEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset)
+{
 	hlUInt uiTest;
-	hlULongLong uiOffset = 0, uiLength = this->pMapping->GetMappingSize();
-	while(uiOffset < uiLength - sizeof(uiTest))
+	hlULongLong uiEnd = uiArchiveOffset + uiArchiveLength;
+
+	uiOffset = uiArchiveOffset;
+	while(uiOffset < uiEnd - sizeof(uiTest))
 	{
 		Mapping::CView *pTestView = 0;
 
-		if(!this->pMapping->Map(pTestView, uiOffset, sizeof(hlUInt)))
+		if(!Mapping.Map(pTestView, uiOffset, sizeof(hlUInt)))
 		{
 			return hlFalse;
 		}
 
 		uiTest = *(hlUInt *)pTestView->GetView();
 
-		this->pMapping->Unmap(pTestView);
+		Mapping.Unmap(pTestView);
 
 		switch(uiTest)
 		{
 			case HL_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE:
 			{
-				if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord)))
+				return hlTrue;
+			}
+			case HL_ZIP64_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE:
+			{
+				if(!Mapping.Map(pTestView, uiOffset, sizeof(ZIP64EndOfCentralDirectoryRecord)))
 				{
 					return hlFalse;
 				}
 
-				const ZIPEndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIPEndOfCentralDirectoryRecord *>(pTestView->GetView());
+				const ZIP64EndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIP64EndOfCentralDirectoryRecord *>(pTestView->GetView());
 
-				this->pMapping->Unmap(pTestView);
+				Mapping.Unmap(pTestView);
 
-				if(!this->pMapping->Map(this->pEndOfCentralDirectoryRecordView, uiOffset, sizeof(ZIPEndOfCentralDirectoryRecord) + EndOfCentralDirRecord.uiCommentLength))
-				{
-					return hlFalse;
-				}
-
-				this->pEndOfCentralDirectoryRecord = static_cast<const ZIPEndOfCentralDirectoryRecord *>(this->pEndOfCentralDirectoryRecordView->GetView());
-
-				if(!this->pMapping->Map(this->pFileHeaderView, this->pEndOfCentralDirectoryRecord->uiStartOfCentralDirOffset, this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize))
-				{
-					return hlFalse;
-				}
-
-				return hlTrue;
+				// The size excludes the signature and the size field itself.
+				uiOffset += sizeof(hlUInt) + sizeof(hlULongLong) + EndOfCentralDirRecord.uiSizeOfEndOfCentralDirectoryRecord;
+				break;
+			}
+			case HL_ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE:
+			{
+				uiOffset += sizeof(ZIP64EndOfCentralDirectoryLocator);
+				break;
 			}
 			case HL_ZIP_FILE_HEADER_SIGNATURE:
 			{
-				if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPFileHeader)))
+				if(!Mapping.Map(pTestView, uiOffset, sizeof(ZIPFileHeader)))
 				{
 					return hlFalse;
 				}
 
 				const ZIPFileHeader FileHeader = *static_cast<const ZIPFileHeader *>(pTestView->GetView());
 
-				this->pMapping->Unmap(pTestView);
+				Mapping.Unmap(pTestView);
 
 				uiOffset += static_cast<hlULongLong>(sizeof(ZIPFileHeader) + FileHeader.uiFileNameLength + FileHeader.uiExtraFieldLength + FileHeader.uiFileCommentLength);
 				break;
 			}
 			case HL_ZIP_LOCAL_FILE_HEADER_SIGNATURE:
 			{
-				if(!this->pMapping->Map(pTestView, uiOffset, sizeof(ZIPLocalFileHeader)))
+				if(!Mapping.Map(pTestView, uiOffset, sizeof(ZIPLocalFileHeader)))
 				{
 					return hlFalse;
 				}
 
 				const ZIPLocalFileHeader LocalFileHeader = *static_cast<const ZIPLocalFileHeader *>(pTestView->GetView());
 
-				this->pMapping->Unmap(pTestView);
+				Mapping.Unmap(pTestView);
+
+				hlULongLong uiCompressedSize = LocalFileHeader.uiCompressedSize;
+
+				if(uiCompressedSize == 0xffffffff)
+				{
+					// ZIP64, a local header's extended information holds both sizes, compressed second.
+					if(!Mapping.Map(pTestView, uiOffset + sizeof(ZIPLocalFileHeader) + LocalFileHeader.uiFileNameLength, LocalFileHeader.uiExtraFieldLength))
+					{
+						return hlFalse;
+					}
+
+					const hlByte *lpExtraField = static_cast<const hlByte *>(pTestView->GetView());
+					const hlByte *lpExtraFieldEnd = lpExtraField + LocalFileHeader.uiExtraFieldLength;
+
+					while(lpExtraField + sizeof(ZIPExtraField) <= lpExtraFieldEnd)
+					{
+						const ZIPExtraField *pExtraField = reinterpret_cast<const ZIPExtraField *>(lpExtraField);
+						const hlByte *lpData = lpExtraField + sizeof(ZIPExtraField);
+
+						if(pExtraField->uiHeaderID == HL_ZIP64_EXTENDED_INFORMATION_ID && pExtraField->uiDataSize >= 2 * sizeof(hlULongLong) && lpData + 2 * sizeof(hlULongLong) <= lpExtraFieldEnd)
+						{
+							uiCompressedSize = *reinterpret_cast<const hlULongLong *>(lpData + sizeof(hlULongLong));
+							break;
+						}
+
+						lpExtraField = lpData + pExtraField->uiDataSize;
+					}
+
+					Mapping.Unmap(pTestView);
+				}
 
-				uiOffset += static_cast<hlULongLong>(sizeof(ZIPLocalFileHeader) + LocalFileHeader.uiFileNameLength + LocalFileHeader.uiExtraFieldLength + LocalFileHeader.uiCompressedSize);
+				uiOffset += static_cast<hlULongLong>(sizeof(ZIPLocalFileHeader) + LocalFileHeader.uiFileNameLength + LocalFileHeader.uiExtraFieldLength) + uiCompressedSize;
 				break;
 			}
 			default:
@@ -140,6 +276,64 @@ hlBool CZIPFile::MapDataStructures()
 	return hlFalse;
 }
 
+//
+// ReadZIP64EndOfCentralDirectoryRecord()
+// Archives over 4 GB or with more than 65535 entries saturate the end of central
+// directory record's fields and carry the real values in a ZIP64 record, found
+// through the locator that immediately precedes the regular record.
+//
+hlBool CZIPFile::ReadZIP64EndOfCentralDirectoryRecord(hlULongLong uiOffset)
+{
+	if(uiOffset < sizeof(ZIP64EndOfCentralDirectoryLocator))
+	{
+		return hlTrue;
+	}
+
+	Mapping::CView *pTestView = 0;
+
+	if(!this->pMapping->Map(pTestView, uiOffset - sizeof(ZIP64EndOfCentralDirectoryLocator), sizeof(ZIP64EndOfCentralDirectoryLocator)))
+	{
+		return hlFalse;
+	}
+
+	const ZIP64EndOfCentralDirectoryLocator Locator = *static_cast<const ZIP64EndOfCentralDirectoryLocator *>(pTestView->GetView());
+
+	this->pMapping->Unmap(pTestView);
+
+	if(Locator.uiSignature != HL_ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE)
+	{
+		// Not a ZIP64 archive.
+		return hlTrue;
+	}
+
+	if(Locator.uiRelativeOffsetOfEndOfCentralDirectoryRecord + sizeof(ZIP64EndOfCentralDirectoryRecord) > uiOffset - sizeof(ZIP64EndOfCentralDirectoryLocator))
+	{
+		LastError.SetErrorMessage("Invalid file: the ZIP64 end of central directory record is out of range.");
+		return hlFalse;
+	}
+
+	if(!this->pMapping->Map(pTestView, Locator.uiRelativeOffsetOfEndOfCentralDirectoryRecord, sizeof(ZIP64EndOfCentralDirectoryRecord)))
+	{
+		return hlFalse;
+	}
+
+	const ZIP64EndOfCentralDirectoryRecord EndOfCentralDirRecord = *static_cast<const ZIP64EndOfCentralDirectoryRecord *>(pTestView->GetView());
+
+	this->pMapping->Unmap(pTestView);
+
+	if(EndOfCentralDirRecord.uiSignature != HL_ZIP64_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE)
+	{
+		LastError.SetErrorMessage("Invalid file: the ZIP64 end of central directory record's signature does not match.");
+		return hlFalse;
+	}
+
+	this->uiNumberOfThisDisk = EndOfCentralDirRecord.uiNumberOfThisDisk;
+	this->uiCentralDirectoryOffset = EndOfCentralDirRecord.uiStartOfCentralDirOffset;
+	this->uiCentralDirectorySize = EndOfCentralDirRecord.uiCentralDirectorySize;
+
+	return hlTrue;
+}
+
 hlVoid CZIPFile::UnmapDataStructures()
 {
 	this->pMapping->Unmap(this->pFileHeaderView);
@@ -151,9 +345,11 @@ hlVoid CZIPFile::UnmapDataStructures()
 CDirectoryFolder *CZIPFile::CreateRoot()
 {
 	CDirectoryFolder *pRoot = new CDirectoryFolder(this);
+	CDirectoryTreeBuilder Builder(pRoot);
 
-	hlUInt uiTest, uiOffset = 0;
-	while(uiOffset < this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize - sizeof(uiTest))
+	hlUInt uiTest;
+	hlULongLong uiOffset = 0;
+	while(uiOffset + sizeof(uiTest) <= this->uiCentralDirectorySize)
 	{
 		uiTest = *(hlUInt *)((hlByte *)this->pFileHeaderView->GetView() + uiOffset);
 
@@ -167,44 +363,7 @@ CDirectoryFolder *CZIPFile::CreateRoot()
 				memcpy(lpFileName, (hlByte *)pFileHeader + sizeof(ZIPFileHeader), pFileHeader->uiFileNameLength);
 				lpFileName[pFileHeader->uiFileNameLength] = '\0';
 
-				// Check if we have just a file, or if the file has directories we need to create.
-				if(strchr(lpFileName, '/') == 0 && strchr(lpFileName, '\\') == 0)
-				{
-					pRoot->AddFile(lpFileName, HL_ID_INVALID, pFileHeader);
-				}
-				else
-				{
-					// Tokenize the file path and create the directories.
-					CDirectoryFolder *pInsertFolder = pRoot;
-
-					hlChar lpTemp[256] = "";
-					hlChar *lpToken = strtok(lpFileName, "/\\");
-					while(lpToken != 0)
-					{
-						strcpy(lpTemp, lpToken);
-
-						lpToken = strtok(0, "/\\");
-
-						if(lpToken != 0)
-						{
-							// Check if the directory exists.
-							CDirectoryItem *pItem = pInsertFolder->GetItem(lpTemp);
-							if(pItem == 0 || pItem->GetType() == HL_ITEM_FILE)
-							{
-								// It doesn't, create it.
-								pInsertFolder = pInsertFolder->AddFolder(lpTemp);
-							}
-							else
-							{
-								// It does, use it.
-								pInsertFolder = static_cast<CDirectoryFolder *>(pItem);
-							}
-						}
-					}
-
-					// The file name is the last token, add it.
-					pInsertFolder->AddFile(lpTemp, HL_ID_INVALID, pFileHeader);
-				}
+				Builder.AddFile(lpFileName, HL_ID_INVALID, pFileHeader);
 
 				delete []lpFileName;
 
@@ -213,7 +372,7 @@ CDirectoryFolder *CZIPFile::CreateRoot()
 			}
 			default:
 			{
-				uiOffset = this->pEndOfCentralDirectoryRecord->uiCentralDirectorySize;
+				uiOffset = this->uiCentralDirectorySize;
 				break;
 			}
 		}
@@ -243,7 +402,7 @@ hlBool CZIPFile::GetAttributeInternal(HLPackageAttribute eAttribute, HLAttribute
 	{
 		case HL_ZIP_PACKAGE_DISK:
 		{
-			hlAttributeSetUnsignedInteger(&Attribute, this->lpAttributeNames[eAttribute], this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk, hlFalse);
+			hlAttributeSetUnsignedInteger(&Attribute, this->lpAttributeNames[eAttribute], this->uiNumberOfThisDisk, hlFalse);
 			return hlTrue;
 		}
 		case HL_ZIP_PACKAGE_COMMENT:
@@ -316,7 +475,10 @@ hlBool CZIPFile::GetItemAttributeInternal(const CDirectoryItem *pItem, HLPackage
 				}
 				case HL_ZIP_ITEM_DISK:
 				{
-					hlAttributeSetUnsignedInteger(&Attribute, this->lpItemAttributeNames[eAttribute], pDirectoryItem->uiDiskNumberStart, hlFalse);
+					ZIPFileInfo FileInfo;
+					this->GetFileInfo(pDirectoryItem, FileInfo);
+
+					hlAttributeSetUnsignedInteger(&Attribute, this->lpItemAttributeNames[eAttribute], FileInfo.uiDiskNumberStart, hlFalse);
 					return hlTrue;
 				}
 				case HL_ZIP_ITEM_COMMENT:
@@ -342,7 +504,10 @@ hlBool CZIPFile::GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool
 {
 	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-	bExtractable = pDirectoryItem->uiCompressionMethod == 0 && pDirectoryItem->uiDiskNumberStart == this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk;
+	ZIPFileInfo FileInfo;
+	this->GetFileInfo(pDirectoryItem, FileInfo);
+
+	bExtractable = this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod) && FileInfo.uiDiskNumberStart == this->uiNumberOfThisDisk;
 
 	return hlTrue;
 }
@@ -351,67 +516,134 @@ hlBool CZIPFile::GetFileValidationInternal(const CDirectoryFile *pFile, HLValida
 {
 	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-	if(pDirectoryItem->uiCompressionMethod != 0 || pDirectoryItem->uiDiskNumberStart != this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk)
+	ZIPFileInfo FileInfo;
+	this->GetFileInfo(pDirectoryItem, FileInfo);
+
+	if(!this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod) || FileInfo.uiDiskNumberStart != this->uiNumberOfThisDisk)
 	{
 		eValidation = HL_VALIDATES_ASSUMED_OK;
 		return hlTrue;
 	}
 
-	hlULong uiChecksum = 0;
 	Streams::IStream *pStream = 0;
 	if(const_cast<CZIPFile *>(this)->CreateStreamInternal(pFile, pStream))
 	{
 		if(pStream->Open(HL_MODE_READ))
 		{
-			hlULongLong uiTotalBytes = 0, uiFileBytes = pStream->GetStreamSize();
-			hlUInt uiBufferSize;
-			hlByte lpBuffer[HL_ZIP_CHECKSUM_LENGTH];
-
-			hlBool bCancel = hlFalse;
-			hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+			Streams::CReadAheadStream Input(*pStream, this->GetContext().bReadAhead);
 
-			while((uiBufferSize = pStream->Read(lpBuffer, sizeof(lpBuffer))) != 0)
+			if(Input.Open(HL_MODE_READ))
 			{
-				if(bCancel)
-				{
-					eValidation = HL_VALIDATES_CANCELED;
-					break;
-				}
-
-				uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
-
-				uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+				this->ValidateStreamInternal(pFile, Input, eValidation);
 
-				hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+				Input.Close();
+			}
+			else
+			{
+				eValidation = HL_VALIDATES_ERROR;
 			}
 
 			pStream->Close();
 		}
+		else
+		{
+			eValidation = HL_VALIDATES_ERROR;
+		}
 
 		const_cast<CZIPFile *>(this)->ReleaseStreamInternal(*pStream);
 		delete pStream;
 	}
+	else
+	{
+		eValidation = HL_VALIDATES_ERROR;
+	}
+
+	return hlTrue;
+}
+
+hlBool CZIPFile::ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const
+{
+	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
+
+	hlULong uiChecksum = 0;
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Stream.GetStreamSize();
+	hlUInt uiBufferSize;
+	hlByte lpBuffer[HL_ZIP_CHECKSUM_LENGTH];
+
+	hlBool bCancel = hlFalse;
+	hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+
+	while((uiBufferSize = Stream.Read(lpBuffer, sizeof(lpBuffer))) != 0)
+	{
+		if(bCancel)
+		{
+			eValidation = HL_VALIDATES_CANCELED;
+			return hlTrue;
+		}
+
+		uiChecksum = CRC32(lpBuffer, uiBufferSize, uiChecksum);
+
+		uiTotalBytes += static_cast<hlULongLong>(uiBufferSize);
+
+		hlValidateFileProgress(const_cast<CDirectoryFile *>(pFile), uiTotalBytes, uiFileBytes, &bCancel);
+	}
 
 	eValidation = (hlULong)pDirectoryItem->uiCRC32 == uiChecksum ? HL_VALIDATES_OK : HL_VALIDATES_CORRUPT;
 
 	return hlTrue;
 }
 
+//
+// GetFileSizeInternal()
+// Sizes that don't fit are reported as 0xffffffff, use GetFileSizeEx() for those.
+//
 hlBool CZIPFile::GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
-	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
+	hlULongLong uiSizeEx;
+	this->GetFileSizeExInternal(pFile, uiSizeEx);
 
-	uiSize = pDirectoryItem->uiUncompressedSize;
+	uiSize = uiSizeEx > 0xffffffff ? 0xffffffff : static_cast<hlUInt>(uiSizeEx);
 
 	return hlTrue;
 }
 
 hlBool CZIPFile::GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const
 {
-	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
+	hlULongLong uiSizeEx;
+	this->GetFileSizeOnDiskExInternal(pFile, uiSizeEx);
 
-	uiSize = pDirectoryItem->uiCompressedSize;
+	uiSize = uiSizeEx > 0xffffffff ? 0xffffffff : static_cast<hlUInt>(uiSizeEx);
+
+	return hlTrue;
+}
+
+hlBool CZIPFile::GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	ZIPFileInfo FileInfo;
+	this->GetFileInfo(static_cast<const ZIPFileHeader *>(pFile->GetData()), FileInfo);
+
+	uiSize = FileInfo.uiUncompressedSize;
+
+	return hlTrue;
+}
+
+hlBool CZIPFile::GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const
+{
+	ZIPFileInfo FileInfo;
+	this->GetFileInfo(static_cast<const ZIPFileHeader *>(pFile->GetData()), FileInfo);
+
+	uiSize = FileInfo.uiCompressedSize;
+
+	return hlTrue;
+}
 
+//
+// GetConcurrentExtractionInternal()
+// Every entry gets its own mapping stream or decoder over its own views of the
+// mapping, so entries can be extracted side by side.
+//
+hlBool CZIPFile::GetConcurrentExtractionInternal() const
+{
 	return hlTrue;
 }
 
@@ -419,21 +651,24 @@ hlBool CZIPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStr
 {
 	const ZIPFileHeader *pDirectoryItem = static_cast<const ZIPFileHeader *>(pFile->GetData());
 
-	if(pDirectoryItem->uiCompressionMethod != 0)
+	if(!this->GetCompressionSupported(pDirectoryItem->uiCompressionMethod))
 	{
 		LastError.SetErrorMessageFormated("Compression format %#.2x not supported.", pDirectoryItem->uiCompressionMethod);
 		return hlFalse;
 	}
 
-	if(pDirectoryItem->uiDiskNumberStart != this->pEndOfCentralDirectoryRecord->uiNumberOfThisDisk)
+	ZIPFileInfo FileInfo;
+	this->GetFileInfo(pDirectoryItem, FileInfo);
+
+	if(FileInfo.uiDiskNumberStart != this->uiNumberOfThisDisk)
 	{
-		LastError.SetErrorMessageFormated("File resides on disk %u.", pDirectoryItem->uiDiskNumberStart);
+		LastError.SetErrorMessageFormated("File resides on disk %u.", FileInfo.uiDiskNumberStart);
 		return hlFalse;
 	}
 
 	Mapping::CView *pDirectoryEnrtyView = 0;
 
-	if(!this->pMapping->Map(pDirectoryEnrtyView, pDirectoryItem->uiRelativeOffsetOfLocalHeader, sizeof(ZIPLocalFileHeader)))
+	if(!this->pMapping->Map(pDirectoryEnrtyView, FileInfo.uiRelativeOffsetOfLocalHeader, sizeof(ZIPLocalFileHeader)))
 	{
 		return hlFalse;
 	}
@@ -448,7 +683,143 @@ hlBool CZIPFile::CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStr
 		return hlFalse;
 	}
 
-	pStream = new Streams::CMappingStream(*this->pMapping, pDirectoryItem->uiRelativeOffsetOfLocalHeader + sizeof(ZIPLocalFileHeader) + DirectoryEntry.uiFileNameLength + DirectoryEntry.uiExtraFieldLength, DirectoryEntry.uiUncompressedSize);
+	// Sizes come from the central directory, the local header's are zero when a data descriptor is used.
+	hlULongLong uiDataOffset = FileInfo.uiRelativeOffsetOfLocalHeader + sizeof(ZIPLocalFileHeader) + DirectoryEntry.uiFileNameLength + DirectoryEntry.uiExtraFieldLength;
+
+	switch(pDirectoryItem->uiCompressionMethod)
+	{
+	case HL_ZIP_COMPRESSION_STORE:
+		pStream = new Streams::CMappingStream(*this->pMapping, uiDataOffset, FileInfo.uiUncompressedSize);
+		break;
+#ifdef USE_ZLIB
+	case HL_ZIP_COMPRESSION_DEFLATE:
+		pStream = new Streams::CInflateStream(*this->pMapping, uiDataOffset, FileInfo.uiCompressedSize, FileInfo.uiUncompressedSize);
+		break;
+#endif
+#ifdef USE_LZMA
+	case HL_ZIP_COMPRESSION_LZMA:
+		return CZIPFile::CreateLZMAStream(*this->pMapping, uiDataOffset, FileInfo.uiCompressedSize, FileInfo.uiUncompressedSize, pStream);
+#endif
+	}
+
+	return hlTrue;
+}
+
+//
+// CreateLZMAStream()
+// Method 14 entries: the LZMA data is preceded by a small header holding the LZMA
+// properties.  uiDataOffset is where the entry's data starts in Mapping.
+//
+hlBool CZIPFile::CreateLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiDataOffset, hlULongLong uiCompressedSize, hlULongLong uiUncompressedSize, Streams::IStream *&pStream)
+{
+#ifdef USE_LZMA
+	if(uiCompressedSize < sizeof(ZIPLZMAHeader) + HL_LZMA_PROPERTIES_SIZE)
+	{
+		LastError.SetErrorMessage("Invalid LZMA header: the file data is too small.");
+		return hlFalse;
+	}
+
+	Mapping::CView *pLZMAHeaderView = 0;
+
+	if(!Mapping.Map(pLZMAHeaderView, uiDataOffset, sizeof(ZIPLZMAHeader) + HL_LZMA_PROPERTIES_SIZE))
+	{
+		return hlFalse;
+	}
+
+	const ZIPLZMAHeader *pLZMAHeader = static_cast<const ZIPLZMAHeader *>(pLZMAHeaderView->GetView());
+
+	if(pLZMAHeader->uiPropertiesSize != HL_LZMA_PROPERTIES_SIZE)
+	{
+		LastError.SetErrorMessageFormated("Invalid LZMA header: unsupported properties size %u.", static_cast<hlUInt>(pLZMAHeader->uiPropertiesSize));
+		Mapping.Unmap(pLZMAHeaderView);
+		return hlFalse;
+	}
+
+	hlUInt uiHeaderSize = sizeof(ZIPLZMAHeader) + HL_LZMA_PROPERTIES_SIZE;
+	pStream = new Streams::CLZMAStream(Mapping, uiDataOffset + uiHeaderSize, uiCompressedSize - uiHeaderSize, (const hlByte *)pLZMAHeader + sizeof(ZIPLZMAHeader), uiUncompressedSize);
+
+	Mapping.Unmap(pLZMAHeaderView);
 
 	return hlTrue;
+#else
+	LastError.SetErrorMessageFormated("Compression format %#.2x not supported.", HL_ZIP_COMPRESSION_LZMA);
+	return hlFalse;
+#endif
+}
+
+hlBool CZIPFile::GetCompressionSupported(hlUInt uiCompressionMethod) const
+{
+	switch(uiCompressionMethod)
+	{
+	case HL_ZIP_COMPRESSION_STORE:
+#ifdef USE_ZLIB
+	case HL_ZIP_COMPRESSION_DEFLATE:
+#endif
+#ifdef USE_LZMA
+	case HL_ZIP_COMPRESSION_LZMA:
+#endif
+		return hlTrue;
+	default:
+		return hlFalse;
+	}
+}
+
+//
+// GetFileInfo()
+// Fields of a central directory entry that don't fit are saturated and stored in the
+// ZIP64 extended information extra field instead, which holds only those fields, in
+// order.
+//
+hlVoid CZIPFile::GetFileInfo(const ZIPFileHeader *pFileHeader, ZIPFileInfo &FileInfo) const
+{
+	FileInfo.uiUncompressedSize = pFileHeader->uiUncompressedSize;
+	FileInfo.uiCompressedSize = pFileHeader->uiCompressedSize;
+	FileInfo.uiRelativeOffsetOfLocalHeader = pFileHeader->uiRelativeOffsetOfLocalHeader;
+	FileInfo.uiDiskNumberStart = pFileHeader->uiDiskNumberStart;
+
+	if(pFileHeader->uiUncompressedSize != 0xffffffff && pFileHeader->uiCompressedSize != 0xffffffff && pFileHeader->uiRelativeOffsetOfLocalHeader != 0xffffffff && pFileHeader->uiDiskNumberStart != 0xffff)
+	{
+		return;
+	}
+
+	const hlByte *lpExtraField = (const hlByte *)pFileHeader + sizeof(ZIPFileHeader) + pFileHeader->uiFileNameLength;
+	const hlByte *lpExtraFieldEnd = lpExtraField + pFileHeader->uiExtraFieldLength;
+
+	while(lpExtraField + sizeof(ZIPExtraField) <= lpExtraFieldEnd)
+	{
+		const ZIPExtraField *pExtraField = reinterpret_cast<const ZIPExtraField *>(lpExtraField);
+		const hlByte *lpData = lpExtraField + sizeof(ZIPExtraField);
+		const hlByte *lpDataEnd = lpData + pExtraField->uiDataSize;
+
+		if(lpDataEnd > lpExtraFieldEnd)
+		{
+			break;
+		}
+
+		if(pExtraField->uiHeaderID == HL_ZIP64_EXTENDED_INFORMATION_ID)
+		{
+			if(pFileHeader->uiUncompressedSize == 0xffffffff && lpData + sizeof(hlULongLong) <= lpDataEnd)
+			{
+				FileInfo.uiUncompressedSize = *reinterpret_cast<const hlULongLong *>(lpData);
+				lpData += sizeof(hlULongLong);
+			}
+			if(pFileHeader->uiCompressedSize == 0xffffffff && lpData + sizeof(hlULongLong) <= lpDataEnd)
+			{
+				FileInfo.uiCompressedSize = *reinterpret_cast<const hlULongLong *>(lpData);
+				lpData += sizeof(hlULongLong);
+			}
+			if(pFileHeader->uiRelativeOffsetOfLocalHeader == 0xffffffff && lpData + sizeof(hlULongLong) <= lpDataEnd)
+			{
+				FileInfo.uiRelativeOffsetOfLocalHeader = *reinterpret_cast<const hlULongLong *>(lpData);
+				lpData += sizeof(hlULongLong);
+			}
+			if(pFileHeader->uiDiskNumberStart == 0xffff && lpData + sizeof(hlUInt) <= lpDataEnd)
+			{
+				FileInfo.uiDiskNumberStart = *reinterpret_cast<const hlUInt *>(lpData);
+			}
+			break;
+		}
+
+		lpExtraField = lpDataEnd;
+	}
 }
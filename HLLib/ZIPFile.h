@@ -35,6 +35,29 @@ namespace HLLib
 			// zip file comment follows
 		};
 
+		struct ZIP64EndOfCentralDirectoryLocator
+		{
+			hlUInt uiSignature; // 4 bytes (0x07064b50)
+			hlUInt uiNumberOfTheDiskWithStartOfEndOfCentralDirectory; // 4 bytes
+			hlULongLong uiRelativeOffsetOfEndOfCentralDirectoryRecord; // 8 bytes
+			hlUInt uiTotalNumberOfDisks; // 4 bytes
+		};
+
+		struct ZIP64EndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature; // 4 bytes (0x06064b50)
+			hlULongLong uiSizeOfEndOfCentralDirectoryRecord; // 8 bytes
+			hlUInt16 uiVersionMadeBy; // 2 bytes
+			hlUInt16 uiVersionNeededToExtract; // 2 bytes
+			hlUInt uiNumberOfThisDisk; // 4 bytes
+			hlUInt uiNumberOfTheDiskWithStartOfCentralDirectory; // 4 bytes
+			hlULongLong uiCentralDirectoryEntriesThisDisk; // 8 bytes
+			hlULongLong uiCentralDirectoryEntriesTotal; // 8 bytes
+			hlULongLong uiCentralDirectorySize; // 8 bytes
+			hlULongLong uiStartOfCentralDirOffset; // 8 bytes
+			// zip64 extensible data sector follows
+		};
+
 		struct ZIPFileHeader
 		{
 			hlUInt uiSignature; //  4 bytes (0x02014b50) 
@@ -77,8 +100,31 @@ namespace HLLib
 			// file data (variable size) 
 		};
 
+		struct ZIPLZMAHeader
+		{
+			hlUInt16 uiVersion; // LZMA SDK version 2 bytes 
+			hlUInt16 uiPropertiesSize; // properties size 2 bytes 
+			// properties (variable size) 
+			// LZMA data (variable size) 
+		};
+
+		struct ZIPExtraField
+		{
+			hlUInt16 uiHeaderID; // header id 2 bytes 
+			hlUInt16 uiDataSize; // data size 2 bytes 
+			// data (variable size) 
+		};
+
 		#pragma pack()
 
+		struct ZIPFileInfo
+		{
+			hlULongLong uiUncompressedSize;
+			hlULongLong uiCompressedSize;
+			hlULongLong uiRelativeOffsetOfLocalHeader;
+			hlUInt uiDiskNumberStart;
+		};
+
 	private:
 		static const char *lpAttributeNames[];
 		static const char *lpItemAttributeNames[];
@@ -88,6 +134,10 @@ namespace HLLib
 
 		const ZIPEndOfCentralDirectoryRecord *pEndOfCentralDirectoryRecord;
 
+		hlUInt uiNumberOfThisDisk;
+		hlULongLong uiCentralDirectoryOffset;
+		hlULongLong uiCentralDirectorySize;
+
 	public:
 		CZIPFile();
 		virtual ~CZIPFile();
@@ -112,10 +162,28 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
+		virtual hlBool GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		virtual hlBool GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		virtual hlBool GetConcurrentExtractionInternal() const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
+
+	public:
+		// Also used by CVBSPFile, whose pakfile lump is a ZIP archive.
+		static hlBool FindEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset);
+		static hlBool ScanEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset);
+		static hlBool CreateLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiDataOffset, hlULongLong uiCompressedSize, hlULongLong uiUncompressedSize, Streams::IStream *&pStream);
+
+	private:
+		hlBool ReadZIP64EndOfCentralDirectoryRecord(hlULongLong uiOffset);
+
+		hlVoid GetFileInfo(const ZIPFileHeader *pFileHeader, ZIPFileInfo &FileInfo) const;
+
+		hlBool GetCompressionSupported(hlUInt uiCompressionMethod) const;
 	};
 }
 
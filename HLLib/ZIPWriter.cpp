@@ -0,0 +1,859 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#include "HLLib.h"
+#include "ZIPWriter.h"
+#include "Checksum.h"
+#include "Context.h"
+#include "InputPool.h"
+#include "Package.h"
+#include "ReadAheadStream.h"
+#include "Thread.h"
+#include "Utility.h"
+
+#include <time.h>
+
+#ifdef USE_ZLIB
+#	include <zlib.h>
+#endif
+
+using namespace HLLib;
+
+#define HL_ZIP_LOCAL_FILE_HEADER_SIGNATURE					0x04034b50
+#define HL_ZIP_FILE_HEADER_SIGNATURE						0x02014b50
+#define HL_ZIP_DATA_DESCRIPTOR_SIGNATURE					0x08074b50
+#define HL_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE	0x06054b50
+#define HL_ZIP64_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE	0x06064b50
+#define HL_ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE	0x07064b50
+
+#define HL_ZIP64_EXTENDED_INFORMATION_ID					0x0001
+
+#define HL_ZIP_COMPRESSION_STORE							0
+#define HL_ZIP_COMPRESSION_DEFLATE							8
+
+#define HL_ZIP_VERSION										20	// 2.0: folders and Deflate.
+#define HL_ZIP_VERSION_ZIP64								45	// 4.5: ZIP64.
+
+#define HL_ZIP_FLAG_DATA_DESCRIPTOR							0x0008
+#define HL_ZIP_ATTRIBUTE_DIRECTORY							0x00000010
+
+// Streamed entries above this size get ZIP64 sizes up front, leaving Deflate room to grow the data.
+#define HL_ZIP_WRITER_ZIP64_THRESHOLD						0xf0000000ULL
+
+struct CZIPWriter::ZIPWriterEntry : public InputPoolJob
+{
+	hlChar *lpPath;
+	hlBool bFolder;
+	const CDirectoryItem *pItem;
+	Streams::IStream *pInput;
+
+	hlUInt16 uiFlags;
+	hlUInt16 uiCompressionMethod;
+	hlUInt uiCRC32;
+	hlULongLong uiUncompressedSize;
+	hlULongLong uiCompressedSize;
+	hlULongLong uiRelativeOffsetOfLocalHeader;
+
+	// Entries compressed in memory, possibly by a worker.
+	hlBool bBuffered;
+	hlByte *lpData;
+};
+
+static hlVoid GetDOSDateTime(hlUInt16 &uiTime, hlUInt16 &uiDate)
+{
+	time_t Time = time(0);
+	const struct tm *pTime = localtime(&Time);
+
+	if(pTime == 0 || pTime->tm_year < 80)
+	{
+		// 1980-01-01 00:00:00, the earliest DOS date.
+		uiTime = 0;
+		uiDate = (1 << 5) | 1;
+		return;
+	}
+
+	uiTime = static_cast<hlUInt16>((pTime->tm_hour << 11) | (pTime->tm_min << 5) | (pTime->tm_sec / 2));
+	uiDate = static_cast<hlUInt16>(((pTime->tm_year - 80) << 9) | ((pTime->tm_mon + 1) << 5) | pTime->tm_mday);
+}
+
+//
+// CZIPWriter
+// Writes a ZIP archive to a stream or write callback.  Entries are queued with
+// Add*() and written by Finish(): small entries are read, checksummed and
+// compressed in memory on a pool of worker threads, a bounded number ahead of
+// the entry being written, while larger ones are streamed through the writing
+// thread with a data descriptor.  Output is written strictly in order and never
+// seeks, so the sink can be a pipe.
+//
+
+CZIPWriter::CZIPWriter(Streams::IStream &Stream) : pStream(&Stream), pWriteProc(0), pUserData(0), uiBytesWritten(0), uiLastModifiedTime(0), uiLastModifiedDate(0), iCompressionLevel(-1), pEntries(new CZIPWriterEntryVector())
+{
+	GetDOSDateTime(this->uiLastModifiedTime, this->uiLastModifiedDate);
+}
+
+CZIPWriter::CZIPWriter(PWriteProc pWriteProc, hlVoid *pUserData) : pStream(0), pWriteProc(pWriteProc), pUserData(pUserData), uiBytesWritten(0), uiLastModifiedTime(0), uiLastModifiedDate(0), iCompressionLevel(-1), pEntries(new CZIPWriterEntryVector())
+{
+	GetDOSDateTime(this->uiLastModifiedTime, this->uiLastModifiedDate);
+}
+
+CZIPWriter::~CZIPWriter()
+{
+	this->DeleteEntries();
+
+	delete this->pEntries;
+}
+
+hlInt CZIPWriter::GetCompressionLevel() const
+{
+	return this->iCompressionLevel;
+}
+
+//
+// SetCompressionLevel()
+// 0 stores entries, 1 to 9 trade speed for size and -1 uses the Deflate
+// default.  Entries are always stored if HLLib is built without zlib.
+//
+hlVoid CZIPWriter::SetCompressionLevel(hlInt iCompressionLevel)
+{
+	if(iCompressionLevel < -1)
+	{
+		iCompressionLevel = -1;
+	}
+	else if(iCompressionLevel > 9)
+	{
+		iCompressionLevel = 9;
+	}
+
+	this->iCompressionLevel = iCompressionLevel;
+}
+
+hlULongLong CZIPWriter::GetBytesWritten() const
+{
+	return this->uiBytesWritten;
+}
+
+//
+// Add()
+// Queues pItem and, if it is a folder, everything below it.  Entry paths start
+// with pItem's name, mirroring the layout CDirectoryItem::Extract() creates.
+//
+hlBool CZIPWriter::Add(const CDirectoryItem *pItem)
+{
+	return this->Add(0, pItem);
+}
+
+hlBool CZIPWriter::Add(const hlChar *lpPath, const CDirectoryItem *pItem)
+{
+	hlChar *lpName = new hlChar[strlen(pItem->GetName()) + 1];
+	strcpy(lpName, pItem->GetName());
+	RemoveIllegalCharacters(lpName);
+
+	hlChar *lpItemPath;
+	if(lpPath == 0 || *lpPath == '\0')
+	{
+		lpItemPath = new hlChar[strlen(lpName) + 1];
+		strcpy(lpItemPath, lpName);
+	}
+	else
+	{
+		lpItemPath = new hlChar[strlen(lpPath) + 1 + strlen(lpName) + 1];
+		strcpy(lpItemPath, lpPath);
+		strcat(lpItemPath, "/");
+		strcat(lpItemPath, lpName);
+	}
+
+	hlBool bResult = hlTrue;
+	switch(pItem->GetType())
+	{
+		case HL_ITEM_FOLDER:
+		{
+			const CDirectoryFolder *pFolder = static_cast<const CDirectoryFolder *>(pItem);
+
+			this->AddEntry(lpItemPath, hlTrue, pItem, 0, 0);
+			for(hlUInt i = 0; bResult && i < pFolder->GetCount(); i++)
+			{
+				bResult = this->Add(lpItemPath, pFolder->GetItem(i));
+			}
+			break;
+		}
+		case HL_ITEM_FILE:
+		{
+			bResult = this->AddFile(lpItemPath, static_cast<const CDirectoryFile *>(pItem));
+			break;
+		}
+	}
+
+	delete []lpItemPath;
+	delete []lpName;
+
+	return bResult;
+}
+
+hlBool CZIPWriter::AddFolder(const hlChar *lpPath)
+{
+	this->AddEntry(lpPath, hlTrue, 0, 0, 0);
+
+	return hlTrue;
+}
+
+hlBool CZIPWriter::AddFile(const hlChar *lpPath, const CDirectoryFile *pFile)
+{
+	hlULongLong uiSize = 0;
+	if(!pFile->GetSizeEx(uiSize))
+	{
+		return hlFalse;
+	}
+
+	this->AddEntry(lpPath, hlFalse, pFile, 0, uiSize);
+
+	return hlTrue;
+}
+
+//
+// AddFile()
+// Queues an opened stream, read from its current position to its end.  The
+// stream must stay open until Finish() returns.
+//
+hlBool CZIPWriter::AddFile(const hlChar *lpPath, Streams::IStream &Input)
+{
+	if(!Input.GetOpened())
+	{
+		LastError.SetErrorMessage("Stream not open.");
+		return hlFalse;
+	}
+
+	this->AddEntry(lpPath, hlFalse, 0, &Input, Input.GetStreamSize() - Input.GetStreamPointer());
+
+	return hlTrue;
+}
+
+hlVoid CZIPWriter::AddEntry(const hlChar *lpPath, hlBool bFolder, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize)
+{
+	while(*lpPath == '/' || *lpPath == '\\')
+	{
+		lpPath++;
+	}
+
+	ZIPWriterEntry *pEntry = new ZIPWriterEntry();
+
+	// Folder entries end in a slash; all separators are forward slashes.
+	hlUInt uiPathLength = static_cast<hlUInt>(strlen(lpPath));
+	pEntry->lpPath = new hlChar[uiPathLength + 2];
+	strcpy(pEntry->lpPath, lpPath);
+	for(hlChar *lpSeparator = strchr(pEntry->lpPath, '\\'); lpSeparator != 0; lpSeparator = strchr(lpSeparator + 1, '\\'))
+	{
+		*lpSeparator = '/';
+	}
+	if(bFolder && (uiPathLength == 0 || pEntry->lpPath[uiPathLength - 1] != '/'))
+	{
+		strcat(pEntry->lpPath, "/");
+	}
+
+	pEntry->bFolder = bFolder;
+	pEntry->pItem = pItem;
+	pEntry->pInput = pInput;
+	pEntry->uiFlags = 0;
+	pEntry->uiCompressionMethod = HL_ZIP_COMPRESSION_STORE;
+	pEntry->uiCRC32 = 0;
+	pEntry->uiUncompressedSize = uiSize;
+	pEntry->uiCompressedSize = 0;
+	pEntry->uiRelativeOffsetOfLocalHeader = 0;
+	pEntry->bBuffered = !bFolder && uiSize <= HL_ZIP_WRITER_BUFFER_SIZE;
+	pEntry->bClaimed = hlFalse;
+	pEntry->bWorker = hlFalse;
+	pEntry->lpData = 0;
+	pEntry->bResult = hlFalse;
+	pEntry->pError = 0;
+	pEntry->pDone = pEntry->bBuffered ? new Threading::CSemaphore(0) : 0;
+
+	this->pEntries->push_back(pEntry);
+}
+
+hlVoid CZIPWriter::DeleteEntries()
+{
+	for(CZIPWriterEntryVector::iterator i = this->pEntries->begin(); i != this->pEntries->end(); ++i)
+	{
+		ZIPWriterEntry *pEntry = *i;
+
+		delete []pEntry->lpPath;
+		delete []pEntry->lpData;
+		delete pEntry->pError;
+		delete pEntry->pDone;
+		delete pEntry;
+	}
+
+	this->pEntries->clear();
+}
+
+//
+// Finish()
+// Writes all queued entries followed by the central directory.  Stops on the
+// first failure; the output can't be rewound.
+//
+hlBool CZIPWriter::Finish()
+{
+	CZIPWriterEntryVector &Entries = *this->pEntries;
+
+	CInputPoolJobVector Jobs;
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+	{
+		if(Entries[i]->bBuffered)
+		{
+			Jobs.push_back(Entries[i]);
+		}
+	}
+
+	hlBool bResult = hlTrue;
+	{
+		CInputPool Pool(Jobs, CZIPWriter::CompressProc, this);
+
+		for(hlUInt i = 0; bResult && i < static_cast<hlUInt>(Entries.size()); i++)
+		{
+			ZIPWriterEntry &Entry = *Entries[i];
+
+			Pool.Wait(Entry);
+
+			bResult = this->WriteEntry(Entry);
+
+			delete []Entry.lpData;
+			Entry.lpData = 0;
+
+			Pool.Release(Entry);
+		}
+	}
+
+	if(bResult)
+	{
+		bResult = this->WriteCentralDirectory();
+	}
+
+	this->DeleteEntries();
+
+	return bResult;
+}
+
+hlBool CZIPWriter::CompressProc(InputPoolJob &Job, const hlVoid *pUserData)
+{
+	return static_cast<const CZIPWriter *>(pUserData)->CompressEntry(static_cast<ZIPWriterEntry &>(Job));
+}
+
+//
+// CompressEntry()
+// Reads a buffered entry into memory, checksums it and compresses it, keeping
+// it stored if Deflate doesn't make it smaller.  Safe to call from several
+// threads for different entries.
+//
+hlBool CZIPWriter::CompressEntry(ZIPWriterEntry &Entry) const
+{
+	Streams::IStream *pInput = CInputPool::OpenInput(Entry.pItem, Entry.pInput);
+	if(pInput == 0)
+	{
+		return hlFalse;
+	}
+
+	hlUInt uiSize = static_cast<hlUInt>(Entry.uiUncompressedSize);
+	hlByte *lpBuffer = new hlByte[uiSize > 0 ? uiSize : 1];
+
+	hlUInt uiTotalBytes = 0;
+	while(uiTotalBytes < uiSize)
+	{
+		hlUInt uiBytes = pInput->Read(lpBuffer + uiTotalBytes, uiSize - uiTotalBytes);
+		if(uiBytes == 0)
+		{
+			break;
+		}
+		uiTotalBytes += uiBytes;
+	}
+
+	CInputPool::CloseInput(Entry.pItem, Entry.pInput, pInput);
+
+	if(uiTotalBytes != uiSize)
+	{
+		LastError.SetErrorMessage("Unexpected end of input stream.");
+		delete []lpBuffer;
+		return hlFalse;
+	}
+
+	Entry.uiCRC32 = static_cast<hlUInt>(CRC32(lpBuffer, uiSize));
+	Entry.uiCompressionMethod = HL_ZIP_COMPRESSION_STORE;
+	Entry.uiCompressedSize = static_cast<hlULongLong>(uiSize);
+	Entry.lpData = lpBuffer;
+
+#ifdef USE_ZLIB
+	if(this->iCompressionLevel != 0 && uiSize > 0)
+	{
+		z_stream Stream;
+		memset(&Stream, 0, sizeof(Stream));
+
+		if(deflateInit2(&Stream, this->iCompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			LastError.SetErrorMessage("Error initializing Deflate compressor.");
+			return hlFalse;
+		}
+
+		hlUInt uiBound = static_cast<hlUInt>(deflateBound(&Stream, uiSize));
+		hlByte *lpCompressed = new hlByte[uiBound];
+
+		Stream.next_in = lpBuffer;
+		Stream.avail_in = uiSize;
+		Stream.next_out = lpCompressed;
+		Stream.avail_out = uiBound;
+
+		if(deflate(&Stream, Z_FINISH) == Z_STREAM_END && Stream.total_out < uiSize)
+		{
+			delete []lpBuffer;
+
+			Entry.uiCompressionMethod = HL_ZIP_COMPRESSION_DEFLATE;
+			Entry.uiCompressedSize = static_cast<hlULongLong>(Stream.total_out);
+			Entry.lpData = lpCompressed;
+		}
+		else
+		{
+			delete []lpCompressed;
+		}
+
+		deflateEnd(&Stream);
+	}
+#endif
+
+	return hlTrue;
+}
+
+//
+// WriteEntry()
+// Writes an entry's local header and data.  Buffered entries must already be
+// compressed; other files are compressed here as they are written and followed
+// by a data descriptor.
+//
+hlBool CZIPWriter::WriteEntry(ZIPWriterEntry &Entry)
+{
+	if(Entry.pItem != 0)
+	{
+		hlExtractItemStart(Entry.pItem);
+	}
+
+	Entry.uiRelativeOffsetOfLocalHeader = this->uiBytesWritten;
+
+	hlULongLong uiTotalBytes = 0, uiFileBytes = Entry.uiUncompressedSize;
+	hlBool bCancel = hlFalse;
+
+	hlBool bResult = hlFalse;
+	if(Entry.bFolder)
+	{
+		bResult = this->WriteLocalFileHeader(Entry, hlFalse);
+	}
+	else if(Entry.bBuffered)
+	{
+		if(!Entry.bResult)
+		{
+			LastError = *Entry.pError;
+		}
+		else if(this->WriteLocalFileHeader(Entry, hlFalse) && this->WriteData(Entry.lpData, static_cast<hlUInt>(Entry.uiCompressedSize)))
+		{
+			bResult = hlTrue;
+
+			if(Entry.pItem != 0)
+			{
+				hlExtractFileProgress(Entry.pItem, 0, uiFileBytes, &bCancel);
+				hlExtractFileProgress(Entry.pItem, uiFileBytes, uiFileBytes, &bCancel);
+			}
+		}
+	}
+	else
+	{
+		hlBool bZIP64 = uiFileBytes > HL_ZIP_WRITER_ZIP64_THRESHOLD;
+
+		Entry.uiFlags |= HL_ZIP_FLAG_DATA_DESCRIPTOR;
+#ifdef USE_ZLIB
+		Entry.uiCompressionMethod = this->iCompressionLevel != 0 ? HL_ZIP_COMPRESSION_DEFLATE : HL_ZIP_COMPRESSION_STORE;
+#else
+		Entry.uiCompressionMethod = HL_ZIP_COMPRESSION_STORE;
+#endif
+
+		Streams::IStream *pInput = CInputPool::OpenInput(Entry.pItem, Entry.pInput);
+
+		if(pInput != 0 && this->WriteLocalFileHeader(Entry, bZIP64))
+		{
+#ifdef USE_ZLIB
+			z_stream Stream;
+			memset(&Stream, 0, sizeof(Stream));
+
+			hlBool bDeflate = Entry.uiCompressionMethod == HL_ZIP_COMPRESSION_DEFLATE;
+			if(bDeflate && deflateInit2(&Stream, this->iCompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				LastError.SetErrorMessage("Error initializing Deflate compressor.");
+			}
+			else
+#endif
+			{
+				Streams::CReadAheadStream Input(*pInput);
+
+				if(Input.Open(HL_MODE_READ))
+				{
+					hlByte *lpBuffer = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE];
+#ifdef USE_ZLIB
+					hlByte *lpCompressed = new hlByte[HL_DEFAULT_COPY_BUFFER_SIZE];
+#endif
+
+					hlULong uiCRC32 = 0;
+
+					if(Entry.pItem != 0)
+					{
+						hlExtractFileProgress(Entry.pItem, uiTotalBytes, uiFileBytes, &bCancel);
+					}
+
+					bResult = hlTrue;
+					while(bResult)
+					{
+						if(bCancel)
+						{
+							LastError.SetErrorMessage("Canceled by user.");
+							bResult = hlFalse;
+							break;
+						}
+
+						hlUInt uiBytes = 0;
+						if(uiTotalBytes < uiFileBytes)
+						{
+							uiBytes = HL_DEFAULT_COPY_BUFFER_SIZE;
+							if(static_cast<hlULongLong>(uiBytes) > uiFileBytes - uiTotalBytes)
+							{
+								uiBytes = static_cast<hlUInt>(uiFileBytes - uiTotalBytes);
+							}
+
+							uiBytes = Input.Read(lpBuffer, uiBytes);
+
+							if(uiBytes == 0)
+							{
+								LastError.SetErrorMessage("Unexpected end of input stream.");
+								bResult = hlFalse;
+								break;
+							}
+
+							// Checksum the data while it is still hot in the cache.
+							uiCRC32 = CRC32(lpBuffer, uiBytes, uiCRC32);
+							uiTotalBytes += static_cast<hlULongLong>(uiBytes);
+						}
+
+						hlBool bFinish = uiTotalBytes == uiFileBytes;
+
+#ifdef USE_ZLIB
+						if(bDeflate)
+						{
+							Stream.next_in = lpBuffer;
+							Stream.avail_in = uiBytes;
+
+							hlInt iResult;
+							do
+							{
+								Stream.next_out = lpCompressed;
+								Stream.avail_out = HL_DEFAULT_COPY_BUFFER_SIZE;
+
+								iResult = deflate(&Stream, bFinish ? Z_FINISH : Z_NO_FLUSH);
+
+								hlUInt uiCompressed = HL_DEFAULT_COPY_BUFFER_SIZE - Stream.avail_out;
+								if(uiCompressed > 0 && !this->WriteData(lpCompressed, uiCompressed))
+								{
+									bResult = hlFalse;
+									break;
+								}
+							} while(Stream.avail_out == 0 || (bFinish && iResult == Z_OK));
+
+							if(bFinish)
+							{
+								Entry.uiCompressedSize = static_cast<hlULongLong>(Stream.total_out);
+							}
+						}
+						else
+#endif
+						{
+							if(uiBytes > 0 && !this->WriteData(lpBuffer, uiBytes))
+							{
+								bResult = hlFalse;
+							}
+
+							Entry.uiCompressedSize = uiTotalBytes;
+						}
+
+						if(Entry.pItem != 0 && uiBytes > 0)
+						{
+							hlExtractFileProgress(Entry.pItem, uiTotalBytes, uiFileBytes, &bCancel);
+						}
+
+						if(bFinish)
+						{
+							break;
+						}
+					}
+
+					Entry.uiCRC32 = static_cast<hlUInt>(uiCRC32);
+
+#ifdef USE_ZLIB
+					delete []lpCompressed;
+#endif
+					delete []lpBuffer;
+
+					Input.Close();
+				}
+
+#ifdef USE_ZLIB
+				if(bDeflate)
+				{
+					deflateEnd(&Stream);
+				}
+#endif
+			}
+
+			if(bResult)
+			{
+				if(bZIP64)
+				{
+					ZIP64DataDescriptor DataDescriptor;
+					DataDescriptor.uiSignature = HL_ZIP_DATA_DESCRIPTOR_SIGNATURE;
+					DataDescriptor.uiCRC32 = Entry.uiCRC32;
+					DataDescriptor.uiCompressedSize = Entry.uiCompressedSize;
+					DataDescriptor.uiUncompressedSize = Entry.uiUncompressedSize;
+
+					bResult = this->WriteData(&DataDescriptor, sizeof(DataDescriptor));
+				}
+				else if(Entry.uiCompressedSize >= 0xffffffff)
+				{
+					LastError.SetErrorMessage("Compressed entry too large for its data descriptor.");
+					bResult = hlFalse;
+				}
+				else
+				{
+					ZIPDataDescriptor DataDescriptor;
+					DataDescriptor.uiSignature = HL_ZIP_DATA_DESCRIPTOR_SIGNATURE;
+					DataDescriptor.uiCRC32 = Entry.uiCRC32;
+					DataDescriptor.uiCompressedSize = static_cast<hlUInt>(Entry.uiCompressedSize);
+					DataDescriptor.uiUncompressedSize = static_cast<hlUInt>(Entry.uiUncompressedSize);
+
+					bResult = this->WriteData(&DataDescriptor, sizeof(DataDescriptor));
+				}
+			}
+		}
+
+		CInputPool::CloseInput(Entry.pItem, Entry.pInput, pInput);
+	}
+
+	if(bResult && bCancel)
+	{
+		LastError.SetErrorMessage("Canceled by user.");
+		bResult = hlFalse;
+	}
+
+	if(Entry.pItem != 0)
+	{
+		hlExtractItemEnd(Entry.pItem, bResult);
+	}
+
+	return bResult;
+}
+
+hlBool CZIPWriter::WriteLocalFileHeader(const ZIPWriterEntry &Entry, hlBool bZIP64)
+{
+	hlUInt16 uiFileNameLength = static_cast<hlUInt16>(strlen(Entry.lpPath));
+
+	ZIPLocalFileHeader Header;
+	Header.uiSignature = HL_ZIP_LOCAL_FILE_HEADER_SIGNATURE;
+	Header.uiVersionNeededToExtract = bZIP64 ? HL_ZIP_VERSION_ZIP64 : HL_ZIP_VERSION;
+	Header.uiFlags = Entry.uiFlags;
+	Header.uiCompressionMethod = Entry.uiCompressionMethod;
+	Header.uiLastModifiedTime = this->uiLastModifiedTime;
+	Header.uiLastModifiedDate = this->uiLastModifiedDate;
+	if(Entry.uiFlags & HL_ZIP_FLAG_DATA_DESCRIPTOR)
+	{
+		// Filled in by the data descriptor.
+		Header.uiCRC32 = 0;
+		Header.uiCompressedSize = bZIP64 ? 0xffffffff : 0;
+		Header.uiUncompressedSize = bZIP64 ? 0xffffffff : 0;
+	}
+	else
+	{
+		Header.uiCRC32 = Entry.uiCRC32;
+		Header.uiCompressedSize = static_cast<hlUInt>(Entry.uiCompressedSize);
+		Header.uiUncompressedSize = static_cast<hlUInt>(Entry.uiUncompressedSize);
+	}
+	Header.uiFileNameLength = uiFileNameLength;
+	Header.uiExtraFieldLength = bZIP64 ? 4 + 2 * sizeof(hlULongLong) : 0;
+
+	if(!this->WriteData(&Header, sizeof(Header)) || !this->WriteData(Entry.lpPath, uiFileNameLength))
+	{
+		return hlFalse;
+	}
+
+	if(bZIP64)
+	{
+		hlByte lpExtraField[4 + 2 * sizeof(hlULongLong)];
+		memset(lpExtraField, 0, sizeof(lpExtraField));
+		*reinterpret_cast<hlUInt16 *>(lpExtraField) = HL_ZIP64_EXTENDED_INFORMATION_ID;
+		*reinterpret_cast<hlUInt16 *>(lpExtraField + 2) = 2 * sizeof(hlULongLong);
+
+		return this->WriteData(lpExtraField, sizeof(lpExtraField));
+	}
+
+	return hlTrue;
+}
+
+hlBool CZIPWriter::WriteCentralDirectory()
+{
+	const CZIPWriterEntryVector &Entries = *this->pEntries;
+
+	hlULongLong uiCentralDirectoryOffset = this->uiBytesWritten;
+
+	for(hlUInt i = 0; i < static_cast<hlUInt>(Entries.size()); i++)
+	{
+		const ZIPWriterEntry &Entry = *Entries[i];
+
+		hlUInt16 uiFileNameLength = static_cast<hlUInt16>(strlen(Entry.lpPath));
+
+		ZIPFileHeader Header;
+		Header.uiSignature = HL_ZIP_FILE_HEADER_SIGNATURE;
+		Header.uiFlags = Entry.uiFlags;
+		Header.uiCompressionMethod = Entry.uiCompressionMethod;
+		Header.uiLastModifiedTime = this->uiLastModifiedTime;
+		Header.uiLastModifiedDate = this->uiLastModifiedDate;
+		Header.uiCRC32 = Entry.uiCRC32;
+		Header.uiFileNameLength = uiFileNameLength;
+		Header.uiFileCommentLength = 0;
+		Header.uiDiskNumberStart = 0;
+		Header.uiInternalFileAttribs = 0;
+		Header.uiExternalFileAttribs = Entry.bFolder ? HL_ZIP_ATTRIBUTE_DIRECTORY : 0;
+
+		// Values that don't fit move to the ZIP64 extra field, in this order.
+		hlByte lpExtraField[4 + 3 * sizeof(hlULongLong)];
+		hlUInt16 uiExtraFieldLength = 4;
+
+		if(Entry.uiUncompressedSize >= 0xffffffff)
+		{
+			Header.uiUncompressedSize = 0xffffffff;
+			memcpy(lpExtraField + uiExtraFieldLength, &Entry.uiUncompressedSize, sizeof(hlULongLong));
+			uiExtraFieldLength += sizeof(hlULongLong);
+		}
+		else
+		{
+			Header.uiUncompressedSize = static_cast<hlUInt>(Entry.uiUncompressedSize);
+		}
+
+		if(Entry.uiCompressedSize >= 0xffffffff)
+		{
+			Header.uiCompressedSize = 0xffffffff;
+			memcpy(lpExtraField + uiExtraFieldLength, &Entry.uiCompressedSize, sizeof(hlULongLong));
+			uiExtraFieldLength += sizeof(hlULongLong);
+		}
+		else
+		{
+			Header.uiCompressedSize = static_cast<hlUInt>(Entry.uiCompressedSize);
+		}
+
+		if(Entry.uiRelativeOffsetOfLocalHeader >= 0xffffffff)
+		{
+			Header.uiRelativeOffsetOfLocalHeader = 0xffffffff;
+			memcpy(lpExtraField + uiExtraFieldLength, &Entry.uiRelativeOffsetOfLocalHeader, sizeof(hlULongLong));
+			uiExtraFieldLength += sizeof(hlULongLong);
+		}
+		else
+		{
+			Header.uiRelativeOffsetOfLocalHeader = static_cast<hlUInt>(Entry.uiRelativeOffsetOfLocalHeader);
+		}
+
+		if(uiExtraFieldLength > 4)
+		{
+			*reinterpret_cast<hlUInt16 *>(lpExtraField) = HL_ZIP64_EXTENDED_INFORMATION_ID;
+			*reinterpret_cast<hlUInt16 *>(lpExtraField + 2) = uiExtraFieldLength - 4;
+		}
+		else
+		{
+			uiExtraFieldLength = 0;
+		}
+
+		Header.uiVersionNeededToExtract = uiExtraFieldLength > 0 || Entry.uiUncompressedSize > HL_ZIP_WRITER_ZIP64_THRESHOLD ? HL_ZIP_VERSION_ZIP64 : HL_ZIP_VERSION;
+		Header.uiVersionMadeBy = Header.uiVersionNeededToExtract;
+		Header.uiExtraFieldLength = uiExtraFieldLength;
+
+		if(!this->WriteData(&Header, sizeof(Header)) || !this->WriteData(Entry.lpPath, uiFileNameLength) || !this->WriteData(lpExtraField, uiExtraFieldLength))
+		{
+			return hlFalse;
+		}
+	}
+
+	hlULongLong uiCentralDirectorySize = this->uiBytesWritten - uiCentralDirectoryOffset;
+	hlULongLong uiEntries = static_cast<hlULongLong>(Entries.size());
+
+	if(uiEntries >= 0xffff || uiCentralDirectorySize >= 0xffffffff || uiCentralDirectoryOffset >= 0xffffffff)
+	{
+		ZIP64EndOfCentralDirectoryRecord Record;
+		Record.uiSignature = HL_ZIP64_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE;
+		Record.uiSizeOfEndOfCentralDirectoryRecord = sizeof(Record) - sizeof(Record.uiSignature) - sizeof(Record.uiSizeOfEndOfCentralDirectoryRecord);
+		Record.uiVersionMadeBy = HL_ZIP_VERSION_ZIP64;
+		Record.uiVersionNeededToExtract = HL_ZIP_VERSION_ZIP64;
+		Record.uiNumberOfThisDisk = 0;
+		Record.uiNumberOfTheDiskWithStartOfCentralDirectory = 0;
+		Record.uiCentralDirectoryEntriesThisDisk = uiEntries;
+		Record.uiCentralDirectoryEntriesTotal = uiEntries;
+		Record.uiCentralDirectorySize = uiCentralDirectorySize;
+		Record.uiStartOfCentralDirOffset = uiCentralDirectoryOffset;
+
+		ZIP64EndOfCentralDirectoryLocator Locator;
+		Locator.uiSignature = HL_ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE;
+		Locator.uiNumberOfTheDiskWithStartOfEndOfCentralDirectory = 0;
+		Locator.uiRelativeOffsetOfEndOfCentralDirectoryRecord = this->uiBytesWritten;
+		Locator.uiTotalNumberOfDisks = 1;
+
+		if(!this->WriteData(&Record, sizeof(Record)) || !this->WriteData(&Locator, sizeof(Locator)))
+		{
+			return hlFalse;
+		}
+	}
+
+	ZIPEndOfCentralDirectoryRecord Record;
+	Record.uiSignature = HL_ZIP_END_OF_CENTRAL_DIRECTORY_RECORD_SIGNATURE;
+	Record.uiNumberOfThisDisk = 0;
+	Record.uiNumberOfTheDiskWithStartOfCentralDirectory = 0;
+	Record.uiCentralDirectoryEntriesThisDisk = uiEntries >= 0xffff ? 0xffff : static_cast<hlUInt16>(uiEntries);
+	Record.uiCentralDirectoryEntriesTotal = Record.uiCentralDirectoryEntriesThisDisk;
+	Record.uiCentralDirectorySize = uiCentralDirectorySize >= 0xffffffff ? 0xffffffff : static_cast<hlUInt>(uiCentralDirectorySize);
+	Record.uiStartOfCentralDirOffset = uiCentralDirectoryOffset >= 0xffffffff ? 0xffffffff : static_cast<hlUInt>(uiCentralDirectoryOffset);
+	Record.uiCommentLength = 0;
+
+	return this->WriteData(&Record, sizeof(Record));
+}
+
+hlBool CZIPWriter::WriteData(const hlVoid *lpData, hlUInt uiBytes)
+{
+	const hlByte *lpBytes = static_cast<const hlByte *>(lpData);
+
+	while(uiBytes > 0)
+	{
+		hlUInt uiBytesWritten;
+		if(this->pStream != 0)
+		{
+			uiBytesWritten = this->pStream->Write(lpBytes, uiBytes);
+		}
+		else
+		{
+			uiBytesWritten = this->pWriteProc(lpBytes, uiBytes, this->pUserData);
+		}
+
+		if(uiBytesWritten == 0)
+		{
+			LastError.SetErrorMessage("Error writing zip stream.");
+			return hlFalse;
+		}
+
+		lpBytes += uiBytesWritten;
+		uiBytes -= uiBytesWritten;
+		this->uiBytesWritten += static_cast<hlULongLong>(uiBytesWritten);
+	}
+
+	return hlTrue;
+}
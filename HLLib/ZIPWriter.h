@@ -0,0 +1,173 @@
+/*
+ * HLLib
+ * Copyright (C) 2006-2010 Ryan Gregg
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later
+ * version.
+ */
+
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include "stdafx.h"
+#include "DirectoryItems.h"
+#include "Stream.h"
+
+// Entries up to this size are compressed in memory by worker threads; larger
+// ones are compressed straight to the output by the writing thread.
+#define HL_ZIP_WRITER_BUFFER_SIZE 16777216
+
+namespace HLLib
+{
+	struct InputPoolJob;
+
+	class HLLIB_API CZIPWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct ZIPLocalFileHeader
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt16 uiFlags;
+			hlUInt16 uiCompressionMethod;
+			hlUInt16 uiLastModifiedTime;
+			hlUInt16 uiLastModifiedDate;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+			hlUInt16 uiFileNameLength;
+			hlUInt16 uiExtraFieldLength;
+		};
+
+		struct ZIPFileHeader
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiVersionMadeBy;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt16 uiFlags;
+			hlUInt16 uiCompressionMethod;
+			hlUInt16 uiLastModifiedTime;
+			hlUInt16 uiLastModifiedDate;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+			hlUInt16 uiFileNameLength;
+			hlUInt16 uiExtraFieldLength;
+			hlUInt16 uiFileCommentLength;
+			hlUInt16 uiDiskNumberStart;
+			hlUInt16 uiInternalFileAttribs;
+			hlUInt uiExternalFileAttribs;
+			hlUInt uiRelativeOffsetOfLocalHeader;
+		};
+
+		struct ZIPDataDescriptor
+		{
+			hlUInt uiSignature;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+		};
+
+		struct ZIP64DataDescriptor
+		{
+			hlUInt uiSignature;
+			hlUInt uiCRC32;
+			hlULongLong uiCompressedSize;
+			hlULongLong uiUncompressedSize;
+		};
+
+		struct ZIPEndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiNumberOfThisDisk;
+			hlUInt16 uiNumberOfTheDiskWithStartOfCentralDirectory;
+			hlUInt16 uiCentralDirectoryEntriesThisDisk;
+			hlUInt16 uiCentralDirectoryEntriesTotal;
+			hlUInt uiCentralDirectorySize;
+			hlUInt uiStartOfCentralDirOffset;
+			hlUInt16 uiCommentLength;
+		};
+
+		struct ZIP64EndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature;
+			hlULongLong uiSizeOfEndOfCentralDirectoryRecord;
+			hlUInt16 uiVersionMadeBy;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt uiNumberOfThisDisk;
+			hlUInt uiNumberOfTheDiskWithStartOfCentralDirectory;
+			hlULongLong uiCentralDirectoryEntriesThisDisk;
+			hlULongLong uiCentralDirectoryEntriesTotal;
+			hlULongLong uiCentralDirectorySize;
+			hlULongLong uiStartOfCentralDirOffset;
+		};
+
+		struct ZIP64EndOfCentralDirectoryLocator
+		{
+			hlUInt uiSignature;
+			hlUInt uiNumberOfTheDiskWithStartOfEndOfCentralDirectory;
+			hlULongLong uiRelativeOffsetOfEndOfCentralDirectoryRecord;
+			hlUInt uiTotalNumberOfDisks;
+		};
+
+		#pragma pack()
+
+		struct ZIPWriterEntry;
+
+		typedef std::vector<ZIPWriterEntry *> CZIPWriterEntryVector;
+
+	private:
+		Streams::IStream *pStream;
+		PWriteProc pWriteProc;
+		hlVoid *pUserData;
+
+		hlULongLong uiBytesWritten;
+		hlUInt16 uiLastModifiedTime;
+		hlUInt16 uiLastModifiedDate;
+
+		hlInt iCompressionLevel;
+
+		CZIPWriterEntryVector *pEntries;
+
+	public:
+		CZIPWriter(Streams::IStream &Stream);
+		CZIPWriter(PWriteProc pWriteProc, hlVoid *pUserData);
+		~CZIPWriter();
+
+		hlInt GetCompressionLevel() const;
+		hlVoid SetCompressionLevel(hlInt iCompressionLevel);
+
+		hlULongLong GetBytesWritten() const;
+
+		hlBool Add(const CDirectoryItem *pItem);
+		hlBool AddFolder(const hlChar *lpPath);
+		hlBool AddFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool AddFile(const hlChar *lpPath, Streams::IStream &Input);
+
+		hlBool Finish();
+
+	private:
+		hlBool Add(const hlChar *lpPath, const CDirectoryItem *pItem);
+		hlVoid AddEntry(const hlChar *lpPath, hlBool bFolder, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize);
+		hlVoid DeleteEntries();
+
+		static hlBool CompressProc(InputPoolJob &Job, const hlVoid *pUserData);
+		hlBool CompressEntry(ZIPWriterEntry &Entry) const;
+		hlBool WriteEntry(ZIPWriterEntry &Entry);
+		hlBool WriteCentralDirectory();
+
+		hlBool WriteLocalFileHeader(const ZIPWriterEntry &Entry, hlBool bZIP64);
+		hlBool WriteData(const hlVoid *lpData, hlUInt uiBytes);
+
+	private:
+		CZIPWriter(const CZIPWriter &);
+		CZIPWriter &operator=(const CZIPWriter &);
+	};
+}
+
+#endif
@@ -68,6 +68,9 @@ typedef hlSingle		hlFloat;
 #define HL_DEFAULT_PACKAGE_TEST_BUFFER_SIZE 8
 #define HL_DEFAULT_VIEW_SIZE 131072
 #define HL_DEFAULT_COPY_BUFFER_SIZE 131072
+#define HL_DEFAULT_ARCHIVE_HANDLE_LIMIT 64
+#define HL_DEFAULT_STREAM_CACHE_SIZE 16777216
+#define HL_READ_AHEAD_BUFFER_COUNT 4
 
 #ifdef __cplusplus
 extern "C" {
@@ -104,7 +107,12 @@ typedef enum
 	HL_PROC_DEFRAGMENT_PROGRESS_EX,
 	HL_PROC_SEEK_EX,
 	HL_PROC_TELL_EX,
-	HL_PROC_SIZE_EX
+	HL_PROC_SIZE_EX,
+	HL_SKIP_UNCHANGED_FILES,
+	HL_READ_AHEAD,
+	HL_EXTRACT_THREAD_COUNT,
+	HL_ARCHIVE_HANDLE_LIMIT,
+	HL_STREAM_CACHE_SIZE
 } HLOption;
 
 typedef enum
@@ -164,7 +172,12 @@ typedef enum
 	HL_STREAM_MAPPING,
 	HL_STREAM_MEMORY,
 	HL_STREAM_PROC,
-	HL_STREAM_NULL
+	HL_STREAM_NULL,
+	HL_STREAM_READ_AHEAD,
+	HL_STREAM_INFLATE,
+	HL_STREAM_LZMA,
+	HL_STREAM_CONCATENATED,
+	HL_STREAM_LZSS
 } HLStreamType;
 
 typedef enum
@@ -301,6 +314,13 @@ typedef enum
 	HL_VALIDATES_ERROR
 } HLValidation;
 
+typedef enum
+{
+	HL_SKIP_NONE = 0,
+	HL_SKIP_SIZE,
+	HL_SKIP_CHECKSUM
+} HLSkipMode;
+
 typedef struct
 {
 	HLAttributeType eAttributeType;
@@ -333,6 +353,27 @@ typedef struct
 
 typedef hlVoid HLDirectoryItem;
 typedef hlVoid HLStream;
+typedef hlVoid HLContext;
+
+typedef struct
+{
+	const HLDirectoryItem *pFile;
+	hlUInt uiMipmap;
+	hlUInt uiWidth;
+	hlUInt uiHeight;
+	hlUInt uiOffset;
+} HLWADImage;
+
+typedef struct
+{
+	hlUInt uiWidth;
+	hlUInt uiHeight;
+	hlUInt uiMipmapCount;
+	hlUInt uiPaletteSize;
+	const hlByte *lpPalette;
+	const hlByte *lpMipmaps[4];
+	hlVoid *pHandle;
+} HLBorrowedImage;
 
 typedef hlBool (*POpenProc) (hlUInt, hlVoid *);
 typedef hlVoid (*PCloseProc)(hlVoid *);
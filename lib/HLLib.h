@@ -68,6 +68,9 @@ typedef hlSingle		hlFloat;
 #define HL_DEFAULT_PACKAGE_TEST_BUFFER_SIZE 8
 #define HL_DEFAULT_VIEW_SIZE 131072
 #define HL_DEFAULT_COPY_BUFFER_SIZE 131072
+#define HL_DEFAULT_ARCHIVE_HANDLE_LIMIT 64
+#define HL_DEFAULT_STREAM_CACHE_SIZE 16777216
+#define HL_READ_AHEAD_BUFFER_COUNT 4
 
 //
 // C data types.
@@ -108,7 +111,12 @@ typedef enum
 	HL_PROC_DEFRAGMENT_PROGRESS_EX,
 	HL_PROC_SEEK_EX,
 	HL_PROC_TELL_EX,
-	HL_PROC_SIZE_EX
+	HL_PROC_SIZE_EX,
+	HL_SKIP_UNCHANGED_FILES,
+	HL_READ_AHEAD,
+	HL_EXTRACT_THREAD_COUNT,
+	HL_ARCHIVE_HANDLE_LIMIT,
+	HL_STREAM_CACHE_SIZE
 } HLOption;
 
 typedef enum
@@ -168,7 +176,12 @@ typedef enum
 	HL_STREAM_MAPPING,
 	HL_STREAM_MEMORY,
 	HL_STREAM_PROC,
-	HL_STREAM_NULL
+	HL_STREAM_NULL,
+	HL_STREAM_READ_AHEAD,
+	HL_STREAM_INFLATE,
+	HL_STREAM_LZMA,
+	HL_STREAM_CONCATENATED,
+	HL_STREAM_LZSS
 } HLStreamType;
 
 typedef enum
@@ -305,6 +318,13 @@ typedef enum
 	HL_VALIDATES_ERROR
 } HLValidation;
 
+typedef enum
+{
+	HL_SKIP_NONE = 0,
+	HL_SKIP_SIZE,
+	HL_SKIP_CHECKSUM
+} HLSkipMode;
+
 typedef struct
 {
 	HLAttributeType eAttributeType;
@@ -337,6 +357,27 @@ typedef struct
 
 typedef hlVoid HLDirectoryItem;
 typedef hlVoid HLStream;
+typedef hlVoid HLContext;
+
+typedef struct
+{
+	const HLDirectoryItem *pFile;
+	hlUInt uiMipmap;
+	hlUInt uiWidth;
+	hlUInt uiHeight;
+	hlUInt uiOffset;
+} HLWADImage;
+
+typedef struct
+{
+	hlUInt uiWidth;
+	hlUInt uiHeight;
+	hlUInt uiMipmapCount;
+	hlUInt uiPaletteSize;
+	const hlByte *lpPalette;
+	const hlByte *lpMipmaps[4];
+	hlVoid *pHandle;
+} HLBorrowedImage;
 
 typedef hlBool (*POpenProc) (hlUInt, hlVoid *);
 typedef hlVoid (*PCloseProc)(hlVoid *);
@@ -406,6 +447,27 @@ HLLIB_API const hlVoid *hlGetVoid(HLOption eOption);
 HLLIB_API hlBool hlGetVoidValidate(HLOption eOption, const hlVoid **pValue);
 HLLIB_API hlVoid hlSetVoid(HLOption eOption, const hlVoid *pValue);
 
+//
+// Contexts
+//
+
+HLLIB_API hlBool hlContextCreate(HLContext **pContext);
+HLLIB_API hlVoid hlContextDelete(HLContext *pContext);
+
+HLLIB_API hlBool hlContextGetBooleanValidate(HLContext *pContext, HLOption eOption, hlBool *pValue);
+HLLIB_API hlVoid hlContextSetBoolean(HLContext *pContext, HLOption eOption, hlBool bValue);
+
+HLLIB_API hlBool hlContextGetUnsignedIntegerValidate(HLContext *pContext, HLOption eOption, hlUInt *pValue);
+HLLIB_API hlVoid hlContextSetUnsignedInteger(HLContext *pContext, HLOption eOption, hlUInt iValue);
+
+HLLIB_API hlBool hlContextGetUnsignedLongLongValidate(HLContext *pContext, HLOption eOption, hlULongLong *pValue);
+
+HLLIB_API const hlChar *hlContextGetString(HLContext *pContext, HLOption eOption);
+HLLIB_API hlBool hlContextGetStringValidate(HLContext *pContext, HLOption eOption, const hlChar **pValue);
+
+HLLIB_API hlBool hlContextGetVoidValidate(HLContext *pContext, HLOption eOption, const hlVoid **pValue);
+HLLIB_API hlVoid hlContextSetVoid(HLContext *pContext, HLOption eOption, const hlVoid *pValue);
+
 //
 // Attributes
 //
@@ -445,6 +507,11 @@ HLLIB_API hlBool hlItemGetSizeOnDiskEx(const HLDirectoryItem *pItem, hlULongLong
 
 HLLIB_API hlVoid hlItemGetPath(const HLDirectoryItem *pItem, hlChar *lpPath, hlUInt uiPathSize);
 HLLIB_API hlBool hlItemExtract(HLDirectoryItem *pItem, const hlChar *lpPath);
+HLLIB_API hlBool hlItemExtractTar(HLDirectoryItem *pItem, hlInt iFile, hlBool bFinish);
+HLLIB_API hlBool hlItemExtractTarProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish);
+HLLIB_API hlBool hlItemExtractZIP(HLDirectoryItem *pItem, hlInt iFile);
+HLLIB_API hlBool hlItemExtractZIPProc(HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData);
+HLLIB_API hlBool hlItemExtractVPK(HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion);
 
 //
 // Directory Folder
@@ -551,18 +618,89 @@ HLLIB_API hlVoid hlPackageReleaseStream(HLStream *pStream);
 HLLIB_API const hlChar *hlNCFFileGetRootPath();
 HLLIB_API hlVoid hlNCFFileSetRootPath(const hlChar *lpRootPath);
 
+HLLIB_API HLValidation hlVPKFileValidateArchives();
+HLLIB_API hlBool hlVPKFilePinArchive(hlUInt uiArchiveIndex);
+HLLIB_API hlVoid hlVPKFileUnpinArchive(hlUInt uiArchiveIndex);
+HLLIB_API HLDirectoryItem *hlVPKFileFindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
+HLLIB_API HLDirectoryItem *hlXZPFileGetFileByCRC(hlUInt uiFileNameCRC);
+
 HLLIB_API hlBool hlWADFileGetImageSizePaletted(const HLDirectoryItem *pFile, hlUInt *uiPaletteDataSize, hlUInt *uiPixelDataSize);
 HLLIB_API hlBool hlWADFileGetImageDataPaletted(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPaletteData, hlByte **lpPixelData);
 HLLIB_API hlBool hlWADFileGetImageSize(const HLDirectoryItem *pFile, hlUInt *uiPixelDataSize);
 HLLIB_API hlBool hlWADFileGetImageData(const HLDirectoryItem *pFile, hlUInt *uiWidth, hlUInt *uiHeight, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileGetImageMipmapsSize(const HLDirectoryItem *pFile, hlUInt *uiImageCount, hlUInt *uiPixelDataSize);
+HLLIB_API hlBool hlWADFileGetImageMipmaps(const HLDirectoryItem *pFile, HLWADImage *lpImages, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileGetImagesSize(hlUInt *uiImageCount, hlUInt *uiPixelDataSize);
+HLLIB_API hlBool hlWADFileGetImages(HLWADImage *lpImages, hlByte **lpPixelData);
+HLLIB_API hlBool hlWADFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage);
+HLLIB_API hlVoid hlWADFileReleaseImage(HLBorrowedImage *pImage);
+
+HLLIB_API hlBool hlBSPFileBorrowImage(const HLDirectoryItem *pFile, HLBorrowedImage *pImage);
+HLLIB_API hlVoid hlBSPFileReleaseImage(HLBorrowedImage *pImage);
+
+//
+// Context Package
+//
+
+HLLIB_API hlBool hlContextCreatePackage(HLContext *pContext, HLPackageType ePackageType, hlUInt *uiPackage);
+HLLIB_API hlVoid hlContextDeletePackage(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API HLPackageType hlContextPackageGetType(HLContext *pContext, hlUInt uiPackage);
+HLLIB_API hlBool hlContextPackageGetOpened(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageOpenFile(HLContext *pContext, hlUInt uiPackage, const hlChar *lpFileName, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenMemory(HLContext *pContext, hlUInt uiPackage, hlVoid *lpData, hlUInt uiBufferSize, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenProc(HLContext *pContext, hlUInt uiPackage, hlVoid *pUserData, hlUInt uiMode);
+HLLIB_API hlBool hlContextPackageOpenStream(HLContext *pContext, hlUInt uiPackage, HLStream *pStream, hlUInt uiMode);
+HLLIB_API hlVoid hlContextPackageClose(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageDefragment(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API HLDirectoryItem *hlContextPackageGetRoot(HLContext *pContext, hlUInt uiPackage);
+
+HLLIB_API hlBool hlContextPackageGetAttribute(HLContext *pContext, hlUInt uiPackage, HLPackageAttribute eAttribute, HLAttribute *pAttribute);
+HLLIB_API hlBool hlContextPackageGetItemAttribute(HLContext *pContext, const HLDirectoryItem *pItem, HLPackageAttribute eAttribute, HLAttribute *pAttribute);
+
+HLLIB_API hlBool hlContextItemExtract(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpPath);
+HLLIB_API hlBool hlContextItemExtractTarProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData, hlBool bFinish);
+HLLIB_API hlBool hlContextItemExtractZIPProc(HLContext *pContext, HLDirectoryItem *pItem, PWriteProc pWriteProc, hlVoid *pUserData);
+HLLIB_API hlBool hlContextItemExtractVPK(HLContext *pContext, HLDirectoryItem *pItem, const hlChar *lpFileName, hlUInt uiVersion);
+
+HLLIB_API HLValidation hlContextFileGetValidation(HLContext *pContext, const HLDirectoryItem *pItem);
+HLLIB_API hlBool hlContextFileCreateStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream **pStream);
+HLLIB_API hlVoid hlContextFileReleaseStream(HLContext *pContext, HLDirectoryItem *pItem, HLStream *pStream);
+
+HLLIB_API hlBool hlContextItemGetSizeEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize);
+HLLIB_API hlBool hlContextItemGetSizeOnDiskEx(HLContext *pContext, const HLDirectoryItem *pItem, hlULongLong *pSize);
+
+//
+// Context Stream
+//
+
+HLLIB_API hlBool hlContextStreamOpen(HLContext *pContext, HLStream *pStream, hlUInt uiMode);
+HLLIB_API hlVoid hlContextStreamClose(HLContext *pContext, HLStream *pStream);
+
+HLLIB_API hlULongLong hlContextStreamSeekEx(HLContext *pContext, HLStream *pStream, hlLongLong iOffset, HLSeekMode eSeekMode);
+
+HLLIB_API hlUInt hlContextStreamRead(HLContext *pContext, HLStream *pStream, hlVoid *lpData, hlUInt uiBytes);
+HLLIB_API hlUInt hlContextStreamWrite(HLContext *pContext, HLStream *pStream, const hlVoid *lpData, hlUInt uiBytes);
 
 #ifdef __cplusplus
 }
 #endif
 
 #ifdef __cplusplus
+#ifndef _WIN32
+#	include <pthread.h>
+#endif
+
 namespace HLLib
 {
+	class CContext;
+	class CError;
+	struct InputPoolJob;
+	class CBufferCache;
 	class HLLIB_API CDirectoryItem;
 	class HLLIB_API CDirectoryFile;
 	class HLLIB_API CDirectoryFolder;
@@ -570,25 +708,36 @@ namespace HLLib
 	namespace Streams
 	{
 		class HLLIB_API IStream;
+		class HLLIB_API CConcatenatedStream;
 		class HLLIB_API CFileStream;
 		class HLLIB_API CGCFStream;
+		class HLLIB_API CInflateStream;
+		class HLLIB_API CLZMAStream;
+		class HLLIB_API CLZSSStream;
 		class HLLIB_API CMappingStream;
 		class HLLIB_API CMemoryStream;
 		class HLLIB_API CNullStream;
 		class HLLIB_API CProcStream;
+		class HLLIB_API CReadAheadStream;
+	}
+
+	namespace Threading
+	{
+		class HLLIB_API CMutex;
+		class HLLIB_API CLock;
+		class HLLIB_API CSemaphore;
+		class HLLIB_API CThread;
 	}
 
 	namespace Mapping
 	{
 		class HLLIB_API CView;
-		class HLLIB_API CViewList;
 		class HLLIB_API CMapping;
 		class HLLIB_API CFileMapping;
 		class HLLIB_API CMemoryMapping;
 		class HLLIB_API CStreamMapping;
 	}
 
-	class HLLIB_API CStreamList;
 	class HLLIB_API CPackage;
 	class HLLIB_API CBSPFile;
 	class HLLIB_API CGCFFile;
@@ -599,6 +748,9 @@ namespace HLLib
 	class HLLIB_API CWADFile;
 	class HLLIB_API CXZPFile;
 	class HLLIB_API CZIPFile;
+	class HLLIB_API CTarWriter;
+	class HLLIB_API CVPKWriter;
+	class HLLIB_API CZIPWriter;
 }
 
 namespace HLLib
@@ -662,10 +814,16 @@ namespace HLLib
 		hlBool GetSize(hlUInt &uiSize) const;
 		hlUInt GetSizeOnDisk() const;
 		hlBool GetSizeOnDisk(hlUInt &uiSize) const;
+		hlULongLong GetSizeEx() const;
+		hlBool GetSizeEx(hlULongLong &uiSize) const;
+		hlULongLong GetSizeOnDiskEx() const;
+		hlBool GetSizeOnDiskEx(hlULongLong &uiSize) const;
 
 		hlBool CreateStream(Streams::IStream *&pStream) const;
 		hlVoid ReleaseStream(Streams::IStream *pStream) const;
 
+		hlBool GetUnchanged(const hlChar *lpFileName, HLSkipMode eSkipMode) const;
+
 		virtual hlBool Extract(const hlChar *lpPath);
 	};
 
@@ -720,6 +878,119 @@ namespace HLLib
 		const CDirectoryItem *FindNext(const CDirectoryFolder *pFolder, const CDirectoryItem *pRelative, const hlChar *lpSearch, HLFindType eFind = HL_FIND_ALL) const;
 	};
 
+	namespace Threading
+	{
+		typedef hlVoid (*PThreadProc)(hlVoid *pUserData);
+
+		//
+		// CMutex
+		//
+
+		class HLLIB_API CMutex
+		{
+		private:
+#ifdef _WIN32
+			CRITICAL_SECTION CriticalSection;
+#else
+			pthread_mutex_t Mutex;
+#endif
+
+		public:
+			CMutex();
+			~CMutex();
+
+			hlVoid Lock();
+			hlVoid Unlock();
+
+		private:
+			CMutex(const CMutex &);
+			CMutex &operator=(const CMutex &);
+		};
+
+		//
+		// CLock
+		//
+
+		class HLLIB_API CLock
+		{
+		private:
+			CMutex &Mutex;
+
+		public:
+			CLock(CMutex &Mutex);
+			~CLock();
+
+		private:
+			CLock(const CLock &);
+			CLock &operator=(const CLock &);
+		};
+
+		//
+		// CSemaphore
+		//
+
+		class HLLIB_API CSemaphore
+		{
+		private:
+#ifdef _WIN32
+			HANDLE hSemaphore;
+#else
+			pthread_mutex_t Mutex;
+			pthread_cond_t Condition;
+			hlUInt uiCount;
+#endif
+
+		public:
+			CSemaphore(hlUInt uiCount = 0);
+			~CSemaphore();
+
+			hlVoid Wait();
+			hlVoid Post();
+
+		private:
+			CSemaphore(const CSemaphore &);
+			CSemaphore &operator=(const CSemaphore &);
+		};
+
+		//
+		// CThread
+		//
+
+		class HLLIB_API CThread
+		{
+		private:
+#ifdef _WIN32
+			HANDLE hThread;
+#else
+			pthread_t Thread;
+			hlBool bStarted;
+#endif
+			PThreadProc pThreadProc;
+			hlVoid *pUserData;
+
+		public:
+			CThread();
+			~CThread();
+
+			hlBool GetStarted() const;
+
+			hlBool Start(PThreadProc pThreadProc, hlVoid *pUserData);
+			hlVoid Join();
+
+			static hlUInt GetProcessorCount();
+
+		private:
+			CThread(const CThread &);
+			CThread &operator=(const CThread &);
+
+#ifdef _WIN32
+			static DWORD WINAPI ThreadProc(LPVOID lpParameter);
+#else
+			static hlVoid *ThreadProc(hlVoid *lpParameter);
+#endif
+		};
+	}
+
 	namespace Streams
 	{
 		//
@@ -728,7 +999,16 @@ namespace HLLib
 
 		class HLLIB_API IStream
 		{
+			friend class HLLib::CPackage;
+
+		private:
+			const CPackage *pPackage;
+			IStream *pPrevious;
+			IStream *pNext;
+			hlUInt uiPackageData;
+
 		public:
+			IStream();
 			virtual ~IStream();
 
 			virtual HLStreamType GetType() const = 0;
@@ -753,6 +1033,49 @@ namespace HLLib
 			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes) = 0;
 		};
 
+		//
+		// CConcatenatedStream
+		//
+
+		class HLLIB_API CConcatenatedStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			IStream *pFirst;
+			IStream *pSecond;
+
+			hlULongLong uiFirstLength;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+		public:
+			CConcatenatedStream(IStream *pFirst, IStream *pSecond);
+			~CConcatenatedStream();
+
+			virtual HLStreamType GetType() const;
+
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+		};
 		//
 		// CFileStream
 		//
@@ -766,11 +1089,13 @@ namespace HLLib
 			hlInt iFile;
 #endif
 			hlUInt uiMode;
+			hlBool bOverwriteFiles;
 
 			hlChar *lpFileName;
 
 		public:
 			CFileStream(const hlChar *lpFileName);
+			CFileStream(const hlChar *lpFileName, hlBool bOverwriteFiles);
 			~CFileStream();
 
 			virtual HLStreamType GetType() const;
@@ -847,6 +1172,203 @@ namespace HLLib
 			hlBool Map(hlUInt uiPointer);
 		};
 
+		//
+		// CInflateStream
+		//
+
+		class HLLIB_API CInflateStream : public IStream
+		{
+		private:
+			struct InflateRestartPoint
+			{
+				hlULongLong uiInput;
+				hlULongLong uiOutput;
+				hlUInt uiBits;
+				hlUInt uiWindowSize;
+				hlByte *lpWindow;
+			};
+
+			class CRestartPointVector;
+
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			Mapping::CMapping &Mapping;
+			Mapping::CView *pView;
+
+			hlULongLong uiMappingOffset;
+			hlULongLong uiMappingSize;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			hlVoid *pZStream;
+			hlULongLong uiInput;
+			hlBool bEnd;
+
+			CRestartPointVector *pRestartPoints;
+
+		public:
+			CInflateStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, hlULongLong uiLength);
+			~CInflateStream();
+
+			virtual HLStreamType GetType() const;
+
+			const Mapping::CMapping &GetMapping() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+		private:
+			hlBool MapInput();
+
+			hlVoid Restart(hlULongLong uiPointer);
+			hlVoid AddRestartPoint();
+			hlVoid ClearRestartPoints();
+		};
+
+		//
+		// CLZMAStream
+		//
+
+		#define HL_LZMA_PROPERTIES_SIZE 5
+
+		class HLLIB_API CLZMAStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			Mapping::CMapping &Mapping;
+			Mapping::CView *pView;
+
+			hlULongLong uiMappingOffset;
+			hlULongLong uiMappingSize;
+
+			hlByte lpProperties[HL_LZMA_PROPERTIES_SIZE];
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			hlVoid *pLZMAStream;
+			hlULongLong uiInput;
+			hlBool bEnd;
+
+		public:
+			CLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, const hlByte *lpProperties, hlULongLong uiLength);
+			~CLZMAStream();
+
+			virtual HLStreamType GetType() const;
+
+			const Mapping::CMapping &GetMapping() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+		private:
+			hlBool MapInput();
+
+			hlBool CreateDecoder();
+			hlVoid DestroyDecoder();
+		};
+
+		//
+		// CLZSSStream
+		//
+
+		#define HL_LZSS_WINDOW_SIZE 4096
+
+		class HLLIB_API CLZSSStream : public IStream
+		{
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			Mapping::CMapping &Mapping;
+			Mapping::CView *pView;
+
+			hlULongLong uiMappingOffset;
+			hlULongLong uiMappingSize;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			const hlByte *lpInput;
+			hlUInt uiInputSize;
+			hlULongLong uiInput;
+
+			hlByte lpWindow[HL_LZSS_WINDOW_SIZE];
+			hlUInt uiWindowPosition;
+			hlUInt uiFlags;
+			hlUInt uiMatchPosition;
+			hlUInt uiMatchLength;
+
+		public:
+			CLZSSStream(Mapping::CMapping &Mapping, hlULongLong uiMappingOffset, hlULongLong uiMappingSize, hlULongLong uiLength);
+			~CLZSSStream();
+
+			virtual HLStreamType GetType() const;
+
+			const Mapping::CMapping &GetMapping() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+			static hlULongLong GetMaximumLength(hlULongLong uiMappingSize);
+
+		private:
+			hlBool ReadInput(hlByte &uiByte);
+			hlBool MapInput();
+
+			hlVoid Reset();
+		};
+
 		//
 		// CMappingStream
 		//
@@ -893,6 +1415,8 @@ namespace HLLib
 			virtual hlBool Write(hlChar iChar);
 			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
 
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const;
+
 		private:
 			hlBool Map(hlULongLong uiPointer);
 		};
@@ -909,12 +1433,14 @@ namespace HLLib
 
 			hlVoid *lpData;
 			hlUInt uiBufferSize;
+			hlBool bReadOnly;
 
 			hlULongLong uiPointer;
 			hlULongLong uiLength;
 
 		public:
 			CMemoryStream(hlVoid *lpData, hlUInt uiBufferSize);
+			CMemoryStream(const hlVoid *lpData, hlUInt uiBufferSize);
 			~CMemoryStream();
 
 			virtual HLStreamType GetType() const;
@@ -987,6 +1513,7 @@ namespace HLLib
 			hlBool bOpened;
 			hlUInt uiMode;
 
+			const CContext &Context;
 			hlVoid *pUserData;
 
 		public:
@@ -1014,6 +1541,81 @@ namespace HLLib
 			virtual hlBool Write(hlChar iChar);
 			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
 		};
+
+		//
+		// CReadAheadStream
+		//
+
+		class HLLIB_API CReadAheadStream : public IStream
+		{
+		private:
+			struct ReadAheadBuffer
+			{
+				hlByte *lpData;
+				hlUInt uiSize;
+			};
+
+		private:
+			hlBool bOpened;
+			hlUInt uiMode;
+
+			IStream &Stream;
+
+			hlULongLong uiPointer;
+			hlULongLong uiLength;
+
+			hlBool bReadAhead;
+			hlBool bThreaded;
+			hlBool bEnd;
+			volatile hlBool bStop;
+
+			CError *pError;
+			Threading::CThread Thread;
+			Threading::CSemaphore *pFree;
+			Threading::CSemaphore *pFilled;
+
+			hlByte *lpBuffer;
+			ReadAheadBuffer Buffers[HL_READ_AHEAD_BUFFER_COUNT];
+			hlUInt uiReadBuffer;
+			hlUInt uiReadOffset;
+			hlBool bReadBuffer;
+
+		public:
+			CReadAheadStream(IStream &Stream);
+			CReadAheadStream(IStream &Stream, hlBool bReadAhead);
+			~CReadAheadStream();
+
+			virtual HLStreamType GetType() const;
+
+			const IStream &GetStream() const;
+			virtual const hlChar *GetFileName() const;
+
+			virtual hlBool GetOpened() const;
+			virtual hlUInt GetMode() const;
+
+			virtual hlBool Open(hlUInt uiMode);
+			virtual hlVoid Close();
+
+			virtual hlULongLong GetStreamSize() const;
+			virtual hlULongLong GetStreamPointer() const;
+
+			virtual hlULongLong Seek(hlLongLong iOffset, HLSeekMode eSeekMode);
+
+			virtual hlBool Read(hlChar &cChar);
+			virtual hlUInt Read(hlVoid *lpData, hlUInt uiBytes);
+
+			virtual hlBool Write(hlChar cChar);
+			virtual hlUInt Write(const hlVoid *lpData, hlUInt uiBytes);
+
+		private:
+			hlBool Start();
+			hlVoid Stop();
+
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength);
+
+			hlVoid ReadAhead();
+			static hlVoid ReadAheadProc(hlVoid *pUserData);
+		};
 	}
 
 	namespace Mapping
@@ -1035,6 +1637,9 @@ namespace HLLib
 			hlULongLong uiAllocationOffset;
 			hlULongLong uiAllocationLength;
 
+			CView *pPrevious;
+			CView *pNext;
+
 		public:
 			CView(CMapping *pMapping, hlVoid *lpView, hlULongLong uiAllocationOffset, hlULongLong uiAllocationLength, hlULongLong uiOffset = 0, hlULongLong uiLength = 0);
 			~CView();
@@ -1056,7 +1661,12 @@ namespace HLLib
 		class HLLIB_API CMapping
 		{
 		private:
-			CViewList *pViews;
+			CView *pViews;
+			mutable Threading::CMutex ViewsMutex;
+
+			hlUInt uiTotalAllocations;
+			hlULongLong uiTotalMemoryAllocated;
+			hlULongLong uiTotalMemoryUsed;
 
 		public:
 			CMapping();
@@ -1084,6 +1694,8 @@ namespace HLLib
 			hlBool Commit(CView &View);
 			hlBool Commit(CView &View, hlULongLong uiOffset, hlULongLong uiLength);
 
+			hlVoid Prefetch(hlULongLong uiOffset, hlULongLong uiLength) const;
+
 		private:
 			virtual hlBool OpenInternal(hlUInt uiMode) = 0;
 			virtual hlVoid CloseInternal() = 0;
@@ -1092,6 +1704,10 @@ namespace HLLib
 			virtual hlVoid UnmapInternal(CView &View);
 
 			virtual hlBool CommitInternal(CView &View, hlULongLong uiOffset, hlULongLong uiLength);
+
+			virtual hlVoid PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const;
+
+			hlVoid UnlinkView(CView &View);
 		};
 
 		//
@@ -1134,6 +1750,8 @@ namespace HLLib
 
 			virtual hlBool MapInternal(CView *&pView, hlULongLong uiOffset, hlULongLong uiLength);
 			virtual hlVoid UnmapInternal(CView &View);
+
+			virtual hlVoid PrefetchInternal(hlULongLong uiOffset, hlULongLong uiLength) const;
 		};
 
 		//
@@ -1178,6 +1796,7 @@ namespace HLLib
 		{
 		private:
 			Streams::IStream &Stream;
+			Threading::CMutex StreamMutex;
 
 		public:
 			CStreamMapping(Streams::IStream &Stream);
@@ -1221,7 +1840,12 @@ namespace HLLib
 		CDirectoryFolder *pRoot;
 
 	private:
-		CStreamList *pStreams;
+		mutable Streams::IStream *pStreams;
+		mutable Threading::CMutex StreamsMutex;
+
+		CContext *pContext;
+
+		struct ImageHandle;
 
 	public:
 		CPackage();
@@ -1256,12 +1880,21 @@ namespace HLLib
 
 		hlBool GetFileExtractable(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		hlBool GetFileValidation(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		hlBool GetFileValidation(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		hlBool GetFileSize(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		hlBool GetFileSizeOnDisk(const CDirectoryFile *pFile, hlUInt &uiSize) const;
+		hlBool GetFileSizeEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		hlBool GetFileSizeOnDiskEx(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		hlBool GetConcurrentExtraction() const;
+
+		CContext &GetContext() const;
 
 		hlBool CreateStream(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
 		hlVoid ReleaseStream(Streams::IStream *pStream) const;
 
+		static hlBool ReleaseBorrowedImage(HLBorrowedImage &Image, HLPackageType ePackageType, const CPackage *pPackage = 0);
+
 	protected:
 		virtual hlBool MapDataStructures() = 0;
 		virtual hlVoid UnmapDataStructures() = 0;
@@ -1281,12 +1914,22 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const = 0;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const = 0;
+		virtual hlBool GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		virtual hlBool GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		virtual hlBool GetConcurrentExtractionInternal() const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const = 0;
 		virtual hlVoid ReleaseStreamInternal(Streams::IStream &Stream) const;
 
+		static hlVoid SetStreamData(Streams::IStream &Stream, hlUInt uiData);
+		static hlUInt GetStreamData(const Streams::IStream &Stream);
+
+		hlVoid SetImageHandle(HLBorrowedImage &Image, Mapping::CView *pView, hlBool bOwnsBuffer) const;
+
 	private:
 		hlBool Open(Streams::IStream *pStream, hlUInt uiMode, hlBool bDeleteStream);
 		hlBool Open(Mapping::CMapping *pMapping, hlUInt uiMode, hlBool bDeleteMapping);
@@ -1341,6 +1984,8 @@ namespace HLLib
 		const BSPHeader *pHeader;
 		const BSPTextureHeader *pTextureHeader;
 
+		CBufferCache *pStreamCache;
+
 	public:
 		CBSPFile();
 		virtual ~CBSPFile();
@@ -1349,6 +1994,9 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		hlBool BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image);
+		hlVoid ReleaseImage(HLBorrowedImage &Image);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -1620,6 +2268,7 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
@@ -1885,6 +2534,14 @@ namespace HLLib
 			hlInt		iMapRevision;					// The map's revision (iteration, version) number.
 		};
 
+		struct VBSPLZMAHeader
+		{
+			hlUInt		uiID;							// LZMA header signature ("LZMA").
+			hlUInt		uiActualSize;					// Uncompressed size.
+			hlUInt		uiLZMASize;						// Compressed size.
+			hlByte		lpProperties[5];				// LZMA properties.
+		};
+
 		struct ZIPEndOfCentralDirectoryRecord
 		{
 			hlUInt uiSignature; // 4 bytes (0x06054b50)
@@ -1953,6 +2610,8 @@ namespace HLLib
 		const VBSPHeader *pHeader;
 		const ZIPEndOfCentralDirectoryRecord *pEndOfCentralDirectoryRecord;
 
+		CBufferCache *pStreamCache;
+
 	public:
 		CVBSPFile();
 		virtual ~CVBSPFile();
@@ -1977,13 +2636,21 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
+		virtual hlVoid ReleaseStreamInternal(Streams::IStream &Stream) const;
 
 	private:
 		hlVoid GetFileName(hlChar *lpBuffer, hlUInt uiBufferSize);
+
+		hlBool GetCompressionSupported(hlUInt uiCompressionMethod) const;
+
+		hlBool GetLumpCompressed(hlUInt uiID) const;
+		hlUInt GetLumpSize(hlUInt uiID) const;
+		hlBool CreateLumpStream(hlUInt uiID, Streams::IStream *&pStream) const;
 	};
 
 	//
@@ -2002,6 +2669,14 @@ namespace HLLib
 			hlUInt uiDirectoryLength;
 		};
 
+		struct VPKExtendedHeader
+		{
+			hlUInt uiFileDataSectionSize;
+			hlUInt uiArchiveMD5SectionSize;
+			hlUInt uiOtherMD5SectionSize;	// Always 48.
+			hlUInt uiSignatureSectionSize;
+		};
+
 		struct VPKDirectoryEntry
 		{
 			hlUInt uiCRC;
@@ -2012,27 +2687,49 @@ namespace HLLib
 			hlUShort uiDummy0;			// Always 0xffff.
 		};
 
+		struct VPKArchiveMD5Entry
+		{
+			hlUInt uiArchiveIndex;
+			hlUInt uiStartingOffset;
+			hlUInt uiCount;
+			hlByte lpMD5[16];
+		};
+
+		struct VPKOtherMD5Section
+		{
+			hlByte lpTreeMD5[16];
+			hlByte lpArchiveMD5SectionMD5[16];
+			hlByte lpWholeFileMD5[16];
+		};
+
 		#pragma pack()
 
 		struct VPKArchive
 		{
 			Streams::IStream *pStream;
 			Mapping::CMapping *pMapping;
+			hlULongLong uiSize;
+			hlULongLong uiLastUsed;
+			hlUInt uiReferences;		// Open streams and validations.
+			hlBool bPinned;
+			hlBool bSizeKnown;
+			hlBool bMissing;
 		};
 
 		struct VPKDirectoryItem
 		{
-			VPKDirectoryItem(const hlChar *lpExtention, const hlChar *lpPath, const hlChar *lpName, const VPKDirectoryEntry *pDirectoryEntry, const hlVoid *lpPreloadData) : lpExtention(lpExtention), lpPath(lpPath), lpName(lpName), pDirectoryEntry(pDirectoryEntry), lpPreloadData(lpPreloadData)
-			{
-			}
-
 			const hlChar *lpExtention;
 			const hlChar *lpPath;
 			const hlChar *lpName;
 			const VPKDirectoryEntry *pDirectoryEntry;
 			const hlVoid *lpPreloadData;
+			CDirectoryFile *pFile;		// Set by CreateRoot().
+			hlUInt uiHash;
+			hlUInt uiNext;				// Next item in the same hash bucket.
 		};
 
+		struct VPKValidatePool;
+
 	private:
 		static const char *lpItemAttributeNames[];
 
@@ -2040,9 +2737,22 @@ namespace HLLib
 
 		hlUInt uiArchiveCount;
 		VPKArchive *lpArchives;
+		hlChar *lpArchivePrefix;
+		hlChar *lpArchiveExtension;
+		hlUInt uiArchiveHandleLimit;
+		mutable hlUInt uiOpenArchiveCount;
+		mutable hlULongLong uiArchiveClock;
+		mutable Threading::CMutex ArchiveMutex;
 
 		const VPKHeader *pHeader;
-		class CDirectoryItemList *pDirectoryItems;
+		const VPKExtendedHeader *pExtendedHeader;
+		const VPKArchiveMD5Entry *lpArchiveMD5Entries;
+		hlUInt uiArchiveMD5EntryCount;
+		const VPKOtherMD5Section *pOtherMD5Section;
+		hlUInt uiDirectoryItemCount;
+		VPKDirectoryItem *lpDirectoryItems;
+		hlUInt uiDirectoryItemBucketCount;
+		hlUInt *lpDirectoryItemBuckets;
 
 	public:
 		CVPKFile();
@@ -2052,6 +2762,13 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		hlBool ValidateArchives(HLValidation &eValidation) const;
+
+		hlBool PinArchive(hlUInt uiArchiveIndex);
+		hlVoid UnpinArchive(hlUInt uiArchiveIndex);
+
+		CDirectoryFile *FindFile(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -2068,6 +2785,7 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
@@ -2076,6 +2794,20 @@ namespace HLLib
 
 	private:
 		hlBool MapString(const hlChar *&lpViewData, const hlChar *lpViewDirectoryDataEnd, const hlChar *&lpString);
+		hlBool MapDirectoryItems(const hlChar *lpViewData, const hlChar *lpViewDirectoryDataEnd, const hlChar *lpViewDataEnd, VPKDirectoryItem *lpDirectoryItems, hlUInt &uiDirectoryItemCount);
+
+		static hlUInt HashDirectoryItem(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+
+		Mapping::CMapping *AcquireArchive(hlUInt uiArchiveIndex) const;
+		hlVoid ReleaseArchive(hlUInt uiArchiveIndex) const;
+		hlBool GetArchiveSize(hlUInt uiArchiveIndex, hlULongLong &uiSize) const;
+		hlBool OpenArchive(hlUInt uiArchiveIndex) const;
+		hlVoid CloseArchive(hlUInt uiArchiveIndex) const;
+		hlVoid CloseArchives(hlUInt uiOpenCount) const;
+
+		static hlVoid ValidateArchiveWorker(hlVoid *pUserData);
+		HLValidation ValidateArchiveMD5Entry(const VPKArchiveMD5Entry &Entry) const;
+		HLValidation ValidateMD5(Mapping::CMapping &Mapping, hlULongLong uiOffset, hlULongLong uiLength, const hlByte lpMD5[16]) const;
 	};
 
 	//
@@ -2125,6 +2857,9 @@ namespace HLLib
 		const WADHeader *pHeader;
 		const WADLump *lpLumps;
 		WADLumpInfo *lpLumpInfo;
+		mutable Threading::CMutex LumpInfoMutex;
+
+		CBufferCache *pStreamCache;
 
 	public:
 		CWADFile();
@@ -2140,6 +2875,15 @@ namespace HLLib
 		hlBool GetImageSize(const CDirectoryFile *pFile, hlUInt &uiPixelDataSize);
 		hlBool GetImageData(const CDirectoryFile *pFile, hlUInt &uiWidth, hlUInt &uiHeight, hlByte *lpPixelData);
 
+		hlBool GetImageMipmapsSize(const CDirectoryFile *pFile, hlUInt &uiImageCount, hlUInt &uiPixelDataSize);
+		hlBool GetImageMipmaps(const CDirectoryFile *pFile, HLWADImage *lpImages, hlByte *lpPixelData);
+
+		hlBool GetImagesSize(hlUInt &uiImageCount, hlUInt &uiPixelDataSize);
+		hlBool GetImages(HLWADImage *lpImages, hlByte *lpPixelData);
+
+		hlBool BorrowImage(const CDirectoryFile *pFile, HLBorrowedImage &Image);
+		hlVoid ReleaseImage(HLBorrowedImage &Image);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -2164,6 +2908,16 @@ namespace HLLib
 	private:
 		hlBool GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, hlUInt uiMipmap = 0) const;
 		hlBool GetLumpInfo(const CDirectoryFile &File, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize, const hlByte *&lpPalette, const hlByte *&lpPixels, Mapping::CView *&pView, hlUInt uiMipmap = 0) const;
+
+		hlUInt GetMipmapCount(const CDirectoryFile &File) const;
+		hlBool GetLumpImagesSize(const CDirectoryFile &File, hlUInt &uiImageCount, hlULongLong &uiPixelDataSize) const;
+		hlBool GetLumpImages(const CDirectoryFile &File, HLWADImage *lpImages, hlByte *lpPixelData, hlUInt &uiOffset) const;
+		hlBool GetLumpMipmaps(const CDirectoryFile &File, hlUInt uiWidth, hlUInt uiHeight, hlUInt uiPaletteSize, const hlByte *lpPalette, const hlByte *lpPixels, const Mapping::CView &View, const hlByte **lpMipmaps) const;
+
+		hlBool GetCompressionSupported(hlChar iCompression) const;
+		hlBool GetCompressedLumpInfo(const WADLump &Lump, hlUInt &uiWidth, hlUInt &uiHeight, hlUInt &uiPaletteSize) const;
+		hlBool MapCompressedLump(const WADLump &Lump, Mapping::CView *&pView) const;
+		hlVoid UnmapLump(Mapping::CView *&pView) const;
 	};
 
 	//
@@ -2215,6 +2969,14 @@ namespace HLLib
 
 		#pragma pack()
 
+		// Chained hash of file name CRCs to directory entry or item indices.
+		struct XZPCRCIndex
+		{
+			hlUInt uiMask;
+			hlUInt *lpBuckets;
+			hlUInt *lpNext;
+		};
+
 	private:
 		static const char *lpAttributeNames[];
 		static const char *lpItemAttributeNames[];
@@ -2231,6 +2993,10 @@ namespace HLLib
 		const XZPDirectoryItem *lpDirectoryItems;
 		const XZPFooter *pFooter;
 
+		XZPCRCIndex EntryIndex;
+		XZPCRCIndex ItemIndex;
+		CDirectoryFile **lpFiles;
+
 	public:
 		CXZPFile();
 		virtual ~CXZPFile();
@@ -2239,6 +3005,8 @@ namespace HLLib
 		virtual const hlChar *GetExtension() const;
 		virtual const hlChar *GetDescription() const;
 
+		CDirectoryFile *GetFileByCRC(hlUInt uiFileNameCRC);
+
 	protected:
 		virtual hlBool MapDataStructures();
 		virtual hlVoid UnmapDataStructures();
@@ -2257,6 +3025,14 @@ namespace HLLib
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
+
+	private:
+		static hlVoid CreateCRCIndex(XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiCount);
+		static hlVoid DeleteCRCIndex(XZPCRCIndex &Index);
+		static hlUInt FindCRC(const XZPCRCIndex &Index, const hlVoid *lpFirst, hlUInt uiStride, hlUInt uiFileNameCRC);
+
+		hlUInt FindDirectoryEntry(hlUInt uiFileNameCRC) const;
+		hlUInt FindDirectoryItem(hlUInt uiFileNameCRC) const;
 	};
 
 	//
@@ -2281,6 +3057,29 @@ namespace HLLib
 			// zip file comment follows
 		};
 
+		struct ZIP64EndOfCentralDirectoryLocator
+		{
+			hlUInt uiSignature; // 4 bytes (0x07064b50)
+			hlUInt uiNumberOfTheDiskWithStartOfEndOfCentralDirectory; // 4 bytes
+			hlULongLong uiRelativeOffsetOfEndOfCentralDirectoryRecord; // 8 bytes
+			hlUInt uiTotalNumberOfDisks; // 4 bytes
+		};
+
+		struct ZIP64EndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature; // 4 bytes (0x06064b50)
+			hlULongLong uiSizeOfEndOfCentralDirectoryRecord; // 8 bytes
+			hlUInt16 uiVersionMadeBy; // 2 bytes
+			hlUInt16 uiVersionNeededToExtract; // 2 bytes
+			hlUInt uiNumberOfThisDisk; // 4 bytes
+			hlUInt uiNumberOfTheDiskWithStartOfCentralDirectory; // 4 bytes
+			hlULongLong uiCentralDirectoryEntriesThisDisk; // 8 bytes
+			hlULongLong uiCentralDirectoryEntriesTotal; // 8 bytes
+			hlULongLong uiCentralDirectorySize; // 8 bytes
+			hlULongLong uiStartOfCentralDirOffset; // 8 bytes
+			// zip64 extensible data sector follows
+		};
+
 		struct ZIPFileHeader
 		{
 			hlUInt uiSignature; //  4 bytes (0x02014b50) 
@@ -2323,8 +3122,31 @@ namespace HLLib
 			// file data (variable size) 
 		};
 
+		struct ZIPLZMAHeader
+		{
+			hlUInt16 uiVersion; // LZMA SDK version 2 bytes 
+			hlUInt16 uiPropertiesSize; // properties size 2 bytes 
+			// properties (variable size) 
+			// LZMA data (variable size) 
+		};
+
+		struct ZIPExtraField
+		{
+			hlUInt16 uiHeaderID; // header id 2 bytes 
+			hlUInt16 uiDataSize; // data size 2 bytes 
+			// data (variable size) 
+		};
+
 		#pragma pack()
 
+		struct ZIPFileInfo
+		{
+			hlULongLong uiUncompressedSize;
+			hlULongLong uiCompressedSize;
+			hlULongLong uiRelativeOffsetOfLocalHeader;
+			hlUInt uiDiskNumberStart;
+		};
+
 	private:
 		static const char *lpAttributeNames[];
 		static const char *lpItemAttributeNames[];
@@ -2334,6 +3156,10 @@ namespace HLLib
 
 		const ZIPEndOfCentralDirectoryRecord *pEndOfCentralDirectoryRecord;
 
+		hlUInt uiNumberOfThisDisk;
+		hlULongLong uiCentralDirectoryOffset;
+		hlULongLong uiCentralDirectorySize;
+
 	public:
 		CZIPFile();
 		virtual ~CZIPFile();
@@ -2358,10 +3184,376 @@ namespace HLLib
 
 		virtual hlBool GetFileExtractableInternal(const CDirectoryFile *pFile, hlBool &bExtractable) const;
 		virtual hlBool GetFileValidationInternal(const CDirectoryFile *pFile, HLValidation &eValidation) const;
+		virtual hlBool ValidateStreamInternal(const CDirectoryFile *pFile, Streams::IStream &Stream, HLValidation &eValidation) const;
 		virtual hlBool GetFileSizeInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
 		virtual hlBool GetFileSizeOnDiskInternal(const CDirectoryFile *pFile, hlUInt &uiSize) const;
+		virtual hlBool GetFileSizeExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+		virtual hlBool GetFileSizeOnDiskExInternal(const CDirectoryFile *pFile, hlULongLong &uiSize) const;
+
+		virtual hlBool GetConcurrentExtractionInternal() const;
 
 		virtual hlBool CreateStreamInternal(const CDirectoryFile *pFile, Streams::IStream *&pStream) const;
+
+	public:
+		// Also used by CVBSPFile, whose pakfile lump is a ZIP archive.
+		static hlBool FindEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset);
+		static hlBool ScanEndOfCentralDirectoryRecord(Mapping::CMapping &Mapping, hlULongLong uiArchiveOffset, hlULongLong uiArchiveLength, hlULongLong &uiOffset);
+		static hlBool CreateLZMAStream(Mapping::CMapping &Mapping, hlULongLong uiDataOffset, hlULongLong uiCompressedSize, hlULongLong uiUncompressedSize, Streams::IStream *&pStream);
+
+	private:
+		hlBool ReadZIP64EndOfCentralDirectoryRecord(hlULongLong uiOffset);
+
+		hlVoid GetFileInfo(const ZIPFileHeader *pFileHeader, ZIPFileInfo &FileInfo) const;
+
+		hlBool GetCompressionSupported(hlUInt uiCompressionMethod) const;
+	};
+
+	//
+	// CTarWriter
+	//
+
+	class HLLIB_API CTarWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct TarHeader
+		{
+			hlChar lpName[100];
+			hlChar lpMode[8];
+			hlChar lpUserID[8];
+			hlChar lpGroupID[8];
+			hlChar lpSize[12];
+			hlChar lpModificationTime[12];
+			hlChar lpChecksum[8];
+			hlChar cTypeFlag;
+			hlChar lpLinkName[100];
+			hlChar lpMagic[6];
+			hlChar lpVersion[2];
+			hlChar lpUserName[32];
+			hlChar lpGroupName[32];
+			hlChar lpDeviceMajor[8];
+			hlChar lpDeviceMinor[8];
+			hlChar lpPrefix[155];
+			hlChar lpPadding[12];
+		};
+
+		#pragma pack()
+
+	private:
+		Streams::IStream *pStream;
+		PWriteProc pWriteProc;
+		hlVoid *pUserData;
+
+		hlULongLong uiBytesWritten;
+		hlULongLong uiModificationTime;
+
+	public:
+		CTarWriter(Streams::IStream &Stream);
+		CTarWriter(PWriteProc pWriteProc, hlVoid *pUserData);
+		~CTarWriter();
+
+		hlULongLong GetBytesWritten() const;
+
+		hlBool Write(const CDirectoryItem *pItem);
+		hlBool WriteFolder(const hlChar *lpPath);
+		hlBool WriteFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool WriteFile(const hlChar *lpPath, Streams::IStream &Input, const CDirectoryFile *pFile = 0);
+
+		hlBool Finish();
+
+	private:
+		hlBool Write(const hlChar *lpPath, const CDirectoryItem *pItem);
+
+		hlBool WriteHeader(const hlChar *lpPath, hlChar cTypeFlag, hlULongLong uiSize);
+		hlBool WriteData(const hlVoid *lpData, hlUInt uiBytes);
+		hlBool WritePadding(hlULongLong uiSize);
+	};
+
+	//
+	// CVPKWriter
+	//
+
+	class HLLIB_API CVPKWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct VPKHeader
+		{
+			hlUInt uiSignature;
+			hlUInt uiVersion;
+			hlUInt uiDirectoryLength;
+		};
+
+		struct VPKExtendedHeader
+		{
+			hlUInt uiFileDataSectionSize;
+			hlUInt uiArchiveMD5SectionSize;
+			hlUInt uiOtherMD5SectionSize;
+			hlUInt uiSignatureSectionSize;
+		};
+
+		struct VPKDirectoryEntry
+		{
+			hlUInt uiCRC;
+			hlUShort uiPreloadBytes;
+			hlUShort uiArchiveIndex;
+			hlUInt uiEntryOffset;
+			hlUInt uiEntryLength;
+			hlUShort uiDummy0;
+		};
+
+		struct VPKArchiveMD5Entry
+		{
+			hlUInt uiArchiveIndex;
+			hlUInt uiStartingOffset;
+			hlUInt uiCount;
+			hlByte lpMD5[16];
+		};
+
+		struct VPKOtherMD5Section
+		{
+			hlByte lpTreeMD5[16];
+			hlByte lpArchiveMD5SectionMD5[16];
+			hlByte lpWholeFileMD5[16];
+		};
+
+		#pragma pack()
+
+		struct VPKWriterEntry;
+
+		class CVPKWriterEntryVector;
+		class CArchiveMD5EntryVector;
+
+	private:
+		hlChar *lpFileName;
+
+		hlUInt uiVersion;
+		hlULongLong uiArchiveSize;
+		hlUInt uiPreloadSize;
+		hlBool bUpdate;
+		hlBool bCompact;
+
+		CVPKWriterEntryVector *pEntries;
+
+		hlBool bArchives;
+		Streams::IStream *pDirectoryStream;
+		Streams::IStream *pArchiveStream;
+		hlUInt uiArchiveIndex;
+		hlULongLong uiArchiveOffset;
+		hlBool bAppendArchive;
+
+		struct MD5Context *pArchiveMD5Context;
+		VPKArchiveMD5Entry ArchiveMD5Entry;
+		CArchiveMD5EntryVector *pArchiveMD5Entries;
+
+	public:
+		CVPKWriter(const hlChar *lpFileName);
+		~CVPKWriter();
+
+		hlUInt GetVersion() const;
+		hlVoid SetVersion(hlUInt uiVersion);
+
+		hlULongLong GetArchiveSize() const;
+		hlVoid SetArchiveSize(hlULongLong uiArchiveSize);
+
+		hlUInt GetPreloadSize() const;
+		hlVoid SetPreloadSize(hlUInt uiPreloadSize);
+
+		hlBool GetUpdate() const;
+		hlVoid SetUpdate(hlBool bUpdate);
+
+		hlBool GetCompact() const;
+		hlVoid SetCompact(hlBool bCompact);
+
+		hlBool Add(const CDirectoryItem *pItem);
+		hlBool AddFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool AddFile(const hlChar *lpPath, Streams::IStream &Input);
+		hlBool RemoveFile(const hlChar *lpPath);
+
+		hlBool Finish();
+
+	private:
+		hlBool Add(const hlChar *lpPath, const CDirectoryItem *pItem);
+		hlBool AddEntry(const hlChar *lpPath, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize);
+		VPKWriterEntry *NewEntry(const hlChar *lpPath);
+		VPKWriterEntry *NewEntry(const hlChar *lpExtension, const hlChar *lpPath, const hlChar *lpName);
+		static hlVoid DeleteEntry(VPKWriterEntry *pEntry);
+		hlVoid DeleteEntries();
+
+		hlBool ReadDirectory();
+		hlBool ResolveEntries();
+		hlVoid BeginAppend(hlUInt uiArchiveCount);
+		hlBool Compact(hlUInt uiArchiveCount, hlBool *lpCompacted);
+		static hlChar *GetTemporaryFileName(const hlChar *lpFileName);
+		static hlBool CommitFile(const hlChar *lpTemporaryFileName, const hlChar *lpFileName);
+
+		static hlBool CompareEntries(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond);
+		static hlBool CompareEntryOffsets(const VPKWriterEntry *pFirst, const VPKWriterEntry *pSecond);
+		hlChar *GetArchiveFileName(hlUInt uiArchiveIndex) const;
+
+		static hlBool ReadProc(InputPoolJob &Job, const hlVoid *pUserData);
+		hlBool ReadEntry(VPKWriterEntry &Entry) const;
+		hlBool WriteEntry(VPKWriterEntry &Entry);
+		hlBool WriteTree();
+
+		hlUInt GetTree(hlByte *lpTree) const;
+
+		hlBool BeginArchiveData(VPKDirectoryEntry &DirectoryEntry, hlUInt uiSize);
+		hlBool WriteArchiveData(const hlVoid *lpData, hlUInt uiBytes);
+		hlVoid EndArchiveMD5Entry();
+		hlVoid CloseArchive();
+		static hlBool WriteData(Streams::IStream &Stream, const hlVoid *lpData, hlUInt uiBytes);
+	};
+
+	//
+	// CZIPWriter
+	//
+
+	class HLLIB_API CZIPWriter
+	{
+	private:
+		#pragma pack(1)
+
+		struct ZIPLocalFileHeader
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt16 uiFlags;
+			hlUInt16 uiCompressionMethod;
+			hlUInt16 uiLastModifiedTime;
+			hlUInt16 uiLastModifiedDate;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+			hlUInt16 uiFileNameLength;
+			hlUInt16 uiExtraFieldLength;
+		};
+
+		struct ZIPFileHeader
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiVersionMadeBy;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt16 uiFlags;
+			hlUInt16 uiCompressionMethod;
+			hlUInt16 uiLastModifiedTime;
+			hlUInt16 uiLastModifiedDate;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+			hlUInt16 uiFileNameLength;
+			hlUInt16 uiExtraFieldLength;
+			hlUInt16 uiFileCommentLength;
+			hlUInt16 uiDiskNumberStart;
+			hlUInt16 uiInternalFileAttribs;
+			hlUInt uiExternalFileAttribs;
+			hlUInt uiRelativeOffsetOfLocalHeader;
+		};
+
+		struct ZIPDataDescriptor
+		{
+			hlUInt uiSignature;
+			hlUInt uiCRC32;
+			hlUInt uiCompressedSize;
+			hlUInt uiUncompressedSize;
+		};
+
+		struct ZIP64DataDescriptor
+		{
+			hlUInt uiSignature;
+			hlUInt uiCRC32;
+			hlULongLong uiCompressedSize;
+			hlULongLong uiUncompressedSize;
+		};
+
+		struct ZIPEndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature;
+			hlUInt16 uiNumberOfThisDisk;
+			hlUInt16 uiNumberOfTheDiskWithStartOfCentralDirectory;
+			hlUInt16 uiCentralDirectoryEntriesThisDisk;
+			hlUInt16 uiCentralDirectoryEntriesTotal;
+			hlUInt uiCentralDirectorySize;
+			hlUInt uiStartOfCentralDirOffset;
+			hlUInt16 uiCommentLength;
+		};
+
+		struct ZIP64EndOfCentralDirectoryRecord
+		{
+			hlUInt uiSignature;
+			hlULongLong uiSizeOfEndOfCentralDirectoryRecord;
+			hlUInt16 uiVersionMadeBy;
+			hlUInt16 uiVersionNeededToExtract;
+			hlUInt uiNumberOfThisDisk;
+			hlUInt uiNumberOfTheDiskWithStartOfCentralDirectory;
+			hlULongLong uiCentralDirectoryEntriesThisDisk;
+			hlULongLong uiCentralDirectoryEntriesTotal;
+			hlULongLong uiCentralDirectorySize;
+			hlULongLong uiStartOfCentralDirOffset;
+		};
+
+		struct ZIP64EndOfCentralDirectoryLocator
+		{
+			hlUInt uiSignature;
+			hlUInt uiNumberOfTheDiskWithStartOfEndOfCentralDirectory;
+			hlULongLong uiRelativeOffsetOfEndOfCentralDirectoryRecord;
+			hlUInt uiTotalNumberOfDisks;
+		};
+
+		#pragma pack()
+
+		struct ZIPWriterEntry;
+
+		class CZIPWriterEntryVector;
+
+	private:
+		Streams::IStream *pStream;
+		PWriteProc pWriteProc;
+		hlVoid *pUserData;
+
+		hlULongLong uiBytesWritten;
+		hlUInt16 uiLastModifiedTime;
+		hlUInt16 uiLastModifiedDate;
+
+		hlInt iCompressionLevel;
+
+		CZIPWriterEntryVector *pEntries;
+
+	public:
+		CZIPWriter(Streams::IStream &Stream);
+		CZIPWriter(PWriteProc pWriteProc, hlVoid *pUserData);
+		~CZIPWriter();
+
+		hlInt GetCompressionLevel() const;
+		hlVoid SetCompressionLevel(hlInt iCompressionLevel);
+
+		hlULongLong GetBytesWritten() const;
+
+		hlBool Add(const CDirectoryItem *pItem);
+		hlBool AddFolder(const hlChar *lpPath);
+		hlBool AddFile(const hlChar *lpPath, const CDirectoryFile *pFile);
+		hlBool AddFile(const hlChar *lpPath, Streams::IStream &Input);
+
+		hlBool Finish();
+
+	private:
+		hlBool Add(const hlChar *lpPath, const CDirectoryItem *pItem);
+		hlVoid AddEntry(const hlChar *lpPath, hlBool bFolder, const CDirectoryItem *pItem, Streams::IStream *pInput, hlULongLong uiSize);
+		hlVoid DeleteEntries();
+
+		static hlBool CompressProc(InputPoolJob &Job, const hlVoid *pUserData);
+		hlBool CompressEntry(ZIPWriterEntry &Entry) const;
+		hlBool WriteEntry(ZIPWriterEntry &Entry);
+		hlBool WriteCentralDirectory();
+
+		hlBool WriteLocalFileHeader(const ZIPWriterEntry &Entry, hlBool bZIP64);
+		hlBool WriteData(const hlVoid *lpData, hlUInt uiBytes);
+
+	private:
+		CZIPWriter(const CZIPWriter &);
+		CZIPWriter &operator=(const CZIPWriter &);
 	};
 }
 #endif